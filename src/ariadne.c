@@ -405,6 +405,8 @@ long navigation_rule_normal(NavColour treeA, NavColour treeB)
 long init_navigation(void)
 {
     IanMap = (NavColour *)&game.navigation_map;
+    // Cache isn't saved nor synced; all players need to start with it empty
+    reach_cache_clear();
     init_navigation_map();
     triangulate_map(IanMap);
     nav_rulesA2B = navigation_rule_normal;
@@ -2767,6 +2769,84 @@ long ariadne_count_waypoints_on_creature_route_to_target_f(const struct Thing *t
     return path.waypoints_num;
 }
 
+/**
+ * Computes bounding box, in subtiles, of all triangles on the last route found by path_init8_wide_f().
+ */
+static void tree_route_bounds(long *min_x, long *min_y, long *max_x, long *max_y)
+{
+    *min_x = LONG_MAX;
+    *min_y = LONG_MAX;
+    *max_x = LONG_MIN;
+    *max_y = LONG_MIN;
+    for (long i = 0; i <= tree_routelen; i++)
+    {
+        for (long ncor = 0; ncor < 3; ncor++)
+        {
+            struct Point* pt = get_triangle_point(tree_route[i], ncor);
+            if (*min_x > pt->x) *min_x = pt->x;
+            if (*min_y > pt->y) *min_y = pt->y;
+            if (*max_x < pt->x) *max_x = pt->x;
+            if (*max_y < pt->y) *max_y = pt->y;
+        }
+    }
+}
+
+/**
+ * Returns whether a route for given creature between given positions exists.
+ * Gives the same answer as ariadne_count_waypoints_on_creature_route_to_target_f(), but uses
+ * reachability cache so that repeated queries are answered without routing.
+ */
+TbBool ariadne_creature_can_reach_target_f(const struct Thing *thing,
+    const struct Coord3d *srcpos, const struct Coord3d *dstpos, AriadneRouteFlags flags, const char *func_name)
+{
+    struct Path path;
+    long nav_sizexy;
+    NAVIDBG(18,"%s: The %s index %d from %3d,%3d to %3d,%3d", func_name, thing_model_name(thing), (int)thing->index,
+        (int)srcpos->x.stl.num, (int)srcpos->y.stl.num, (int)dstpos->x.stl.num, (int)dstpos->y.stl.num);
+    nav_sizexy = thing_nav_block_sizexy(thing);
+    if (nav_sizexy > 0) nav_sizexy--;
+    PlayerNumber owner = ((flags & AridRtF_NoOwner) != 0) ? -1 : thing->owner;
+    TbBool can_travel_over_lava = creature_can_travel_over_lava(thing);
+    long tri_beg = triangle_findSE8(srcpos->x.val, srcpos->y.val);
+    long tri_end = triangle_findSE8(dstpos->x.val, dstpos->y.val);
+    unsigned short rules = reach_cache_rules(nav_sizexy, owner, can_travel_over_lava);
+    if ((tri_beg != -1) && (tri_end != -1))
+    {
+        short cached = reach_cache_get(tri_beg, tri_end, rules);
+        if (cached >= 0) {
+            NAVIDBG(19,"%s: Cached answer %d",func_name,(int)cached);
+            return (cached > 0);
+        }
+    }
+    LbMemorySet(&path, 0, sizeof(struct Path));
+    // Set the required parameters
+    nav_thing_can_travel_over_lava = can_travel_over_lava;
+    owner_player_navigating = owner;
+    // Find the path
+    path_init8_wide_f(&path, srcpos->x.val, srcpos->y.val,
+        dstpos->x.val, dstpos->y.val, -2, nav_sizexy, func_name);
+    // Reset globals
+    nav_thing_can_travel_over_lava = 0;
+    owner_player_navigating = -1;
+    if ((tree_triA == -1) || (tree_triB == -1)) {
+        return false;
+    }
+    if (path.waypoints_num > 0)
+    {
+        long min_x;
+        long min_y;
+        long max_x;
+        long max_y;
+        tree_route_bounds(&min_x, &min_y, &max_x, &max_y);
+        reach_cache_put_reachable(tree_triA, tree_triB, rules, min_x, min_y, max_x, max_y);
+    } else
+    {
+        reach_cache_put_unreachable(tree_triA, tree_triB, rules);
+    }
+    NAVIDBG(19,"%s: Finished, %d waypoints",func_name,(int)path.waypoints_num);
+    return (path.waypoints_num > 0);
+}
+
 AriadneReturn ariadne_invalidate_creature_route(struct Thing *thing)
 {
     struct CreatureControl *cctrl;
@@ -3552,6 +3632,8 @@ static long delete_4point(long tri1_id, long cor1_id)
         tri_dispose(tri4_id);
         edgelen_set(tri1_id);
         edgelen_set(tri3_id);
+        triangle_find_cache_update(tri1_id);
+        triangle_find_cache_update(tri3_id);
     }
     else
     {
@@ -3586,6 +3668,8 @@ static long delete_4point(long tri1_id, long cor1_id)
         tri_dispose(tri1_id);
         edgelen_set(tri2_id);
         edgelen_set(tri4_id);
+        triangle_find_cache_update(tri2_id);
+        triangle_find_cache_update(tri4_id);
     }
     point_dispose(del_pt_id);
     return 1;
@@ -3650,6 +3734,7 @@ static long delete_3point(long tri1_id, long cor1_id)
     tri_dispose(tri2_id);
     tri_dispose(tri3_id);
     edgelen_set(tri1_id);
+    triangle_find_cache_update(tri1_id);
     point_dispose(del_pt_id);
     return true;
 }
@@ -3764,6 +3849,9 @@ long tri_split3(long btri_id, long pt_x, long pt_y)
     edgelen_set(btri_id);
     edgelen_set(tri_id1);
     edgelen_set(tri_id2);
+    triangle_find_cache_update(btri_id);
+    triangle_find_cache_update(tri_id1);
+    triangle_find_cache_update(tri_id2);
     return pt_id;
 }
 
@@ -3809,6 +3897,8 @@ long tri_split2(long tri_id1, long cor_id1, long pt_x, long pt_y, long pt_id1)
     tri2->field_E = 0;
     edgelen_set(tri_id1);
     edgelen_set(tri_id2);
+    triangle_find_cache_update(tri_id1);
+    triangle_find_cache_update(tri_id2);
     return tri_id2;
 }
 
@@ -4965,6 +5055,11 @@ TbBool triangulate_area(NavColour *imap, long start_x, long start_y, long end_x,
         end_y = gameadd.map_subtiles_y + 1;
     }
     triangulation_init();
+    // Routes crossing the updated area are no longer known to exist
+    if (not_whole_map)
+        reach_cache_invalidate_area(start_x, start_y, end_x, end_y);
+    else
+        reach_cache_clear();
     if ( not_whole_map )
     {
         r &= border_clip_horizontal(imap, start_x, end_x, start_y, 0);
@@ -31,55 +31,56 @@
 extern "C" {
 #endif
 /******************************************************************************/
-static long find_cache[4][4];
+/** Triangle location grid; every cell stores a triangle lying close to it.
+ * Cells cover FIND_CACHE_CELL_SUBTILES x FIND_CACHE_CELL_SUBTILES subtiles, so
+ * the walk in triangle_find8() starts in the neighbourhood of the searched point.
+ */
+static long find_cache[FIND_CACHE_CELLS_Y][FIND_CACHE_CELLS_X];
 
 /******************************************************************************/
+static long find_cache_cell_x(long pos_x)
+{
+    long cache_x = (pos_x >> FIND_CACHE_CELL_SHIFT);
+    if (cache_x >= FIND_CACHE_CELLS_X)
+        cache_x = FIND_CACHE_CELLS_X-1;
+    if (cache_x < 0)
+        cache_x = 0;
+    return cache_x;
+}
+
+static long find_cache_cell_y(long pos_y)
+{
+    long cache_y = (pos_y >> FIND_CACHE_CELL_SHIFT);
+    if (cache_y >= FIND_CACHE_CELLS_Y)
+        cache_y = FIND_CACHE_CELLS_Y-1;
+    if (cache_y < 0)
+        cache_y = 0;
+    return cache_y;
+}
+
 long triangle_brute_find8_near(long pos_x, long pos_y)
 {
-    long cx = pos_x >> 14;
-    if (cx < 0)
-        cx = 0;
-    if (cx > 3)
-        cx = 3;
-    long cy = pos_y >> 14;
-    if (cy < 0)
-        cy = 0;
-    if (cy > 3)
-        cy = 3;
-   // Try sibling
+    long cx = find_cache_cell_x(pos_x);
+    long cy = find_cache_cell_y(pos_y);
+    // Try siblings, in rings of growing radius
     long tri_id;
-    if (cx-1 >= 0)
-    {
-        tri_id = find_cache[cy][cx-1];
-        if (get_triangle_tree_alt(tri_id) != NAV_COL_UNSET)
-            return tri_id;
-    }
-    if (cx+1 < 4)
-    {
-        tri_id = find_cache[cy][cx+1];
-        if (get_triangle_tree_alt(tri_id) != NAV_COL_UNSET)
-            return tri_id;
-    }
-    if (cy-1 >= 0)
+    for (long radius = 1; radius <= FIND_CACHE_NEAR_RADIUS; radius++)
     {
-        tri_id = find_cache[cy-1][cx];
-        if (get_triangle_tree_alt(tri_id) != NAV_COL_UNSET)
-            return tri_id;
-    }
-    if (cy+1 < 4)
-    {
-        tri_id = find_cache[cy+1][cx];
-        if (get_triangle_tree_alt(tri_id) != NAV_COL_UNSET)
-            return tri_id;
-    }
-    // Try any in cache
-    for (cy=0; cy < 4; cy++)
-    {
-        for (cx=0; cx < 4; cx++)
+        for (long dy = -radius; dy <= radius; dy++)
         {
-            tri_id = find_cache[cy][cx];
-            if (get_triangle_tree_alt(tri_id) != NAV_COL_UNSET)
-                return tri_id;
+            long ny = cy + dy;
+            if ((ny < 0) || (ny >= FIND_CACHE_CELLS_Y))
+                continue;
+            long step = ((dy == -radius) || (dy == radius)) ? 1 : 2*radius;
+            for (long dx = -radius; dx <= radius; dx += step)
+            {
+                long nx = cx + dx;
+                if ((nx < 0) || (nx >= FIND_CACHE_CELLS_X))
+                    continue;
+                tri_id = find_cache[ny][nx];
+                if (get_triangle_tree_alt(tri_id) != NAV_COL_UNSET)
+                    return tri_id;
+            }
         }
     }
     // Try any
@@ -89,17 +90,8 @@ long triangle_brute_find8_near(long pos_x, long pos_y)
 
 long triangle_find_cache_get(long pos_x, long pos_y)
 {
-    long cache_x = (pos_x >> 14);
-    if (cache_x > 3)
-        cache_x = 3;
-    if (cache_x < 0)
-        cache_x = 0;
-    long cache_y = (pos_y >> 14);
-    if (cache_y > 3)
-        cache_y = 3;
-    if (cache_y < 0)
-        cache_y = 0;
-
+    long cache_x = find_cache_cell_x(pos_x);
+    long cache_y = find_cache_cell_y(pos_y);
     long ntri = find_cache[cache_y][cache_x];
     if (get_triangle_tree_alt(ntri) == NAV_COL_UNSET)
     {
@@ -110,34 +102,46 @@ long triangle_find_cache_get(long pos_x, long pos_y)
             ntri = -1;
         }
         find_cache[cache_y][cache_x] = ntri;
-  }
-  return ntri;
-
+    }
+    return ntri;
 }
 
 void triangle_find_cache_put(long pos_x, long pos_y, long ntri)
 {
-    long cache_x = (pos_x >> 14);
-    if (cache_x > 3)
-        cache_x = 3;
-    if (cache_x < 0)
-        cache_x = 0;
-    long cache_y = (pos_y >> 14);
-    if (cache_y > 3)
-        cache_y = 3;
-    if (cache_y < 0)
-        cache_y = 0;
+    long cache_x = find_cache_cell_x(pos_x);
+    long cache_y = find_cache_cell_y(pos_y);
     find_cache[cache_y][cache_x] = ntri;
 }
 
+/**
+ * Stores given triangle in the grid cell which contains its centroid.
+ * To be called whenever triangulation creates or reshapes a triangle, so that
+ * the grid follows the triangulation without being rebuilt.
+ * @param tri_idx Triangle index.
+ */
+void triangle_find_cache_update(long tri_idx)
+{
+    if ((tri_idx < 0) || (tri_idx >= TRIANLGLES_COUNT))
+        return;
+    long pos_x = 0;
+    long pos_y = 0;
+    for (long ncor = 0; ncor < 3; ncor++)
+    {
+        struct Point* pt = get_triangle_point(tri_idx, ncor);
+        pos_x += pt->x;
+        pos_y += pt->y;
+    }
+    triangle_find_cache_put((pos_x << 8) / 3, (pos_y << 8) / 3, tri_idx);
+}
+
 void triangulation_init_cache(long tri_idx)
 {
-    for (long i = 0; i < 4; i++)
+    for (long cy = 0; cy < FIND_CACHE_CELLS_Y; cy++)
     {
-        find_cache[i][0] = tri_idx;
-        find_cache[i][1] = tri_idx;
-        find_cache[i][2] = tri_idx;
-        find_cache[i][3] = tri_idx;
+        for (long cx = 0; cx < FIND_CACHE_CELLS_X; cx++)
+        {
+            find_cache[cy][cx] = tri_idx;
+        }
     }
 }
 
@@ -27,6 +27,14 @@ extern "C" {
 #endif
 
 /******************************************************************************/
+/** Size of a triangle location grid cell, as shift of a coordinate in 1/256 subtile units. */
+#define FIND_CACHE_CELL_SHIFT 10
+#define FIND_CACHE_CELL_SUBTILES (1 << (FIND_CACHE_CELL_SHIFT - 8))
+#define FIND_CACHE_CELLS_X ((MAX_SUBTILES_X + FIND_CACHE_CELL_SUBTILES) / FIND_CACHE_CELL_SUBTILES)
+#define FIND_CACHE_CELLS_Y ((MAX_SUBTILES_Y + FIND_CACHE_CELL_SUBTILES) / FIND_CACHE_CELL_SUBTILES)
+/** Amount of cell rings checked around a stale cell before falling back to any used triangle. */
+#define FIND_CACHE_NEAR_RADIUS 2
+
 #pragma pack(1)
 
 
@@ -34,6 +42,7 @@ extern "C" {
 /******************************************************************************/
 long triangle_find_cache_get(long pos_x, long pos_y);
 void triangle_find_cache_put(long pos_x, long pos_y, long ntri);
+void triangle_find_cache_update(long tri_idx);
 
 void triangulation_init_cache(long tri_idx);
 
@@ -39,6 +39,10 @@ static long ix_RegionQput;
 static long ix_RegionQget;
 static long count_RegionQ;
 static long RegionQueue[REGION_QUEUE_LEN];
+/** Reachability cache; entries are placed at position based on hash of the key. */
+static struct ReachCacheEntry ReachCache[REACH_CACHE_LEN];
+/** Current generation of unreachable entries; increased on every triangulation change. */
+static unsigned long reach_cache_generation = 1;
 /******************************************************************************/
 struct RegionT bad_region;
 /******************************************************************************/
@@ -314,6 +318,97 @@ void region_unlock(long ntri)
     }
 }
 
+/******************************************************************************/
+/**
+ * Packs routing rules which influence whether a route exists into reachability cache key.
+ * @param nav_size Navigation block size of the creature, as given to path_init8_wide_f().
+ * @param owner Owner whose doors may be passed, or -1 if owner rules are ignored.
+ * @param can_travel_over_lava Whether the creature may enter lava.
+ */
+unsigned short reach_cache_rules(long nav_size, PlayerNumber owner, TbBool can_travel_over_lava)
+{
+    return (unsigned short)(((nav_size & 0x0F) << 8) | (((owner + 1) & 0x0F) << 4) | (can_travel_over_lava ? 1 : 0));
+}
+
+static unsigned long reach_cache_hash(long tri_beg, long tri_end, unsigned short rules)
+{
+    unsigned long hash = (unsigned long)tri_beg * 2654435761UL;
+    hash ^= (unsigned long)tri_end * 40503UL + rules;
+    hash ^= (hash >> 13);
+    return hash & (REACH_CACHE_LEN - 1);
+}
+
+/**
+ * Checks reachability cache for a route between given triangles.
+ * @return Returns 1 if the route exists, 0 if it doesn't, or -1 if the answer is not cached.
+ */
+short reach_cache_get(long tri_beg, long tri_end, unsigned short rules)
+{
+    struct ReachCacheEntry* rcentry = &ReachCache[reach_cache_hash(tri_beg, tri_end, rules)];
+    if ((rcentry->generation == 0) || (rcentry->tri_beg != tri_beg) || (rcentry->tri_end != tri_end) || (rcentry->rules != rules))
+        return -1;
+    if (rcentry->reachable)
+        return 1;
+    // Unreachable entries may be invalidated by any change in triangulation
+    if (rcentry->generation != reach_cache_generation)
+        return -1;
+    return 0;
+}
+
+void reach_cache_put_reachable(long tri_beg, long tri_end, unsigned short rules, long min_x, long min_y, long max_x, long max_y)
+{
+    struct ReachCacheEntry* rcentry = &ReachCache[reach_cache_hash(tri_beg, tri_end, rules)];
+    rcentry->tri_beg = tri_beg;
+    rcentry->tri_end = tri_end;
+    rcentry->rules = rules;
+    rcentry->reachable = 1;
+    rcentry->generation = reach_cache_generation;
+    rcentry->min_x = min_x;
+    rcentry->min_y = min_y;
+    rcentry->max_x = max_x;
+    rcentry->max_y = max_y;
+}
+
+void reach_cache_put_unreachable(long tri_beg, long tri_end, unsigned short rules)
+{
+    struct ReachCacheEntry* rcentry = &ReachCache[reach_cache_hash(tri_beg, tri_end, rules)];
+    rcentry->tri_beg = tri_beg;
+    rcentry->tri_end = tri_end;
+    rcentry->rules = rules;
+    rcentry->reachable = 0;
+    rcentry->generation = reach_cache_generation;
+}
+
+/**
+ * Invalidates reachability cache entries which may be affected by re-triangulating given area.
+ * Reachable entries survive if their route is outside of the area; unreachable ones never do.
+ */
+void reach_cache_invalidate_area(long start_x, long start_y, long end_x, long end_y)
+{
+    NAVIDBG(19,"Area from (%03ld,%03ld) to (%03ld,%03ld)",start_x,start_y,end_x,end_y);
+    reach_cache_generation++;
+    if (reach_cache_generation == 0)
+    {
+        reach_cache_clear();
+        return;
+    }
+    for (long i = 0; i < REACH_CACHE_LEN; i++)
+    {
+        struct ReachCacheEntry* rcentry = &ReachCache[i];
+        if ((rcentry->generation == 0) || (!rcentry->reachable))
+            continue;
+        // Triangles touching the area border may be split too, so the comparison is inclusive
+        if ((rcentry->max_x < start_x) || (rcentry->min_x > end_x) || (rcentry->max_y < start_y) || (rcentry->min_y > end_y))
+            continue;
+        rcentry->generation = 0;
+    }
+}
+
+void reach_cache_clear(void)
+{
+    memset(ReachCache, 0, sizeof(ReachCache));
+    reach_cache_generation = 1;
+}
 /******************************************************************************/
 #ifdef __cplusplus
 }
@@ -24,6 +24,8 @@
 
 #define REGIONS_COUNT        300
 #define REGION_QUEUE_LEN     200
+/** Amount of entries in reachability cache; needs to be power of 2. */
+#define REACH_CACHE_LEN     2048
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +40,21 @@ struct RegionT { // sizeof = 3
 };
 
 #pragma pack()
+
+/** Reachability cache entry, storing whether a route between two triangles exists.
+ * For reachable entries, bounding box of all triangles on the route is stored,
+ * so that the entry can outlive triangulation updates outside of that box. */
+struct ReachCacheEntry {
+  long tri_beg;
+  long tri_end;
+  unsigned short rules;
+  unsigned char reachable;
+  unsigned long generation;
+  short min_x;
+  short min_y;
+  short max_x;
+  short max_y;
+};
 /******************************************************************************/
 extern struct RegionT bad_region;
 #define INVALID_REGION &bad_region;
@@ -53,6 +70,13 @@ void region_unset_f(long ntri, unsigned long nreg, const char *func_name);
 void region_unlock(long ntri);
 void triangulation_init_regions(void);
 
+unsigned short reach_cache_rules(long nav_size, PlayerNumber owner, TbBool can_travel_over_lava);
+short reach_cache_get(long tri_beg, long tri_end, unsigned short rules);
+void reach_cache_put_reachable(long tri_beg, long tri_end, unsigned short rules, long min_x, long min_y, long max_x, long max_y);
+void reach_cache_put_unreachable(long tri_beg, long tri_end, unsigned short rules);
+void reach_cache_invalidate_area(long start_x, long start_y, long end_x, long end_y);
+void reach_cache_clear(void);
+
 /******************************************************************************/
 #ifdef __cplusplus
 }
@@ -173,22 +173,97 @@ short error_dialog_fatal(const char *codefile,const int ecode,const char *messag
   return 0;
 }
 
+/******************************************************************************/
+/** Max length of a line written by the background log writer; longer lines are truncated. */
+#define LOG_QUEUE_LINE_LEN 1024
+/** Amount of lines the buffer of background log writer can hold. */
+#define LOG_QUEUE_LINES_COUNT 1024
+/** How long a crash handler waits for the background writer to finish its lines, in milliseconds. */
+#define LOG_QUEUE_CRASH_WAIT 500
+
+struct LogQueueLine {
+    /** Equal to queue position if the line is free, or to position+1 if it's filled and waits for writing. */
+    SDL_atomic_t sequence;
+    char text[LOG_QUEUE_LINE_LEN];
+};
+
+/**
+ * Lock-free ring buffer of log lines, filled by any thread and written into file
+ * by the background writer thread.
+ */
+struct LogQueue {
+    struct LogQueueLine *lines;
+    SDL_atomic_t mode;
+    /** Position of next line to be filled; lines are reserved by increasing it. */
+    SDL_atomic_t write_pos;
+    /** Position of next line to be written; only changed while holding file_lock. */
+    unsigned int read_pos;
+    SDL_atomic_t dropped_count;
+    SDL_SpinLock file_lock;
+    SDL_sem *pending;
+    SDL_Thread *thread;
+    SDL_atomic_t quit;
+    /** Set after a crash; lines are then written immediately, by the thread which logs them. */
+    SDL_atomic_t bypass;
+};
 /******************************************************************************/
 short error_log_initialised=false;
 struct TbLog error_log;
+static struct LogQueue log_queue;
+/** Serializes logging threads; the log prefix and the live viewing array are shared by all of them. */
+static SDL_SpinLock log_entry_lock;
 /******************************************************************************/
 int LbLog(struct TbLog *log, const char *fmt_str, va_list arg);
 /******************************************************************************/
 
+static TbBool log_lock(SDL_SpinLock *lock, TbBool crashing)
+{
+    if (!crashing)
+    {
+        SDL_AtomicLock(lock);
+        return true;
+    }
+    // The thread holding the lock may be the one which crashed, so don't wait for it forever
+    for (int i = 0; i < LOG_QUEUE_CRASH_WAIT; i++)
+    {
+        if (SDL_AtomicTryLock(lock))
+            return true;
+        SDL_Delay(1);
+    }
+    return false;
+}
+
+static TbBool log_queue_lock_file(TbBool crashing)
+{
+    return log_lock(&log_queue.file_lock, crashing);
+}
+
+/**
+ * Starts a log entry. After a crash, the entry is logged even if the lock couldn't be taken.
+ * @return True if the lock was taken and should be given back by log_entry_end().
+ */
+static TbBool log_entry_begin(void)
+{
+    return log_lock(&log_entry_lock, SDL_AtomicGet(&log_queue.bypass) != 0);
+}
+
+static void log_entry_end(TbBool locked)
+{
+    if (locked)
+        SDL_AtomicUnlock(&log_entry_lock);
+}
+
 int LbErrorLog(const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefix(&error_log, "Error: ");
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -196,11 +271,13 @@ int LbWarnLog(const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefix(&error_log, "Warning: ");
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -208,11 +285,13 @@ int LbAiLog(const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefix(&error_log, "Skirmish AI: ");
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -220,11 +299,13 @@ int LbNetLog(const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefix(&error_log, "Net: ");
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -232,11 +313,13 @@ int LbSyncLog(const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefix(&error_log, "Sync: ");
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -244,11 +327,13 @@ int LbNaviLog(const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefix(&error_log, "Navi: ");
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -266,11 +351,13 @@ int LbFTestLog(const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefix(&error_log, "FTest: ");
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 #endif
@@ -282,11 +369,13 @@ int LbScriptLog(unsigned long line,const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefixFmt(&error_log, "Script(line %lu): ",line);
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -297,11 +386,13 @@ int LbConfigLog(unsigned long line,const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefixFmt(&error_log, "Config(line %lu): ",line);
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -309,11 +400,13 @@ int LbJustLog(const char *format, ...)
 {
     if (!error_log_initialised)
         return -1;
+    TbBool locked = log_entry_begin();
     LbLogSetPrefix(&error_log, "");
     va_list val;
     va_start(val, format);
     int result=LbLog(&error_log, format, val);
     va_end(val);
+    log_entry_end(locked);
     return result;
 }
 
@@ -347,34 +440,260 @@ int LbErrorLogClose(void)
 {
     if (!error_log_initialised)
         return -1;
+    LbLogQueueSetup(LbLogQueue_Off);
     return LbLogClose(&error_log);
 }
 
 FILE *file = NULL;
 
+/**
+ * Writes all lines waiting in the queue into log file. Caller should hold file_lock.
+ */
+static void log_queue_write_lines(void)
+{
+    TbBool written = false;
+    while (1)
+    {
+        struct LogQueueLine *line = &log_queue.lines[log_queue.read_pos % LOG_QUEUE_LINES_COUNT];
+        // Stop if the queue is empty, or the line is still being filled
+        if (SDL_AtomicGet(&line->sequence) != (int)(log_queue.read_pos + 1))
+            break;
+        if (file != NULL)
+            fputs(line->text, file);
+        SDL_AtomicSet(&line->sequence, (int)(log_queue.read_pos + LOG_QUEUE_LINES_COUNT));
+        log_queue.read_pos++;
+        written = true;
+    }
+    int dropped = SDL_AtomicSet(&log_queue.dropped_count, 0);
+    if ((dropped > 0) && (file != NULL))
+    {
+        fprintf(file, "Skipped %d log lines, as the log buffer was full\n", dropped);
+        written = true;
+    }
+    if (written && (file != NULL))
+        fflush(file);
+}
+
+/**
+ * Puts a line into the queue of background writer.
+ * @return True if the line was queued or skipped according to queue mode, false if it should be written directly.
+ */
+static TbBool log_queue_add(const char *text)
+{
+    unsigned int pos = SDL_AtomicGet(&log_queue.write_pos);
+    while (1)
+    {
+        struct LogQueueLine *line = &log_queue.lines[pos % LOG_QUEUE_LINES_COUNT];
+        int dif = SDL_AtomicGet(&line->sequence) - (int)pos;
+        if (dif == 0)
+        {
+            if (SDL_AtomicCAS(&log_queue.write_pos, pos, pos + 1))
+            {
+                snprintf(line->text, LOG_QUEUE_LINE_LEN, "%s", text);
+                SDL_AtomicSet(&line->sequence, (int)(pos + 1));
+                break;
+            }
+        } else
+        if (dif < 0)
+        {
+            // The buffer is full
+            if (SDL_AtomicGet(&log_queue.bypass) != 0)
+                return false;
+            if (SDL_AtomicGet(&log_queue.mode) == LbLogQueue_Drop)
+            {
+                SDL_AtomicIncRef(&log_queue.dropped_count);
+                return true;
+            }
+            SDL_SemPost(log_queue.pending);
+            SDL_Delay(1);
+        }
+        pos = SDL_AtomicGet(&log_queue.write_pos);
+    }
+    if (SDL_SemValue(log_queue.pending) == 0)
+        SDL_SemPost(log_queue.pending);
+    return true;
+}
+
+static int log_queue_writer(void *arg)
+{
+    while (SDL_AtomicGet(&log_queue.quit) == 0)
+    {
+        SDL_SemWaitTimeout(log_queue.pending, 100);
+        SDL_AtomicLock(&log_queue.file_lock);
+        log_queue_write_lines();
+        SDL_AtomicUnlock(&log_queue.file_lock);
+    }
+    return 0;
+}
+
+/**
+ * Starts or stops writing the log in background thread, or changes what happens when its buffer is full.
+ * Stopping writes all queued lines first.
+ */
+TbBool LbLogQueueSetup(enum TbLogQueueMode mode)
+{
+    if (mode == LbLogQueue_Off)
+    {
+        if (log_queue.lines == NULL)
+            return true;
+        if (SDL_AtomicGet(&log_queue.bypass) != 0)
+        {
+            // After a crash, only make sure everything is written
+            LbLogQueueFlush();
+            return true;
+        }
+        SDL_AtomicSet(&log_queue.quit, 1);
+        SDL_SemPost(log_queue.pending);
+        SDL_WaitThread(log_queue.thread, NULL);
+        log_queue.thread = NULL;
+        log_queue_write_lines();
+        SDL_DestroySemaphore(log_queue.pending);
+        log_queue.pending = NULL;
+        free(log_queue.lines);
+        log_queue.lines = NULL;
+        return true;
+    }
+    if (log_queue.lines != NULL)
+    {
+        SDL_AtomicSet(&log_queue.mode, mode);
+        return true;
+    }
+    log_queue.lines = (struct LogQueueLine *)calloc(LOG_QUEUE_LINES_COUNT, sizeof(struct LogQueueLine));
+    if (log_queue.lines == NULL)
+        return false;
+    for (int i = 0; i < LOG_QUEUE_LINES_COUNT; i++)
+        SDL_AtomicSet(&log_queue.lines[i].sequence, i);
+    SDL_AtomicSet(&log_queue.write_pos, 0);
+    log_queue.read_pos = 0;
+    SDL_AtomicSet(&log_queue.dropped_count, 0);
+    SDL_AtomicSet(&log_queue.quit, 0);
+    SDL_AtomicSet(&log_queue.bypass, 0);
+    SDL_AtomicSet(&log_queue.mode, mode);
+    log_queue.pending = SDL_CreateSemaphore(0);
+    if (log_queue.pending != NULL)
+        log_queue.thread = SDL_CreateThread(log_queue_writer, "LogWriter", NULL);
+    if (log_queue.thread == NULL)
+    {
+        if (log_queue.pending != NULL)
+            SDL_DestroySemaphore(log_queue.pending);
+        log_queue.pending = NULL;
+        free(log_queue.lines);
+        log_queue.lines = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Writes all queued log lines immediately, and makes all further lines to be written without queuing.
+ * To be used by crash handlers - it doesn't wait for the writer thread to end.
+ */
+void LbLogQueueFlush(void)
+{
+    if (log_queue.lines == NULL)
+    {
+        if (file != NULL)
+            fflush(file);
+        return;
+    }
+    SDL_AtomicSet(&log_queue.bypass, 1);
+    // If the writer thread doesn't give back the lock, it's stuck while writing; leave the file to it
+    if (!log_queue_lock_file(true))
+        return;
+    log_queue_write_lines();
+    SDL_AtomicUnlock(&log_queue.file_lock);
+}
+
 void LbCloseLog()
 {
-    fclose(file);
+    TbBool locked = false;
+    if (log_queue.lines != NULL)
+    {
+        // Only wait for a limited time if we're closing after a crash
+        locked = log_queue_lock_file(SDL_AtomicGet(&log_queue.bypass) != 0);
+        if (!locked)
+            return;
+        log_queue_write_lines();
+    }
+    if (file != NULL)
+        fclose(file);
     file = NULL;
+    if (locked)
+        SDL_AtomicUnlock(&log_queue.file_lock);
 }
 
-void write_log_to_array_for_live_viewing(const char* fmt_str, va_list args, const char* add_log_prefix) {
+static void write_line_to_array_for_live_viewing(const char *text)
+{
     if (consoleLogArraySize >= MAX_CONSOLE_LOG_COUNT) {
         // Array is full - so clear it. This is a bit of a stopgap solution, it will lose us the older entries.
         memset(consoleLogArray, 0, sizeof(consoleLogArray));
         consoleLogArraySize = 0;
     }
+    // Add the combined message to the array
+    strncpy(consoleLogArray[consoleLogArraySize], text, MAX_TEXT_LENGTH);
+    consoleLogArray[consoleLogArraySize][MAX_TEXT_LENGTH - 1] = '\0';
+    consoleLogArraySize++;
+}
 
+void write_log_to_array_for_live_viewing(const char* fmt_str, va_list args, const char* add_log_prefix) {
     char formattedString[MAX_TEXT_LENGTH];
     vsnprintf(formattedString, sizeof(formattedString), fmt_str, args);
 
     char buffer[MAX_TEXT_LENGTH];
     snprintf(buffer, sizeof(buffer), "%s%s", add_log_prefix, formattedString); // merge prefix and formatted string
+    write_line_to_array_for_live_viewing(buffer);
+}
 
-    // Add the combined message to the array
-    strncpy(consoleLogArray[consoleLogArraySize], buffer, MAX_TEXT_LENGTH);
-    consoleLogArray[consoleLogArraySize][MAX_TEXT_LENGTH - 1] = '\0';
-    consoleLogArraySize++;
+/**
+ * Gives the text to the background writer. After a crash, writes it directly,
+ * after lines which are still in the queue.
+ */
+static void log_queue_put(const char *text)
+{
+    if ((SDL_AtomicGet(&log_queue.bypass) == 0) && log_queue_add(text))
+        return;
+    if (!log_queue_lock_file(true))
+        return;
+    log_queue_write_lines();
+    if (file != NULL)
+    {
+        fputs(text, file);
+        fflush(file);
+    }
+    SDL_AtomicUnlock(&log_queue.file_lock);
+}
+
+/**
+ * Formats the log line and gives it to the background writer.
+ */
+static void log_queue_add_formatted(struct TbLog *log, const char *fmt_str, va_list arg)
+{
+    char text[LOG_QUEUE_LINE_LEN];
+    int len = 0;
+    if ((log->flags & LbLog_DateInLines) != 0)
+    {
+        struct TbDate curr_date;
+        LbDate(&curr_date);
+        len += snprintf(text + len, sizeof(text) - len, "%02d-%02d-%d ",curr_date.Day,curr_date.Month,curr_date.Year);
+    }
+    if ((log->flags & LbLog_TimeInLines) != 0)
+    {
+        struct TbTime curr_time;
+        LbTime(&curr_time);
+        len += snprintf(text + len, sizeof(text) - len, "%02d:%02d:%02d ",
+            curr_time.Hour,curr_time.Minute,curr_time.Second);
+    }
+    int msg_pos = len;
+    len += snprintf(text + len, sizeof(text) - len, "%s", log->prefix);
+    len += vsnprintf(text + len, sizeof(text) - len, fmt_str, arg);
+    if (len >= (int)sizeof(text) - 1)
+    {
+        // Truncated - make sure the next line still starts in new line
+        text[sizeof(text) - 2] = '\n';
+        text[sizeof(text) - 1] = '\0';
+    }
+    write_line_to_array_for_live_viewing(&text[msg_pos]);
+    log_queue_put(text);
 }
 
 int LbLog(struct TbLog *log, const char *fmt_str, va_list arg)
@@ -425,24 +744,27 @@ int LbLog(struct TbLog *log, const char *fmt_str, va_list arg)
     log->Created = true;
     if (header != NONE)
     {
+      // Header goes the same way as log lines, so it can't be written before lines queued earlier
+      char text[LOG_QUEUE_LINE_LEN];
+      int len = 0;
       if ( need_initial_newline )
-        fprintf(file, "\n");
+        len += snprintf(text + len, sizeof(text) - len, "\n");
       const char *actn;
       if (header == CREATE)
       {
-        fprintf(file, PROGRAM_NAME" ver "VER_STRING" (%s release) git:%s\n", (BFDEBUG_LEVEL>7)?"heavylog":"standard", GIT_REVISION);
+        len += snprintf(text + len, sizeof(text) - len, PROGRAM_NAME" ver "VER_STRING" (%s release) git:%s\n", (BFDEBUG_LEVEL>7)?"heavylog":"standard", GIT_REVISION);
         actn = "CREATED";
       } else
       {
         actn = "APPENDED";
       }
-      fprintf(file, "LOG %s", actn);
+      len += snprintf(text + len, sizeof(text) - len, "LOG %s", actn);
       short at_used = 0;
       if ((log->flags & LbLog_TimeInHeader) != 0)
       {
         struct TbTime curr_time;
         LbTime(&curr_time);
-        fprintf(file, "  @ %02d:%02d:%02d",
+        len += snprintf(text + len, sizeof(text) - len, "  @ %02d:%02d:%02d",
             curr_time.Hour,curr_time.Minute,curr_time.Second);
         at_used = 1;
       }
@@ -455,9 +777,18 @@ int LbLog(struct TbLog *log, const char *fmt_str, va_list arg)
           sep = " ";
         else
           sep = "  @ ";
-        fprintf(file," %s%02d-%02d-%d",sep,curr_date.Day,curr_date.Month,curr_date.Year);
+        len += snprintf(text + len, sizeof(text) - len, " %s%02d-%02d-%d",sep,curr_date.Day,curr_date.Month,curr_date.Year);
       }
-      fprintf(file, "\n\n");
+      snprintf(text + len, sizeof(text) - len, "\n\n");
+      if (log_queue.lines != NULL)
+        log_queue_put(text);
+      else
+        fputs(text, file);
+    }
+    if (log_queue.lines != NULL)
+    {
+        log_queue_add_formatted(log, fmt_str, arg);
+        return 1;
     }
     if ((log->flags & LbLog_DateInLines) != 0)
     {
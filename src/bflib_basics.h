@@ -55,6 +55,13 @@ enum TbLogFlags {
         LbLog_LoopedFile   = 0x0100,
 };
 
+/** How log lines are written to file. */
+enum TbLogQueueMode {
+        LbLogQueue_Off  = 1, /**< Every line is written and flushed immediately. */
+        LbLogQueue_Wait = 2, /**< Lines are written by background thread; if its buffer is full, logging waits for it. */
+        LbLogQueue_Drop = 3, /**< Lines are written by background thread; if its buffer is full, they are skipped. */
+};
+
 enum TbErrorCode {
     Lb_FAIL                 = -1,
     Lb_OK                   =  0,
@@ -171,6 +178,8 @@ int LbLogSetPrefix(struct TbLog *log, const char *prefix);
 int LbLogSetPrefixFmt(struct TbLog *log, const char *format, ...);
 
 void LbCloseLog();
+TbBool LbLogQueueSetup(enum TbLogQueueMode mode);
+void LbLogQueueFlush(void);
 /******************************************************************************/
 typedef void (*TbNetworkCallbackFunc)(struct TbNetworkCallbackData *, void *);
 /******************************************************************************/
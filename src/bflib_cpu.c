@@ -46,6 +46,21 @@ static inline void cpuid_string(int code, void * destination) {
   asm volatile("cpuid":"=a"(*where),"=b"(*(where+1)),
       "=c"(*(where+2)),"=d"(*(where+3)):"0"(code));
 }
+
+/** Issue a request with sub-leaf to CPUID, storing general registers output in an array.
+ */
+static inline void cpuid_subleaf(int code, int subleaf, uint32_t * where) {
+  asm volatile("cpuid":"=a"(*where),"=b"(*(where+1)),
+      "=c"(*(where+2)),"=d"(*(where+3)):"0"(code),"2"(subleaf));
+}
+
+/** Read extended control register; only valid if OSXSAVE feature is set.
+ */
+static inline uint32_t xgetbv_low(int index) {
+  uint32_t eax, edx;
+  asm volatile("xgetbv":"=a"(eax),"=d"(edx):"c"(index));
+  return eax;
+}
 /******************************************************************************/
 
 void cpu_detect(struct CPU_INFO *cpu)
@@ -56,9 +71,14 @@ void cpu_detect(struct CPU_INFO *cpu)
   cpu->timeStampCounter = 0;
   cpu->feature_intl = 0;
   cpu->feature_edx = 0;
+  cpu->feature_ecx = 0;
+  cpu->feature_ext_ebx = 0;
+  cpu->avx_state_saved = 0;
   {
     uint32_t where[4];
+    uint32_t max_request;
     cpuid_string(CPUID_GETVENDORSTRING, where);
+    max_request = where[0];
     memcpy(&cpu->vendor[0],&where[1],4);
     memcpy(&cpu->vendor[4],&where[3],4);
     memcpy(&cpu->vendor[8],&where[2],4);
@@ -66,6 +86,16 @@ void cpu_detect(struct CPU_INFO *cpu)
     cpuid(CPUID_GETFEATURES, &where[0], &where[3]);
     cpu->feature_intl = where[0];
     cpu->feature_edx = where[3];
+    cpuid_subleaf(CPUID_GETFEATURES, 0, where);
+    cpu->feature_ecx = where[2];
+    // Both SSE and AVX state must be preserved by the OS
+    if ((cpu->feature_ecx & CPUID_FEAT_ECX_OSXSAVE) != 0)
+        cpu->avx_state_saved = ((xgetbv_low(0) & 0x06) == 0x06);
+    if (max_request >= CPUID_GETEXTFEATURES)
+    {
+        cpuid_subleaf(CPUID_GETEXTFEATURES, 0, where);
+        cpu->feature_ext_ebx = where[1];
+    }
     if (cpu_get_family(cpu) >= 5)
     {
       if (cpu->feature_edx & CPUID_FEAT_EDX_TSC)
@@ -129,6 +159,20 @@ unsigned char cpu_get_stepping(struct CPU_INFO *cpu)
   return (cpu->feature_intl) & 0xF;
 }
 
+TbBool cpu_has_sse2(struct CPU_INFO *cpu)
+{
+  return ((cpu->feature_edx & CPUID_FEAT_EDX_SSE2) != 0);
+}
+
+TbBool cpu_has_avx2(struct CPU_INFO *cpu)
+{
+  if (!cpu->avx_state_saved)
+    return 0;
+  if ((cpu->feature_ecx & CPUID_FEAT_ECX_AVX) == 0)
+    return 0;
+  return ((cpu->feature_ext_ebx & CPUID_FEAT_EXT_EBX_AVX2) != 0);
+}
+
 /******************************************************************************/
 #ifdef __cplusplus
 }
@@ -33,6 +33,7 @@ enum cpuid_requests {
   CPUID_GETFEATURES,
   CPUID_GETTLB,
   CPUID_GETSERIAL,
+  CPUID_GETEXTFEATURES = 7,
 
   CPUID_INTELEXTENDED=0x80000000,
   CPUID_INTELFEATURES,
@@ -100,6 +101,11 @@ enum {
     CPUID_FEAT_EDX_PBE          = 1 << 31
 };
 
+// When called with CPUID_GETEXTFEATURES and sub-leaf 0, CPUID returns these bits in EBX.
+enum {
+    CPUID_FEAT_EXT_EBX_AVX2     = 1 << 5,
+};
+
 enum {
     CPUID_TYPE_OEM              = 0x00,
     CPUID_TYPE_OVERDRIVE        = 0x01,
@@ -132,6 +138,10 @@ enum {
 struct CPU_INFO {
   long feature_intl;
   long feature_edx;
+  long feature_ecx;
+  long feature_ext_ebx;
+  /** Whether the OS saves AVX registers on context switch. */
+  TbBool avx_state_saved;
   TbBool timeStampCounter;
   char vendor[17];
   TbBool BrandString;
@@ -144,6 +154,8 @@ unsigned char cpu_get_type(struct CPU_INFO *cpu);
 unsigned char cpu_get_family(struct CPU_INFO *cpu);
 unsigned char cpu_get_model(struct CPU_INFO *cpu);
 unsigned char cpu_get_stepping(struct CPU_INFO *cpu);
+TbBool cpu_has_sse2(struct CPU_INFO *cpu);
+TbBool cpu_has_avx2(struct CPU_INFO *cpu);
 
 
 /******************************************************************************/
@@ -87,11 +87,13 @@ static const char* sigstr(int s)
 void exit_handler(void)
 {
     LbErrorLog("Application exit called.\n");
+    LbLogQueueFlush();
 }
 
 void ctrl_handler(int sig_id)
 {
     signal(sig_id, SIG_DFL);
+    LbLogQueueFlush();
     LbErrorLog("Failure signal: %s.\n",sigstr(sig_id));
     LbScreenReset(true);
     LbErrorLogClose();
@@ -275,6 +277,8 @@ _backtrace(int depth , LPCONTEXT context)
 
 static LONG CALLBACK ctrl_handler_w32(LPEXCEPTION_POINTERS info)
 {
+    // Write queued lines now, and everything after without queuing
+    LbLogQueueFlush();
     switch (info->ExceptionRecord->ExceptionCode) {
     case EXCEPTION_ACCESS_VIOLATION:
         switch (info->ExceptionRecord->ExceptionInformation[0])
@@ -83,6 +83,25 @@ static unsigned long bit_read (bit_stream *bs, unsigned long mask,
 
 static unsigned long mirror(unsigned long x, int n);
 
+// Amount of bits decoded with one lookup by the table-driven decoder
+#define HUF_LOOKUP_BITS 10
+
+typedef struct {
+    uint64_t bitbuf;            /* holds bitcount bits, first one is lowest */
+    int bitcount;
+    unsigned char *in;          /* where next word should be loaded from */
+} bit_stream64;
+
+typedef struct {
+    huf_table huf;
+    /* Code length and value for every combination of first bits; zero length for longer codes */
+    unsigned char lookup_len[1 << HUF_LOOKUP_BITS];
+    unsigned char lookup_val[1 << HUF_LOOKUP_BITS];
+} huf_lookup_table;
+
+static void read_huftable64 (huf_lookup_table *h, bit_stream64 *bs, unsigned char *pend);
+static long huf_read64 (const huf_lookup_table *h, bit_stream64 *bs, unsigned char *pend);
+
 /*
  * Return an error string corresponding to an error return code.
  */
@@ -109,11 +128,13 @@ const char *rnc_error (long errcode) {
 
 // Decompress a packed data block. Returns the unpacked length if
 // successful, or negative error codes if not.
+// This version reads the bit stream one Huffman code at a time;
+// it is kept as reference for rnc_unpack().
 
 // If COMPRESSOR is defined, it also returns the leeway number
 // (which gets stored at offset 16 into the compressed-file header)
 // in `*leeway', if `leeway' isn't NULL.
-long rnc_unpack (const void *packed, void *unpacked, unsigned int flags
+long rnc_unpack_bitwise (const void *packed, void *unpacked, unsigned int flags
 #ifdef COMPRESSOR
          , long *leeway
 #endif
@@ -396,6 +417,336 @@ static unsigned long bit_read (bit_stream *bs, unsigned long mask,
     return result;
 }
 
+// Loads words into the 64-bit buffer, so that any single code with its extra bits can be read.
+// Checks pend for proper buffer pointers range, the same way bit_advance() does; words
+// after pend are read as zeros, so no more input is read than by the bitwise decoder.
+static inline void bit_refill64 (bit_stream64 *bs, unsigned char *pend)
+{
+    while (bs->bitcount <= 48)
+    {
+        if (pend - bs->in >= 0)
+            bs->bitbuf |= (uint64_t)(bs->in[0] | (bs->in[1] << 8)) << bs->bitcount;
+        bs->in += 2;
+        bs->bitcount += 16;
+    }
+}
+
+static inline unsigned long bit_read64 (bit_stream64 *bs, int n, unsigned char *pend)
+{
+    bit_refill64(bs, pend);
+    unsigned long result = bs->bitbuf & ((1UL << n) - 1);
+    bs->bitbuf >>= n;
+    bs->bitcount -= n;
+    return result;
+}
+
+// Gives position of the first word which has no bits read from it; that's where
+// the bitwise decoder keeps its data pointer, and where literals start.
+static inline unsigned char *bit_position64 (const bit_stream64 *bs)
+{
+    return bs->in - 2 * (bs->bitcount / 16);
+}
+
+// Drops the words which were loaded from where literals are, and continues after them.
+static inline void bitread_fix64 (bit_stream64 *bs, unsigned char *p)
+{
+    bs->bitcount %= 16;
+    bs->bitbuf &= (1UL << bs->bitcount) - 1;
+    bs->in = p;
+}
+
+// Read a Huffman table out of the bit stream, and prepare lookup for it.
+static void read_huftable64 (huf_lookup_table *h, bit_stream64 *bs, unsigned char *pend)
+{
+    int i;
+    int leaflen[32];
+    int num = bit_read64(bs, 5, pend);
+    // Empty table leaves the previous one, like in the bitwise decoder
+    if (!num)
+        return;
+
+    int leafmax = 1;
+    for (i=0; i<num; i++)
+    {
+        leaflen[i] = bit_read64(bs, 4, pend);
+        if (leafmax < leaflen[i])
+            leafmax = leaflen[i];
+    }
+
+    unsigned long codeb = 0L;
+    int k = 0;
+    for (i=1; i<=leafmax; i++)
+    {
+        for (int j = 0; j < num; j++)
+            if (leaflen[j] == i)
+            {
+                h->huf.table[k].code = mirror(codeb, i);
+                h->huf.table[k].codelen = i;
+                h->huf.table[k].value = j;
+                codeb++;
+                k++;
+            }
+        codeb <<= 1;
+    }
+    h->huf.num = k;
+
+    // If codes overlap, the bitwise decoder takes the first one; so fill from the last
+    memset(h->lookup_len, 0, sizeof(h->lookup_len));
+    for (k = h->huf.num - 1; k >= 0; k--)
+    {
+        int codelen = h->huf.table[k].codelen;
+        // Codes longer than lookup are searched; overflowed codes never match
+        if ((codelen > HUF_LOOKUP_BITS) || (h->huf.table[k].code >> codelen) != 0)
+            continue;
+        for (unsigned long n = h->huf.table[k].code; n < (1 << HUF_LOOKUP_BITS); n += (1 << codelen))
+        {
+            h->lookup_len[n] = codelen;
+            h->lookup_val[n] = h->huf.table[k].value;
+        }
+    }
+}
+
+// Read a value out of the bit stream using the given Huffman table.
+static long huf_read64 (const huf_lookup_table *h, bit_stream64 *bs, unsigned char *pend)
+{
+    bit_refill64(bs, pend);
+    unsigned long peek = bs->bitbuf & ((1 << HUF_LOOKUP_BITS) - 1);
+    int codelen = h->lookup_len[peek];
+    int value = h->lookup_val[peek];
+    if (codelen == 0)
+    {
+        // Longer codes are searched, like in huf_read()
+        int i;
+        for (i=0; i<h->huf.num; i++)
+        {
+            unsigned long mask = (1 << h->huf.table[i].codelen) - 1;
+            if ((bs->bitbuf & mask) == h->huf.table[i].code)
+                break;
+        }
+        if (i == h->huf.num)
+            return -1;
+        codelen = h->huf.table[i].codelen;
+        value = h->huf.table[i].value;
+    }
+    bs->bitbuf >>= codelen;
+    bs->bitcount -= codelen;
+
+    unsigned long val = value;
+    if (val >= 2)
+    {
+        val = 1 << (val-1);
+        val |= bs->bitbuf & (val-1);
+        bs->bitbuf >>= value - 1;
+        bs->bitcount -= value - 1;
+    }
+    return val;
+}
+
+// Decompress a packed data block. Returns the unpacked length if
+// successful, or negative error codes if not.
+// Gives the same results as rnc_unpack_bitwise(), but decodes Huffman codes
+// through lookup tables, and reads the bit stream through 64-bit buffer.
+long rnc_unpack (const void *packed, void *unpacked, unsigned int flags
+#ifdef COMPRESSOR
+         , long *leeway
+#endif
+         )
+{
+    rnc_header header;
+    unsigned char *input = ((unsigned char *)packed) + RNC_HEADER_LEN;
+    unsigned char *output = (unsigned char *)unpacked;
+#ifdef COMPRESSOR
+    long lee = 0;
+#endif
+
+    memcpy(&header, packed, sizeof(header));
+
+    if (header.signature != RNC_SIGNATURE) {
+        if (!(flags & RNC_IGNORE_HEADER_VAL_ERROR)) {
+            return RNC_HEADER_VAL_ERROR;
+        }
+    }
+
+    // flip big-endian values
+    header.packed_size = ntohl(header.packed_size);
+    header.packed_crc32 = ntohs(header.packed_crc32);
+    header.unpacked_size = ntohl(header.unpacked_size);
+    header.unpacked_crc32 = ntohs(header.unpacked_crc32);
+
+    if ((header.unpacked_size>(1<<30))||(header.packed_size>(1<<30))) {
+        return RNC_HEADER_VAL_ERROR;
+    }
+    unsigned char* outputend = output + header.unpacked_size;
+    unsigned char* inputend = input + header.packed_size;
+
+    // Check the packed-data CRC. Also save the unpacked-data CRC
+    // for later.
+
+    if (rnc_crc(input, header.packed_size) != header.packed_crc32) {
+        if (!(flags & RNC_IGNORE_PACKED_CRC_ERROR)) {
+            return RNC_PACKED_CRC_ERROR;
+        }
+    }
+
+    bit_stream64 bs;
+    bs.bitbuf = 0;
+    bs.bitcount = 0;
+    bs.in = input;
+    bit_read64(&bs, 2, inputend);      // discard first two bits
+
+    // Tables are kept between chunks, because empty table doesn't replace the previous one
+    huf_lookup_table tables[3];
+    huf_lookup_table *raw = &tables[0];
+    huf_lookup_table *dist = &tables[1];
+    huf_lookup_table *len = &tables[2];
+    for (int i = 0; i < 3; i++)
+    {
+        tables[i].huf.num = 0;
+        memset(tables[i].lookup_len, 0, sizeof(tables[i].lookup_len));
+    }
+
+   // Process chunks.
+
+  while (output < outputend)
+  {
+#ifdef COMPRESSOR
+      long this_lee;
+#endif
+      unsigned long ch_count;
+      input = bit_position64(&bs);
+      if (inputend - input < 6)
+      {
+          if (!(flags&RNC_IGNORE_HUF_EXCEEDS_RANGE))
+              return RNC_HUF_EXCEEDS_RANGE;
+            else
+              {output=outputend;ch_count=0;break;}
+      }
+      read_huftable64(raw, &bs, inputend);
+      read_huftable64(dist, &bs, inputend);
+      read_huftable64(len, &bs, inputend);
+      ch_count = bit_read64(&bs, 16, inputend);
+
+      while (1)
+      {
+          long length = huf_read64(raw, &bs, inputend);
+          if (length == -1)
+          {
+              if (!(flags & RNC_IGNORE_HUF_DECODE_ERROR))
+                  return RNC_HUF_DECODE_ERROR;
+              else
+              {
+                  output = outputend;
+                  ch_count = 0;
+                  break;
+              }
+            }
+        if (length)
+        {
+            input = bit_position64(&bs);
+            if ((length <= inputend - input) && (length <= outputend - output))
+            {
+                memcpy(output, input, length);
+                output += length;
+                input += length;
+            } else
+            {
+                while (length--)
+                {
+                    if ((input>=inputend)||(output>=outputend))
+                       {
+                       if (!(flags&RNC_IGNORE_HUF_EXCEEDS_RANGE))
+                           return RNC_HUF_EXCEEDS_RANGE;
+                       else
+                           {output=outputend;ch_count=0;break;}
+                       }
+                    *output++ = *input++;
+                }
+            }
+            bitread_fix64(&bs, input);
+        }
+        if (--ch_count <= 0)
+            break;
+
+        long posn = huf_read64(dist, &bs, inputend);
+        if (posn == -1)
+        {
+            if (!(flags&RNC_IGNORE_HUF_DECODE_ERROR))
+                return RNC_HUF_DECODE_ERROR;
+            else
+                {output=outputend;ch_count=0;break;}
+        }
+        length = huf_read64(len, &bs, inputend);
+        if (length == -1)
+        {
+            if (!(flags&RNC_IGNORE_HUF_DECODE_ERROR))
+                return RNC_HUF_DECODE_ERROR;
+            else
+                {output=outputend;ch_count=0;break;}
+        }
+        posn += 1;
+        length += 2;
+        if ((posn <= output - (unsigned char *)unpacked) && (length <= outputend - output))
+        {
+            // Source may overlap the destination, so it has to be copied in order
+            unsigned char *src = output - posn;
+            if (posn >= length)
+            {
+                memcpy(output, src, length);
+                output += length;
+            } else
+            {
+                while (length--)
+                    *output++ = *src++;
+            }
+        } else
+        {
+            while (length--)
+            {
+                if (((output-posn)<(unsigned char *)unpacked)
+                 || ((output-posn)>(unsigned char *)outputend)
+                 || ((output)<(unsigned char *)unpacked)
+                 || ((output)>(unsigned char *)outputend))
+                {
+                       if (!(flags&RNC_IGNORE_HUF_EXCEEDS_RANGE))
+                           return RNC_HUF_EXCEEDS_RANGE;
+                       else
+                           {output=outputend-1;ch_count=0;break;}
+                }
+                *output = output[-posn];
+                output++;
+            }
+        }
+#ifdef COMPRESSOR
+        input = bit_position64(&bs);
+        this_lee = (inputend - input) - (outputend - output);
+        if (lee < this_lee)
+            lee = this_lee;
+#endif
+      }
+  }
+
+    if (outputend != output)
+    {
+        if (!(flags&RNC_IGNORE_FILE_SIZE_MISMATCH))
+            return RNC_FILE_SIZE_MISMATCH;
+    }
+
+#ifdef COMPRESSOR
+    if (leeway)
+        *leeway = lee;
+#endif
+
+    // Check the unpacked-data CRC.
+
+    if (rnc_crc(unpacked, header.unpacked_size) != header.unpacked_crc32)
+    {
+        if (!(flags&RNC_IGNORE_UNPACKED_CRC_ERROR))
+            return RNC_UNPACKED_CRC_ERROR;
+    }
+
+    return header.unpacked_size;
+}
+
 // Mirror the bottom n bits of x.
 static unsigned long mirror (unsigned long x, int n) {
     unsigned long top = 1 << (n - 1);
@@ -412,15 +763,16 @@ static unsigned long mirror (unsigned long x, int n) {
     return x;
 }
 
-unsigned short crctab[256];
-short crctab_ready=false;
+// Tables for computing CRC 8 bytes at a time; first one is the usual byte table
+static unsigned short crctab[8][256];
+static short crctab_ready=false;
 
 // Calculate a CRC, the RNC way
 long rnc_crc(void *data, unsigned long len)
 {
   unsigned short val;
   unsigned char *p = (unsigned char *)data;
-  //computing CRC table
+  //computing CRC tables
   if (!crctab_ready)
   {
       for (int i = 0; i < 256; i++)
@@ -434,16 +786,33 @@ long rnc_crc(void *data, unsigned long len)
               else
                   val = (val >> 1);
           }
-          crctab[i] = val;
-    }
-  crctab_ready=true;
+          crctab[0][i] = val;
+      }
+      for (int i = 0; i < 256; i++)
+      {
+          val = crctab[0][i];
+          for (int k = 1; k < 8; k++)
+          {
+              val = (val >> 8) ^ crctab[0][val & 0xFF];
+              crctab[k][i] = val;
+          }
+      }
+      crctab_ready=true;
   }
 
   val = 0;
+  while (len >= 8)
+  {
+     val ^= p[0] | (p[1] << 8);
+     val = crctab[7][val & 0xFF] ^ crctab[6][val >> 8] ^ crctab[5][p[2]] ^ crctab[4][p[3]]
+         ^ crctab[3][p[4]] ^ crctab[2][p[5]] ^ crctab[1][p[6]] ^ crctab[0][p[7]];
+     p += 8;
+     len -= 8;
+  }
   while (len--)
   {
      val ^= *p++;
-     val = (val >> 8) ^ crctab[val & 0xFF];
+     val = (val >> 8) ^ crctab[0][val & 0xFF];
   }
   return val;
 }
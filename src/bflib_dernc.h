@@ -60,8 +60,10 @@ long UnpackM1(void *buffer, unsigned long bufsize);
 /******************************************************************************/
 #ifndef COMPRESSOR
 long rnc_unpack (const void *packed, void *unpacked, unsigned int flags);
+long rnc_unpack_bitwise (const void *packed, void *unpacked, unsigned int flags);
 #else
 long rnc_unpack (const void *packed, void *unpacked, unsigned int flags, long *leeway);
+long rnc_unpack_bitwise (const void *packed, void *unpacked, unsigned int flags, long *leeway);
 #endif
 const char *rnc_error (long errcode);
 long rnc_crc (void *data, unsigned long len);
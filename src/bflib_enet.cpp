@@ -33,10 +33,10 @@ namespace
     ENetHost *host = nullptr;
     ENetPeer *client_peer = nullptr;
 
-    // List
-    ENetPacket *oldest_packet = nullptr;
-    ENetPacket *newest_packet = nullptr;
-    int incoming_queue_size = 0;
+    // Lists of received packets, separate for every user so that they can be read in any order
+    ENetPacket *oldest_packet[MAX_N_USERS] = {nullptr};
+    ENetPacket *newest_packet[MAX_N_USERS] = {nullptr};
+    int incoming_queue_size[MAX_N_USERS] = {0};
 
     TbError bf_enet_init(NetDropCallback drop_callback)
     {
@@ -46,20 +46,25 @@ namespace
         return Lb_OK;
     }
 
-    void host_destroy()
+    void clear_user_packets(NetUserId user_id)
     {
-        if (oldest_packet)
+        for (ENetPacket *p = oldest_packet[user_id]; p != nullptr;)
         {
-            for (ENetPacket *p = oldest_packet; p != nullptr;)
-            {
-                ENetPacket *pp = p;
-                p = static_cast<ENetPacket *>(p->userData);
-                enet_packet_destroy(pp);
-            }
+            ENetPacket *pp = p;
+            p = static_cast<ENetPacket *>(p->userData);
+            enet_packet_destroy(pp);
+        }
 
-            oldest_packet = nullptr;
-            newest_packet = nullptr;
-            incoming_queue_size = 0;
+        oldest_packet[user_id] = nullptr;
+        newest_packet[user_id] = nullptr;
+        incoming_queue_size[user_id] = 0;
+    }
+
+    void host_destroy()
+    {
+        for (NetUserId user_id = 0; user_id < MAX_N_USERS; user_id++)
+        {
+            clear_user_packets(user_id);
         }
         if (client_peer)
         {
@@ -90,9 +95,19 @@ namespace
     {
         ENetAddress addr = {.host = 0,
                             .port = DEFAULT_PORT };
+        const char *P;
         if (!*session)
             return Lb_FAIL;
+        P = strchr(session,':');
+        if ((P != NULL) && (atoi(P+1) > 0))
+        {
+            addr.port = atoi(P+1);
+        }
         host = enet_host_create(&addr, 4, NUM_CHANNELS, 0, 0);
+        if (!host)
+        {
+            return Lb_FAIL;
+        }
         return Lb_OK;
     }
 
@@ -195,25 +210,37 @@ namespace
                     break;
                 case ENET_EVENT_TYPE_DISCONNECT:
                     user_id = NetUserId(reinterpret_cast<ptrdiff_t>(ev.peer->data));
+                    if ((user_id >= 0) && (user_id < MAX_N_USERS))
+                    {
+                        clear_user_packets(user_id);
+                    }
                     g_drop_callback(user_id, NETDROP_ERROR);
                     break;
                 case ENET_EVENT_TYPE_RECEIVE:
-                    if (oldest_packet == nullptr)
+                    // On client, the only peer is server, which has no user data set
+                    user_id = NetUserId(reinterpret_cast<ptrdiff_t>(ev.peer->data));
+                    if ((user_id < 0) || (user_id >= MAX_N_USERS))
                     {
-                        newest_packet = ev.packet;
-                        oldest_packet = newest_packet;
-                        incoming_queue_size = 1;
+                        WARNLOG("Packet from unknown user %d", (int)user_id);
+                        enet_packet_destroy(ev.packet);
+                        return 0;
+                    }
+                    ev.packet->userData = nullptr;
+                    if (oldest_packet[user_id] == nullptr)
+                    {
+                        newest_packet[user_id] = ev.packet;
+                        oldest_packet[user_id] = newest_packet[user_id];
+                        incoming_queue_size[user_id] = 1;
                     }
                     else
                     {
-                        newest_packet->userData = ev.packet;
-                        newest_packet = ev.packet;
-                        newest_packet->userData = nullptr;
-                        incoming_queue_size +=1;
-                        if (incoming_queue_size > 50)
+                        newest_packet[user_id]->userData = ev.packet;
+                        newest_packet[user_id] = ev.packet;
+                        incoming_queue_size[user_id] +=1;
+                        if (incoming_queue_size[user_id] > 50)
                         {
-                            fprintf(stderr, "Too many packets %d\n", incoming_queue_size);
-                            WARNLOG("Too many packets %d", incoming_queue_size);
+                            fprintf(stderr, "Too many packets %d\n", incoming_queue_size[user_id]);
+                            WARNLOG("Too many packets %d from user %d", incoming_queue_size[user_id], (int)user_id);
                         }
                     }
                     return 1;
@@ -294,13 +321,24 @@ namespace
     size_t bf_enet_readmsg(NetUserId source, char *buffer, size_t max_size)
     {
         size_t sz;
-        while (!oldest_packet)
+        if ((source < 0) || (source >= MAX_N_USERS))
         {
-            bf_enet_read_event(not_expected_user, 0);
+            return 0;
         }
-        ENetPacket *packet = oldest_packet;
-        oldest_packet = static_cast<ENetPacket *>(oldest_packet->userData);
-        incoming_queue_size--;
+        while (!oldest_packet[source])
+        {
+            if (bf_enet_read_event(not_expected_user, 0) < 0)
+            {
+                return 0;
+            }
+        }
+        ENetPacket *packet = oldest_packet[source];
+        oldest_packet[source] = static_cast<ENetPacket *>(packet->userData);
+        if (oldest_packet[source] == nullptr)
+        {
+            newest_packet[source] = nullptr;
+        }
+        incoming_queue_size[source]--;
 
         sz = min(packet->dataLength, max_size);
         memcpy(buffer, packet->data, sz);
@@ -321,11 +359,16 @@ namespace
      */
     size_t bf_enet_msgready(NetUserId source, unsigned timeout)
     {
-        if ((!oldest_packet) && timeout > 0)
+        if ((source < 0) || (source >= MAX_N_USERS))
+        {
+            return 0;
+        }
+        // Waiting ends on any event, even if the packet came from another user
+        if ((!oldest_packet[source]) && timeout > 0)
         {
             bf_enet_read_event(not_expected_user, timeout);
         }
-        return oldest_packet? oldest_packet->dataLength : 0;
+        return oldest_packet[source]? oldest_packet[source]->dataLength : 0;
     }
 
     /**
@@ -40,6 +40,9 @@
 #include <dos.h>
 #include <direct.h>
 #endif
+#if !defined(_WIN32)&&!defined(DOS)&&!defined(GO32)
+#include <sys/mman.h>
+#endif
 #include "post_inc.h"
 
 #if defined(_WIN32)
@@ -70,6 +73,13 @@ WINBASEAPI DWORD WINAPI GetShortPathNameA(LPCSTR,LPSTR,DWORD);
 #define GetShortPathName GetShortPathNameA
 WINBASEAPI BOOL WINAPI FlushFileBuffers(HANDLE);
 WINBASEAPI DWORD WINAPI GetLastError(void);
+typedef const void *LPCVOID;
+#define PAGE_READONLY 0x02
+#define FILE_MAP_READ 0x0004
+WINBASEAPI HANDLE WINAPI CreateFileMappingA(HANDLE,LPVOID,DWORD,DWORD,DWORD,LPCSTR);
+WINBASEAPI LPVOID WINAPI MapViewOfFile(HANDLE,DWORD,DWORD,DWORD,size_t);
+WINBASEAPI BOOL WINAPI UnmapViewOfFile(LPCVOID);
+WINBASEAPI BOOL WINAPI CloseHandle(HANDLE);
 #ifdef __cplusplus
 }
 #endif
@@ -290,6 +300,62 @@ long LbFileLength(const char *fname)
   return result;
 }
 
+/**
+ * Maps whole content of an opened file into memory, for reading only.
+ * The file handle may be closed after mapping; the mapping stays valid until LbFileMapClose().
+ * @return True on success; on failure, the mapping is cleared.
+ */
+TbBool LbFileMapOpen(struct TbFileMapping *fmap, TbFileHandle handle)
+{
+    fmap->data = NULL;
+    fmap->length = 0;
+    fmap->map_handle = NULL;
+    long length = LbFileLengthHandle(handle);
+    if (length <= 0)
+        return false;
+#if defined(_WIN32)
+    HANDLE fhandle = (HANDLE)_get_osfhandle(handle);
+    if (fhandle == (HANDLE)-1)
+        return false;
+    HANDLE mhandle = CreateFileMappingA(fhandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mhandle == NULL)
+        return false;
+    void *data = MapViewOfFile(mhandle, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mhandle);
+        return false;
+    }
+    fmap->map_handle = mhandle;
+#elif defined(DOS)||defined(GO32)
+    // No mapping on old systems
+    void *data = NULL;
+    return false;
+#else
+    void *data = mmap(NULL, length, PROT_READ, MAP_SHARED, handle, 0);
+    if (data == MAP_FAILED)
+        return false;
+#endif
+    fmap->data = (unsigned char *)data;
+    fmap->length = length;
+    return true;
+}
+
+void LbFileMapClose(struct TbFileMapping *fmap)
+{
+    if (fmap->data == NULL)
+        return;
+#if defined(_WIN32)
+    UnmapViewOfFile(fmap->data);
+    CloseHandle(fmap->map_handle);
+#elif !defined(DOS)&&!defined(GO32)
+    munmap(fmap->data, fmap->length);
+#endif
+    fmap->data = NULL;
+    fmap->length = 0;
+    fmap->map_handle = NULL;
+}
+
 //Converts file search information from platform-specific into independent form
 //Yeah, right...
 void convert_find_info(struct TbFileFind *ffind)
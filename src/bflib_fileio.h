@@ -38,6 +38,13 @@ enum TbFileSeekMode {
         Lb_FILE_SEEK_END,
 };
 
+/** Read-only view of whole file content. */
+struct TbFileMapping {
+    unsigned char *data;
+    long length;
+    /** Platform specific mapping object. */
+    void *map_handle;
+};
 
 /******************************************************************************/
 
@@ -58,6 +65,8 @@ int LbFileDelete(const char *filename);
 short LbFileFlush(TbFileHandle handle);
 int LbFileMakeFullPath(const short append_cur_dir,
   const char *directory, const char *filename, char *buf, const unsigned long len);
+TbBool LbFileMapOpen(struct TbFileMapping *fmap, TbFileHandle handle);
+void LbFileMapClose(struct TbFileMapping *fmap);
 
 /******************************************************************************/
 #ifdef __cplusplus
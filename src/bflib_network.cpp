@@ -31,6 +31,8 @@
 #include "globals.h"
 #include <assert.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <zlib.h>
 
 //TODO: get rid of the following headers later by refactoring, they're here for testing primarily
 #include "frontend.h"
@@ -126,11 +128,19 @@ struct UnidirectionalRTSMessage rtsMessage;
 #define WAIT_FOR_SERVER_TIMEOUT_IN_MS   WAIT_FOR_CLIENT_TIMEOUT_IN_MS
 
 /**
- * If queued frames on client exceed > SCHEDULED_LAG_IN_FRAMES/2 game speed should
- * be faster, if queued frames < SCHEDULED_LAG_IN_FRAMES/2 game speed should be slower.
- * Server also expects there to be SCHEDULED_LAG_IN_FRAMES in TCP stream.
+ * Size of blocks which are compared by their hashes when resyncing, and sent only if different.
  */
-#define SCHEDULED_LAG_IN_FRAMES 12
+#define RESYNC_BLOCK_SIZE               4096
+
+/**
+ * Max time of waiting for a message from one client, while frames of others are awaited too.
+ */
+#define CLIENT_POLL_INTERVAL_MS         2
+
+/**
+ * Amount of turns after which statistics of scheduled exchange are logged.
+ */
+#define SCHEDULED_STATS_INTERVAL_TURNS 400
 
 #define SESSION_COUNT 32 //not arbitrary, it's what code calling EnumerateSessions expects
 
@@ -168,7 +178,23 @@ enum NetMessageType
     NETMSG_USERUPDATE,      //changed player from server
     NETMSG_FRAME,           //to server: ACK of frame + packets, from server: the frame itself
     // Not used: NETMSG_LAGWARNING,      //from server: notice that some client is lagging
-    NETMSG_RESYNC,          //from server: re-synchronization is occurring
+    NETMSG_RESYNC,          //to server: hashes of resync blocks, from server: compressed blocks which differ
+    NETMSG_SCHEDFRAME,      //to server: packets gathered on given turn, from server: frame to be executed on given turn
+};
+
+/**
+ * Statistics of the scheduled exchange, gathered between reports in log.
+ */
+struct NetSchedStats
+{
+    int                     turns;              //turns exchanged
+    int                     stalls;             //turns on which the exchange had to wait for a frame
+    TbClockMSec             stall_time;         //total time of waiting
+    TbClockMSec             max_stall;          //longest wait
+    int                     depth_min;          //least frames queued ahead by a user
+    int                     depth_max;          //most frames queued ahead by a user
+    long                    depth_sum;          //sum of frames queued ahead, over turns and users
+    int                     depth_count;        //amount of values in depth_sum
 };
 
 /**
@@ -207,11 +233,24 @@ struct NetState
     char                    msg_buffer[(sizeof(NetFrame) + sizeof(struct Packet)) * PACKETS_COUNT + 1]; //completely estimated for now
     char                    msg_buffer_null;    //theoretical safe guard vs non-terminated strings
     TbBool                  locked;             //if set, no players may join
+    struct NetFrame *       sched_queues[MAX_N_USERS]; //scheduled frames; on server input of users, on client frames from server
+    TbBool                  sched_active;       //if set, game turns are exchanged with scheduled lag
+    int                     sched_turn;         //number of the next scheduled exchange
+    int                     sched_start_turn;   //first turn with input gathered since the schedule was (re)started
+    int                     sched_lag;          //scheduled lag in frames, used on server
+    size_t                  sched_frame_size;   //size of user frame in scheduled exchange
+    struct NetSchedStats    sched_stats;        //statistics since last report
 };
 
 //the "new" code contained in this struct
 static struct NetState netstate;
 
+//scheduled lag to be used for next games hosted on this machine; kept through LbNetwork_Init()
+static int scheduled_lag_frames = 0;
+
+//port on which next games are hosted on this machine; zero means default of the service provider
+static unsigned short hosting_port = 0;
+
 //sessions placed here for now, would be smarter to store dynamically
 static struct TbNetworkSessionNameEntry sessions[SESSION_COUNT]; //using original because enumerate expects static life time
 
@@ -274,7 +313,7 @@ static void SendUserUpdate(NetUserId dest, NetUserId updated_user)
         ptr - netstate.msg_buffer);
 }
 
-static void SendClientFrame(const char * send_buf, size_t buf_size, int seq_nbr) //seq_nbr because it isn't necessarily determined
+static void SendClientFrame(enum NetMessageType type, const char * send_buf, size_t buf_size, int seq_nbr) //seq_nbr because it isn't necessarily determined
 {
     char * ptr;
 
@@ -282,7 +321,7 @@ static void SendClientFrame(const char * send_buf, size_t buf_size, int seq_nbr)
 
     ptr = netstate.msg_buffer;
 
-    *ptr = NETMSG_FRAME;
+    *ptr = type;
     ptr += 1;
 
     *(int *) ptr = seq_nbr;
@@ -311,17 +350,17 @@ static int CountLoggedInClients()
     return count;
 }
 
-static void SendServerFrame(const void *send_buf, size_t frame_size, int num_frames)
+static void SendServerFrame(enum NetMessageType type, int seq_nbr, const void *send_buf, size_t frame_size, int num_frames)
 {
     char * ptr;
 
     NETDBG(9, "Starting");
 
     ptr = netstate.msg_buffer;
-    *ptr = NETMSG_FRAME;
+    *ptr = type;
     ptr += sizeof(char);
 
-    *(int *) ptr = netstate.seq_nbr;
+    *(int *) ptr = seq_nbr;
     ptr += sizeof(int);
 
     *ptr = num_frames;
@@ -493,6 +532,137 @@ static void HandleServerFrame(char * ptr, char * end, size_t user_frame_size)
     NETDBG(9, "Handled server frame of %u bytes", frame->size);
 }
 
+static void SchedQueuePush(NetUserId id, int seq_nbr, const char * buffer, size_t size)
+{
+    NetFrame * frame;
+    NetFrame ** it;
+
+    frame = (NetFrame *) LbMemoryAlloc(sizeof(*frame));
+    frame->next = NULL;
+    frame->size = size;
+    frame->buffer = (char *) LbMemoryAlloc(frame->size);
+    frame->seq_nbr = seq_nbr;
+    LbMemoryCopy(frame->buffer, buffer, frame->size);
+
+    for (it = &netstate.sched_queues[id]; *it != NULL; it = &(*it)->next)
+    {
+    }
+    *it = frame;
+}
+
+static void SchedQueueFree(NetUserId id)
+{
+    NetFrame * frame;
+    NetFrame * nextframe;
+
+    frame = netstate.sched_queues[id];
+    while (frame != NULL) {
+        nextframe = frame->next;
+        LbMemoryFree(frame->buffer);
+        LbMemoryFree(frame);
+        frame = nextframe;
+    }
+    netstate.sched_queues[id] = NULL;
+}
+
+static int SchedQueueDepth(NetUserId id)
+{
+    NetFrame * it;
+    int count;
+
+    for (count = 0, it = netstate.sched_queues[id]; it != NULL; it = it->next)
+    {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Checks if a frame of given number is first in queue of given user; frames older than it are discarded.
+ */
+static TbBool SchedQueueReady(NetUserId id, int seq_nbr)
+{
+    NetFrame * frame;
+
+    while ((frame = netstate.sched_queues[id]) != NULL && frame->seq_nbr < seq_nbr)
+    {
+        NETDBG(6, "Discarding outdated frame %d of user %d", frame->seq_nbr, id);
+        netstate.sched_queues[id] = frame->next;
+        LbMemoryFree(frame->buffer);
+        LbMemoryFree(frame);
+    }
+    return (frame != NULL) && (frame->seq_nbr == seq_nbr);
+}
+
+static TbBool SchedQueuePop(NetUserId id, int seq_nbr, void * buffer, size_t max_size)
+{
+    NetFrame * frame;
+
+    if (!SchedQueueReady(id, seq_nbr)) {
+        return false;
+    }
+    frame = netstate.sched_queues[id];
+    netstate.sched_queues[id] = frame->next;
+    LbMemoryCopy(buffer, frame->buffer, min(frame->size, max_size));
+    LbMemoryFree(frame->buffer);
+    LbMemoryFree(frame);
+    return true;
+}
+
+static void HandleClientSchedFrame(NetUserId source, const char * ptr, char * end, size_t frame_size)
+{
+    int seq_nbr;
+
+    NETDBG(7, "Starting");
+
+    seq_nbr = *(int *) ptr;
+    ptr += 4;
+
+    if (ptr + frame_size >= end) {
+        NETMSG("Bad scheduled frame size from client %u", source);
+        return;
+    }
+    if (!netstate.sched_active) {
+        // Input sent ahead before the game ended; nothing to schedule it for
+        NETDBG(6, "Discarding scheduled frame %d from client %u", seq_nbr, source);
+        return;
+    }
+    if (seq_nbr < netstate.sched_start_turn) {
+        // Input gathered before the schedule was restarted
+        NETDBG(6, "Discarding outdated scheduled frame %d from client %u", seq_nbr, source);
+        return;
+    }
+    SchedQueuePush(source, seq_nbr, ptr, frame_size);
+
+    NETDBG(9, "Queued scheduled frame %d of client %u", seq_nbr, source);
+}
+
+static void HandleServerSchedFrame(char * ptr, char * end, size_t user_frame_size)
+{
+    int seq_nbr;
+    unsigned num_user_frames;
+
+    NETDBG(7, "Starting");
+
+    seq_nbr = *(int *) ptr;
+    ptr += 4;
+
+    num_user_frames = *ptr;
+    ptr += 1;
+
+    if (ptr + num_user_frames * user_frame_size >= end) {
+        NETMSG("Bad scheduled frame size from server");
+        return;
+    }
+    if (!netstate.sched_active) {
+        NETDBG(6, "Discarding scheduled frame %d from server", seq_nbr);
+        return;
+    }
+    SchedQueuePush(SERVER_ID, seq_nbr, ptr, num_user_frames * user_frame_size);
+
+    NETDBG(9, "Queued scheduled frame %d from server", seq_nbr);
+}
+
 static void HandleMessageFromServer(NetUserId source, size_t frame_size)
 {
     //this is a very bad way to do network message parsing, but it is what C offers
@@ -525,6 +695,9 @@ static void HandleMessageFromServer(NetUserId source, size_t frame_size)
         case NETMSG_FRAME:
             HandleServerFrame(buffer_ptr, buffer_end, frame_size);
             break;
+        case NETMSG_SCHEDFRAME:
+            HandleServerSchedFrame(buffer_ptr, buffer_end, frame_size);
+            break;
         default:
             break;
     }
@@ -563,6 +736,9 @@ static void HandleMessageFromClient(NetUserId source, void *server_buf, size_t f
             HandleClientFrame(source,((char*)server_buf) + source * frame_size,
                               buffer_ptr, buffer_end, frame_size);
             break;
+        case NETMSG_SCHEDFRAME:
+            HandleClientSchedFrame(source, buffer_ptr, buffer_end, frame_size);
+            break;
         default:
             break;
     }
@@ -847,7 +1023,9 @@ TbError LbNetwork_Create(char *nsname_str, char *plyr_name, unsigned long *plyr_
         return Lb_FAIL;
     }
 
-    if (netstate.sp->host(":5555", optns) == Lb_FAIL) {
+    char session[16];
+    snprintf(session, sizeof(session), ":%u", (unsigned)hosting_port);
+    if (netstate.sp->host(session, optns) == Lb_FAIL) {
         return Lb_FAIL;
     }
 
@@ -920,6 +1098,9 @@ TbError LbNetwork_Stop(void)
         LbMemoryFree(frame);
         frame = nextframe;
     }
+    for (NetUserId id = 0; id < MAX_N_USERS; ++id) {
+        SchedQueueFree(id);
+    }
 
     LbMemorySet(&netstate, 0, sizeof(netstate));
 
@@ -969,6 +1150,7 @@ static void OnDroppedUser(NetUserId id, enum NetDropReason reason)
 
 
     if (netstate.my_id == SERVER_ID) {
+        SchedQueueFree(id);
         LbMemorySet(&netstate.users[id], 0, sizeof(netstate.users[id]));
         netstate.users[id].id = id; //repair effect by LbMemorySet
 
@@ -1041,6 +1223,79 @@ static void ProcessMessagesUntilNextLoginReply(TbClockMSec timeout, void *server
     }
 }
 
+typedef TbBool (*NetFrameArrivedFunc)(NetUserId id, int seq_nbr);
+
+static TbBool ClientFrameArrived(NetUserId id, int seq_nbr)
+{
+    return (netstate.msg_buffer[0] == NETMSG_FRAME) || (netstate.msg_buffer[0] == NETMSG_RESYNC);
+}
+
+static TbBool ClientSchedFrameArrived(NetUserId id, int seq_nbr)
+{
+    return SchedQueueReady(id, seq_nbr);
+}
+
+/**
+ * Reads messages from all awaited clients at once, so that the server waits as long as
+ * for the slowest client, not for the sum of their delays.
+ * @param awaited Users whose frames are awaited; cleared as the frames arrive, or users are dropped.
+ * @param arrived Checks whether the message just processed completes the frame.
+ * @return True if the server had to wait for messages which haven't arrived yet.
+ */
+static TbBool ProcessMessagesUntilClientFrames(TbBool *awaited, NetFrameArrivedFunc arrived, int seq_nbr,
+    void *serv_buf, size_t frame_size, TbClockMSec timeout)
+{
+    TbClockMSec start;
+    TbClockMSec elapsed;
+    NetUserId id;
+    NetUserId first_awaited;
+    TbBool waited;
+
+    start = LbTimerClock();
+    waited = false;
+    while (netstate.sp != NULL)
+    {
+        first_awaited = -1;
+        for (id = 0; id < MAX_N_USERS; ++id)
+        {
+            if (!awaited[id]) {
+                continue;
+            }
+            while (awaited[id] && (netstate.users[id].progress != USER_UNUSED) && (netstate.sp->msgready(id, 0) != 0))
+            {
+                if (ProcessMessage(id, serv_buf, frame_size) == Lb_FAIL) {
+                    awaited[id] = false;
+                } else
+                if (arrived(id, seq_nbr)) {
+                    awaited[id] = false;
+                }
+            }
+            if (netstate.users[id].progress == USER_UNUSED) {
+                awaited[id] = false;
+            }
+            if (awaited[id] && (first_awaited < 0)) {
+                first_awaited = id;
+            }
+        }
+        if (first_awaited < 0) {
+            break;
+        }
+        elapsed = LbTimerClock() - start;
+        if (elapsed >= timeout) {
+            for (id = 0; id < MAX_N_USERS; ++id) {
+                if (awaited[id]) {
+                    NETLOG("No frame from user %d after %ld ms", (int)id, (long)elapsed);
+                }
+            }
+            break;
+        }
+        // Any message ends the wait; a short one if the message was from another client
+        waited = true;
+        netstate.sp->msgready(first_awaited, min(timeout - elapsed, (TbClockMSec)CLIENT_POLL_INTERVAL_MS));
+    }
+    return waited;
+}
+
 static void ConsumeServerFrame(void *server_buf, int frame_size)
 {
     NetFrame * frame;
@@ -1060,33 +1315,26 @@ static void ConsumeServerFrame(void *server_buf, int frame_size)
  */
 TbError LbNetwork_ExchangeServer(void *server_buf, size_t client_frame_size)
 {
+    TbBool awaited[MAX_N_USERS];
+    TbBool any_client;
+
     //server needs to be careful about how it reads messages
+    any_client = false;
     for (NetUserId id = 0; id < MAX_N_USERS; ++id)
     {
-        if (id == netstate.my_id) {
-            continue;
-        }
-
-        if (netstate.users[id].progress == USER_UNUSED) {
-            continue;
-        }
+        awaited[id] = (id != netstate.my_id) && (netstate.users[id].progress != USER_UNUSED);
+        any_client |= awaited[id];
+    }
 
-        if (netstate.users[id].progress == USER_LOGGEDIN)
-        {
-            //if (netstate.seq_nbr >= SCHEDULED_LAG_IN_FRAMES) { //scheduled lag in TCP stream
-                //TODO NET take time to detect a lagger which can then be announced
-                ProcessMessagesUntilNextFrame(id, server_buf, client_frame_size, WAIT_FOR_CLIENT_TIMEOUT_IN_MS);
-            //}
+    if (any_client)
+    {
+        //TODO NET take time to detect a lagger which can then be announced
+        ProcessMessagesUntilClientFrames(awaited, ClientFrameArrived, netstate.seq_nbr,
+            server_buf, client_frame_size, WAIT_FOR_CLIENT_TIMEOUT_IN_MS);
 
-            netstate.seq_nbr += 1;
-            SendServerFrame(server_buf, client_frame_size, CountLoggedInClients() + 1);
-        }
-        else
-        {
-            ProcessMessagesUntilNextFrame(id, server_buf, client_frame_size, WAIT_FOR_CLIENT_TIMEOUT_IN_MS);
-            netstate.seq_nbr += 1;
-            SendServerFrame(server_buf, client_frame_size, CountLoggedInClients() + 1);
-        }
+        // One frame with input of everyone
+        netstate.seq_nbr += 1;
+        SendServerFrame(NETMSG_FRAME, netstate.seq_nbr, server_buf, client_frame_size, CountLoggedInClients() + 1);
     }
     //TODO NET deal with case where no new frame is available and game should be stalled
     netstate.sp->update(OnNewUser);
@@ -1098,7 +1346,7 @@ TbError LbNetwork_ExchangeServer(void *server_buf, size_t client_frame_size)
 
 TbError LbNetwork_ExchangeClient(void *send_buf, void *server_buf, size_t client_frame_size)
 {
-    SendClientFrame((char *) send_buf, client_frame_size, netstate.seq_nbr);
+    SendClientFrame(NETMSG_FRAME, (char *) send_buf, client_frame_size, netstate.seq_nbr);
     ProcessMessagesUntilNextFrame(SERVER_ID, server_buf, client_frame_size, 0);
 
     if (netstate.exchg_queue == NULL)
@@ -1121,6 +1369,243 @@ TbError LbNetwork_ExchangeClient(void *send_buf, void *server_buf, size_t client
     return Lb_OK;
 }
 
+static void ReportScheduledStats(void)
+{
+    struct NetSchedStats * stats;
+
+    stats = &netstate.sched_stats;
+    if (stats->turns <= 0) {
+        return;
+    }
+    if (stats->depth_count > 0) {
+        NETLOG("Scheduled exchange, %d turns with lag %d: queue depth %d..%d (avg %ld.%02ld), %d stalls for %lu ms (longest %lu ms)",
+            stats->turns, netstate.sched_lag, stats->depth_min, stats->depth_max,
+            stats->depth_sum / stats->depth_count, (stats->depth_sum * 100 / stats->depth_count) % 100,
+            stats->stalls, (unsigned long)stats->stall_time, (unsigned long)stats->max_stall);
+    } else {
+        NETLOG("Scheduled exchange, %d turns: %d stalls for %lu ms (longest %lu ms)",
+            stats->turns, stats->stalls, (unsigned long)stats->stall_time, (unsigned long)stats->max_stall);
+    }
+    LbMemorySet(stats, 0, sizeof(*stats));
+}
+
+static void UpdateScheduledStats(TbClockMSec stall_time, TbBool stalled)
+{
+    struct NetSchedStats * stats;
+
+    stats = &netstate.sched_stats;
+    stats->turns++;
+    if (stalled) {
+        stats->stalls++;
+        stats->stall_time += stall_time;
+        stats->max_stall = max(stats->max_stall, stall_time);
+    }
+    if (stats->turns >= SCHEDULED_STATS_INTERVAL_TURNS) {
+        ReportScheduledStats();
+    }
+}
+
+static void UpdateScheduledDepthStats(int depth)
+{
+    struct NetSchedStats * stats;
+
+    stats = &netstate.sched_stats;
+    if ((stats->depth_count == 0) || (depth < stats->depth_min)) {
+        stats->depth_min = depth;
+    }
+    if ((stats->depth_count == 0) || (depth > stats->depth_max)) {
+        stats->depth_max = depth;
+    }
+    stats->depth_sum += depth;
+    stats->depth_count++;
+}
+
+static void StartScheduledExchange(void)
+{
+    NetUserId id;
+
+    for (id = 0; id < MAX_N_USERS; ++id) {
+        SchedQueueFree(id);
+    }
+    LbMemorySet(&netstate.sched_stats, 0, sizeof(netstate.sched_stats));
+    netstate.sched_active = true;
+    netstate.sched_turn = 0;
+    netstate.sched_start_turn = 0;
+    netstate.sched_lag = scheduled_lag_frames;
+    if (netstate.users[netstate.my_id].progress == USER_SERVER) {
+        NETMSG("Starting scheduled exchange with lag of %d turns", netstate.sched_lag);
+    } else {
+        NETMSG("Starting scheduled exchange, lag is set by server");
+    }
+}
+
+static void StopScheduledExchange(void)
+{
+    NetUserId id;
+
+    ReportScheduledStats();
+    for (id = 0; id < MAX_N_USERS; ++id) {
+        SchedQueueFree(id);
+    }
+    netstate.sched_active = false;
+    NETMSG("Scheduled exchange finished after %d turns", netstate.sched_turn);
+}
+
+/**
+ * Reads messages from given user until the scheduled frame of given number is queued.
+ * @param timeout Max time of waiting, or 0 to wait until connection is lost.
+ * @param stall_time Receives time spent on waiting for the frame to arrive.
+ * @return True if the frame is queued.
+ */
+static TbBool ProcessMessagesUntilSchedFrame(NetUserId id, int seq_nbr, void *serv_buf, size_t frame_size,
+    TbClockMSec timeout, TbClockMSec *stall_time)
+{
+    TbClockMSec start;
+    TbClockMSec elapsed;
+
+    start = LbTimerClock();
+    *stall_time = 0;
+    while ((netstate.sp != NULL) && (netstate.sched_active) && !SchedQueueReady(id, seq_nbr))
+    {
+        elapsed = LbTimerClock() - start;
+        if ((timeout != 0) && (elapsed >= timeout)) {
+            break;
+        }
+        if (netstate.sp->msgready(id, (timeout != 0) ? (timeout - elapsed) : WAIT_FOR_SERVER_TIMEOUT_IN_MS) == 0) {
+            continue;
+        }
+        if (ProcessMessage(id, serv_buf, frame_size) == Lb_FAIL) {
+            break;
+        }
+    }
+    *stall_time = LbTimerClock() - start;
+    return netstate.sched_active && SchedQueueReady(id, seq_nbr);
+}
+
+/*
+ * Scheduled exchange assuming we are at server side; input of every user is delayed
+ * by the scheduled lag, so that clients may send it ahead.
+ */
+static TbError LbNetwork_ExchangeServerScheduled(void *server_buf, size_t client_frame_size)
+{
+    NetUserId id;
+    int exec_turn;
+    char * slot;
+    TbBool awaited[MAX_N_USERS];
+    TbClockMSec stall_start;
+    TbClockMSec total_stall;
+    TbBool stalled;
+
+    exec_turn = netstate.sched_turn - netstate.sched_lag;
+    total_stall = 0;
+    stalled = false;
+    // Local input is queued just like the one which comes from clients
+    SchedQueuePush(netstate.my_id, netstate.sched_turn,
+        ((char *)server_buf) + netstate.my_id * client_frame_size, client_frame_size);
+    if (exec_turn >= netstate.sched_start_turn)
+    {
+        for (id = 0; id < MAX_N_USERS; ++id)
+        {
+            awaited[id] = (id != netstate.my_id) && (netstate.users[id].progress == USER_LOGGEDIN)
+                && !SchedQueueReady(id, exec_turn);
+        }
+        stall_start = LbTimerClock();
+        stalled = ProcessMessagesUntilClientFrames(awaited, ClientSchedFrameArrived, exec_turn,
+            server_buf, client_frame_size, WAIT_FOR_CLIENT_TIMEOUT_IN_MS);
+        total_stall = LbTimerClock() - stall_start;
+    }
+    for (id = 0; id < MAX_N_USERS; ++id)
+    {
+        if ((id != netstate.my_id) && (netstate.users[id].progress != USER_LOGGEDIN)) {
+            continue;
+        }
+        slot = ((char *)server_buf) + id * client_frame_size;
+        // Nobody had any input for the first turns
+        if (exec_turn < netstate.sched_start_turn) {
+            LbMemorySet(slot, 0, client_frame_size);
+            continue;
+        }
+        if (!SchedQueuePop(id, exec_turn, slot, client_frame_size)) {
+            NETLOG("No input from user %d for turn %d, using empty one", (int)id, exec_turn);
+            LbMemorySet(slot, 0, client_frame_size);
+        }
+        UpdateScheduledDepthStats(SchedQueueDepth(id));
+    }
+
+    SendServerFrame(NETMSG_SCHEDFRAME, netstate.sched_turn, server_buf, client_frame_size, CountLoggedInClients() + 1);
+    netstate.sched_turn += 1;
+    UpdateScheduledStats(total_stall, stalled);
+
+    netstate.sp->update(OnNewUser);
+
+    assert(UserIdentifiersValid());
+
+    return Lb_OK;
+}
+
+static TbError LbNetwork_ExchangeClientScheduled(void *send_buf, void *server_buf, size_t client_frame_size)
+{
+    TbClockMSec stall_time;
+    TbBool stalled;
+
+    SendClientFrame(NETMSG_SCHEDFRAME, (char *) send_buf, client_frame_size, netstate.sched_turn);
+
+    stalled = !SchedQueueReady(SERVER_ID, netstate.sched_turn) && (netstate.sp->msgready(SERVER_ID, 0) == 0);
+    if (!ProcessMessagesUntilSchedFrame(SERVER_ID, netstate.sched_turn, server_buf, client_frame_size, 0, &stall_time))
+    {
+        //connection lost
+        return Lb_FAIL;
+    }
+    SchedQueuePop(SERVER_ID, netstate.sched_turn, server_buf, MAX_N_USERS * client_frame_size);
+    netstate.sched_turn += 1;
+    UpdateScheduledStats(stall_time, stalled);
+
+    netstate.sp->update(OnNewUser);
+
+    if (!UserIdentifiersValid())
+    {
+        fprintf(stderr, "Bad network peer state\n");
+        return Lb_FAIL;
+    }
+    return Lb_OK;
+}
+
+/*
+ * Exchange of game turns; if scheduled lag is set on server, input is executed
+ * that many turns after it was gathered, and exchange waits only if it's not there yet.
+ */
+TbError LbNetwork_ExchangeScheduled(void *send_buf, void *server_buf, size_t client_frame_size)
+{
+    NETDBG(7, "Starting");
+
+    assert(UserIdentifiersValid());
+
+    if (!netstate.sched_active)
+    {
+        StartScheduledExchange();
+    }
+    netstate.sched_frame_size = client_frame_size;
+
+    if (netstate.users[netstate.my_id].progress == USER_SERVER)
+    {
+        return LbNetwork_ExchangeServerScheduled(server_buf, client_frame_size);
+    }
+    else
+    { // client
+        return LbNetwork_ExchangeClientScheduled(send_buf, server_buf, client_frame_size);
+    }
+}
+
+void LbNetwork_SetScheduledLag(int frames)
+{
+    scheduled_lag_frames = max(min(frames, SCHEDULED_LAG_IN_FRAMES), 0);
+}
+
+void LbNetwork_SetHostingPort(unsigned short port)
+{
+    hosting_port = port;
+}
+
 /*
  * send_buf is a buffer inside shared buffer which sent to a server
  * server_buf is a buffer shared between all clients and server
@@ -1131,6 +1616,11 @@ TbError LbNetwork_Exchange(void *send_buf, void *server_buf, size_t client_frame
 
     assert(UserIdentifiersValid());
 
+    if (netstate.sched_active)
+    {
+        StopScheduledExchange();
+    }
+
     if (netstate.users[netstate.my_id].progress == USER_SERVER)
     {
         return LbNetwork_ExchangeServer(server_buf, client_frame_size);
@@ -1141,41 +1631,364 @@ TbError LbNetwork_Exchange(void *send_buf, void *server_buf, size_t client_frame
     }
 }
 
-TbBool LbNetwork_Resync(void * buf, size_t len)
+/**
+ * Returns amount of resync blocks the areas are divided into; blocks never span two areas.
+ */
+static size_t ResyncBlocksCount(const struct NetResyncArea *areas, int count)
 {
-    char * full_buf;
+    size_t num_blocks;
     int i;
 
-    NETLOG("Starting");
+    num_blocks = 0;
+    for (i = 0; i < count; ++i) {
+        num_blocks += (areas[i].len + RESYNC_BLOCK_SIZE - 1) / RESYNC_BLOCK_SIZE;
+    }
+    return num_blocks;
+}
 
-    full_buf = (char *) LbMemoryAlloc(len + 1);
+static char * ResyncBlockPtr(const struct NetResyncArea *areas, int count, size_t block_idx, size_t *block_len)
+{
+    size_t area_blocks;
+    int i;
 
-    if (netstate.users[netstate.my_id].progress == USER_SERVER) {
-        full_buf[0] = NETMSG_RESYNC;
-        LbMemoryCopy(full_buf + 1, buf, len);
+    for (i = 0; i < count; ++i) {
+        area_blocks = (areas[i].len + RESYNC_BLOCK_SIZE - 1) / RESYNC_BLOCK_SIZE;
+        if (block_idx < area_blocks) {
+            *block_len = min(areas[i].len - block_idx * RESYNC_BLOCK_SIZE, (size_t)RESYNC_BLOCK_SIZE);
+            return ((char *)areas[i].buf) + block_idx * RESYNC_BLOCK_SIZE;
+        }
+        block_idx -= area_blocks;
+    }
+    *block_len = 0;
+    return NULL;
+}
 
-        for (i = 0; i < MAX_N_USERS; ++i) {
-            if (netstate.users[i].progress != USER_LOGGEDIN) {
-                continue;
+/**
+ * Fills two hash values for every block; the pair of CRC32 and Adler-32 makes collisions unlikely enough.
+ */
+static void ResyncHashBlocks(const struct NetResyncArea *areas, int count, uint32_t *hashes)
+{
+    size_t num_blocks;
+    size_t block_len;
+    size_t n;
+    const Bytef * block;
+
+    num_blocks = ResyncBlocksCount(areas, count);
+    for (n = 0; n < num_blocks; ++n) {
+        block = (const Bytef *)ResyncBlockPtr(areas, count, n, &block_len);
+        hashes[2*n+0] = crc32(0L, block, block_len);
+        hashes[2*n+1] = adler32(1L, block, block_len);
+    }
+}
+
+/**
+ * Handles a message which came while resync messages were awaited. Scheduled frames are queued
+ * like within the exchange, as the peer could have sent them ahead; other messages are discarded.
+ */
+static void ResyncHandleOtherMessage(NetUserId source, const char *msg, size_t msg_size)
+{
+    if ((msg[0] != NETMSG_SCHEDFRAME) || (msg_size > sizeof(netstate.msg_buffer))) {
+        NETDBG(6, "Discarding message of type %d from user %d", (int)msg[0], (int)source);
+        return;
+    }
+    LbMemoryCopy(netstate.msg_buffer, msg, msg_size);
+    if (source == SERVER_ID) {
+        HandleMessageFromServer(source, netstate.sched_frame_size);
+    } else {
+        HandleMessageFromClient(source, NULL, netstate.sched_frame_size);
+    }
+}
+
+/**
+ * Waits for a message of given type from given user; scheduled frames which come before it are queued.
+ * @return Newly allocated message, or NULL on timeout.
+ */
+static char * ResyncReadMessage(NetUserId source, enum NetMessageType type, size_t *msg_size, TbClockMSec timeout)
+{
+    TbClockMSec start;
+    TbClockMSec elapsed;
+    size_t size;
+    char * msg;
+
+    start = LbTimerClock();
+    for (;;)
+    {
+        elapsed = LbTimerClock() - start;
+        if (elapsed >= timeout) {
+            return NULL;
+        }
+        size = netstate.sp->msgready(source, timeout - elapsed);
+        if (size == 0) {
+            if (netstate.users[source].progress == USER_UNUSED) {
+                return NULL;
             }
+            continue;
+        }
+        msg = (char *) LbMemoryAlloc(size);
+        if (msg == NULL) {
+            return NULL;
+        }
+        *msg_size = netstate.sp->readmsg(source, msg, size);
+        if ((*msg_size > 0) && (msg[0] == type)) {
+            return msg;
+        }
+        if (*msg_size > 0) {
+            ResyncHandleOtherMessage(source, msg, *msg_size);
+        }
+        LbMemoryFree(msg);
+        if (*msg_size == 0) {
+            return NULL;
+        }
+    }
+}
 
-            netstate.sp->sendmsg_single(netstate.users[i].id, full_buf, len + 1);
+/**
+ * Sends to a client the blocks which differ from the ones it has, according to the hashes it sent.
+ */
+static TbBool ResyncSendToClient(NetUserId id, const struct NetResyncArea *areas, int count, const uint32_t *hashes)
+{
+    size_t num_blocks;
+    size_t block_len;
+    size_t msg_size;
+    size_t raw_size;
+    size_t n;
+    uLongf packed_size;
+    uint32_t diff_blocks;
+    uint32_t idx;
+    char * msg;
+    char * raw;
+    char * ptr;
+    const char * block;
+    const uint32_t * client_hashes;
+    size_t client_num_blocks;
+    TbBool result;
+
+    msg = ResyncReadMessage(id, NETMSG_RESYNC, &msg_size, WAIT_FOR_CLIENT_TIMEOUT_IN_MS);
+    if (msg == NULL) {
+        NETLOG("No resync hashes from user %d", (int)id);
+        return false;
+    }
+    // Blocks the client didn't send hashes for are sent in whole
+    client_num_blocks = (msg_size - 1) / (2 * sizeof(uint32_t));
+    client_hashes = (const uint32_t *)(msg + 1);
+
+    num_blocks = ResyncBlocksCount(areas, count);
+    raw = (char *) LbMemoryAlloc(num_blocks * (sizeof(uint32_t) + RESYNC_BLOCK_SIZE) + 1);
+    if (raw == NULL) {
+        LbMemoryFree(msg);
+        return false;
+    }
+    ptr = raw;
+    diff_blocks = 0;
+    for (n = 0; n < num_blocks; ++n)
+    {
+        if ((n < client_num_blocks) && (memcmp(&client_hashes[2*n], &hashes[2*n], 2 * sizeof(uint32_t)) == 0)) {
+            continue;
         }
+        block = ResyncBlockPtr(areas, count, n, &block_len);
+        idx = n;
+        LbMemoryCopy(ptr, &idx, sizeof(idx));
+        ptr += sizeof(idx);
+        LbMemoryCopy(ptr, block, block_len);
+        ptr += block_len;
+        diff_blocks++;
+    }
+    LbMemoryFree(msg);
+    raw_size = ptr - raw;
+
+    packed_size = compressBound(raw_size);
+    msg = (char *) LbMemoryAlloc(1 + 2 * sizeof(uint32_t) + packed_size);
+    if (msg == NULL) {
+        LbMemoryFree(raw);
+        return false;
+    }
+    msg[0] = NETMSG_RESYNC;
+    *(uint32_t *)(msg + 1) = raw_size;
+    *(uint32_t *)(msg + 1 + sizeof(uint32_t)) = diff_blocks;
+    result = (compress2((Bytef *)(msg + 1 + 2 * sizeof(uint32_t)), &packed_size,
+        (const Bytef *)raw, raw_size, Z_BEST_SPEED) == Z_OK);
+    if (result)
+    {
+        msg_size = 1 + 2 * sizeof(uint32_t) + packed_size;
+        netstate.sp->sendmsg_single(id, msg, msg_size);
+        NETLOG("Resync to user %d: %lu of %lu blocks differ, sent %lu bytes",
+            (int)id, (unsigned long)diff_blocks, (unsigned long)num_blocks, (unsigned long)msg_size);
+    } else {
+        NETLOG("Cannot compress resync data for user %d", (int)id);
+    }
+    LbMemoryFree(msg);
+    LbMemoryFree(raw);
+    return result;
+}
+
+/**
+ * Sends hashes of local blocks to the server, and then applies blocks which the server found different.
+ */
+static TbBool ResyncReceiveFromServer(const struct NetResyncArea *areas, int count)
+{
+    size_t num_blocks;
+    size_t block_len;
+    size_t msg_size;
+    uLongf raw_size;
+    uint32_t diff_blocks;
+    uint32_t idx;
+    uint32_t n;
+    char * msg;
+    char * raw;
+    const char * ptr;
+    const char * end;
+    char * block;
+
+    num_blocks = ResyncBlocksCount(areas, count);
+    msg_size = 1 + num_blocks * 2 * sizeof(uint32_t);
+    msg = (char *) LbMemoryAlloc(msg_size);
+    if (msg == NULL) {
+        return false;
+    }
+    msg[0] = NETMSG_RESYNC;
+    ResyncHashBlocks(areas, count, (uint32_t *)(msg + 1));
+    netstate.sp->sendmsg_single(SERVER_ID, msg, msg_size);
+    NETLOG("Sent hashes of %lu resync blocks, %lu bytes", (unsigned long)num_blocks, (unsigned long)msg_size);
+    LbMemoryFree(msg);
+
+    //queue scheduled frames which come before the resync one
+    msg = ResyncReadMessage(SERVER_ID, NETMSG_RESYNC, &msg_size, WAIT_FOR_SERVER_TIMEOUT_IN_MS);
+    if ((msg == NULL) || (msg_size < 1 + 2 * sizeof(uint32_t))) {
+        NETLOG("Bad reception of resync message");
+        LbMemoryFree(msg);
+        return false;
+    }
+    raw_size = *(uint32_t *)(msg + 1);
+    diff_blocks = *(uint32_t *)(msg + 1 + sizeof(uint32_t));
+    raw = (char *) LbMemoryAlloc(raw_size + 1);
+    if ((raw == NULL) || (uncompress((Bytef *)raw, &raw_size,
+        (const Bytef *)(msg + 1 + 2 * sizeof(uint32_t)), msg_size - 1 - 2 * sizeof(uint32_t)) != Z_OK))
+    {
+        NETLOG("Cannot decompress resync message");
+        LbMemoryFree(raw);
+        LbMemoryFree(msg);
+        return false;
     }
-    else {
-        //discard all frames until next resync frame
-        do {
-            if (netstate.sp->readmsg(SERVER_ID, full_buf, len + 1) < 1) {
-                NETLOG("Bad reception of resync message");
-                return false;
-            }
-        } while (full_buf[0] != NETMSG_RESYNC);
+    LbMemoryFree(msg);
 
-        LbMemoryCopy(buf, full_buf + 1, len);
+    ptr = raw;
+    end = raw + raw_size;
+    for (n = 0; n < diff_blocks; ++n)
+    {
+        if (ptr + sizeof(idx) > end) {
+            break;
+        }
+        LbMemoryCopy(&idx, ptr, sizeof(idx));
+        ptr += sizeof(idx);
+        block = ResyncBlockPtr(areas, count, idx, &block_len);
+        if ((block == NULL) || (ptr + block_len > end)) {
+            break;
+        }
+        LbMemoryCopy(block, ptr, block_len);
+        ptr += block_len;
     }
+    LbMemoryFree(raw);
+    if (n < diff_blocks) {
+        NETLOG("Resync message is damaged, got %lu of %lu blocks", (unsigned long)n, (unsigned long)diff_blocks);
+        return false;
+    }
+    NETLOG("Updated %lu of %lu resync blocks", (unsigned long)diff_blocks, (unsigned long)num_blocks);
+    return true;
+}
+
+/**
+ * Makes memory areas of all clients identical to the ones of the server.
+ * Clients send hashes of blocks they have, and server replies with compressed
+ * blocks which are different. All areas must have the same sizes on all machines.
+ */
+TbBool LbNetwork_ResyncAreas(const struct NetResyncArea *areas, int count)
+{
+    TbClockMSec start;
+    uint32_t * hashes;
+    TbBool result;
+    NetUserId id;
 
-    LbMemoryFree(full_buf);
+    NETLOG("Starting");
+    start = LbTimerClock();
 
+    if (netstate.users[netstate.my_id].progress == USER_SERVER)
+    {
+        hashes = (uint32_t *) LbMemoryAlloc(ResyncBlocksCount(areas, count) * 2 * sizeof(uint32_t) + 1);
+        if (hashes == NULL) {
+            return false;
+        }
+        ResyncHashBlocks(areas, count, hashes);
+        result = true;
+        for (id = 0; id < MAX_N_USERS; ++id)
+        {
+            if (netstate.users[id].progress != USER_LOGGEDIN) {
+                continue;
+            }
+            result &= ResyncSendToClient(id, areas, count, hashes);
+        }
+        LbMemoryFree(hashes);
+    }
+    else
+    {
+        result = ResyncReceiveFromServer(areas, count);
+    }
+    NETLOG("Resync finished in %ld ms", (long)(LbTimerClock() - start));
+    return result;
+}
+
+TbBool LbNetwork_Resync(void * buf, size_t len)
+{
+    struct NetResyncArea area;
+
+    area.buf = buf;
+    area.len = len;
+    return LbNetwork_ResyncAreas(&area, 1);
+}
+
+/**
+ * Restarts scheduled exchange, dropping input which was queued before. Used after resync,
+ * as that input was gathered from the state before it. The server sends number of the next
+ * turn to clients, and first turns after it are executed with empty input on all machines.
+ */
+TbBool LbNetwork_RestartScheduled(void)
+{
+    NetUserId id;
+    size_t msg_size;
+    char * msg;
+    int turn;
+
+    if (!netstate.sched_active) {
+        return true;
+    }
+    if (netstate.users[netstate.my_id].progress == USER_SERVER)
+    {
+        turn = netstate.sched_turn;
+        msg = netstate.msg_buffer;
+        msg[0] = NETMSG_RESYNC;
+        LbMemoryCopy(msg + 1, &turn, sizeof(turn));
+        for (id = 0; id < MAX_N_USERS; ++id)
+        {
+            if (netstate.users[id].progress == USER_LOGGEDIN) {
+                netstate.sp->sendmsg_single(id, msg, 1 + sizeof(turn));
+            }
+        }
+    }
+    else
+    {
+        msg = ResyncReadMessage(SERVER_ID, NETMSG_RESYNC, &msg_size, WAIT_FOR_SERVER_TIMEOUT_IN_MS);
+        if ((msg == NULL) || (msg_size < 1 + sizeof(turn))) {
+            NETLOG("No turn to restart scheduled exchange from");
+            LbMemoryFree(msg);
+            return false;
+        }
+        LbMemoryCopy(&turn, msg + 1, sizeof(turn));
+        LbMemoryFree(msg);
+    }
+    StopScheduledExchange();
+    StartScheduledExchange();
+    netstate.sched_turn = turn;
+    netstate.sched_start_turn = turn;
+    NETMSG("Scheduled exchange restarted on turn %d", turn);
     return true;
 }
 
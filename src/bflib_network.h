@@ -39,6 +39,13 @@ extern "C" {
 #define MAX_N_PEERS (MAX_N_USERS - 1)
 #define SERVER_ID   0
 
+/**
+ * Max amount of turns for which input of players can be scheduled ahead.
+ * With scheduled lag of k frames, input gathered on turn N is executed on turn N+k,
+ * so the exchange doesn't have to wait for a full round trip on every turn.
+ */
+#define SCHEDULED_LAG_IN_FRAMES 12
+
 typedef int NetUserId;
 
 enum NetDropReason
@@ -216,6 +223,12 @@ long field_0;
     long field_C;
 };
 
+/** Memory area which is synchronized by LbNetwork_ResyncAreas(). */
+struct NetResyncArea {
+    void *buf;
+    size_t len;
+};
+
 /******************************************************************************/
 
 #pragma pack()
@@ -227,7 +240,12 @@ TbError LbNetwork_Create(char *nsname_str, char *plyr_name, unsigned long *plyr_
 TbError LbNetwork_ExchangeServer(void *server_buf, size_t buf_size);
 TbError LbNetwork_ExchangeClient(void *send_buf, void *server_buf, size_t buf_size);
 TbError LbNetwork_Exchange(void *send_buf, void *server_buf, size_t buf_size);
+TbError LbNetwork_ExchangeScheduled(void *send_buf, void *server_buf, size_t buf_size);
+TbBool  LbNetwork_RestartScheduled(void);
+void    LbNetwork_SetScheduledLag(int frames);
+void    LbNetwork_SetHostingPort(unsigned short port);
 TbBool  LbNetwork_Resync(void * buf, size_t len);
+TbBool  LbNetwork_ResyncAreas(const struct NetResyncArea *areas, int count);
 void    LbNetwork_ChangeExchangeTimeout(unsigned long tmout);
 TbError LbNetwork_EnableNewPlayers(TbBool allow);
 TbError LbNetwork_EnumerateServices(TbNetworkCallbackFunc callback, void *a2);
@@ -22,8 +22,37 @@
 
 #include "globals.h"
 #include "bflib_video.h"
+#include "bflib_vidraw.h"
+#include "bflib_memory.h"
+#include "bflib_fileio.h"
+#include "bflib_threadpool.h"
+#include "bflib_render_span.h"
 #include "post_inc.h"
 
+/******************************************************************************/
+/** Max amount of triangles waiting in the queue for banded rendering. */
+#define TRIG_QUEUE_LENGTH 4096
+/** Max amount of triangles written by one capture; it ends when reached. */
+#define TRIG_STREAM_CAPTURE_MAX 262144
+/** Max amount of horizontal bands the rendering window is divided into. */
+#define TRIG_BANDS_MAX (4*THREADPOOL_THREADS_MAX)
+
+/** Triangle waiting for banded rendering, with the rendering mode it was queued with. */
+struct TrigQueueItem {
+    struct PolyPoint points[3];
+    long min_y;
+    long max_y;
+    unsigned char *vec_map;
+    TbPixel vec_colour;
+    unsigned char vec_mode;
+};
+
+struct TrigBandsJob {
+    struct TrigParams prm;
+    long bands_count;
+    long band_height;
+};
+
 /******************************************************************************/
 TbPixel vec_colour = 112;
 unsigned char vec_mode;
@@ -38,6 +67,14 @@ unsigned long LOC_vec_window_width;
 unsigned long LOC_vec_window_height;
 struct PolyPoint *polyscans = NULL;
 /******************************************************************************/
+static struct TrigQueueItem trig_queue[TRIG_QUEUE_LENGTH];
+static long trig_queue_count = 0;
+/** Edge buffers for all bands; each band uses band_height entries. */
+static struct PolyPoint *trig_bands_polyscans = NULL;
+static long trig_bands_polyscans_count = 0;
+static TbFileHandle trig_stream_file = -1;
+static long trig_stream_items_count = 0;
+/******************************************************************************/
 void draw_triangle(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c)
 {
     draw_gpoly(point_a, point_b, point_c);
@@ -53,6 +90,7 @@ void setup_bflib_render()
 {
     polyscans = malloc(sizeof(struct PolyPoint) * 4096);
     memset(polyscans, 0, sizeof(struct PolyPoint) * 4096);
+    setup_trig_spans();
 }
 
 void reset_bflib_render()
@@ -67,5 +105,173 @@ void finish_bflib_render()
         free(polyscans);
         polyscans = NULL;
     }
+    trig_queue_count = 0;
+    free(trig_bands_polyscans);
+    trig_bands_polyscans = NULL;
+    trig_bands_polyscans_count = 0;
+    trig_stream_capture_stop();
+}
+
+/**
+ * Starts writing all drawn triangles into given file. The header is written with the first triangle,
+ * when size of the rendering window is known.
+ */
+TbBool trig_stream_capture_start(const char *fname)
+{
+    trig_stream_capture_stop();
+    trig_stream_file = LbFileOpen(fname, Lb_FILE_MODE_NEW);
+    if (trig_stream_file == -1)
+    {
+        ERRORLOG("Cannot create triangles capture file \"%s\"",fname);
+        return false;
+    }
+    trig_stream_items_count = 0;
+    return true;
+}
+
+void trig_stream_capture_stop(void)
+{
+    if (trig_stream_file == -1)
+        return;
+    LbFileClose(trig_stream_file);
+    trig_stream_file = -1;
+    SYNCMSG("Captured %ld triangles",trig_stream_items_count);
+}
+
+/**
+ * Writes triangle drawn with current rendering mode into capture file, if capturing.
+ */
+void trig_stream_capture_add(const struct PolyPoint *point_a, const struct PolyPoint *point_b, const struct PolyPoint *point_c)
+{
+    if (trig_stream_file == -1)
+        return;
+    if (trig_stream_items_count == 0)
+    {
+        struct TrigStreamHeader hdr;
+        memcpy(hdr.magic, TRIG_STREAM_MAGIC, sizeof(hdr.magic));
+        hdr.version = TRIG_STREAM_VERSION;
+        hdr.window_width = vec_window_width;
+        hdr.window_height = vec_window_height;
+        LbFileWrite(trig_stream_file, &hdr, sizeof(hdr));
+    }
+    const struct PolyPoint *points[3] = {point_a, point_b, point_c};
+    struct TrigStreamItem item;
+    for (int i = 0; i < 3; i++)
+    {
+        item.coords[i][0] = points[i]->X;
+        item.coords[i][1] = points[i]->Y;
+        item.coords[i][2] = points[i]->U;
+        item.coords[i][3] = points[i]->V;
+        item.coords[i][4] = points[i]->S;
+    }
+    item.vec_mode = vec_mode;
+    item.vec_colour = vec_colour;
+    item.reserved[0] = 0;
+    item.reserved[1] = 0;
+    LbFileWrite(trig_stream_file, &item, sizeof(item));
+    trig_stream_items_count++;
+    if (trig_stream_items_count >= TRIG_STREAM_CAPTURE_MAX)
+        trig_stream_capture_stop();
+}
+
+/**
+ * Adds a triangle to the queue of banded rendering. Works like trig(), but the triangle is drawn
+ * later, by trig_queue_flush(). Rendering mode, colour and texture are remembered with the triangle;
+ * the texture must stay unchanged until the queue is flushed. The triangle is captured here, in queue
+ * order, as bands are drawn on worker threads.
+ */
+void trig_queue_add(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c)
+{
+    trig_stream_capture_add(point_a, point_b, point_c);
+    if (trig_queue_count >= TRIG_QUEUE_LENGTH)
+        trig_queue_flush();
+    struct TrigQueueItem *item = &trig_queue[trig_queue_count];
+    item->points[0] = *point_a;
+    item->points[1] = *point_b;
+    item->points[2] = *point_c;
+    item->min_y = min(min(point_a->Y, point_b->Y), point_c->Y);
+    item->max_y = max(max(point_a->Y, point_b->Y), point_c->Y);
+    item->vec_map = vec_map;
+    item->vec_colour = vec_colour;
+    item->vec_mode = vec_mode;
+    trig_queue_count++;
+}
+
+static void trig_render_bands_job(void *data, long item_beg, long item_end)
+{
+    struct TrigBandsJob *job = (struct TrigBandsJob *)data;
+    for (long band = item_beg; band < item_end; band++)
+    {
+        long y_beg = band * job->band_height;
+        long y_end = y_beg + job->band_height;
+        if (y_end > job->prm.vec_window_height)
+            y_end = job->prm.vec_window_height;
+        if (y_beg >= y_end)
+            continue;
+        struct TrigParams prm = job->prm;
+        prm.poly_screen += y_beg * prm.vec_screen_width;
+        prm.polyscans = &trig_bands_polyscans[band * job->band_height];
+        prm.vec_window_height = y_end - y_beg;
+        for (long i = 0; i < trig_queue_count; i++)
+        {
+            const struct TrigQueueItem *item = &trig_queue[i];
+            // Triangles are clipped to the window, so the ones outside of the band draw nothing in it
+            if ((item->max_y < y_beg) || (item->min_y >= y_end))
+                continue;
+            struct PolyPoint points[3];
+            for (int n = 0; n < 3; n++)
+            {
+                points[n] = item->points[n];
+                points[n].Y -= y_beg;
+            }
+            prm.vec_map = item->vec_map;
+            prm.vec_colour = item->vec_colour;
+            prm.vec_mode = item->vec_mode;
+            trig_with_params(&prm, &points[0], &points[1], &points[2]);
+        }
+    }
+}
+
+/**
+ * Draws all triangles queued by trig_queue_add(), in the order they were added.
+ * The window is divided into horizontal bands, which are drawn concurrently by the thread pool.
+ * Every pixel is drawn by one thread only, and with the same triangles in the same order,
+ * so the result is identical to drawing the triangles with trig().
+ */
+void trig_queue_flush(void)
+{
+    if (trig_queue_count <= 0)
+        return;
+    struct TrigBandsJob job;
+    trig_params_from_globals(&job.prm);
+    job.bands_count = 4 * LbThreadPoolThreadsCount();
+    if (job.bands_count > TRIG_BANDS_MAX)
+        job.bands_count = TRIG_BANDS_MAX;
+    job.band_height = (job.prm.vec_window_height + job.bands_count - 1) / job.bands_count;
+    if (job.band_height < 1)
+        job.band_height = 1;
+    long scans_count = job.band_height * job.bands_count;
+    if (trig_bands_polyscans_count < scans_count)
+    {
+        struct PolyPoint *scans = (struct PolyPoint *)realloc(trig_bands_polyscans, scans_count * sizeof(struct PolyPoint));
+        if (scans == NULL)
+        {
+            WARNLOG("Cannot allocate edge buffers for %ld bands, drawing in one thread",job.bands_count);
+            for (long i = 0; i < trig_queue_count; i++)
+            {
+                struct TrigQueueItem *item = &trig_queue[i];
+                job.prm.vec_map = item->vec_map;
+                job.prm.vec_colour = item->vec_colour;
+                job.prm.vec_mode = item->vec_mode;
+                trig_with_params(&job.prm, &item->points[0], &item->points[1], &item->points[2]);
+            }
+            trig_queue_count = 0;
+            return;
+        }
+        trig_bands_polyscans = scans;
+        trig_bands_polyscans_count = scans_count;
+    }
+    LbThreadPoolRun(trig_render_bands_job, &job, job.bands_count, 1);
+    trig_queue_count = 0;
 }
 /******************************************************************************/
@@ -89,6 +89,43 @@ struct GtBlock { // sizeof = 48
 /******************************************************************************/
 
 #pragma pack()
+/******************************************************************************/
+/**
+ * Rendering parameters of trig_with_params(); copies of global variables used by trig().
+ */
+struct TrigParams {
+    unsigned char *poly_screen; // Screen buffer, pointing one line above the rendering window
+    struct PolyPoint *polyscans; // Buffer for triangle edges, one entry per line of the window
+    unsigned char *vec_map;
+    TbPixel vec_colour;
+    unsigned char vec_mode;
+    unsigned long vec_screen_width;
+    long vec_window_width;
+    long vec_window_height;
+};
+
+#define TRIG_STREAM_MAGIC "KFXTRIGS"
+#define TRIG_STREAM_VERSION 1
+
+/**
+ * Header of a file with captured triangles, for replaying them in benchmarks.
+ * It is followed by TrigStreamItem entries, up to the end of file.
+ */
+struct TrigStreamHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t window_width;
+    uint32_t window_height;
+};
+
+/** Captured triangle, with rendering mode it was drawn with. */
+struct TrigStreamItem {
+    int32_t coords[3][5]; // X, Y, U, V, S of every point
+    uint8_t vec_mode;
+    uint8_t vec_colour;
+    uint8_t reserved[2];
+};
+
 /******************************************************************************/
 extern TbPixel vec_colour;
 extern unsigned char vec_mode;
@@ -114,6 +151,14 @@ void gtblock_set_clipping_window(unsigned char *screen_addr, long clip_width, lo
 void gtblock_draw(struct GtBlock *gtb);
 /******************************************************************************/
 void trig(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c);
+void trig_with_params(const struct TrigParams *prm, struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c);
+void trig_params_from_globals(struct TrigParams *prm);
+/******************************************************************************/
+void trig_queue_add(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c);
+void trig_queue_flush(void);
+TbBool trig_stream_capture_start(const char *fname);
+void trig_stream_capture_stop(void);
+void trig_stream_capture_add(const struct PolyPoint *point_a, const struct PolyPoint *point_b, const struct PolyPoint *point_c);
 /******************************************************************************/
 void setup_bflib_render();
 void reset_bflib_render();
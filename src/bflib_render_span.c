@@ -0,0 +1,284 @@
+/******************************************************************************/
+// Bullfrog Engine Emulation Library - for use to remake classic games like
+// Syndicate Wars, Magic Carpet or Dungeon Keeper.
+/******************************************************************************/
+/** @file bflib_render_span.c
+ *     Horizontal span fillers for triangle rendering.
+ * @par Purpose:
+ *     Draws the inner loops of most used trig() rendering modes, using vector
+ *     instructions if the CPU supports them.
+ * @par Comment:
+ *     All span fillers give results identical to the original scalar loops;
+ *     the packed values and carries between them are kept as they were.
+ * @author   KeeperFX Team
+ * @date     18 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#include "pre_inc.h"
+#include "bflib_render_span.h"
+
+#include "globals.h"
+#include "bflib_basics.h"
+#include "bflib_cpu.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define TRIG_SPANS_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TRIG_SPANS_NEON 1
+#include <arm_neon.h>
+#endif
+#include "post_inc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************/
+/**
+ * Adds step to the state treated as one 72-bit value, with carries from a to b and from b to h.
+ */
+static inline void trig_span_state_add72(struct TrigSpanState *st, const struct TrigSpanState *step)
+{
+    uint64_t lo = ((uint64_t)st->b << 32) | st->a;
+    uint64_t lo_step = ((uint64_t)step->b << 32) | step->a;
+    lo += lo_step;
+    st->h += step->h + (lo < lo_step);
+    st->a = (uint32_t)lo;
+    st->b = (uint32_t)(lo >> 32);
+}
+
+/**
+ * Advances mode 5 state by one pixel, the way the original loop did. Same as trig_span_state_add72(),
+ * except that carry from a to b is lost if b is 0xFFFFFFFF; it then doesn't reach h.
+ */
+static inline void trig_span_state_next(struct TrigSpanState *st, const struct TrigSpanState *step)
+{
+    uint32_t a = st->a + step->a;
+    uint32_t b = st->b + (a < step->a);
+    st->a = a;
+    st->b = b + step->b;
+    st->h += step->h + (st->b < b);
+}
+
+static void span_md05_scalar(unsigned char *o, long count, const struct TrigSpanState *st,
+    const struct TrigSpanState *step, const unsigned char *m, const unsigned char *f)
+{
+    struct TrigSpanState cur = *st;
+    for (; count > 0; count--, o++)
+    {
+        // Fade level from high byte of a, texture column from low byte of b, texture row from h
+        *o = f[(cur.a & 0xFF00) | m[((cur.h & 0xFF) << 8) | (cur.b & 0xFF)]];
+        trig_span_state_next(&cur, step);
+    }
+}
+
+static void span_md07_scalar(unsigned char *o, long count, const struct TrigSpanState *st,
+    const struct TrigSpanState *step, const unsigned char *m, const unsigned char *f)
+{
+    uint32_t u = st->a;
+    uint32_t v = st->b;
+    for (; count > 0; count--, o++)
+    {
+        *o = f[m[((v >> 8) & 0xFF00) | ((u >> 16) & 0xFF)]];
+        u += step->a;
+        v += step->b;
+    }
+}
+
+static const struct TrigSpanFuncs trig_spans_scalar = {
+    "scalar",
+    span_md05_scalar,
+    span_md07_scalar,
+};
+/******************************************************************************/
+#if TRIG_SPANS_X86
+#define SPAN_FUNC(name) name ## _sse2
+#define SPAN_NAME "SSE2"
+#if defined(__GNUC__)
+#define SPAN_TARGET __attribute__((target("sse2")))
+#else
+#define SPAN_TARGET
+#endif
+#define SPAN_VEC __m128i
+#define SPAN_LANES 4
+#define SPAN_LOADU(p) _mm_loadu_si128((const __m128i *)(p))
+#define SPAN_STOREU(p,v) _mm_storeu_si128((__m128i *)(p), v)
+#define SPAN_SET1(x) _mm_set1_epi32((int)(x))
+#define SPAN_ADD(a,b) _mm_add_epi32(a, b)
+#define SPAN_SUB(a,b) _mm_sub_epi32(a, b)
+#define SPAN_AND(a,b) _mm_and_si128(a, b)
+#define SPAN_OR(a,b) _mm_or_si128(a, b)
+#define SPAN_SHL(a,n) _mm_slli_epi32(a, n)
+#define SPAN_SHR(a,n) _mm_srli_epi32(a, n)
+// SSE2 has no unsigned compare; flipping sign bits makes the signed one work
+#define SPAN_LTU(a,b) _mm_cmplt_epi32(_mm_xor_si128(a, _mm_set1_epi32((int)0x80000000)), _mm_xor_si128(b, _mm_set1_epi32((int)0x80000000)))
+#define SPAN_ISZERO(a) _mm_cmpeq_epi32(a, _mm_setzero_si128())
+#include "bflib_render_span_simd.h"
+#undef SPAN_FUNC
+#undef SPAN_NAME
+#undef SPAN_TARGET
+#undef SPAN_VEC
+#undef SPAN_LANES
+#undef SPAN_LOADU
+#undef SPAN_STOREU
+#undef SPAN_SET1
+#undef SPAN_ADD
+#undef SPAN_SUB
+#undef SPAN_AND
+#undef SPAN_OR
+#undef SPAN_SHL
+#undef SPAN_SHR
+#undef SPAN_LTU
+#undef SPAN_ISZERO
+
+#define SPAN_FUNC(name) name ## _avx2
+#define SPAN_NAME "AVX2"
+#if defined(__GNUC__)
+#define SPAN_TARGET __attribute__((target("avx2")))
+#else
+#define SPAN_TARGET
+#endif
+#define SPAN_VEC __m256i
+#define SPAN_LANES 8
+#define SPAN_LOADU(p) _mm256_loadu_si256((const __m256i *)(p))
+#define SPAN_STOREU(p,v) _mm256_storeu_si256((__m256i *)(p), v)
+#define SPAN_SET1(x) _mm256_set1_epi32((int)(x))
+#define SPAN_ADD(a,b) _mm256_add_epi32(a, b)
+#define SPAN_SUB(a,b) _mm256_sub_epi32(a, b)
+#define SPAN_AND(a,b) _mm256_and_si256(a, b)
+#define SPAN_OR(a,b) _mm256_or_si256(a, b)
+#define SPAN_SHL(a,n) _mm256_slli_epi32(a, n)
+#define SPAN_SHR(a,n) _mm256_srli_epi32(a, n)
+#define SPAN_LTU(a,b) _mm256_cmpgt_epi32(_mm256_xor_si256(b, _mm256_set1_epi32((int)0x80000000)), _mm256_xor_si256(a, _mm256_set1_epi32((int)0x80000000)))
+#define SPAN_ISZERO(a) _mm256_cmpeq_epi32(a, _mm256_setzero_si256())
+#include "bflib_render_span_simd.h"
+#undef SPAN_FUNC
+#undef SPAN_NAME
+#undef SPAN_TARGET
+#undef SPAN_VEC
+#undef SPAN_LANES
+#undef SPAN_LOADU
+#undef SPAN_STOREU
+#undef SPAN_SET1
+#undef SPAN_ADD
+#undef SPAN_SUB
+#undef SPAN_AND
+#undef SPAN_OR
+#undef SPAN_SHL
+#undef SPAN_SHR
+#undef SPAN_LTU
+#undef SPAN_ISZERO
+#endif // TRIG_SPANS_X86
+
+#if TRIG_SPANS_NEON
+#define SPAN_FUNC(name) name ## _neon
+#define SPAN_NAME "NEON"
+#define SPAN_TARGET
+#define SPAN_VEC uint32x4_t
+#define SPAN_LANES 4
+#define SPAN_LOADU(p) vld1q_u32(p)
+#define SPAN_STOREU(p,v) vst1q_u32(p, v)
+#define SPAN_SET1(x) vdupq_n_u32(x)
+#define SPAN_ADD(a,b) vaddq_u32(a, b)
+#define SPAN_SUB(a,b) vsubq_u32(a, b)
+#define SPAN_AND(a,b) vandq_u32(a, b)
+#define SPAN_OR(a,b) vorrq_u32(a, b)
+#define SPAN_SHL(a,n) vshlq_n_u32(a, n)
+#define SPAN_SHR(a,n) vshrq_n_u32(a, n)
+#define SPAN_LTU(a,b) vcltq_u32(a, b)
+#define SPAN_ISZERO(a) vceqq_u32(a, vdupq_n_u32(0))
+#include "bflib_render_span_simd.h"
+#undef SPAN_FUNC
+#undef SPAN_NAME
+#undef SPAN_TARGET
+#undef SPAN_VEC
+#undef SPAN_LANES
+#undef SPAN_LOADU
+#undef SPAN_STOREU
+#undef SPAN_SET1
+#undef SPAN_ADD
+#undef SPAN_SUB
+#undef SPAN_AND
+#undef SPAN_OR
+#undef SPAN_SHL
+#undef SPAN_SHR
+#undef SPAN_LTU
+#undef SPAN_ISZERO
+#endif // TRIG_SPANS_NEON
+/******************************************************************************/
+/** Span fillers used by trig(); selected by setup_trig_spans(). */
+const struct TrigSpanFuncs *trig_spans = &trig_spans_scalar;
+/******************************************************************************/
+/**
+ * Returns span fillers of given kind, or NULL if they're not available on this CPU.
+ */
+const struct TrigSpanFuncs *trig_spans_get_funcs(enum TrigSpanKind kind)
+{
+#if TRIG_SPANS_X86
+    struct CPU_INFO cpu_info;
+#endif
+    switch (kind)
+    {
+    case TSpan_Scalar:
+        return &trig_spans_scalar;
+#if TRIG_SPANS_X86
+    case TSpan_SSE2:
+        cpu_detect(&cpu_info);
+        if (cpu_has_sse2(&cpu_info))
+            return &trig_spans_sse2;
+        break;
+    case TSpan_AVX2:
+        cpu_detect(&cpu_info);
+        if (cpu_has_avx2(&cpu_info))
+            return &trig_spans_avx2;
+        break;
+#endif
+#if TRIG_SPANS_NEON
+    case TSpan_NEON:
+        return &trig_spans_neon;
+#endif
+    default:
+        break;
+    }
+    return NULL;
+}
+
+TbBool trig_spans_kind_available(enum TrigSpanKind kind)
+{
+    return (trig_spans_get_funcs(kind) != NULL);
+}
+
+TbBool trig_spans_set_kind(enum TrigSpanKind kind)
+{
+    const struct TrigSpanFuncs *funcs = trig_spans_get_funcs(kind);
+    if (funcs == NULL)
+        return false;
+    trig_spans = funcs;
+    return true;
+}
+
+/**
+ * Selects the fastest span fillers supported by the CPU.
+ */
+void setup_trig_spans(void)
+{
+    enum TrigSpanKind kind;
+    for (kind = TSpan_KindsCount-1; kind > TSpan_Scalar; kind--)
+    {
+        if (trig_spans_set_kind(kind))
+            break;
+    }
+    if (kind == TSpan_Scalar)
+        trig_spans_set_kind(TSpan_Scalar);
+    SYNCDBG(3,"Using %s span fillers",trig_spans->name);
+}
+/******************************************************************************/
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+/******************************************************************************/
+// Bullfrog Engine Emulation Library - for use to remake classic games like
+// Syndicate Wars, Magic Carpet or Dungeon Keeper.
+/******************************************************************************/
+/** @file bflib_render_span.h
+ *     Header file for bflib_render_span.c.
+ * @par Purpose:
+ *     Horizontal span fillers for the most used triangle rendering modes.
+ * @par Comment:
+ *     Just a header file - #defines, typedefs, function prototypes etc.
+ * @author   KeeperFX Team
+ * @date     18 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#ifndef BFLIB_RENDSPAN_H
+#define BFLIB_RENDSPAN_H
+
+#include <stdint.h>
+#include "bflib_basics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************/
+enum TrigSpanKind {
+    TSpan_Scalar = 0,
+    TSpan_SSE2,
+    TSpan_AVX2,
+    TSpan_NEON,
+    TSpan_KindsCount,
+};
+
+/**
+ * Interpolated values of a span pixel, packed the way original rendering code keeps them.
+ * For mode 5, the three values make one 72-bit accumulator (h:b:a), with carry going from
+ * the lower parts to the higher ones; but like in the original code, carry from a is lost
+ * if b is 0xFFFFFFFF. For mode 7, a and b are independent U and V coordinates.
+ */
+struct TrigSpanState {
+    uint32_t a;
+    uint32_t b;
+    uint32_t h;
+};
+
+/**
+ * Span filler; draws count pixels starting at o.
+ * @param st Values for the first pixel.
+ * @param step Values added for every next pixel.
+ * @param m Texture map.
+ * @param f Fade table; for mode 7, already offset to the row of the drawing colour.
+ */
+typedef void (*TrigSpanFunc)(unsigned char *o, long count, const struct TrigSpanState *st,
+    const struct TrigSpanState *step, const unsigned char *m, const unsigned char *f);
+
+struct TrigSpanFuncs {
+    const char *name;
+    /** Textured and shaded span, used by RendVec_mode05. */
+    TrigSpanFunc md05;
+    /** Textured span with fixed fade level, used by RendVec_mode07. */
+    TrigSpanFunc md07;
+};
+/******************************************************************************/
+extern const struct TrigSpanFuncs *trig_spans;
+/******************************************************************************/
+void setup_trig_spans(void);
+TbBool trig_spans_kind_available(enum TrigSpanKind kind);
+TbBool trig_spans_set_kind(enum TrigSpanKind kind);
+const struct TrigSpanFuncs *trig_spans_get_funcs(enum TrigSpanKind kind);
+/******************************************************************************/
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,134 @@
+/******************************************************************************/
+// Bullfrog Engine Emulation Library - for use to remake classic games like
+// Syndicate Wars, Magic Carpet or Dungeon Keeper.
+/******************************************************************************/
+/** @file bflib_render_span_simd.h
+ *     Vector span fillers, written over an abstract vector type.
+ * @par Purpose:
+ *     Template of span fillers, shared by all vector instruction sets.
+ * @par Comment:
+ *     Not a regular header - it is included by bflib_render_span.c once for every
+ *     instruction set, after defining the SPAN_* macros below. Interpolated values
+ *     of SPAN_LANES pixels are computed at once; texture and fade table lookups
+ *     are still made one pixel at a time, as there is no byte gather.
+ *     Required macros:
+ *     - SPAN_FUNC(name) - decorates function name with instruction set suffix
+ *     - SPAN_NAME - instruction set name, as text
+ *     - SPAN_TARGET - function attribute enabling the instruction set
+ *     - SPAN_VEC, SPAN_LANES - vector type of uint32 lanes, and amount of lanes
+ *     - SPAN_LOADU(p), SPAN_STOREU(p,v), SPAN_SET1(x) - loading and storing lanes
+ *     - SPAN_ADD(a,b), SPAN_SUB(a,b), SPAN_AND(a,b), SPAN_OR(a,b) - lane arithmetic
+ *     - SPAN_SHL(a,n), SPAN_SHR(a,n) - logical shifts by constant
+ *     - SPAN_LTU(a,b) - all bits set in lanes where a < b, unsigned
+ *     - SPAN_ISZERO(a) - all bits set in lanes where a == 0
+ * @author   KeeperFX Team
+ * @date     18 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+
+SPAN_TARGET static void SPAN_FUNC(span_md05)(unsigned char *o, long count, const struct TrigSpanState *st,
+    const struct TrigSpanState *step, const unsigned char *m, const unsigned char *f)
+{
+    struct TrigSpanState cur = *st;
+    if (count >= SPAN_LANES)
+    {
+        uint32_t lane_a[SPAN_LANES];
+        uint32_t lane_b[SPAN_LANES];
+        uint32_t lane_h[SPAN_LANES];
+        struct TrigSpanState lnst = cur;
+        struct TrigSpanState lnstep = {0, 0, 0};
+        for (int k = 0; k < SPAN_LANES; k++)
+        {
+            lane_a[k] = lnst.a;
+            lane_b[k] = lnst.b;
+            lane_h[k] = lnst.h;
+            trig_span_state_next(&lnst, step);
+            trig_span_state_add72(&lnstep, step);
+        }
+        SPAN_VEC va = SPAN_LOADU(lane_a);
+        SPAN_VEC vb = SPAN_LOADU(lane_b);
+        SPAN_VEC vh = SPAN_LOADU(lane_h);
+        const SPAN_VEC sa = SPAN_SET1(lnstep.a);
+        const SPAN_VEC sb = SPAN_SET1(lnstep.b);
+        const SPAN_VEC sh = SPAN_SET1(lnstep.h);
+        const SPAN_VEC step_a = SPAN_SET1(step->a);
+        const SPAN_VEC one = SPAN_SET1(1);
+        const SPAN_VEC mask_lo = SPAN_SET1(0xFF);
+        const SPAN_VEC mask_shade = SPAN_SET1(0xFF00);
+        uint32_t texel[SPAN_LANES];
+        uint32_t shade[SPAN_LANES];
+        uint32_t lost[SPAN_LANES];
+        for (; count >= SPAN_LANES; count -= SPAN_LANES, o += SPAN_LANES)
+        {
+            // Sums of steps can't lose a carry like trig_span_state_next() does, so if any lane
+            // is about to lose one, the rest of the span is left to the scalar loop
+            SPAN_STOREU(lost, SPAN_AND(SPAN_LTU(SPAN_ADD(va, step_a), step_a), SPAN_ISZERO(SPAN_ADD(vb, one))));
+            uint32_t any_lost = 0;
+            for (int k = 0; k < SPAN_LANES; k++)
+                any_lost |= lost[k];
+            if (any_lost != 0)
+                break;
+            SPAN_STOREU(texel, SPAN_OR(SPAN_SHL(SPAN_AND(vh, mask_lo), 8), SPAN_AND(vb, mask_lo)));
+            SPAN_STOREU(shade, SPAN_AND(va, mask_shade));
+            for (int k = 0; k < SPAN_LANES; k++)
+                o[k] = f[shade[k] | m[texel[k]]];
+            // Add with carry from a to b and from b to h
+            SPAN_VEC na = SPAN_ADD(va, sa);
+            SPAN_VEC carry_a = SPAN_LTU(na, sa);
+            SPAN_VEC nb = SPAN_ADD(vb, sb);
+            SPAN_VEC carry_b = SPAN_LTU(nb, sb);
+            nb = SPAN_SUB(nb, carry_a);
+            carry_b = SPAN_OR(carry_b, SPAN_AND(carry_a, SPAN_ISZERO(nb)));
+            vh = SPAN_SUB(SPAN_ADD(vh, sh), carry_b);
+            va = na;
+            vb = nb;
+            trig_span_state_add72(&cur, &lnstep);
+        }
+    }
+    span_md05_scalar(o, count, &cur, step, m, f);
+}
+
+SPAN_TARGET static void SPAN_FUNC(span_md07)(unsigned char *o, long count, const struct TrigSpanState *st,
+    const struct TrigSpanState *step, const unsigned char *m, const unsigned char *f)
+{
+    struct TrigSpanState cur = *st;
+    if (count >= SPAN_LANES)
+    {
+        uint32_t lane_u[SPAN_LANES];
+        uint32_t lane_v[SPAN_LANES];
+        for (int k = 0; k < SPAN_LANES; k++)
+        {
+            lane_u[k] = cur.a + k * step->a;
+            lane_v[k] = cur.b + k * step->b;
+        }
+        SPAN_VEC vu = SPAN_LOADU(lane_u);
+        SPAN_VEC vv = SPAN_LOADU(lane_v);
+        const SPAN_VEC su = SPAN_SET1(SPAN_LANES * step->a);
+        const SPAN_VEC sv = SPAN_SET1(SPAN_LANES * step->b);
+        const SPAN_VEC mask_u = SPAN_SET1(0xFF);
+        const SPAN_VEC mask_v = SPAN_SET1(0xFF00);
+        uint32_t texel[SPAN_LANES];
+        for (; count >= SPAN_LANES; count -= SPAN_LANES, o += SPAN_LANES)
+        {
+            SPAN_STOREU(texel, SPAN_OR(SPAN_AND(SPAN_SHR(vv, 8), mask_v), SPAN_AND(SPAN_SHR(vu, 16), mask_u)));
+            for (int k = 0; k < SPAN_LANES; k++)
+                o[k] = f[m[texel[k]]];
+            vu = SPAN_ADD(vu, su);
+            vv = SPAN_ADD(vv, sv);
+            cur.a += SPAN_LANES * step->a;
+            cur.b += SPAN_LANES * step->b;
+        }
+    }
+    span_md07_scalar(o, count, &cur, step, m, f);
+}
+
+static const struct TrigSpanFuncs SPAN_FUNC(trig_spans) = {
+    SPAN_NAME,
+    SPAN_FUNC(span_md05),
+    SPAN_FUNC(span_md07),
+};
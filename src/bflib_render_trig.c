@@ -26,6 +26,7 @@
 #include "bflib_video.h"
 #include "bflib_sprite.h"
 #include "bflib_vidraw.h"
+#include "bflib_render_span.h"
 #include "post_inc.h"
 
 #include "vidmode.h"
@@ -139,6 +140,7 @@ struct TrigLocalPrep {
 };
 
 struct TrigLocalRend {
+    const struct TrigParams *prm;
     unsigned char *var_24;
     long var_44;
     long var_48;
@@ -297,8 +299,8 @@ static inline int trig_ll_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pYb = tlp->var_30 * tlp->var_6C + tlp->var_40;
             if (tlp->var_8C)
             {
-                tlp->trig_height_bottom = vec_window_height;
-                tlr->var_44 = vec_window_height;
+                tlp->trig_height_bottom = tlr->prm->vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
             }
             tlp->var_38 = 0;
         }
@@ -309,12 +311,12 @@ static inline int trig_ll_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pYa += tlp->var_6C * tlp->var_2C;
             if (tlp->var_8C)
             {
-                tlr->var_44 = vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
                 if (tlp->hide_bottom_part) {
-                    tlp->var_38 = vec_window_height;
+                    tlp->var_38 = tlr->prm->vec_window_height;
                 } else {
-                    tlp->hide_bottom_part = vec_window_height <= tlp->var_38;
-                    tlp->trig_height_bottom = vec_window_height - tlp->var_38;
+                    tlp->hide_bottom_part = tlr->prm->vec_window_height <= tlp->var_38;
+                    tlp->trig_height_bottom = tlr->prm->vec_window_height - tlp->var_38;
                 }
             }
             pYb = tlp->var_40;
@@ -327,7 +329,7 @@ static inline int trig_ll_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             long dH, eH;
             TbBool eH_overflow;
 
-            dH = vec_window_height - tlp->var_78;
+            dH = tlr->prm->vec_window_height - tlp->var_78;
             tlr->var_44 = dH;
             if (tlp->hide_bottom_part) {
                 tlp->var_38 = dH;
@@ -341,7 +343,7 @@ static inline int trig_ll_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         }
         pYb = tlp->var_40;
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->var_38; tlp->var_38--)
     {
         pp->X = pX;
@@ -421,8 +423,8 @@ static inline int trig_ll_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pS += tlp->var_6C * tlp->var_64 + tlp->var_38 * tlp->var_64;
             if (tlp->var_8C)
             {
-              tlp->trig_height_bottom = vec_window_height;
-              tlr->var_44 = vec_window_height;
+              tlp->trig_height_bottom = tlr->prm->vec_window_height;
+              tlr->var_44 = tlr->prm->vec_window_height;
             }
             tlp->var_38 = 0;
         }
@@ -434,12 +436,12 @@ static inline int trig_ll_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pS += tlp->var_6C * tlp->var_64;
             if (tlp->var_8C)
             {
-                tlr->var_44 = vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
                 if (tlp->hide_bottom_part) {
-                    tlp->var_38 = vec_window_height;
+                    tlp->var_38 = tlr->prm->vec_window_height;
                 } else {
-                    tlp->hide_bottom_part = vec_window_height <= tlp->var_38;
-                    tlp->trig_height_bottom = vec_window_height - tlp->var_38;
+                    tlp->hide_bottom_part = tlr->prm->vec_window_height <= tlp->var_38;
+                    tlp->trig_height_bottom = tlr->prm->vec_window_height - tlp->var_38;
                 }
             }
             pYb = tlp->var_40;
@@ -452,7 +454,7 @@ static inline int trig_ll_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             long dH, eH;
             TbBool eH_overflow;
 
-            dH = vec_window_height - tlp->var_78;
+            dH = tlr->prm->vec_window_height - tlp->var_78;
             tlr->var_44 = dH;
             if (tlp->hide_bottom_part) {
                 tlp->var_38 = dH;
@@ -465,7 +467,7 @@ static inline int trig_ll_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         }
         pYb = tlp->var_40;
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->var_38; tlp->var_38--)
     {
         pp->X = pX;
@@ -554,8 +556,8 @@ static inline int trig_ll_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pV += tlp->var_6C * tlp->var_58 + tlp->var_38 * tlp->var_58;
             if ( tlp->var_8C )
             {
-                tlp->trig_height_bottom = vec_window_height;
-                tlr->var_44 = vec_window_height;
+                tlp->trig_height_bottom = tlr->prm->vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
             }
             tlp->var_38 = 0;
         }
@@ -568,12 +570,12 @@ static inline int trig_ll_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pV += tlp->var_6C * tlp->var_58;
             if ( tlp->var_8C )
             {
-                tlr->var_44 = vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
                 if (tlp->hide_bottom_part) {
-                  tlp->var_38 = vec_window_height;
+                  tlp->var_38 = tlr->prm->vec_window_height;
                 } else {
-                  tlp->hide_bottom_part = vec_window_height <= tlp->var_38;
-                  tlp->trig_height_bottom = vec_window_height - tlp->var_38;
+                  tlp->hide_bottom_part = tlr->prm->vec_window_height <= tlp->var_38;
+                  tlp->trig_height_bottom = tlr->prm->vec_window_height - tlp->var_38;
                 }
             }
             pYb = tlp->var_40;
@@ -586,7 +588,7 @@ static inline int trig_ll_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             long dH, eH;
             TbBool eH_overflow;
 
-            dH = vec_window_height - tlp->var_78;
+            dH = tlr->prm->vec_window_height - tlp->var_78;
             tlr->var_44 = dH;
             if (tlp->hide_bottom_part) {
                 tlp->var_38 = dH;
@@ -599,7 +601,7 @@ static inline int trig_ll_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         }
         pYb = tlp->var_40;
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->var_38; tlp->var_38--)
     {
         pp->X = pX;
@@ -699,8 +701,8 @@ static inline int trig_ll_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pV += tlp->var_6C * tlp->var_58 + tlp->var_38 * tlp->var_58;
             pS += tlp->var_6C * tlp->var_64 + tlp->var_38 * tlp->var_64;
             if (tlp->var_8C) {
-              tlp->trig_height_bottom = vec_window_height;
-              tlr->var_44 = vec_window_height;
+              tlp->trig_height_bottom = tlr->prm->vec_window_height;
+              tlr->var_44 = tlr->prm->vec_window_height;
             }
             tlp->var_38 = 0;
         }
@@ -714,12 +716,12 @@ static inline int trig_ll_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pS += tlp->var_6C * tlp->var_64;
             if (tlp->var_8C)
             {
-                tlr->var_44 = vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
                 if (tlp->hide_bottom_part) {
-                    tlp->var_38 = vec_window_height;
+                    tlp->var_38 = tlr->prm->vec_window_height;
                 } else {
-                    tlp->hide_bottom_part = vec_window_height <= tlp->var_38;
-                    tlp->trig_height_bottom = vec_window_height - tlp->var_38;
+                    tlp->hide_bottom_part = tlr->prm->vec_window_height <= tlp->var_38;
+                    tlp->trig_height_bottom = tlr->prm->vec_window_height - tlp->var_38;
                 }
             }
             pYb = tlp->var_40;
@@ -732,10 +734,10 @@ static inline int trig_ll_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             long dH, eH;
             TbBool eH_overflow;
 
-            dH = vec_window_height - tlp->var_78;
-            tlr->var_44 = vec_window_height - tlp->var_78;
+            dH = tlr->prm->vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
             if (tlp->hide_bottom_part) {
-                tlp->var_38 = vec_window_height - tlp->var_78;
+                tlp->var_38 = tlr->prm->vec_window_height - tlp->var_78;
             } else {
                 eH_overflow = __OFSUBL__(dH, tlp->var_38);
                 eH = dH - tlp->var_38;
@@ -745,7 +747,7 @@ static inline int trig_ll_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         }
         pYb = tlp->var_40;
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->var_38; tlp->var_38--)
     {
         pp->X = pX;
@@ -788,22 +790,22 @@ int trig_ll_start(struct TrigLocalPrep *tlp, struct TrigLocalRend *tlr, const st
 
     tlp->var_78 = opt_a->Y;
     if (opt_a->Y < 0) {
-      tlr->var_24 = poly_screen;
+      tlr->var_24 = tlr->prm->poly_screen;
       tlp->var_8A = 1;
-    } else if (opt_a->Y < vec_window_height) {
-      tlr->var_24 = poly_screen + vec_screen_width * opt_a->Y;
+    } else if (opt_a->Y < tlr->prm->vec_window_height) {
+      tlr->var_24 = tlr->prm->poly_screen + tlr->prm->vec_screen_width * opt_a->Y;
       tlp->var_8A = 0;
     } else {
-        NOLOG("height %ld exceeded by opt_a Y %ld", (long)vec_window_height, (long)opt_a->Y);
+        NOLOG("height %ld exceeded by opt_a Y %ld", (long)tlr->prm->vec_window_height, (long)opt_a->Y);
         return 0;
     }
 
-    tlp->var_8C = opt_c->Y > vec_window_height;
+    tlp->var_8C = opt_c->Y > tlr->prm->vec_window_height;
     dY = opt_c->Y - opt_a->Y;
     tlp->trig_height_top = dY;
     tlr->var_44 = dY;
 
-    tlp->hide_bottom_part = opt_b->Y > vec_window_height;
+    tlp->hide_bottom_part = opt_b->Y > tlr->prm->vec_window_height;
     dY = opt_b->Y - opt_a->Y;
     tlp->var_38 = dY;
     dX = opt_c->X - opt_a->X;
@@ -822,7 +824,7 @@ int trig_ll_start(struct TrigLocalPrep *tlp, struct TrigLocalRend *tlr, const st
     tlp->var_40 = opt_b->X << 16;
 
     ret = 0;
-    switch (vec_mode) /* swars-final @ 0x120F07 */
+    switch (tlr->prm->vec_mode) /* swars-final @ 0x120F07 */
     {
     case RendVec_mode00:
     case RendVec_mode14:
@@ -895,8 +897,8 @@ static inline int trig_rl_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pXb = tlp->var_30 * tlp->var_6C + tlp->var_40;
             pY += tlp->var_6C * tlp->var_2C + tlp->trig_height_top * tlp->var_2C;
             if (tlp->var_8C) {
-              tlp->trig_height_bottom = vec_window_height;
-              tlr->var_44 = vec_window_height;
+              tlp->trig_height_bottom = tlr->prm->vec_window_height;
+              tlr->var_44 = tlr->prm->vec_window_height;
             }
             tlp->trig_height_top = 0;
         }
@@ -907,12 +909,12 @@ static inline int trig_rl_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pY += tlp->var_6C * tlp->var_2C;
             if (tlp->var_8C)
             {
-                tlr->var_44 = vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
                 if (tlp->hide_bottom_part) {
-                    tlp->trig_height_top = vec_window_height;
+                    tlp->trig_height_top = tlr->prm->vec_window_height;
                 } else {
-                    tlp->hide_bottom_part = vec_window_height <= tlp->trig_height_top;
-                    tlp->trig_height_bottom = vec_window_height - tlp->trig_height_top;
+                    tlp->hide_bottom_part = tlr->prm->vec_window_height <= tlp->trig_height_top;
+                    tlp->trig_height_bottom = tlr->prm->vec_window_height - tlp->trig_height_top;
                 }
             }
             pXb = tlp->var_40;
@@ -925,7 +927,7 @@ static inline int trig_rl_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             long dH, eH;
             TbBool eH_overflow;
 
-            dH = vec_window_height - tlp->var_78;
+            dH = tlr->prm->vec_window_height - tlp->var_78;
             tlr->var_44 = dH;
             if (tlp->hide_bottom_part) {
                 tlp->trig_height_top = dH;
@@ -938,7 +940,7 @@ static inline int trig_rl_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         }
         pXb = tlp->var_40;
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pXa;
@@ -1016,8 +1018,8 @@ static inline int trig_rl_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pY += tlp->var_6C * tlp->var_2C + tlp->trig_height_top * tlp->var_2C;
             pS += tlp->var_6C * tlp->var_68 + tlp->trig_height_top * tlp->var_64;
             if (tlp->var_8C) {
-                tlp->trig_height_bottom = vec_window_height;
-                tlr->var_44 = vec_window_height;
+                tlp->trig_height_bottom = tlr->prm->vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
             }
             tlp->trig_height_top = 0;
         }
@@ -1029,15 +1031,15 @@ static inline int trig_rl_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pS += tlp->var_6C * tlp->var_64;
             if ( tlp->var_8C )
             {
-                tlr->var_44 = vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
                 if ( tlp->hide_bottom_part )
                 {
-                  tlp->trig_height_top = vec_window_height;
+                  tlp->trig_height_top = tlr->prm->vec_window_height;
                 }
                 else
                 {
-                  tlp->hide_bottom_part = vec_window_height <= tlp->trig_height_top;
-                  tlp->trig_height_bottom = vec_window_height - tlp->trig_height_top;
+                  tlp->hide_bottom_part = tlr->prm->vec_window_height <= tlp->trig_height_top;
+                  tlp->trig_height_bottom = tlr->prm->vec_window_height - tlp->trig_height_top;
                 }
             }
             pXb = tlp->var_40;
@@ -1050,10 +1052,10 @@ static inline int trig_rl_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             long dH, eH;
             TbBool eH_overflow;
 
-            dH = vec_window_height - tlp->var_78;
-            tlr->var_44 = vec_window_height - tlp->var_78;
+            dH = tlr->prm->vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
             if (tlp->hide_bottom_part) {
-                tlp->trig_height_top = vec_window_height - tlp->var_78;
+                tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
             } else {
                 eH_overflow = __OFSUBL__(dH, tlp->trig_height_top);
                 eH = dH - tlp->trig_height_top;
@@ -1063,7 +1065,7 @@ static inline int trig_rl_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         }
         pXb = tlp->var_40;
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pXa;
@@ -1153,8 +1155,8 @@ static inline int trig_rl_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pU += tlp->var_6C * tlp->var_50 + tlp->trig_height_top * tlp->var_4C;
             pV += tlp->var_6C * tlp->var_5C + tlp->trig_height_top * tlp->var_58;
             if (tlp->var_8C) {
-                tlp->trig_height_bottom = vec_window_height;
-                tlr->var_44 = vec_window_height;
+                tlp->trig_height_bottom = tlr->prm->vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
             }
             tlp->trig_height_top = 0;
         }
@@ -1167,12 +1169,12 @@ static inline int trig_rl_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pV += tlp->var_6C * tlp->var_58;
             if ( tlp->var_8C )
             {
-                tlr->var_44 = vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
                 if (tlp->hide_bottom_part) {
-                    tlp->trig_height_top = vec_window_height;
+                    tlp->trig_height_top = tlr->prm->vec_window_height;
                 } else {
-                    tlp->hide_bottom_part = vec_window_height <= tlp->trig_height_top;
-                    tlp->trig_height_bottom = vec_window_height - tlp->trig_height_top;
+                    tlp->hide_bottom_part = tlr->prm->vec_window_height <= tlp->trig_height_top;
+                    tlp->trig_height_bottom = tlr->prm->vec_window_height - tlp->trig_height_top;
                 }
             }
             pXb = tlp->var_40;
@@ -1185,7 +1187,7 @@ static inline int trig_rl_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             long dH, eH;
             TbBool eH_overflow;
 
-            dH = vec_window_height - tlp->var_78;
+            dH = tlr->prm->vec_window_height - tlp->var_78;
             tlr->var_44 = dH;
             if (tlp->hide_bottom_part) {
                 tlp->trig_height_top = dH;
@@ -1198,7 +1200,7 @@ static inline int trig_rl_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         }
         pXb = tlp->var_40;
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
 
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
@@ -1301,8 +1303,8 @@ static inline int trig_rl_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pV += tlp->var_6C * tlp->var_5C + tlp->trig_height_top * tlp->var_58;
             pS += tlp->var_6C * tlp->var_68 + tlp->trig_height_top * tlp->var_64;
             if (tlp->var_8C) {
-                tlp->trig_height_bottom = vec_window_height;
-                tlr->var_44 = vec_window_height;
+                tlp->trig_height_bottom = tlr->prm->vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
             }
             tlp->trig_height_top = 0;
         }
@@ -1315,12 +1317,12 @@ static inline int trig_rl_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             pV += tlp->var_6C * tlp->var_58;
             pS += tlp->var_6C * tlp->var_64;
             if (tlp->var_8C) {
-                tlr->var_44 = vec_window_height;
+                tlr->var_44 = tlr->prm->vec_window_height;
                 if (tlp->hide_bottom_part) {
-                    tlp->trig_height_top = vec_window_height;
+                    tlp->trig_height_top = tlr->prm->vec_window_height;
                 } else {
-                    tlp->hide_bottom_part = vec_window_height <= tlp->trig_height_top;
-                    tlp->trig_height_bottom = vec_window_height - tlp->trig_height_top;
+                    tlp->hide_bottom_part = tlr->prm->vec_window_height <= tlp->trig_height_top;
+                    tlp->trig_height_bottom = tlr->prm->vec_window_height - tlp->trig_height_top;
                 }
             }
             pXb = tlp->var_40;
@@ -1333,7 +1335,7 @@ static inline int trig_rl_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
             long dH, eH;
             TbBool eH_overflow;
 
-            dH = vec_window_height - tlp->var_78;
+            dH = tlr->prm->vec_window_height - tlp->var_78;
             tlr->var_44 = dH;
             if (tlp->hide_bottom_part) {
                 tlp->trig_height_top = dH;
@@ -1346,7 +1348,7 @@ static inline int trig_rl_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         }
         pXb = tlp->var_40;
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pXa;
@@ -1389,21 +1391,21 @@ int trig_rl_start(struct TrigLocalPrep *tlp, struct TrigLocalRend *tlr, const st
 
     tlp->var_78 = opt_a->Y;
     if (opt_a->Y < 0) {
-      tlr->var_24 = poly_screen;
+      tlr->var_24 = tlr->prm->poly_screen;
       tlp->var_8A = 1;
-    } else if (opt_a->Y < vec_window_height) {
-      tlr->var_24 = poly_screen + vec_screen_width * opt_a->Y;
+    } else if (opt_a->Y < tlr->prm->vec_window_height) {
+      tlr->var_24 = tlr->prm->poly_screen + tlr->prm->vec_screen_width * opt_a->Y;
       tlp->var_8A = 0;
     } else  {
-        NOLOG("height %ld exceeded by opt_a Y %ld", (long)vec_window_height, (long)opt_a->Y);
+        NOLOG("height %ld exceeded by opt_a Y %ld", (long)tlr->prm->vec_window_height, (long)opt_a->Y);
         return 0;
     }
 
-    tlp->hide_bottom_part = opt_c->Y > vec_window_height;
+    tlp->hide_bottom_part = opt_c->Y > tlr->prm->vec_window_height;
     dY = opt_c->Y - opt_a->Y;
     tlp->trig_height_top = dY;
 
-    tlp->var_8C = opt_b->Y > vec_window_height;
+    tlp->var_8C = opt_b->Y > tlr->prm->vec_window_height;
     dY = opt_b->Y - opt_a->Y;
     tlp->var_38 = dY;
     tlr->var_44 = dY;
@@ -1423,7 +1425,7 @@ int trig_rl_start(struct TrigLocalPrep *tlp, struct TrigLocalRend *tlr, const st
     tlp->var_40 = opt_c->X << 16;
 
     ret = 0;
-    switch (vec_mode) /* swars-final @ 0x121814 */
+    switch (tlr->prm->vec_mode) /* swars-final @ 0x121814 */
     {
     case RendVec_mode00:
     case RendVec_mode14:
@@ -1490,18 +1492,18 @@ static inline int trig_fb_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         pX += tlp->var_28 * (-tlp->var_78);
         pY += (-tlp->var_78) * tlp->var_2C;
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height;
-            tlp->trig_height_top = vec_window_height;
+            tlr->var_44 = tlr->prm->vec_window_height;
+            tlp->trig_height_top = tlr->prm->vec_window_height;
         }
     }
     else
     {
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height - tlp->var_78;
-            tlp->trig_height_top = vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
+            tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
         }
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pX;
@@ -1547,18 +1549,18 @@ static inline int trig_fb_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         pY += (-tlp->var_78) * tlp->var_2C;
         pS += (-tlp->var_78) * tlp->var_64;
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height;
-            tlp->trig_height_top = vec_window_height;
+            tlr->var_44 = tlr->prm->vec_window_height;
+            tlp->trig_height_top = tlr->prm->vec_window_height;
         }
     }
     else
     {
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height - tlp->var_78;
-            tlp->trig_height_top = vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
+            tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
         }
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pX;
@@ -1610,18 +1612,18 @@ static inline int trig_fb_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         pU += (-tlp->var_78) * tlp->var_4C;
         pV += (-tlp->var_78) * tlp->var_58;
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height;
-            tlp->trig_height_top = vec_window_height;
+            tlr->var_44 = tlr->prm->vec_window_height;
+            tlp->trig_height_top = tlr->prm->vec_window_height;
         }
     }
     else
     {
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height - tlp->var_78;
-            tlp->trig_height_top = vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
+            tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
         }
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pX;
@@ -1679,18 +1681,18 @@ static inline int trig_fb_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         pV += (-tlp->var_78) * tlp->var_58;
         pS += (-tlp->var_78) * tlp->var_64;
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height;
-            tlp->trig_height_top = vec_window_height;
+            tlr->var_44 = tlr->prm->vec_window_height;
+            tlp->trig_height_top = tlr->prm->vec_window_height;
         }
     }
     else
     {
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height - tlp->var_78;
-            tlp->trig_height_top = vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
+            tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
         }
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pX;
@@ -1716,16 +1718,16 @@ int trig_fb_start(struct TrigLocalPrep *tlp, struct TrigLocalRend *tlr, const st
 
     tlp->var_78 = opt_a->Y;
     if (opt_a->Y < 0) {
-        tlr->var_24 = poly_screen;
+        tlr->var_24 = tlr->prm->poly_screen;
         tlp->var_8A = 1;
-    } else if (opt_a->Y < vec_window_height) {
-        tlr->var_24 = poly_screen + vec_screen_width * opt_a->Y;
+    } else if (opt_a->Y < tlr->prm->vec_window_height) {
+        tlr->var_24 = tlr->prm->poly_screen + tlr->prm->vec_screen_width * opt_a->Y;
         tlp->var_8A = 0;
     } else {
-        NOLOG("height %ld exceeded by opt_a Y %ld", (long)vec_window_height, (long)opt_a->Y);
+        NOLOG("height %ld exceeded by opt_a Y %ld", (long)tlr->prm->vec_window_height, (long)opt_a->Y);
         return 0;
     }
-    tlp->hide_bottom_part = opt_c->Y > vec_window_height;
+    tlp->hide_bottom_part = opt_c->Y > tlr->prm->vec_window_height;
     dY = opt_c->Y - opt_a->Y;
     tlp->trig_height_top = dY;
     tlr->var_44 = dY;
@@ -1735,7 +1737,7 @@ int trig_fb_start(struct TrigLocalPrep *tlp, struct TrigLocalRend *tlr, const st
     tlp->var_2C = (dX << 16) / dY;
 
     ret = 0;
-    switch (vec_mode) /* swars-final @ 0x122142, genewars-beta @ 0xEFE72 */
+    switch (tlr->prm->vec_mode) /* swars-final @ 0x122142, genewars-beta @ 0xEFE72 */
     {
     case RendVec_mode00:
     case RendVec_mode14:
@@ -1802,18 +1804,18 @@ static inline int trig_ft_md00(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         pX += tlp->var_28 * (-tlp->var_78);
         pY += (-tlp->var_78) * tlp->var_2C;
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height;
-            tlp->trig_height_top = vec_window_height;
+            tlr->var_44 = tlr->prm->vec_window_height;
+            tlp->trig_height_top = tlr->prm->vec_window_height;
         }
     }
     else
     {
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height - tlp->var_78;
-            tlp->trig_height_top = vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
+            tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
         }
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pX;
@@ -1859,18 +1861,18 @@ static inline int trig_ft_md01(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         pY += (-tlp->var_78) * tlp->var_2C;
         pS += (-tlp->var_78) * tlp->var_64;
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height;
-            tlp->trig_height_top = vec_window_height;
+            tlr->var_44 = tlr->prm->vec_window_height;
+            tlp->trig_height_top = tlr->prm->vec_window_height;
         }
     }
     else
     {
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height - tlp->var_78;
-            tlp->trig_height_top = vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
+            tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
         }
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pX;
@@ -1921,18 +1923,18 @@ static inline int trig_ft_md02(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         pU += (-tlp->var_78) * tlp->var_4C;
         pV += (-tlp->var_78) * tlp->var_58;
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height;
-            tlp->trig_height_top = vec_window_height;
+            tlr->var_44 = tlr->prm->vec_window_height;
+            tlp->trig_height_top = tlr->prm->vec_window_height;
         }
     }
     else
     {
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height - tlp->var_78;
-            tlp->trig_height_top = vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
+            tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
         }
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pX;
@@ -1990,18 +1992,18 @@ static inline int trig_ft_md05(struct TrigLocalPrep *tlp, struct TrigLocalRend *
         pV += (-tlp->var_78) * tlp->var_58;
         pS += (-tlp->var_78) * tlp->var_64;
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height;
-            tlp->trig_height_top = vec_window_height;
+            tlr->var_44 = tlr->prm->vec_window_height;
+            tlp->trig_height_top = tlr->prm->vec_window_height;
         }
     }
     else
     {
         if (tlp->hide_bottom_part) {
-            tlr->var_44 = vec_window_height - tlp->var_78;
-            tlp->trig_height_top = vec_window_height - tlp->var_78;
+            tlr->var_44 = tlr->prm->vec_window_height - tlp->var_78;
+            tlp->trig_height_top = tlr->prm->vec_window_height - tlp->var_78;
         }
     }
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     for (; tlp->trig_height_top; tlp->trig_height_top--)
     {
         pp->X = pX;
@@ -2027,16 +2029,16 @@ int trig_ft_start(struct TrigLocalPrep *tlp, struct TrigLocalRend *tlr, const st
 
     tlp->var_78 = opt_a->Y;
     if (opt_a->Y < 0) {
-      tlr->var_24 = poly_screen;
+      tlr->var_24 = tlr->prm->poly_screen;
       tlp->var_8A = 1;
-    } else if (opt_a->Y < vec_window_height) {
-      tlr->var_24 = poly_screen + vec_screen_width * opt_a->Y;
+    } else if (opt_a->Y < tlr->prm->vec_window_height) {
+      tlr->var_24 = tlr->prm->poly_screen + tlr->prm->vec_screen_width * opt_a->Y;
       tlp->var_8A = 0;
     } else {
-        NOLOG("height %ld exceeded by opt_a Y %ld", (long)vec_window_height, (long)opt_a->Y);
+        NOLOG("height %ld exceeded by opt_a Y %ld", (long)tlr->prm->vec_window_height, (long)opt_a->Y);
         return 0;
     }
-    tlp->hide_bottom_part = opt_c->Y > vec_window_height;
+    tlp->hide_bottom_part = opt_c->Y > tlr->prm->vec_window_height;
     dY = opt_c->Y - opt_a->Y;
     tlp->trig_height_top = dY;
     tlr->var_44 = dY;
@@ -2046,7 +2048,7 @@ int trig_ft_start(struct TrigLocalPrep *tlp, struct TrigLocalRend *tlr, const st
     tlp->var_2C = (dX << 16) / dY;
 
     ret = 0;
-    switch (vec_mode) /* swars-final @ 0x1225c1, genewars-beta @ 0xF02F1 */
+    switch (tlr->prm->vec_mode) /* swars-final @ 0x1225c1, genewars-beta @ 0xF02F1 */
     {
     case RendVec_mode00:
     case RendVec_mode14:
@@ -2139,13 +2141,13 @@ void trig_render_md00(struct TrigLocalRend *tlr)
     unsigned char *o_ln;
     unsigned char col;
 
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if (pp == NULL) {
         ERRORLOG("global array not set: 0x%p", pp);
         return;
     }
     o_ln = tlr->var_24;
-    col = vec_colour;
+    col = tlr->prm->vec_colour;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
     {
@@ -2154,20 +2156,20 @@ void trig_render_md00(struct TrigLocalRend *tlr)
 
         pX = pp->X >> 16;
         pY = pp->Y >> 16;
-        o_ln += vec_screen_width;
+        o_ln += tlr->prm->vec_screen_width;
         if (pX < 0)
         {
             if (pY <= 0)
                 continue;
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
             o = &o_ln[0];
         }
         else
         {
             TbBool pY_overflow;
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBL__(pY, pX);
             pY = pY - pX;
             if (((pY < 0) ^ pY_overflow) | (pY == 0))
@@ -2182,7 +2184,7 @@ void trig_render_md01(struct TrigLocalRend *tlr)
 {
     struct PolyPoint *pp;
     TbBool pS_carry;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if (pp == NULL) {
         ERRORLOG("global array not set: 0x%p", pp);
         return;
@@ -2197,8 +2199,8 @@ void trig_render_md01(struct TrigLocalRend *tlr)
 
         pX = pp->X >> 16;
         pY = pp->Y >> 16;
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
 
         if (pX  < 0)
         {
@@ -2212,18 +2214,18 @@ void trig_render_md01(struct TrigLocalRend *tlr)
             pS = pp->S + mX;
             // Delcate code - if we add before shifting, the result is different
             colH = (mX >> 16) + (pp->S >> 16) + pS_carry;
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
 
-            colS = ((colH & 0xFF) << 8) + vec_colour;
+            colS = ((colH & 0xFF) << 8) + tlr->prm->vec_colour;
         }
         else
         {
             TbBool pY_overflow;
             short colH;
 
-            if (pY > vec_window_width)
-              pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+              pY = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pY, pX);
             pY = pY - pX;
             if (((pY < 0) ^ pY_overflow) | (pY == 0))
@@ -2232,7 +2234,7 @@ void trig_render_md01(struct TrigLocalRend *tlr)
             colH = pp->S >> 16;
             pS = pp->S;
 
-            colS = ((colH & 0xFF) << 8) + vec_colour;
+            colS = ((colH & 0xFF) << 8) + tlr->prm->vec_colour;
         }
 
         for (;pY > 0; pY--, o++)
@@ -2256,8 +2258,8 @@ void trig_render_md02(struct TrigLocalRend *tlr)
     unsigned char *m;
     long lsh_var_54;
 
-    m = vec_map;
-    pp = polyscans;
+    m = tlr->prm->vec_map;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p", m, pp);
         return;
@@ -2273,8 +2275,8 @@ void trig_render_md02(struct TrigLocalRend *tlr)
 
         pX = pp->X >> 16;
         pY = pp->Y >> 16;
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
 
         if (pX < 0)
         {
@@ -2290,8 +2292,8 @@ void trig_render_md02(struct TrigLocalRend *tlr)
             mX = tlr->var_48 * (-pX);
             pU = (factorA & 0xFFFF0000) | ((pp->U + mX) & 0xFFFF);
             colL = (pp->U + mX) >> 16;
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
             pX = (pp->U + mX) >> 8;
 
             colS = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -2301,8 +2303,8 @@ void trig_render_md02(struct TrigLocalRend *tlr)
             short colL, colH;
             TbBool pY_overflow;
 
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pY, pX);
             pY = pY - pX;
             if (((pY < 0) ^ pY_overflow) | (pY == 0))
@@ -2342,8 +2344,8 @@ void trig_render_md03(struct TrigLocalRend *tlr)
     unsigned char *m;
     long lsh_var_54;
 
-    m = vec_map;
-    pp = polyscans;
+    m = tlr->prm->vec_map;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p", m, pp);
         return;
@@ -2360,8 +2362,8 @@ void trig_render_md03(struct TrigLocalRend *tlr)
 
         pX = pp->X >> 16;
         pY = pp->Y >> 16;
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
 
         if (pX < 0)
         {
@@ -2376,8 +2378,8 @@ void trig_render_md03(struct TrigLocalRend *tlr)
             mX = tlr->var_48 * (-pX);
             pU = (factorA & 0xFFFF0000) | ((pp->U + mX) & 0xFFFF);
             colL = (pp->U + mX) >> 16;
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
 
             colS = ((colH & 0xFF) << 8) + (colL & 0xFF);
         }
@@ -2386,8 +2388,8 @@ void trig_render_md03(struct TrigLocalRend *tlr)
             short colL, colH;
             TbBool pY_overflow;
 
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pY, pX);
             pY = pY - pX;
             if (((pY < 0) ^ pY_overflow) | (pY == 0))
@@ -2433,7 +2435,7 @@ void trig_render_md04(struct TrigLocalRend *tlr)
     unsigned char *f;
 
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((f == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p", f, pp);
         return;
@@ -2448,8 +2450,8 @@ void trig_render_md04(struct TrigLocalRend *tlr)
 
         pX = pp->X >> 16;
         pY = pp->Y >> 16;
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pX < 0)
         {
             ushort colL, colH;
@@ -2462,9 +2464,9 @@ void trig_render_md04(struct TrigLocalRend *tlr)
             pU_carry = __CFADDS__(pp->S, mX);
             pU = pp->S + mX;
             colH = (pp->S >> 16) + pU_carry + (mX >> 16);
-            if (pY > vec_window_width)
-                pY = vec_window_width;
-            colL = vec_colour;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
+            colL = tlr->prm->vec_colour;
 
             colS = ((colH & 0xFF) << 8) + (colL & 0xFF);
         }
@@ -2473,14 +2475,14 @@ void trig_render_md04(struct TrigLocalRend *tlr)
             ushort colL, colH;
             TbBool pY_overflow;
 
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pY, pX);
             pY = pY - pX;
             if (((pY < 0) ^ pY_overflow) | (pY == 0))
                 continue;
             o += pX;
-            colL = vec_colour;
+            colL = tlr->prm->vec_colour;
             pU = pp->S;
             colH = pp->S >> 16;
 
@@ -2511,10 +2513,11 @@ void trig_render_md05(struct TrigLocalRend *tlr)
     long lsh_var_54;
     long lsh_var_60;
     long lvr_var_54;
+    struct TrigSpanState span_step;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (f == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p 0x%p", m, f, pp);
         return;
@@ -2532,19 +2535,21 @@ void trig_render_md05(struct TrigLocalRend *tlr)
         lsh_var_60 = (factorA & 0xFFFFFF00) | (factorC & 0xFF);
         lvr_var_54 = (factorA & 0xFF);
     }
+    span_step.a = lsh_var_54;
+    span_step.b = lsh_var_60;
+    span_step.h = lvr_var_54;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
     {
         long pX, pY;
         long rfactA, rfactB;
         ushort colM;
-        unsigned char *o;
         unsigned char *o_ln;
 
         pX = pp->X >> 16;
         pY = pp->Y >> 16;
-        o_ln = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o_ln = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
 
         if (pX < 0)
         {
@@ -2563,8 +2568,8 @@ void trig_render_md05(struct TrigLocalRend *tlr)
             colH = factorB;
             rfactB = (factorB & 0xFFFF0000) | (factorA & 0xFF);
             rfactA = (factorA & 0xFFFF0000) | (colL & 0xFFFF);
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
         }
@@ -2574,8 +2579,8 @@ void trig_render_md05(struct TrigLocalRend *tlr)
             ushort colL, colH;
             TbBool pY_overflow;
 
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pY, pX);
             pY = pY - pX;
             if (((pY < 0) ^ pY_overflow) | (pY == 0))
@@ -2592,29 +2597,13 @@ void trig_render_md05(struct TrigLocalRend *tlr)
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
         }
 
-        o = o_ln;
-
-        for (; pY > 0; pY--, o++)
         {
-            ushort colL, colH;
-            ushort colS;
-            TbBool rfactA_carry;
-            TbBool rfactB_carry;
-
-            colM = (colM & 0xFF00) + (rfactB & 0xFF);
-            colS = (((rfactA >> 8) & 0xFF) << 8) + m[colM];
-
-            rfactA_carry = __CFADDL__(rfactA, lsh_var_54);
-            rfactA = rfactA + lsh_var_54;
-
-            rfactB_carry = __CFADDL__(rfactB + rfactA_carry, lsh_var_60);
-            rfactB = rfactB + lsh_var_60 + rfactA_carry;
-
-            colH = lvr_var_54 + rfactB_carry + (colM >> 8);
-            colL = colM;
-            colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
-
-            *o = f[colS];
+            // Inner loop keeps rfactA, rfactB and high byte of colM as one value, adding with carry
+            struct TrigSpanState span;
+            span.a = rfactA;
+            span.b = rfactB;
+            span.h = (colM >> 8) & 0xFF;
+            trig_spans->md05(o_ln, pY, &span, &span_step, m, f);
         }
     }
 }
@@ -2632,9 +2621,9 @@ void trig_render_md06(struct TrigLocalRend *tlr)
     long lsh_var_54;
     long lsh_var_60;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (f == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p 0x%p", m, f, pp);
         return;
@@ -2653,8 +2642,8 @@ void trig_render_md06(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
 
         if (pXa < 0)
         {
@@ -2681,8 +2670,8 @@ void trig_render_md06(struct TrigLocalRend *tlr)
             factorB = (factorB & 0xFFFF0000) | (pYa & 0xFFFF);
             pXa = (pXa & 0xFFFF);
             pY = factorB & 0xFFFF;
-            if (pY > vec_window_width)
-                pY = vec_window_width;
+            if (pY > tlr->prm->vec_window_width)
+                pY = tlr->prm->vec_window_width;
         }
         else
         {
@@ -2690,8 +2679,8 @@ void trig_render_md06(struct TrigLocalRend *tlr)
             unsigned char pLa_overflow;
             short pLa;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pLa_overflow = __OFSUBS__(pYa, pXa);
             pLa = pYa - pXa;
             if (((pLa < 0) ^ pLa_overflow) | (pLa == 0))
@@ -2741,16 +2730,18 @@ void trig_render_md07(struct TrigLocalRend *tlr)
     struct PolyPoint *pp;
     unsigned char *m;
     unsigned char *f;
-    long lsh_var_54;
+    struct TrigSpanState span_step;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (f == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p 0x%p", m, f, pp);
         return;
     }
-    lsh_var_54 = tlr->var_54 << 16;
+    span_step.a = tlr->var_48;
+    span_step.b = tlr->var_54;
+    span_step.h = 0;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
     {
@@ -2763,8 +2754,8 @@ void trig_render_md07(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if ( (pXa & 0x8000u) != 0 )
         {
             ushort colL, colH;
@@ -2779,8 +2770,8 @@ void trig_render_md07(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) | (factorC & 0xFFFF);
             factorB = factorC >> 8;
             colL = ((factorB >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = (ushort)factorB;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -2790,8 +2781,8 @@ void trig_render_md07(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( (unsigned char)(((pYa & 0x8000u) != 0) ^ pY_overflow) | ((ushort)pYa == 0) )
@@ -2805,22 +2796,14 @@ void trig_render_md07(struct TrigLocalRend *tlr)
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
         }
 
-        for (; pYa > 0; pYa--, o++)
+        if (pYa > 0)
         {
-            ushort colL, colH;
-            ushort colS;
-            unsigned char factorA_carry;
-
-            colS = (vec_colour << 8) + m[colM];
-            factorA_carry = __CFADDS__(tlr->var_48, factorA);
-            factorA = (factorA & 0xFFFF0000) | ((tlr->var_48 + factorA) & 0xFFFF);
-            colL = ((tlr->var_48 >> 16) & 0xFF) + factorA_carry + colM;
-            factorA_carry = __CFADDL__(lsh_var_54, factorA);
-            factorA += lsh_var_54;
-            *o = f[colS];
-            colH = (colM >> 8) + ((tlr->var_54 >> 16) & 0xFF) + factorA_carry;
-
-            colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
+            // Inner loop only uses 8.16 fixed point parts of U and V, so these can be plain sums
+            struct TrigSpanState span;
+            span.a = ((colM & 0xFF) << 16) | (factorA & 0xFFFF);
+            span.b = ((colM & 0xFF00) << 8) | ((factorA >> 16) & 0xFFFF);
+            span.h = 0;
+            trig_spans->md07(o, pYa, &span, &span_step, m, &f[tlr->prm->vec_colour << 8]);
         }
     }
 }
@@ -2832,9 +2815,9 @@ void trig_render_md08(struct TrigLocalRend *tlr)
     unsigned char *f;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (f == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p 0x%p", m, f, pp);
         return;
@@ -2851,8 +2834,8 @@ void trig_render_md08(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if ( (pXa & 0x8000u) != 0 )
         {
             ushort colL, colH;
@@ -2868,8 +2851,8 @@ void trig_render_md08(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorB & 0xFFFF);
             factorC = factorB >> 8;
             colL = ((factorC >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = (ushort)factorC;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -2879,8 +2862,8 @@ void trig_render_md08(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( (unsigned char)(((pYa & 0x8000u) != 0) ^ pY_overflow) | ((ushort)pYa == 0) )
@@ -2900,7 +2883,7 @@ void trig_render_md08(struct TrigLocalRend *tlr)
             ushort colS;
             unsigned char factorA_carry;
 
-            colS = (vec_colour << 8) + m[colM];
+            colS = (tlr->prm->vec_colour << 8) + m[colM];
             factorA_carry = __CFADDS__(tlr->var_48, factorA);
             factorA = (factorA & 0xFFFF0000) + ((tlr->var_48 + factorA) & 0xFFFF);
             colL = ((tlr->var_48 >> 16) & 0xFF) + factorA_carry + colM;
@@ -2922,9 +2905,9 @@ void trig_render_md09(struct TrigLocalRend *tlr)
     unsigned char *f;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (f == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p 0x%p", m, f, pp);
         return;
@@ -2941,8 +2924,8 @@ void trig_render_md09(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -2957,8 +2940,8 @@ void trig_render_md09(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorB & 0xFFFF);
             factorC = factorB >> 8;
             colL = ((factorC >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = (ushort)factorC;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -2968,8 +2951,8 @@ void trig_render_md09(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if (((pYa < 0) ^ pY_overflow) | (pYa == 0))
@@ -3013,9 +2996,9 @@ void trig_render_md10(struct TrigLocalRend *tlr)
     unsigned char *f;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (f == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p 0x%p", m, f, pp);
         return;
@@ -3034,8 +3017,8 @@ void trig_render_md10(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -3050,8 +3033,8 @@ void trig_render_md10(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorB & 0xFFFF);
             factorC = factorB >> 8;
             colL = ((factorC >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = (ushort)factorC;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -3061,8 +3044,8 @@ void trig_render_md10(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( (unsigned char)(((pYa & 0x8000u) != 0) ^ pY_overflow) | ((ushort)pYa == 0) )
@@ -3083,7 +3066,7 @@ void trig_render_md10(struct TrigLocalRend *tlr)
             unsigned char factorA_carry;
 
             if (m[colM]) {
-                colS = (vec_colour << 8) | (*o);
+                colS = (tlr->prm->vec_colour << 8) | (*o);
                 *o = f[colS];
             }
             factorA_carry = __CFADDS__(tlr->var_48, factorA);
@@ -3105,9 +3088,9 @@ void trig_render_md12(struct TrigLocalRend *tlr)
     unsigned char *g;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (g == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p 0x%p", m, g, pp);
         return;
@@ -3125,8 +3108,8 @@ void trig_render_md12(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if ( (pXa & 0x8000u) != 0 )
         {
             ushort colL, colH;
@@ -3141,8 +3124,8 @@ void trig_render_md12(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorC & 0xFFFF);
             factorB = factorC >> 8;
             colL = ((factorB >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = (ushort)factorB;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -3152,8 +3135,8 @@ void trig_render_md12(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( (unsigned char)(((pYa & 0x8000u) != 0) ^ pY_overflow) | ((ushort)pYa == 0) )
@@ -3173,7 +3156,7 @@ void trig_render_md12(struct TrigLocalRend *tlr)
             ushort colS;
             unsigned char factorA_carry;
 
-            colS = (m[colM] << 8) | vec_colour;
+            colS = (m[colM] << 8) | tlr->prm->vec_colour;
             factorA_carry = __CFADDS__(tlr->var_48, factorA);
             factorA = (factorA & 0xFFFF0000) + ((tlr->var_48 + factorA) & 0xFFFF);
             colL = ((tlr->var_48 >> 16) & 0xFF) + factorA_carry + colM;
@@ -3194,9 +3177,9 @@ void trig_render_md13(struct TrigLocalRend *tlr)
     unsigned char *g;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((m == NULL) || (g == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p 0x%p", m, g, pp);
         return;
@@ -3213,8 +3196,8 @@ void trig_render_md13(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -3229,8 +3212,8 @@ void trig_render_md13(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorB & 0xFFFF);
             factorC = factorB >> 8;
             colL = ((factorC >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = (ushort)factorC;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -3240,8 +3223,8 @@ void trig_render_md13(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( (unsigned char)(((pYa & 0x8000u) != 0) ^ pY_overflow) | ((ushort)pYa == 0) )
@@ -3261,7 +3244,7 @@ void trig_render_md13(struct TrigLocalRend *tlr)
             ushort colS;
             unsigned char factorA_carry;
 
-            colS = m[colM] | (vec_colour << 8);
+            colS = m[colM] | (tlr->prm->vec_colour << 8);
             factorA_carry = __CFADDS__(tlr->var_48, factorA);
             factorA = (factorA & 0xFFFF0000) + ((tlr->var_48 + factorA) & 0xFFFF);
             colL = ((tlr->var_48 >> 16) & 0xFF) + factorA_carry + colM;
@@ -3283,13 +3266,13 @@ void trig_render_md14(struct TrigLocalRend *tlr)
     unsigned char *o_ln;
 
     g = pixmap.ghost;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     if ((g == NULL) || (pp == NULL)) {
         ERRORLOG("global arrays not set: 0x%p 0x%p", g, pp);
         return;
     }
     o_ln = tlr->var_24;
-    colM = (vec_colour << 8);
+    colM = (tlr->prm->vec_colour << 8);
 
     for (; tlr->var_44; tlr->var_44--, pp++)
     {
@@ -3298,22 +3281,22 @@ void trig_render_md14(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o_ln += vec_screen_width;
+        o_ln += tlr->prm->vec_screen_width;
 
         if (pXa < 0)
         {
             if (pYa <= 0)
                 continue;
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             o = o_ln;
         }
         else
         {
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( ((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -3337,9 +3320,9 @@ void trig_render_md15(struct TrigLocalRend *tlr)
     unsigned char *o_ln;
 
     g = pixmap.ghost;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     o_ln = tlr->var_24;
-    colM = vec_colour;
+    colM = tlr->prm->vec_colour;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
     {
@@ -3348,21 +3331,21 @@ void trig_render_md15(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o_ln += vec_screen_width;
+        o_ln += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             if (pYa <= 0)
                 continue;
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             o = o_ln;
         }
         else
         {
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( ((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -3386,7 +3369,7 @@ void trig_render_md16(struct TrigLocalRend *tlr)
 
     g = pixmap.ghost;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
     {
@@ -3397,8 +3380,8 @@ void trig_render_md16(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
 
         if (pXa < 0)
         {
@@ -3415,9 +3398,9 @@ void trig_render_md16(struct TrigLocalRend *tlr)
             factorA_carry = __CFADDS__(pp->S, pXMb);
             factorA = (pp->S) + pXMb;
             colH = (pXa >> 8) + (pp->S >> 16) + factorA_carry;
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
-            colL = vec_colour;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
+            colL = tlr->prm->vec_colour;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
         }
@@ -3426,14 +3409,14 @@ void trig_render_md16(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( ((pYa < 0) ^ pY_overflow) | (pYa == 0) )
                 continue;
             o += pXa;
-            colL = vec_colour;
+            colL = tlr->prm->vec_colour;
             factorA = pp->S;
             colH = (pp->S >> 16);
 
@@ -3466,7 +3449,7 @@ void trig_render_md17(struct TrigLocalRend *tlr)
 
     g = pixmap.ghost;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
     {
@@ -3478,8 +3461,8 @@ void trig_render_md17(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
 
         if (pXa < 0)
         {
@@ -3495,9 +3478,9 @@ void trig_render_md17(struct TrigLocalRend *tlr)
             factorA_carry = __CFADDS__(pp->S, pXMb);
             factorA = pp->S + pXMb;
             colH = (pXa >> 8) + (pp->S >> 16) + factorA_carry;
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
-            colL = vec_colour;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
+            colL = tlr->prm->vec_colour;
 
             colS = ((colH & 0xFF) << 8) + (colL & 0xFF);
         }
@@ -3506,15 +3489,15 @@ void trig_render_md17(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if (((pYa < 0) ^ pY_overflow) | (pYa == 0))
                 continue;
 
             o += pXa;
-            colL = vec_colour;
+            colL = tlr->prm->vec_colour;
             factorA = pp->S;
             colH = (pp->S >> 16);
 
@@ -3546,9 +3529,9 @@ void trig_render_md18(struct TrigLocalRend *tlr)
     unsigned char *g;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     lsh_var_54 = tlr->var_54 << 16;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
@@ -3561,8 +3544,8 @@ void trig_render_md18(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -3577,8 +3560,8 @@ void trig_render_md18(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorB & 0xFFFF);
             factorC = factorB >> 8;
             colL = (factorC >> 8);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = (ushort)factorC;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -3588,8 +3571,8 @@ void trig_render_md18(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_carry;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_carry = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( ((pYa < 0) ^ pY_carry) | (pYa == 0) )
@@ -3632,9 +3615,9 @@ void trig_render_md19(struct TrigLocalRend *tlr)
     unsigned char *g;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     lsh_var_54 = tlr->var_54 << 16;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
@@ -3646,8 +3629,8 @@ void trig_render_md19(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -3663,8 +3646,8 @@ void trig_render_md19(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorB & 0xFFFF);
             factorC = factorB >> 8;
             colL = ((factorC >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
         }
@@ -3673,8 +3656,8 @@ void trig_render_md19(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( ((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -3717,10 +3700,10 @@ void trig_render_md20(struct TrigLocalRend *tlr)
     long lsh_var_54;
     long lsh_var_60;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     lsh_var_54 = tlr->var_54 << 16;
     lsh_var_60 = tlr->var_60 << 16;
 
@@ -3736,8 +3719,8 @@ void trig_render_md20(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -3745,8 +3728,8 @@ void trig_render_md20(struct TrigLocalRend *tlr)
 
             if (pYa <= 0)
                 continue;
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pXMa = (ushort)-pXa;
             pXMb = pXMa;
             factorA = __ROL4__(pp->V + tlr->var_54 * pXMa, 16);
@@ -3764,8 +3747,8 @@ void trig_render_md20(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( ((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -3813,10 +3796,10 @@ void trig_render_md21(struct TrigLocalRend *tlr)
     long lsh_var_54;
     long lsh_var_60;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     lsh_var_54 = tlr->var_54 << 16;
     lsh_var_60 = tlr->var_60 << 16;
 
@@ -3829,8 +3812,8 @@ void trig_render_md21(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -3840,8 +3823,8 @@ void trig_render_md21(struct TrigLocalRend *tlr)
 
             if (pYa <= 0)
                 continue;
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXMa = (ushort)-pXa;
             pXMb = pXMa;
             factorA = __ROL4__(pp->V + tlr->var_54 * pXMa, 16);
@@ -3860,8 +3843,8 @@ void trig_render_md21(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( ((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -3907,9 +3890,9 @@ void trig_render_md22(struct TrigLocalRend *tlr)
     unsigned char *g;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     lsh_var_54 = tlr->var_54 << 16;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
@@ -3923,8 +3906,8 @@ void trig_render_md22(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -3939,8 +3922,8 @@ void trig_render_md22(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorB & 0xFFFF);
             factorC = factorB >> 8;
             colL = ((factorC >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = factorC & 0xFFFF;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -3950,8 +3933,8 @@ void trig_render_md22(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if ( ((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -3994,9 +3977,9 @@ void trig_render_md23(struct TrigLocalRend *tlr)
     unsigned char *g;
     long lsh_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     lsh_var_54 = tlr->var_54 << 16;
 
     for (; tlr->var_44; tlr->var_44--, pp++)
@@ -4011,8 +3994,8 @@ void trig_render_md23(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if ( (pXa & 0x8000u) != 0 )
         {
             ushort colL, colH;
@@ -4027,8 +4010,8 @@ void trig_render_md23(struct TrigLocalRend *tlr)
             factorA = (factorA & 0xFFFF0000) + (factorB & 0xFFFF);
             factorC = factorB >> 8;
             colL = ((factorC >> 8) & 0xFF);
-            if (pYa > vec_window_width)
-              pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+              pYa = tlr->prm->vec_window_width;
             pXa = (ushort)factorC;
 
             colM = ((colH & 0xFF) << 8) + (colL & 0xFF);
@@ -4038,8 +4021,8 @@ void trig_render_md23(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if (((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -4083,10 +4066,10 @@ void trig_render_md24(struct TrigLocalRend *tlr)
     long lsh_var_54;
     long lsh_var_60;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     lsh_var_54 = tlr->var_54 << 16;
     lsh_var_60 = tlr->var_60 << 16;
 
@@ -4103,8 +4086,8 @@ void trig_render_md24(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -4112,8 +4095,8 @@ void trig_render_md24(struct TrigLocalRend *tlr)
 
             if (pYa <= 0)
                 continue;
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pXMa = (ushort)-pXa;
             pXMb = pXMa;
             factorA = __ROL4__(pp->V + tlr->var_54 * pXMa, 16);
@@ -4132,8 +4115,8 @@ void trig_render_md24(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if (((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -4184,10 +4167,10 @@ void trig_render_md25(struct TrigLocalRend *tlr)
     long lsh_var_54;
     long lsh_var_60;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
     lsh_var_54 = tlr->var_54 << 16;
     lsh_var_60 = tlr->var_60 << 16;
 
@@ -4204,8 +4187,8 @@ void trig_render_md25(struct TrigLocalRend *tlr)
 
         pXa = (pp->X >> 16);
         pYa = (pp->Y >> 16);
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
         if (pXa < 0)
         {
             ushort colL, colH;
@@ -4213,8 +4196,8 @@ void trig_render_md25(struct TrigLocalRend *tlr)
 
             if (pYa <= 0)
                 continue;
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pXMa = (ushort)-pXa;
             pXMb = pXMa;
             factorA = __ROL4__(pp->V + tlr->var_54 * pXMa, 16);
@@ -4233,8 +4216,8 @@ void trig_render_md25(struct TrigLocalRend *tlr)
             ushort colL, colH;
             unsigned char pY_overflow;
 
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa = pYa - pXa;
             if (((pYa < 0) ^ pY_overflow) | (pYa == 0) )
@@ -4286,10 +4269,10 @@ void trig_render_md26(struct TrigLocalRend *tlr)
     long lsh_var_60;
     long lvr_var_54;
 
-    m = vec_map;
+    m = tlr->prm->vec_map;
     g = pixmap.ghost;
     f = pixmap.fade_tables;
-    pp = polyscans;
+    pp = tlr->prm->polyscans;
 
     {
         ulong v1;
@@ -4319,8 +4302,8 @@ void trig_render_md26(struct TrigLocalRend *tlr)
 
         pXa = pp->X >> 16;
         pYa = pp->Y >> 16;
-        o = &tlr->var_24[vec_screen_width];
-        tlr->var_24 += vec_screen_width;
+        o = &tlr->var_24[tlr->prm->vec_screen_width];
+        tlr->var_24 += tlr->prm->vec_screen_width;
 
         if (pXa < 0)
         {
@@ -4333,15 +4316,15 @@ void trig_render_md26(struct TrigLocalRend *tlr)
             factorB = (factorB & 0xFFFFFF00) | (factorA & 0xFF);
             factorA = (factorA & 0xFFFF0000) | (factorC & 0xFFFF);
             factorD = __ROL4__(pp->V + pXa * tlr->var_54, 16);
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
 
             colM = (factorC & 0xFF) + ((factorD & 0xFF) << 8);
         }
         else
         {
-            if (pYa > vec_window_width)
-                pYa = vec_window_width;
+            if (pYa > tlr->prm->vec_window_width)
+                pYa = tlr->prm->vec_window_width;
             pY_overflow = __OFSUBS__(pYa, pXa);
             pYa -= pXa;
             if (((pYa < 0) ^ pY_overflow) | (pYa == 0))
@@ -4388,7 +4371,12 @@ void trig_render_md26(struct TrigLocalRend *tlr)
  * @param point_b
  * @param point_c
  */
-void trig(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c)
+/**
+ * Draws a triangle using rendering parameters from given structure, instead of global variables.
+ * Can be called by several threads at once, as long as they use separate parameters,
+ * and especially separate polyscans buffers.
+ */
+void trig_with_params(const struct TrigParams *prm, struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c)
 {
     struct PolyPoint *opt_a;
     struct PolyPoint *opt_b;
@@ -4397,6 +4385,7 @@ void trig(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint
     struct TrigLocalPrep tlp;
     struct TrigLocalRend tlr;
 
+    tlr.prm = prm;
     NOLOG("Pa(%ld,%ld,%ld)", point_a->X, point_a->Y, point_a->S);
     NOLOG("Pb(%ld,%ld,%ld)", point_b->X, point_b->Y, point_b->S);
     NOLOG("Pc(%ld,%ld,%ld)", point_c->X, point_c->Y, point_c->S);
@@ -4434,9 +4423,9 @@ void trig(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint
         return;
     }
 
-    NOLOG("render mode %d",(int)vec_mode);
+    NOLOG("render mode %d",(int)prm->vec_mode);
 
-    switch (vec_mode)
+    switch (prm->vec_mode)
     {
     case RendVec_mode00:
         trig_render_md00(&tlr);
@@ -4468,7 +4457,7 @@ void trig(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint
 
     case RendVec_mode07:
     case RendVec_mode11:
-        if (vec_colour == 0x20)
+        if (prm->vec_colour == 0x20)
             trig_render_md02(&tlr);
         else
             trig_render_md07(&tlr);
@@ -4549,4 +4538,27 @@ void trig(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint
 
     NOLOG("end");
 }
+
+void trig(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c)
+{
+    struct TrigParams prm;
+    trig_stream_capture_add(point_a, point_b, point_c);
+    trig_params_from_globals(&prm);
+    trig_with_params(&prm, point_a, point_b, point_c);
+}
+
+/**
+ * Fills rendering parameters for trig_with_params() with values from global variables used by trig().
+ */
+void trig_params_from_globals(struct TrigParams *prm)
+{
+    prm->poly_screen = poly_screen;
+    prm->polyscans = polyscans;
+    prm->vec_map = vec_map;
+    prm->vec_colour = vec_colour;
+    prm->vec_mode = vec_mode;
+    prm->vec_screen_width = vec_screen_width;
+    prm->vec_window_width = vec_window_width;
+    prm->vec_window_height = vec_window_height;
+}
 /******************************************************************************/
@@ -0,0 +1,206 @@
+/******************************************************************************/
+// Bullfrog Engine Emulation Library - for use to remake classic games like
+// Syndicate Wars, Magic Carpet or Dungeon Keeper.
+/******************************************************************************/
+/** @file bflib_threadpool.c
+ *     Pool of worker threads.
+ * @par Purpose:
+ *     Runs data-parallel loops on worker threads and the calling thread.
+ * @par Comment:
+ *     A job is a range of items processed in batches; the caller is blocked
+ *     until all items are done. Only one job can run at a time.
+ * @author   KeeperFX Team
+ * @date     18 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#include "pre_inc.h"
+#include "bflib_threadpool.h"
+
+#include <SDL2/SDL.h>
+#include "bflib_basics.h"
+#include "globals.h"
+#include "post_inc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************/
+struct ThreadPool {
+    SDL_Thread *threads[THREADPOOL_THREADS_MAX];
+    int threads_count;
+    SDL_mutex *lock;
+    SDL_cond *job_ready;
+    SDL_cond *job_done;
+    /** Incremented for every job, so that workers know there's a new one. */
+    unsigned long job_generation;
+    /** Amount of workers which didn't finish current job yet. */
+    int workers_busy;
+    TbBool quit;
+    TbJobFunc func;
+    void *data;
+    long items_count;
+    long batch_size;
+    SDL_atomic_t next_item;
+};
+/******************************************************************************/
+static struct ThreadPool pool;
+/******************************************************************************/
+static void thread_pool_process_items(void)
+{
+    while (1)
+    {
+        long item_beg = SDL_AtomicAdd(&pool.next_item, pool.batch_size);
+        if (item_beg >= pool.items_count)
+            break;
+        long item_end = item_beg + pool.batch_size;
+        if (item_end > pool.items_count)
+            item_end = pool.items_count;
+        pool.func(pool.data, item_beg, item_end);
+    }
+}
+
+static int thread_pool_worker(void *arg)
+{
+    unsigned long seen_generation = 0;
+    SDL_LockMutex(pool.lock);
+    while (1)
+    {
+        while (!pool.quit && (pool.job_generation == seen_generation))
+            SDL_CondWait(pool.job_ready, pool.lock);
+        if (pool.quit)
+            break;
+        seen_generation = pool.job_generation;
+        SDL_UnlockMutex(pool.lock);
+        thread_pool_process_items();
+        SDL_LockMutex(pool.lock);
+        pool.workers_busy--;
+        if (pool.workers_busy == 0)
+            SDL_CondSignal(pool.job_done);
+    }
+    SDL_UnlockMutex(pool.lock);
+    return 0;
+}
+
+/**
+ * Starts worker threads.
+ * @param threads_count Amount of threads working on jobs, including the calling thread.
+ *     Value of 0 selects it from amount of CPUs; 1 means no workers are started.
+ * @return True if the pool is ready, even if it has no workers.
+ */
+TbBool LbThreadPoolInit(int threads_count)
+{
+    LbThreadPoolFinish();
+    if (threads_count <= 0)
+        threads_count = SDL_GetCPUCount();
+    if (threads_count > THREADPOOL_THREADS_MAX)
+        threads_count = THREADPOOL_THREADS_MAX;
+    if (threads_count <= 1)
+        return true;
+    pool.lock = SDL_CreateMutex();
+    pool.job_ready = SDL_CreateCond();
+    pool.job_done = SDL_CreateCond();
+    if ((pool.lock == NULL) || (pool.job_ready == NULL) || (pool.job_done == NULL))
+    {
+        ERRORLOG("Cannot create thread pool synchronization objects");
+        LbThreadPoolFinish();
+        return false;
+    }
+    pool.quit = false;
+    pool.job_generation = 0;
+    for (int i = 0; i < threads_count - 1; i++)
+    {
+        pool.threads[i] = SDL_CreateThread(thread_pool_worker, "PoolWorker", NULL);
+        if (pool.threads[i] == NULL)
+        {
+            WARNLOG("Cannot create worker thread %d, continuing with %d",i,pool.threads_count);
+            break;
+        }
+        pool.threads_count++;
+    }
+    SYNCDBG(3,"Started %d worker threads",pool.threads_count);
+    return true;
+}
+
+/**
+ * Stops and releases the worker threads.
+ */
+void LbThreadPoolFinish(void)
+{
+    if (pool.lock != NULL)
+    {
+        SDL_LockMutex(pool.lock);
+        pool.quit = true;
+        SDL_CondBroadcast(pool.job_ready);
+        SDL_UnlockMutex(pool.lock);
+    }
+    for (int i = 0; i < pool.threads_count; i++)
+    {
+        SDL_WaitThread(pool.threads[i], NULL);
+        pool.threads[i] = NULL;
+    }
+    pool.threads_count = 0;
+    if (pool.job_done != NULL)
+        SDL_DestroyCond(pool.job_done);
+    if (pool.job_ready != NULL)
+        SDL_DestroyCond(pool.job_ready);
+    if (pool.lock != NULL)
+        SDL_DestroyMutex(pool.lock);
+    pool.job_done = NULL;
+    pool.job_ready = NULL;
+    pool.lock = NULL;
+}
+
+/**
+ * Returns amount of threads working on jobs, including the calling thread.
+ */
+int LbThreadPoolThreadsCount(void)
+{
+    return pool.threads_count + 1;
+}
+
+/**
+ * Processes a range of items with given function, using all threads of the pool.
+ * Returns when all items are processed. Order in which batches are processed is undefined,
+ * so the function must not depend on other items being already done.
+ * @param func Job function.
+ * @param data Data pointer given to job function.
+ * @param items_count Amount of items to process.
+ * @param batch_size Amount of items given to a thread at once.
+ */
+void LbThreadPoolRun(TbJobFunc func, void *data, long items_count, long batch_size)
+{
+    if (items_count <= 0)
+        return;
+    if (batch_size < 1)
+        batch_size = 1;
+    if ((pool.threads_count == 0) || (items_count <= batch_size))
+    {
+        func(data, 0, items_count);
+        return;
+    }
+    SDL_LockMutex(pool.lock);
+    pool.func = func;
+    pool.data = data;
+    pool.items_count = items_count;
+    pool.batch_size = batch_size;
+    SDL_AtomicSet(&pool.next_item, 0);
+    pool.workers_busy = pool.threads_count;
+    pool.job_generation++;
+    SDL_CondBroadcast(pool.job_ready);
+    SDL_UnlockMutex(pool.lock);
+    // Calling thread works too
+    thread_pool_process_items();
+    SDL_LockMutex(pool.lock);
+    while (pool.workers_busy > 0)
+        SDL_CondWait(pool.job_done, pool.lock);
+    SDL_UnlockMutex(pool.lock);
+}
+/******************************************************************************/
+#ifdef __cplusplus
+}
+#endif
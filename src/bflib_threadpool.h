@@ -0,0 +1,46 @@
+/******************************************************************************/
+// Bullfrog Engine Emulation Library - for use to remake classic games like
+// Syndicate Wars, Magic Carpet or Dungeon Keeper.
+/******************************************************************************/
+/** @file bflib_threadpool.h
+ *     Header file for bflib_threadpool.c.
+ * @par Purpose:
+ *     Pool of worker threads for splitting data-parallel loops.
+ * @par Comment:
+ *     Just a header file - #defines, typedefs, function prototypes etc.
+ * @author   KeeperFX Team
+ * @date     18 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#ifndef BFLIB_THREADPOOL_H
+#define BFLIB_THREADPOOL_H
+
+#include "bflib_basics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************/
+/** Max amount of threads working on a job, including the calling thread. */
+#define THREADPOOL_THREADS_MAX 16
+
+/**
+ * Job function; processes items from item_beg up to, but not including, item_end.
+ * Called concurrently from several threads, for separate ranges of items.
+ */
+typedef void (*TbJobFunc)(void *data, long item_beg, long item_end);
+/******************************************************************************/
+TbBool LbThreadPoolInit(int threads_count);
+void LbThreadPoolFinish(void);
+int LbThreadPoolThreadsCount(void);
+void LbThreadPoolRun(TbJobFunc func, void *data, long items_count, long batch_size);
+/******************************************************************************/
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -54,6 +54,8 @@ extern volatile TbBool lbAppActive;
 volatile TbBool lbHasSecondSurface;
 /** True if we request the double buffering to be on in next mode switch. */
 TbBool lbDoubleBufferingRequested;
+/** If set, the screen is never shown - SDL is initialized with its dummy video driver. */
+TbBool lbScreenHeadless = false;
 /** Name of the video driver to be used. Must be set before LbScreenInitialize().
  * Under Win32 and with SDL, choises are windib or directx. */
 /** Colour palette buffer, to be used inside lbDisplay. */
@@ -504,6 +506,9 @@ TbResult LbScreenInitialize(void)
         LbRegisterModernVideoModes(); // register modern and flexible custom modes
     }
     // Initialize SDL library
+    if (lbScreenHeadless) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
     if (SDL_Init(SDL_INIT_VIDEO|SDL_INIT_NOPARACHUTE) < 0) {
         ERRORLOG("SDL init: %s",SDL_GetError());
         return Lb_FAIL;
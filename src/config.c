@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <ctype.h>
 #include "globals.h"
 #include "bflib_basics.h"
 #include "bflib_memory.h"
@@ -31,7 +32,9 @@
 #include "bflib_keybrd.h"
 #include "bflib_datetm.h"
 #include "bflib_mouse.h"
+#include "bflib_network.h"
 #include "bflib_sound.h"
+#include "bflib_threadpool.h"
 #include "sounds.h"
 #include "engine_render.h"
 
@@ -52,11 +55,85 @@ static long net_number_of_levels;
 static struct NetLevelDesc net_level_desc[100];
 static const char keeper_config_file[]="keeperfx.cfg";
 
+/** Amount of config buffers which have their blocks index remembered. */
+#define CONF_BLOCKS_INDICES_COUNT 4
+/** Size of the hash table of command tables indices; has to be power of 2. */
+#define CONF_COMMANDS_INDICES_COUNT 256
+
+/**
+ * Line of config buffer which starts with '[', so it may be a block header.
+ */
+struct ConfBlockHeader {
+    /** Position at which scanning the line starts. */
+    long line_pos;
+    /** Position of the '[' character. */
+    long bracket_pos;
+    unsigned long line_number;
+};
+
+/**
+ * Index of all block headers within a config buffer.
+ * The buffer is recognized by its address and length, and a sample of its content.
+ */
+struct ConfBlocksIndex {
+    const char *buf;
+    long buflen;
+    unsigned long sample_hash;
+    long count;
+    long alloc;
+    struct ConfBlockHeader *items;
+};
+
+struct ConfCommandsIndexItem {
+    const char *name;
+    int len;
+    /** Position of the command in its table; when names repeat, the first one is used. */
+    int order;
+};
+
+/**
+ * Command names of a NamedCommand table, sorted for binary search.
+ */
+struct ConfCommandsIndex {
+    const struct NamedCommand *commands;
+    int count;
+    /** Set if some names contain separators; such tables can only be scanned. */
+    TbBool scan_only;
+    struct ConfCommandsIndexItem *items;
+};
+
+static struct ConfBlocksIndex conf_blocks_indices[CONF_BLOCKS_INDICES_COUNT];
+static int conf_blocks_index_next;
+static struct ConfCommandsIndex *conf_commands_indices[CONF_COMMANDS_INDICES_COUNT];
+
+/** Size of the hash table of named items tables indices; has to be power of 2. */
+#define NAMED_COMMANDS_INDICES_COUNT 256
+
+/**
+ * Hash index of names within a NamedCommand or LongNamedCommand table.
+ */
+struct NamedCommandsIndex {
+    const void *desc;
+    /** Value of named_commands_generation at the time index was made. */
+    unsigned long generation;
+    /** Amount of items before the one with NULL name. */
+    long count;
+    unsigned long slots_mask;
+    /** Item number plus one for every hash slot, or 0 for empty slot. */
+    long *slots;
+};
+
+static struct NamedCommandsIndex named_commands_indices[NAMED_COMMANDS_INDICES_COUNT];
+/** Increased whenever names in tables may have changed; starts above 0 so that empty indices are outdated. */
+static unsigned long named_commands_generation = 1;
+
 int max_track = 7;
 unsigned short AtmosRepeat = 1013;
 unsigned short AtmosStart = 1014;
 unsigned short AtmosEnd = 1034;
 TbBool AssignCpuKeepers = 0;
+/** Amount of threads used for parallel jobs; 0 means one per CPU core. */
+int worker_threads_count = 1;
 struct InstallInfo install_info;
 char keeper_runtime_directory[152];
 
@@ -111,6 +188,13 @@ const struct NamedCommand atmos_freq[] = {
   {NULL,  0},
   };
 
+const struct NamedCommand log_queue_type[] = {
+  {"OFF",    LbLogQueue_Off},
+  {"WAIT",   LbLogQueue_Wait},
+  {"DROP",   LbLogQueue_Drop},
+  {NULL,     0},
+  };
+
 const struct NamedCommand conf_commands[] = {
   {"INSTALL_PATH",         1},
   {"INSTALL_TYPE",         2},
@@ -142,6 +226,10 @@ const struct NamedCommand conf_commands[] = {
   {"MUSIC_FROM_DISK"               , 29},
   {"HAND_SIZE"                     , 30},
   {"LINE_BOX_SIZE"                 , 31},
+  {"WORKER_THREADS"                , 32},
+  {"MULTITHREADED_RENDERING"       , 33},
+  {"ASYNC_LOG"                     , 34},
+  {"NETWORK_INPUT_DELAY"           , 35},
   {NULL,                   0},
   };
 
@@ -323,13 +411,11 @@ TbBool skip_conf_spaces(const char *buf, long *pos, long buflen)
 }
 
 /**
- * Searches for start of INI file block with given name.
- * Starts at position given with pos, and sets it to position of block data.
- * @return Returns 1 if the block is found, -1 if buffer exceeded.
+ * Searches for start of INI file block with given name, from the line which starts at pos.
+ * Does not reset the line number, so it may be used to continue a search.
  */
-short find_conf_block(const char *buf,long *pos,long buflen,const char *blockname)
+static short find_conf_block_from_line(const char *buf,long *pos,long buflen,const char *blockname)
 {
-  text_line_number = 1;
   int blname_len = strlen(blockname);
   while ((*pos)+blname_len+2 < buflen)
   {
@@ -369,7 +455,19 @@ short find_conf_block(const char *buf,long *pos,long buflen,const char *blocknam
 }
 
 /**
- * Recognizes config command and returns its number, or negative status code.
+ * Searches for start of INI file block with given name, checking the buffer line by line.
+ * Starts at position given with pos, and sets it to position of block data.
+ * @return Returns 1 if the block is found, -1 if buffer exceeded.
+ */
+short find_conf_block_scan(const char *buf,long *pos,long buflen,const char *blockname)
+{
+  text_line_number = 1;
+  return find_conf_block_from_line(buf, pos, buflen, blockname);
+}
+
+/**
+ * Recognizes config command by comparing the line with every command name in the table.
+ * Returns command number, or negative status code, same as recognize_conf_command().
  * @param buf
  * @param pos
  * @param buflen
@@ -380,7 +478,7 @@ short find_conf_block(const char *buf,long *pos,long buflen,const char *blocknam
  * If ccr_unrecognised is returned, that means the command wasn't recognized.
  * If ccr_endOfBlock   is returned, that means we've reached end of the INI block.
  */
-int recognize_conf_command(const char *buf,long *pos,long buflen,const struct NamedCommand commands[])
+int recognize_conf_command_scan(const char *buf,long *pos,long buflen,const struct NamedCommand commands[])
 {
     SYNCDBG(19,"Starting");
     if ((*pos) >= buflen) return ccr_endOfFile;
@@ -435,6 +533,256 @@ int recognize_conf_command(const char *buf,long *pos,long buflen,const struct Na
     return ccr_unrecognised;
 }
 
+/**
+ * Sample of the buffer content, used to notice that another buffer was allocated at the same address.
+ */
+static unsigned long conf_buffer_sample_hash(const char *buf, long buflen)
+{
+    unsigned long hash = buflen;
+    long step = buflen / 256 + 1;
+    for (long i = 0; i < buflen; i += step)
+        hash = hash * 31 + (unsigned char)buf[i];
+    return hash;
+}
+
+static TbBool conf_blocks_index_valid(const struct ConfBlocksIndex *index, const char *buf, long buflen)
+{
+    if ((index->buf != buf) || (index->buflen != buflen))
+        return false;
+    for (long i = 0; i < index->count; i++)
+    {
+        if (buf[index->items[i].bracket_pos] != '[')
+            return false;
+    }
+    return (index->sample_hash == conf_buffer_sample_hash(buf, buflen));
+}
+
+/**
+ * Gives index of block headers for given buffer; builds it in one pass if there isn't one.
+ * Lines are split exactly the way find_conf_block_scan() splits them.
+ */
+static struct ConfBlocksIndex *get_conf_blocks_index(const char *buf, long buflen)
+{
+    for (int i = 0; i < CONF_BLOCKS_INDICES_COUNT; i++)
+    {
+        if (conf_blocks_index_valid(&conf_blocks_indices[i], buf, buflen))
+            return &conf_blocks_indices[i];
+    }
+    struct ConfBlocksIndex* index = &conf_blocks_indices[conf_blocks_index_next];
+    conf_blocks_index_next = (conf_blocks_index_next + 1) % CONF_BLOCKS_INDICES_COUNT;
+    index->buf = NULL;
+    index->count = 0;
+    unsigned long line_number_mem = text_line_number;
+    text_line_number = 1;
+    long pos = 0;
+    while (pos < buflen)
+    {
+        long line_pos = pos;
+        if (!skip_conf_spaces(buf,&pos,buflen))
+            break;
+        if (buf[pos] == '[')
+        {
+            if (index->count >= index->alloc)
+            {
+                long nalloc = (index->alloc > 0) ? 2 * index->alloc : 64;
+                struct ConfBlockHeader* nitems = (struct ConfBlockHeader*)LbMemoryGrow(index->items, nalloc * sizeof(struct ConfBlockHeader));
+                if (nitems == NULL)
+                {
+                    text_line_number = line_number_mem;
+                    return NULL;
+                }
+                index->items = nitems;
+                index->alloc = nalloc;
+            }
+            struct ConfBlockHeader* item = &index->items[index->count];
+            item->line_pos = line_pos;
+            item->bracket_pos = pos;
+            item->line_number = text_line_number;
+            index->count++;
+        }
+        skip_conf_to_next_line(buf,&pos,buflen);
+    }
+    text_line_number = line_number_mem;
+    index->buf = buf;
+    index->buflen = buflen;
+    index->sample_hash = conf_buffer_sample_hash(buf, buflen);
+    return index;
+}
+
+/**
+ * Searches for start of INI file block with given name.
+ * Starts at position given with pos, and sets it to position of block data.
+ * Only lines starting with '[' are checked, using index of the buffer made when it is first searched.
+ * @return Returns 1 if the block is found, -1 if buffer exceeded.
+ */
+short find_conf_block(const char *buf,long *pos,long buflen,const char *blockname)
+{
+  // Index covers the whole buffer; searching from the middle of it is rare
+  struct ConfBlocksIndex* index = ((*pos) == 0) ? get_conf_blocks_index(buf, buflen) : NULL;
+  if (index == NULL)
+      return find_conf_block_scan(buf, pos, buflen, blockname);
+  int blname_len = strlen(blockname);
+  long i;
+  for (i = 0; i < index->count; i++)
+  {
+    // Lines before this header were skipped by the scan; continue it from here if the name may match
+    long hpos = index->items[i].bracket_pos + 1;
+    if (!skip_conf_spaces(buf,&hpos,buflen) || (hpos+blname_len+2 >= buflen))
+      break;
+    if (strncasecmp(&buf[hpos],blockname,blname_len) == 0)
+      break;
+  }
+  if (i < index->count)
+  {
+    *pos = index->items[i].line_pos;
+    text_line_number = index->items[i].line_number;
+  } else
+  if (index->count > 0)
+  {
+    // Not found; the scan would end after the last block, so finish it the same way
+    *pos = index->items[index->count-1].line_pos;
+    text_line_number = index->items[index->count-1].line_number;
+    skip_conf_to_next_line(buf,pos,buflen);
+  } else
+  {
+    text_line_number = 1;
+  }
+  return find_conf_block_from_line(buf, pos, buflen, blockname);
+}
+
+static TbBool conf_command_separator(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '=') || ((unsigned char)c < 7);
+}
+
+static int conf_command_name_cmp(const char *name1, int len1, const char *name2, int len2)
+{
+    int n = strnicmp(name1, name2, (len1 < len2) ? len1 : len2);
+    if (n != 0)
+        return n;
+    return len1 - len2;
+}
+
+static int conf_commands_index_item_cmp(const void *ptr1, const void *ptr2)
+{
+    const struct ConfCommandsIndexItem* item1 = (const struct ConfCommandsIndexItem*)ptr1;
+    const struct ConfCommandsIndexItem* item2 = (const struct ConfCommandsIndexItem*)ptr2;
+    int n = conf_command_name_cmp(item1->name, item1->len, item2->name, item2->len);
+    if (n != 0)
+        return n;
+    return item1->order - item2->order;
+}
+
+/**
+ * Gives sorted index of given commands table; makes it on first use of the table.
+ * Tables are recognized by address, so this only works for tables which never change.
+ * @return The index, or NULL if there's no space for it.
+ */
+static struct ConfCommandsIndex *get_conf_commands_index(const struct NamedCommand commands[])
+{
+    unsigned long hash = ((unsigned long)(uintptr_t)commands >> 4) * 2654435761u;
+    for (int k = 0; k < CONF_COMMANDS_INDICES_COUNT; k++)
+    {
+        int slot = (hash + k) & (CONF_COMMANDS_INDICES_COUNT - 1);
+        struct ConfCommandsIndex* index = conf_commands_indices[slot];
+        if (index != NULL)
+        {
+            if (index->commands == commands)
+                return index;
+            continue;
+        }
+        int count = 0;
+        while (commands[count].num > 0)
+            count++;
+        index = (struct ConfCommandsIndex*)LbMemoryAlloc(sizeof(struct ConfCommandsIndex) + (count + 1) * sizeof(struct ConfCommandsIndexItem));
+        if (index == NULL)
+            return NULL;
+        index->commands = commands;
+        index->count = count;
+        index->items = (struct ConfCommandsIndexItem*)(index + 1);
+        for (int i = 0; i < count; i++)
+        {
+            struct ConfCommandsIndexItem* item = &index->items[i];
+            item->name = commands[i].name;
+            item->len = strlen(commands[i].name);
+            item->order = i;
+            // Command followed by separator is found by the whole word, so a name can't contain any
+            if (item->len == 0)
+                index->scan_only = true;
+            for (int n = 0; n < item->len; n++)
+            {
+                if (conf_command_separator(item->name[n]))
+                    index->scan_only = true;
+            }
+        }
+        qsort(index->items, count, sizeof(struct ConfCommandsIndexItem), conf_commands_index_item_cmp);
+        conf_commands_indices[slot] = index;
+        return index;
+    }
+    return NULL;
+}
+
+/**
+ * Recognizes config command and returns its number, or negative status code.
+ * The command word is found in sorted index of the table, rather than compared with every name.
+ * @param buf
+ * @param pos
+ * @param buflen
+ * @param commands Commands table; it is indexed on first use, so it shouldn't change afterwards.
+ * @return If positive integer is returned, it is the command number recognized in the line.
+ * If ccr_comment      is returned, that means the current line did not contained any command and should be skipped.
+ * If ccr_endOfFile    is returned, that means we've reached end of file.
+ * If ccr_unrecognised is returned, that means the command wasn't recognized.
+ * If ccr_endOfBlock   is returned, that means we've reached end of the INI block.
+ */
+int recognize_conf_command(const char *buf,long *pos,long buflen,const struct NamedCommand commands[])
+{
+    SYNCDBG(19,"Starting");
+    struct ConfCommandsIndex* index = get_conf_commands_index(commands);
+    if ((index == NULL) || (index->scan_only))
+        return recognize_conf_command_scan(buf, pos, buflen, commands);
+    if ((*pos) >= buflen) return ccr_endOfFile;
+    // Skipping starting spaces
+    while ((buf[*pos] == ' ') || (buf[*pos] == '\t') || (buf[*pos] == '\n') || (buf[*pos] == '\r') || (buf[*pos] == 26) || ((unsigned char)buf[*pos] < 7))
+    {
+        (*pos)++;
+        if ((*pos) >= buflen) return ccr_endOfFile;
+    }
+    // Checking if this line is a comment
+    if (buf[*pos] == ';')
+        return ccr_comment;
+    // Checking if this line is start of a block
+    if (buf[*pos] == '[')
+        return ccr_endOfBlock;
+    // Command word ends at a separator; none of the names contains one
+    long word_len = 0;
+    while (((*pos)+word_len < buflen) && !conf_command_separator(buf[(*pos)+word_len]))
+        word_len++;
+    // Find the first item with matching name
+    int lo = 0;
+    int hi = index->count;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        const struct ConfCommandsIndexItem* item = &index->items[mid];
+        if (conf_command_name_cmp(item->name, item->len, buf+(*pos), word_len) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if ((lo >= index->count) || (conf_command_name_cmp(index->items[lo].name, index->items[lo].len, buf+(*pos), word_len) != 0))
+        return ccr_unrecognised;
+    (*pos) += word_len;
+    // Skipping spaces between command and parameters
+    while ((*pos) < buflen)
+    {
+        if ((buf[*pos] != ' ') && (buf[*pos] != '\t') && (buf[*pos] != '=') && ((unsigned char)buf[*pos] >= 7))
+            break;
+        (*pos)++;
+    }
+    return commands[index->items[lo].order].num;
+}
+
 int assign_named_field_value(const struct NamedField* named_field, int64_t value)
 {
     switch (named_field->type)
@@ -784,6 +1132,139 @@ long get_named_field_id(const struct NamedField *desc, const char *itmname)
   return -1;
 }
 
+/**
+ * Informs that names in NamedCommand tables might have changed, so their indices have to be remade.
+ * Needs to be called by anything which modifies names in tables after they might have been used
+ * by get_id(), get_long_id() or get_rid(). Config loaders read item names straight into buffers
+ * pointed by the tables, so they call it once, after the whole file is read. Lookups which miss
+ * are verified by a scan, so an outdated index can't make an existing name not found.
+ */
+void named_commands_changed(void)
+{
+    named_commands_generation++;
+}
+
+static inline const char *named_command_name(const void *desc, size_t item_size, long i)
+{
+    // Name is the first field of every named items structure
+    return *(const char * const *)((const char *)desc + i * item_size);
+}
+
+static unsigned long named_command_hash(const char *name)
+{
+    unsigned long hash = 2166136261u;
+    for (; *name != '\0'; name++)
+    {
+        hash ^= (unsigned char)tolower((unsigned char)*name);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static long find_named_command_scan(const void *desc, size_t item_size, const char *itmname, long *count)
+{
+    long i;
+    for (i = 0; named_command_name(desc, item_size, i) != NULL; i++)
+    {
+        if (strcasecmp(named_command_name(desc, item_size, i), itmname) == 0)
+            return i;
+    }
+    if (count != NULL)
+        *count = i;
+    return -1;
+}
+
+static TbBool make_named_commands_index(struct NamedCommandsIndex *index, const void *desc, size_t item_size)
+{
+    long count = 0;
+    while (named_command_name(desc, item_size, count) != NULL)
+        count++;
+    unsigned long slots_count = 16;
+    while (slots_count < 2 * (unsigned long)count)
+        slots_count *= 2;
+    if ((index->slots == NULL) || (index->slots_mask + 1 < slots_count))
+    {
+        long *slots = (long *)LbMemoryGrow(index->slots, slots_count * sizeof(long));
+        if (slots == NULL)
+            return false;
+        index->slots = slots;
+        index->slots_mask = slots_count - 1;
+    }
+    memset(index->slots, 0, (index->slots_mask + 1) * sizeof(long));
+    for (long i = 0; i < count; i++)
+    {
+        unsigned long slot = named_command_hash(named_command_name(desc, item_size, i)) & index->slots_mask;
+        while (index->slots[slot] != 0)
+            slot = (slot + 1) & index->slots_mask;
+        index->slots[slot] = i + 1;
+    }
+    index->desc = desc;
+    index->count = count;
+    index->generation = named_commands_generation;
+    return true;
+}
+
+/**
+ * Returns index of the named items table, making or updating it if needed; or NULL if there is none.
+ */
+static struct NamedCommandsIndex *get_named_commands_index(const void *desc, size_t item_size)
+{
+    unsigned long hash = ((unsigned long)(uintptr_t)desc >> 4) * 2654435761u;
+    for (int k = 0; k < NAMED_COMMANDS_INDICES_COUNT; k++)
+    {
+        struct NamedCommandsIndex* index = &named_commands_indices[(hash + k) & (NAMED_COMMANDS_INDICES_COUNT - 1)];
+        if ((index->desc != NULL) && (index->desc != desc))
+            continue;
+        // Remake the index if names have changed, or the table got longer or shorter
+        if ((index->desc == NULL) || (index->generation != named_commands_generation)
+          || (named_command_name(desc, item_size, index->count) != NULL)
+          || ((index->count > 0) && (named_command_name(desc, item_size, index->count - 1) == NULL)))
+        {
+            if (!make_named_commands_index(index, desc, item_size))
+                return NULL;
+        }
+        return index;
+    }
+    return NULL;
+}
+
+/**
+ * Finds item with given name in a table of named items, ended with an item of NULL name.
+ * Returns number of the first matching item, like a scan through the table would.
+ * @param count If not NULL and the item is not found, gets amount of items in the table.
+ * @return Item number, or -1 if not found.
+ */
+static long find_named_command(const void *desc, size_t item_size, const char *itmname, long *count)
+{
+    struct NamedCommandsIndex* index = get_named_commands_index(desc, item_size);
+    if (index == NULL)
+        return find_named_command_scan(desc, item_size, itmname, count);
+    long found = -1;
+    unsigned long slot = named_command_hash(itmname) & index->slots_mask;
+    // Names equal when ignoring case have the same hash, so they're all in one chain
+    for (; index->slots[slot] != 0; slot = (slot + 1) & index->slots_mask)
+    {
+        long i = index->slots[slot] - 1;
+        if ((found >= 0) && (i > found))
+            continue;
+        const char *name = named_command_name(desc, item_size, i);
+        if ((name != NULL) && (strcasecmp(name, itmname) == 0))
+            found = i;
+    }
+    if (found < 0)
+    {
+        // Names may have been written since the index was made, without named_commands_changed()
+        // being called yet; a miss is checked by a scan, so it never hides an existing name
+        found = find_named_command_scan(desc, item_size, itmname, count);
+        if (found >= 0)
+        {
+            SYNCDBG(8,"Index of named items outdated when looking for \"%s\", remaking",itmname);
+            make_named_commands_index(index, desc, item_size);
+        }
+    }
+    return found;
+}
+
 /**
  * Returns ID of given item using NamedCommands list.
  * Similar to recognize_conf_parameter(), but for use only if the buffer stores
@@ -794,12 +1275,10 @@ long get_id(const struct NamedCommand *desc, const char *itmname)
 {
   if ((desc == NULL) || (itmname == NULL))
     return -1;
-  for (long i = 0; desc[i].name != NULL; i++)
-  {
-    if (strcasecmp(desc[i].name, itmname) == 0)
-      return desc[i].num;
-  }
-  return -1;
+  long i = find_named_command(desc, sizeof(struct NamedCommand), itmname, NULL);
+  if (i < 0)
+    return -1;
+  return desc[i].num;
 }
 
 /**
@@ -812,12 +1291,10 @@ long long get_long_id(const struct LongNamedCommand* desc, const char* itmname)
 {
     if ((desc == NULL) || (itmname == NULL))
         return -1;
-    for (long i = 0; desc[i].name != NULL; i++)
-    {
-        if (strcasecmp(desc[i].name, itmname) == 0)
-            return desc[i].num;
-    }
-    return -1;
+    long i = find_named_command(desc, sizeof(struct LongNamedCommand), itmname, NULL);
+    if (i < 0)
+        return -1;
+    return desc[i].num;
 }
 
 /**
@@ -828,17 +1305,15 @@ long long get_long_id(const struct LongNamedCommand* desc, const char* itmname)
  */
 long get_rid(const struct NamedCommand *desc, const char *itmname)
 {
-  long i;
+  long count;
   if ((desc == NULL) || (itmname == NULL))
     return -1;
-  for (i=0; desc[i].name != NULL; i++)
-  {
-    if (strcasecmp(desc[i].name, itmname) == 0)
-      return desc[i].num;
-  }
+  long i = find_named_command(desc, sizeof(struct NamedCommand), itmname, &count);
+  if (i >= 0)
+    return desc[i].num;
   if (strcasecmp("RANDOM", itmname) == 0)
   {
-      i = (rand() % i);
+      i = (rand() % count);
       return desc[i].num;
   }
   return -1;
@@ -1304,6 +1779,53 @@ short load_configuration(void)
               CONFWRNLOG("Couldn't recognize \"%s\" command parameter in %s file.",COMMAND_TEXT(cmd_num),config_textname);
           }
           break;
+      case 32: // WORKER_THREADS
+          if (get_conf_parameter_single(buf,&pos,len,word_buf,sizeof(word_buf)) > 0)
+          {
+            i = atoi(word_buf);
+          }
+          if ((i >= 0) && (i <= THREADPOOL_THREADS_MAX)) {
+              worker_threads_count = i;
+          } else {
+              CONFWRNLOG("Couldn't recognize \"%s\" command parameter in %s file.",COMMAND_TEXT(cmd_num),config_textname);
+          }
+          break;
+      case 33: // MULTITHREADED_RENDERING
+          i = recognize_conf_parameter(buf,&pos,len,logicval_type);
+          if (i <= 0)
+          {
+              CONFWRNLOG("Couldn't recognize \"%s\" command parameter in %s file.",
+                COMMAND_TEXT(cmd_num),config_textname);
+            break;
+          }
+          if (i == 1)
+              features_enabled |= Ft_MultithreadedRender;
+          else
+              features_enabled &= ~Ft_MultithreadedRender;
+          break;
+      case 34: // ASYNC_LOG
+          i = recognize_conf_parameter(buf,&pos,len,log_queue_type);
+          if (i <= 0)
+          {
+              CONFWRNLOG("Couldn't recognize \"%s\" command parameter in %s file.",
+                COMMAND_TEXT(cmd_num),config_textname);
+            break;
+          }
+          if (!LbLogQueueSetup(i))
+              WARNLOG("Cannot start background log writer, log will be written directly");
+          break;
+      case 35: // NETWORK_INPUT_DELAY
+          i = -1;
+          if (get_conf_parameter_single(buf,&pos,len,word_buf,sizeof(word_buf)) > 0)
+          {
+            i = atoi(word_buf);
+          }
+          if ((i >= 0) && (i <= SCHEDULED_LAG_IN_FRAMES)) {
+              LbNetwork_SetScheduledLag(i);
+          } else {
+              CONFWRNLOG("Couldn't recognize \"%s\" command parameter in %s file.",COMMAND_TEXT(cmd_num),config_textname);
+          }
+          break;
       case 0: // comment
           break;
       case -1: // end of buffer
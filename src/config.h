@@ -82,6 +82,7 @@ enum TbFeature {
     Ft_DisableCursorCameraPanning   = 0x20000,
     Ft_DeltaTime                    = 0x40000,
     Ft_NoCdMusic                    = 0x80000,
+    Ft_MultithreadedRender          = 0x100000,
 };
 
 enum TbExtraLevels {
@@ -235,6 +236,7 @@ extern unsigned short AtmosRepeat;
 extern unsigned short AtmosStart;
 extern unsigned short AtmosEnd;
 extern TbBool AssignCpuKeepers;
+extern int worker_threads_count;
 
 extern unsigned int vid_scale_flags;
 /******************************************************************************/
@@ -324,7 +326,9 @@ TbBool reset_credits(struct CreditsItem *credits);
 TbBool setup_campaign_credits_data(struct GameCampaign *campgn);
 /******************************************************************************/
 short find_conf_block(const char *buf,long *pos,long buflen,const char *blockname);
+short find_conf_block_scan(const char *buf,long *pos,long buflen,const char *blockname);
 int recognize_conf_command(const char *buf,long *pos,long buflen,const struct NamedCommand *commands);
+int recognize_conf_command_scan(const char *buf,long *pos,long buflen,const struct NamedCommand *commands);
 TbBool skip_conf_to_next_line(const char *buf,long *pos,long buflen);
 int get_conf_parameter_single(const char *buf,long *pos,long buflen,char *dst,long dstlen);
 int get_conf_parameter_whole(const char *buf,long *pos,long buflen,char *dst,long dstlen);
@@ -340,6 +344,7 @@ long get_named_field_id(const struct NamedField *desc, const char *itmname);
 long get_id(const struct NamedCommand *desc, const char *itmname);
 long long get_long_id(const struct LongNamedCommand* desc, const char* itmname);
 long get_rid(const struct NamedCommand *desc, const char *itmname);
+void named_commands_changed(void);
 /******************************************************************************/
 #ifdef __cplusplus
 }
@@ -1714,6 +1714,8 @@ TbBool load_creaturetypes_config_file(const char *textname, const char *fname, u
         if (!result)
           WARNMSG("Parsing %s file \"%s\" attackpref blocks failed.",textname,fname);
     }
+    // Names were read straight into buffers pointed by the named tables
+    named_commands_changed();
     //Freeing and exiting
     LbMemoryFree(buf);
     return result;
@@ -232,6 +232,8 @@ TbBool load_creaturestates_config_file(const char *textname, const char *fname,
         if (!result)
           WARNMSG("Parsing %s file \"%s\" state blocks failed.",textname,fname);
     }
+    // Names were read straight into buffers pointed by the named tables
+    named_commands_changed();
     //Freeing and exiting
     LbMemoryFree(buf);
     return result;
@@ -205,6 +205,8 @@ static TbBool load_effects_config_file(const char *textname, const char *fname,
     load_effects(&file_root,flags);
     load_effectsgenerators(&file_root,flags);
     load_effectelements(&file_root,flags);
+    // Names were read straight into buffers pointed by the named tables
+    named_commands_changed();
 
     value_fini(&file_root);
     
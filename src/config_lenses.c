@@ -340,6 +340,8 @@ TbBool load_lenses_config_file(const char *textname, const char *fname, unsigned
         if (!result)
             WARNMSG("Parsing Lenses file \"%s\" data blocks failed.",fname);
     }
+    // Names were read straight into buffers pointed by the named tables
+    named_commands_changed();
     //Freeing and exiting
     LbMemoryFree(buf);
     return result;
@@ -2483,6 +2483,8 @@ TbBool load_magic_config_file(const char *textname, const char *fname, unsigned
       if (!result)
           WARNMSG("Parsing %s file \"%s\" special blocks failed.",textname,fname);
     }
+    // Names were read straight into buffers pointed by the named tables
+    named_commands_changed();
     //Freeing and exiting
     LbMemoryFree(buf);
     return result;
@@ -85,6 +85,8 @@ TbBool load_powerhands_config_file(const char *textname, const char *fname, unsi
     {
         WARNMSG("more powerhands defined then max of %d", NUM_VARIANTS);
     }
+    // Names were read straight into buffers pointed by the named tables
+    named_commands_changed();
 
     value_fini(&file_root);
     
@@ -89,6 +89,8 @@ const struct NamedField rules_game_named_fields[] = {
   {"TORTUREPAYDAY",              &game.conf.rules.game.torture_payday,             var_type(game.conf.rules.game.torture_payday            ),SHRT_MIN,SHRT_MAX},
   {"TORTURETRAININGCOST",        &game.conf.rules.game.torture_training_cost,      var_type(game.conf.rules.game.torture_training_cost     ),SHRT_MIN,SHRT_MAX},
   {"TORTURESCAVENGINGCOST",      &game.conf.rules.game.torture_scavenging_cost,    var_type(game.conf.rules.game.torture_scavenging_cost   ),SHRT_MIN,SHRT_MAX},
+  {"MAXTHINGS",                  &game.conf.rules.game.max_things,                 var_type(game.conf.rules.game.max_things                ),THINGS_POOL_CHUNK,THINGS_COUNT},
+  {"MAXCREATURES",               &game.conf.rules.game.max_creatures,              var_type(game.conf.rules.game.max_creatures             ),CREATURES_POOL_CHUNK,CREATURES_COUNT},
   {NULL,                            NULL,0,0,0 },
 };
 
@@ -278,6 +280,8 @@ static void set_defaults()
     game.conf.rules.game.pay_day_speed = 100;
     game.conf.rules.game.place_traps_on_subtiles = false;
     game.conf.rules.game.gold_per_hoard = 2000;
+    game.conf.rules.game.max_things = THINGS_COUNT_DEFAULT;
+    game.conf.rules.game.max_creatures = CREATURES_COUNT_DEFAULT;
 
     game.conf.rules.creature.recovery_frequency = 10;
     game.conf.rules.creature.fight_max_hate = 200;
@@ -98,6 +98,8 @@ struct GameRulesConfig {
     short torture_payday;
     short torture_training_cost;
     short torture_scavenging_cost;
+    ThingIndex max_things;
+    short max_creatures;
 };
 
 struct ComputerRulesConfig {
@@ -1186,6 +1186,8 @@ TbBool load_terrain_config_file(const char *textname, const char *fname, unsigne
         if (!result)
             WARNMSG("Parsing %s file \"%s\" room blocks failed.",textname,fname);
     }
+    // Names were read straight into buffers pointed by the named tables
+    named_commands_changed();
     //Freeing and exiting
     LbMemoryFree(buf);
     return result;
@@ -1505,6 +1505,8 @@ TbBool load_trapdoor_config_file(const char *textname, const char *fname, unsign
         if (!result)
             WARNMSG("Parsing %s file \"%s\" door blocks failed.",textname,fname);
     }
+    // Names were read straight into buffers pointed by the named tables
+    named_commands_changed();
     //Freeing and exiting
     LbMemoryFree(buf);
     SYNCDBG(19,"Done");
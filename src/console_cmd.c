@@ -313,7 +313,7 @@ static TbBool cmd_magic_instance(PlayerNumber plyr_idx, char* creature_str, cons
     }
     struct CreatureStats* crstat = creature_stats_get(creature);
     crstat->learned_instance_id[slot] = instance;
-    for (long i = 0; i < THINGS_COUNT; i++)
+    for (long i = 0; i < game.thing_slots_count; i++)
     {
         struct Thing* thing = thing_get(i);
         if ((thing->alloc_flags & TAlF_Exists) != 0)
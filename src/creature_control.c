@@ -40,6 +40,114 @@
 extern "C" {
 #endif
 /******************************************************************************/
+/** Memory blocks backing the creature control slots. Blocks are allocated when the pool grows, and are kept until the game exits. */
+static struct CreatureControl *cctrl_pool_chunks[CREATURES_POOL_CHUNKS_COUNT];
+/** Amount of allocated blocks; they are always allocated from the first one up. */
+static long cctrl_pool_chunks_count = 0;
+/******************************************************************************/
+/**
+ * Makes sure memory for creature control slots below given index is allocated.
+ * @param slots_count Amount of slots which need to be backed by memory.
+ * @return True if the memory is available, false if allocation failed.
+ */
+TbBool creature_controls_pool_reserve(long slots_count)
+{
+    if (slots_count > CREATURES_COUNT)
+        slots_count = CREATURES_COUNT;
+    for (long n = 0; n * CREATURES_POOL_CHUNK < slots_count; n++)
+    {
+        if (cctrl_pool_chunks[n] != NULL)
+            continue;
+        cctrl_pool_chunks[n] = (struct CreatureControl *)LbMemoryAlloc(CREATURES_POOL_CHUNK * sizeof(struct CreatureControl));
+        if (cctrl_pool_chunks[n] == NULL)
+        {
+            ERRORLOG("Cannot allocate memory for creature control slots %d-%d",(int)(n * CREATURES_POOL_CHUNK),(int)((n + 1) * CREATURES_POOL_CHUNK - 1));
+            return false;
+        }
+        cctrl_pool_chunks_count = n + 1;
+        for (long k = 0; k < CREATURES_POOL_CHUNK; k++)
+        {
+            game.persons.cctrl_lookup[n * CREATURES_POOL_CHUNK + k] = &cctrl_pool_chunks[n][k];
+        }
+    }
+    return true;
+}
+
+/**
+ * Fills the creature controls lookup array with addresses of allocated slots.
+ */
+void creature_controls_pool_update_lookups(void)
+{
+    for (long n = 0; n < CREATURES_POOL_CHUNKS_COUNT; n++)
+    {
+        for (long k = 0; k < CREATURES_POOL_CHUNK; k++)
+        {
+            if (cctrl_pool_chunks[n] != NULL)
+                game.persons.cctrl_lookup[n * CREATURES_POOL_CHUNK + k] = &cctrl_pool_chunks[n][k];
+            else
+                game.persons.cctrl_lookup[n * CREATURES_POOL_CHUNK + k] = NULL;
+        }
+    }
+    game.persons.cctrl_end = NULL;
+}
+
+/**
+ * Clears creature control slots which are allocated, but are beyond the slots available in current level.
+ */
+void creature_controls_pool_clear_unavailable(void)
+{
+    for (long i = game.cctrl_slots_count; i < CREATURES_COUNT; i++)
+    {
+        struct CreatureControl* cctrl = game.persons.cctrl_lookup[i];
+        if (cctrl != NULL)
+            LbMemorySet(cctrl, 0, sizeof(struct CreatureControl));
+    }
+}
+
+void creature_controls_pool_free(void)
+{
+    for (long n = 0; n < CREATURES_POOL_CHUNKS_COUNT; n++)
+    {
+        LbMemoryFree(cctrl_pool_chunks[n]);
+        cctrl_pool_chunks[n] = NULL;
+    }
+    cctrl_pool_chunks_count = 0;
+    creature_controls_pool_update_lookups();
+}
+
+/**
+ * Returns max amount of creature control slots which can be used in current level.
+ */
+long get_cctrl_slots_limit(void)
+{
+    long limit = game.conf.rules.game.max_creatures;
+    if (limit > CREATURES_COUNT)
+        limit = CREATURES_COUNT;
+    if (limit < CREATURES_POOL_CHUNK)
+        limit = CREATURES_POOL_CHUNK;
+    return limit;
+}
+
+/**
+ * Makes more creature control slots available.
+ * @return Amount of slots added.
+ */
+static long creature_controls_pool_grow(void)
+{
+    long slots_count = game.cctrl_slots_count;
+    if (slots_count < 1)
+        slots_count = 1;
+    long limit = get_cctrl_slots_limit();
+    if (slots_count >= limit)
+        return 0;
+    long n = CREATURES_POOL_CHUNK - (slots_count % CREATURES_POOL_CHUNK);
+    if (slots_count + n > limit)
+        n = limit - slots_count;
+    if (!creature_controls_pool_reserve(slots_count + n))
+        return 0;
+    game.cctrl_slots_count = slots_count + n;
+    return n;
+}
 
 /******************************************************************************/
 /**
@@ -47,9 +155,12 @@ extern "C" {
  */
 struct CreatureControl *creature_control_get(long cctrl_idx)
 {
-  if ((cctrl_idx < 1) || (cctrl_idx > CREATURES_COUNT))
+  if ((cctrl_idx < 1) || (cctrl_idx >= CREATURES_COUNT))
+    return INVALID_CRTR_CONTROL;
+  struct CreatureControl* cctrl = game.persons.cctrl_lookup[cctrl_idx];
+  if (cctrl == NULL)
     return INVALID_CRTR_CONTROL;
-  return game.persons.cctrl_lookup[cctrl_idx];
+  return cctrl;
 }
 
 /**
@@ -58,9 +169,7 @@ struct CreatureControl *creature_control_get(long cctrl_idx)
  */
 struct CreatureControl *creature_control_get_from_thing(const struct Thing *thing)
 {
-  if ((thing->ccontrol_idx < 1) || (thing->ccontrol_idx > CREATURES_COUNT))
-    return INVALID_CRTR_CONTROL;
-  return game.persons.cctrl_lookup[thing->ccontrol_idx];
+  return creature_control_get(thing->ccontrol_idx);
 }
 
 /**
@@ -68,7 +177,17 @@ struct CreatureControl *creature_control_get_from_thing(const struct Thing *thin
  */
 TbBool creature_control_invalid(const struct CreatureControl *cctrl)
 {
-  return (cctrl <= game.persons.cctrl_lookup[0]) || (cctrl == NULL);
+  if ((cctrl == NULL) || (cctrl == game.persons.cctrl_lookup[0]))
+      return true;
+  // Controls are stored in separately allocated chunks; addresses are compared as integers,
+  // as comparing pointers into different blocks is undefined
+  uintptr_t addr = (uintptr_t)cctrl;
+  for (long n = 0; n < cctrl_pool_chunks_count; n++)
+  {
+      if (addr - (uintptr_t)cctrl_pool_chunks[n] < CREATURES_POOL_CHUNK * sizeof(struct CreatureControl))
+          return false;
+  }
+  return true;
 }
 
 TbBool creature_control_exists(const struct CreatureControl *cctrl)
@@ -87,7 +206,7 @@ TbBool creature_control_exists_in_thing(const struct Thing *thing)
 
 long i_can_allocate_free_control_structure(void)
 {
-    for (long i = 1; i < CREATURES_COUNT; i++)
+    for (long i = 1; i < game.cctrl_slots_count; i++)
     {
         struct CreatureControl* cctrl = game.persons.cctrl_lookup[i];
         if (!creature_control_invalid(cctrl))
@@ -95,14 +214,21 @@ long i_can_allocate_free_control_structure(void)
             if ((cctrl->flgfield_1 & CCFlg_Exists) == 0)
                 return i;
         }
-  }
-  return 0;
+    }
+    // The pool can still grow; first new slot will be used
+    if (game.cctrl_slots_count < get_cctrl_slots_limit())
+        return max(game.cctrl_slots_count, 1);
+    return 0;
 }
 
 struct CreatureControl *allocate_free_control_structure(void)
 {
-    for (long i = 1; i < CREATURES_COUNT; i++)
+    long limit = get_cctrl_slots_limit();
+    for (long i = 1; i < limit; i++)
     {
+        // Slots are checked in order of indices, and the pool grows only when all available ones are used
+        if ((i >= game.cctrl_slots_count) && (creature_controls_pool_grow() <= 0))
+            break;
         struct CreatureControl* cctrl = game.persons.cctrl_lookup[i];
         if (!creature_control_invalid(cctrl))
         {
@@ -113,7 +239,7 @@ struct CreatureControl *allocate_free_control_structure(void)
                 cctrl->index = i;
                 return cctrl;
             }
-      }
+        }
     }
     return NULL;
 }
@@ -134,6 +260,8 @@ void delete_all_control_structures(void)
                 delete_control_structure(cctrl);
       }
     }
+    // Slots will become available again, as the pool grows
+    game.cctrl_slots_count = 1;
 }
 
 struct Thing *create_and_control_creature_as_controller(struct PlayerInfo *player, long crmodel, struct Coord3d *pos)
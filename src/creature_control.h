@@ -39,8 +39,13 @@ extern "C" {
 #define MAX_SIZEXY            768
 /** Max amount of spells casted at the creature at once. */
 #define CREATURE_MAX_SPELLS_CASTED_AT 5
-/** Max amount of creatures supported on any map. */
-#define CREATURES_COUNT       256
+/** Max amount of creatures supported on any map; the limit for a level is set by MaxCreatures rule. */
+#define CREATURES_COUNT      1024
+/** Default limit of creature controls, used if rules do not state otherwise. */
+#define CREATURES_COUNT_DEFAULT 256
+/** Amount of creature control slots by which the pool grows at once. */
+#define CREATURES_POOL_CHUNK   64
+#define CREATURES_POOL_CHUNKS_COUNT ((CREATURES_COUNT + CREATURES_POOL_CHUNK - 1) / CREATURES_POOL_CHUNK)
 /** Number of possible melee combat opponents. */
 #define COMBAT_MELEE_OPPONENTS_LIMIT       4
 /** Number of possible range combat opponents. */
@@ -142,7 +147,7 @@ struct CastedSpellData {
 };
 
 struct CreatureControl {
-    unsigned char index;
+    short index;
     unsigned char flgfield_1;
     unsigned char flgfield_2;
     unsigned char combat_flags;
@@ -554,6 +559,12 @@ struct CreatureSounds {
 
 #pragma pack()
 /******************************************************************************/
+TbBool creature_controls_pool_reserve(long slots_count);
+void creature_controls_pool_update_lookups(void);
+void creature_controls_pool_clear_unavailable(void);
+void creature_controls_pool_free(void);
+long get_cctrl_slots_limit(void);
+
 struct CreatureControl *creature_control_get(long cctrl_idx);
 struct CreatureControl *creature_control_get_from_thing(const struct Thing *thing);
 TbBool creature_control_invalid(const struct CreatureControl *cctrl);
@@ -28,8 +28,10 @@
 #include "bflib_dernc.h"
 #include "sprites.h"
 #include "config_spritecolors.h"
+#include "bflib_threadpool.h"
 
 #include <spng.h>
+#include <zlib.h>
 #include <json.h>
 #include <json-dom.h>
 #include "post_inc.h"
@@ -93,6 +95,10 @@ struct PaletteNode
 
 static struct PaletteRecord pal_records[PALETTE_COLORS]; // for each color of a palette
 static struct PaletteNode pal_tree[MAX_COLOR_VALUE]; // For each component of a palette
+// Palette index for every color, with components scaled to palette range
+static unsigned char pal_lut[MAX_COLOR_VALUE * MAX_COLOR_VALUE * MAX_COLOR_VALUE];
+static TbBool pal_lut_valid = false;
+static uint32_t pal_lut_crc;
 static struct NamedCommand added_sprites[KEEPERSPRITE_ADD_NUM];
 static struct NamedCommand added_icons[GUI_PANEL_SPRITES_NEW];
 static int num_added_sprite = 0;
@@ -105,6 +111,8 @@ unsigned char *big_scratch = big_scratch_data;
 
 static void init_pal_conversion();
 
+static unsigned char pal_nearest_color(uint32_t data);
+
 static void compress_raw(struct TbHugeSprite *sprite, unsigned char *src_buf, int x, int y, int w, int h);
 
 static TbBool add_custom_sprite(const char *path);
@@ -112,10 +120,20 @@ static TbBool add_custom_sprite(const char *path);
 static TbBool
 add_custom_json(const char *path, const char *name, TbBool (*process)(const char *path, unzFile zip, VALUE *root));
 
+static TbBool
+add_custom_json_uncached(const char *path, const char *name, TbBool (*process)(const char *path, unzFile zip, VALUE *root));
+
 static TbBool process_icon(const char *path, unzFile zip, VALUE *root);
 
 static int cmp_named_command(const void *a, const void *b);
 
+static TbBool add_sprite_name(const char *name, short td_id);
+
+static TbBool add_icon_name(const char *name, int first_icon, int icons_count);
+
+struct PngJob;
+static int install_sprites(const char *path, struct SpriteContext *context, VALUE *node, struct PngJob *jobs);
+
 static const unsigned char bad_icon_data[] = // 16x16
         {
                 16, 255, 255, 255, 255, 17, 17, 17, 17, 255, 255, 255, 255, 17, 17, 17, 17, 0,
@@ -206,6 +224,470 @@ static int fastUnzClearCache()
 
 /* end of zip stuff */
 
+/*
+ * Cache of converted sprites
+ * Decoding PNGs and converting them to palette takes most of level loading time,
+ * so results of processing every zip are stored in save folder, and reused while
+ * the zip, palette and screen resolution class are unchanged.
+ * Cache file keeps everything the processing changed: sprites and icons allocated
+ * at the end of lists, and names added in order. Indices are stored relative
+ * to first free sprite and icon, so that cache can be used in any load order.
+ */
+#define SPRITE_CACHE_MAGIC "KFXSPRC"
+#define SPRITE_CACHE_VERSION 1
+// Marks td_iso_add/iso_td_add entry which the processing did not set
+#define SPRITE_CACHE_UNSET_ID -1
+
+enum SpriteCacheNameKind {
+    SCNK_Sprite = 0,
+    SCNK_Icon,
+};
+
+struct SpriteCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t zip_crc;
+    uint32_t zip_adler;
+    uint32_t zip_size;
+    uint32_t pal_crc;
+    uint8_t lowres;
+    uint8_t ret_ok;
+    uint8_t sorted_sprites;
+    uint8_t sorted_icons;
+    uint32_t keepersprite_size;
+    uint32_t sprites_count;
+    uint32_t icons_count;
+    uint32_t names_count;
+};
+
+struct SpriteCacheKey
+{
+    char fname[2048];
+    /** Hash of the zip path and name of the json; shared by all cache files of the json. */
+    uint32_t path_crc;
+    const char *json_name;
+    struct SpriteCacheHeader hdr;
+};
+
+struct SpriteCacheBuf
+{
+    unsigned char *data;
+    size_t size;
+    size_t alloc_size;
+    size_t pos;
+    TbBool failed;
+};
+
+/** State of recording what processing of a zip changes. */
+struct SpriteCacheRecording
+{
+    TbBool active;
+    short sprite_base;
+    short icon_base;
+    int num_added_sprite_base;
+    int num_added_icons_base;
+    TbBool sorted_sprites;
+    TbBool sorted_icons;
+    uint32_t names_count;
+    struct SpriteCacheBuf names;
+    short td_iso_prev[KEEPERSPRITE_ADD_NUM];
+    short iso_td_prev[KEEPERSPRITE_ADD_NUM];
+};
+
+static struct SpriteCacheRecording sprite_cache_rec;
+/** Hash of last zip; reused for second json in the same zip. */
+static char sprite_cache_last_path[2048];
+static struct SpriteCacheHeader sprite_cache_last_hdr;
+
+static void sprite_cache_buf_put(struct SpriteCacheBuf *buf, const void *src, size_t len)
+{
+    if (len == 0)
+        return;
+    if (buf->size + len > buf->alloc_size)
+    {
+        size_t alloc_size = (buf->alloc_size > 0) ? buf->alloc_size : 65536;
+        while (buf->size + len > alloc_size)
+            alloc_size *= 2;
+        unsigned char *data = realloc(buf->data, alloc_size);
+        if (data == NULL)
+        {
+            buf->failed = true;
+            return;
+        }
+        buf->data = data;
+        buf->alloc_size = alloc_size;
+    }
+    memcpy(buf->data + buf->size, src, len);
+    buf->size += len;
+}
+
+static void sprite_cache_buf_free(struct SpriteCacheBuf *buf)
+{
+    free(buf->data);
+    memset(buf, 0, sizeof(*buf));
+}
+
+/**
+ * Returns pointer to next len bytes of the buffer, or NULL if there's not enough data.
+ */
+static const unsigned char *sprite_cache_buf_get(struct SpriteCacheBuf *buf, size_t len)
+{
+    if (buf->failed || (buf->pos + len > buf->size))
+    {
+        buf->failed = true;
+        return NULL;
+    }
+    const unsigned char *ret = buf->data + buf->pos;
+    buf->pos += len;
+    return ret;
+}
+
+/**
+ * Copies next len bytes of the buffer; data in cache file is not aligned.
+ */
+static TbBool sprite_cache_buf_read(struct SpriteCacheBuf *buf, void *dst, size_t len)
+{
+    const unsigned char *src = sprite_cache_buf_get(buf, len);
+    if (src == NULL)
+        return false;
+    memcpy(dst, src, len);
+    return true;
+}
+
+/**
+ * Returns amount of bytes used by RLE coded sprite data with given amount of lines.
+ */
+static size_t sprite_rle_data_size(const unsigned char *data, int height)
+{
+    size_t pos = 0;
+    for (int j = 0; j < height; j++)
+    {
+        for (;;)
+        {
+            signed char len = (signed char)data[pos];
+            pos++;
+            if (len == 0)
+                break;
+            if (len > 0)
+                pos += len;
+        }
+    }
+    return pos;
+}
+
+/**
+ * Prepares cache key for given zip; its content hash is computed when reading it as a whole.
+ * @return False if the zip cannot be read.
+ */
+static TbBool sprite_cache_make_key(const char *path, const char *name, struct SpriteCacheKey *key)
+{
+    struct SpriteCacheHeader *hdr = &key->hdr;
+    if (strcmp(sprite_cache_last_path, path) == 0)
+    {
+        *hdr = sprite_cache_last_hdr;
+    } else
+    {
+        long len = LbFileLength(path);
+        if (len <= 0)
+            return false;
+        unsigned char *buf = malloc(len);
+        if (buf == NULL)
+            return false;
+        if (LbFileLoadAt(path, buf) != len)
+        {
+            free(buf);
+            return false;
+        }
+        memset(hdr, 0, sizeof(*hdr));
+        memcpy(hdr->magic, SPRITE_CACHE_MAGIC, sizeof(hdr->magic));
+        hdr->version = SPRITE_CACHE_VERSION;
+        hdr->zip_crc = crc32(crc32(0L, Z_NULL, 0), buf, len);
+        hdr->zip_adler = adler32(adler32(0L, Z_NULL, 0), buf, len);
+        hdr->zip_size = len;
+        hdr->keepersprite_size = sizeof(struct KeeperSprite);
+        free(buf);
+        snprintf(sprite_cache_last_path, sizeof(sprite_cache_last_path), "%s", path);
+        sprite_cache_last_hdr = *hdr;
+    }
+    hdr->pal_crc = crc32(crc32(0L, Z_NULL, 0), base_pal, PALETTE_SIZE);
+    hdr->lowres = (lbDisplay.PhysicalScreenWidth <= LOWRES_SCREEN_SIZE);
+    key->path_crc = crc32(crc32(0L, Z_NULL, 0), (const unsigned char *)path, strlen(path));
+    key->json_name = name;
+    snprintf(key->fname, sizeof(key->fname), "%s", prepare_file_fmtpath(FGrp_Save, "sprites_%08lx_%08lx%08lx_%.4s.cache",
+        (unsigned long)key->path_crc, (unsigned long)hdr->zip_crc, (unsigned long)hdr->zip_adler, name));
+    return true;
+}
+
+/**
+ * Removes cache files made for earlier content of the zip, so that they don't pile up in save folder.
+ */
+static void sprite_cache_remove_stale(const struct SpriteCacheKey *key)
+{
+    struct TbFileFind fileinfo;
+    char fspec[sizeof(key->fname)];
+    snprintf(fspec, sizeof(fspec), "%s", prepare_file_fmtpath(FGrp_Save, "sprites_%08lx_*_%.4s.cache",
+        (unsigned long)key->path_crc, key->json_name));
+    for (int rc = LbFileFindFirst(fspec, &fileinfo, 0x21u);
+         rc != -1;
+         rc = LbFileFindNext(&fileinfo))
+    {
+        const char *fname = prepare_file_path(FGrp_Save, fileinfo.Filename);
+        if (strcmp(fname, key->fname) != 0)
+        {
+            SYNCDBG(7, "Removing stale sprite cache file \"%s\"", fname);
+            LbFileDelete(fname);
+        }
+    }
+}
+
+/**
+ * Goes through cached sprites, icons and names; adds them only if apply is set.
+ * @return False if cache data is damaged.
+ */
+static TbBool sprite_cache_read_items(struct SpriteCacheBuf *buf, const struct SpriteCacheHeader *hdr, TbBool apply)
+{
+    short sprite_base = next_free_sprite;
+    short icon_base = next_free_icon;
+    for (uint32_t i = 0; i < hdr->sprites_count; i++)
+    {
+        struct KeeperSprite ksp;
+        int16_t ids[2];
+        uint32_t data_len;
+        if (!sprite_cache_buf_read(buf, &ksp, sizeof(ksp)) || !sprite_cache_buf_read(buf, ids, sizeof(ids))
+          || !sprite_cache_buf_read(buf, &data_len, sizeof(data_len)))
+            return false;
+        size_t sz = (ksp.SWidth + 2) * (ksp.SHeight + 3);
+        const unsigned char *data = sprite_cache_buf_get(buf, data_len);
+        if ((data == NULL) || (data_len > sz))
+            return false;
+        if (!apply)
+            continue;
+        short sprite_idx = sprite_base + i;
+        keepersprite_add[sprite_idx] = malloc(sz);
+        memcpy(keepersprite_add[sprite_idx], data, data_len);
+        creature_table_add[sprite_idx] = ksp;
+        if (ids[0] != SPRITE_CACHE_UNSET_ID)
+            td_iso_add[sprite_idx] = ids[0] + sprite_base + KEEPERSPRITE_ADD_OFFSET;
+        if (ids[1] != SPRITE_CACHE_UNSET_ID)
+            iso_td_add[sprite_idx] = ids[1] + sprite_base + KEEPERSPRITE_ADD_OFFSET;
+    }
+    for (uint32_t i = 0; i < hdr->icons_count; i++)
+    {
+        uint16_t dims[2];
+        uint32_t data_len;
+        if (!sprite_cache_buf_read(buf, dims, sizeof(dims)) || !sprite_cache_buf_read(buf, &data_len, sizeof(data_len)))
+            return false;
+        size_t sz = (dims[0] + 2) * (dims[1] + 3);
+        const unsigned char *data = sprite_cache_buf_get(buf, data_len);
+        if ((data == NULL) || (data_len > sz))
+            return false;
+        if (!apply)
+            continue;
+        struct TbSprite *spr = &gui_panel_sprites[GUI_PANEL_SPRITES_COUNT + icon_base + i];
+        spr->Data = malloc(sz);
+        memcpy(spr->Data, data, data_len);
+        spr->SWidth = dims[0];
+        spr->SHeight = dims[1];
+    }
+    if (apply)
+    {
+        next_free_sprite += hdr->sprites_count;
+        next_free_icon += hdr->icons_count;
+    }
+    for (uint32_t i = 0; i < hdr->names_count; i++)
+    {
+        uint8_t kind;
+        int32_t nums[2];
+        uint16_t name_len;
+        if (!sprite_cache_buf_read(buf, &kind, sizeof(kind)) || !sprite_cache_buf_read(buf, nums, sizeof(nums))
+          || !sprite_cache_buf_read(buf, &name_len, sizeof(name_len)))
+            return false;
+        const unsigned char *name_data = sprite_cache_buf_get(buf, name_len);
+        if (name_data == NULL)
+            return false;
+        if (!apply)
+            continue;
+        char *name = malloc(name_len + 1);
+        memcpy(name, name_data, name_len);
+        name[name_len] = '\0';
+        if (kind == SCNK_Sprite)
+        {
+            add_sprite_name(name, nums[0] + sprite_base + KEEPERSPRITE_ADD_OFFSET);
+        } else
+        {
+            int first_icon = (nums[0] >= 0) ? nums[0] + icon_base + GUI_PANEL_SPRITES_COUNT : 0;
+            add_icon_name(name, first_icon, nums[1]);
+        }
+        free(name);
+    }
+    if (apply)
+    {
+        if (hdr->sorted_sprites)
+            qsort(added_sprites, num_added_sprite, sizeof(added_sprites[0]), &cmp_named_command);
+        if (hdr->sorted_icons)
+            qsort(added_icons, num_added_icons, sizeof(added_icons[0]), &cmp_named_command);
+    }
+    return true;
+}
+
+/**
+ * Loads sprites from cache file, if there is one for given key.
+ * @return True if the cache was used; then ret_ok is set to result of original processing.
+ */
+static TbBool sprite_cache_load(const struct SpriteCacheKey *key, TbBool *ret_ok)
+{
+    struct SpriteCacheBuf buf = {0};
+    long len = LbFileLength(key->fname);
+    if (len < (long)sizeof(struct SpriteCacheHeader))
+        return false;
+    buf.data = malloc(len);
+    if (buf.data == NULL)
+        return false;
+    buf.size = len;
+    if (LbFileLoadAt(key->fname, buf.data) != len)
+    {
+        sprite_cache_buf_free(&buf);
+        return false;
+    }
+    struct SpriteCacheHeader hdr_v;
+    struct SpriteCacheHeader *hdr = &hdr_v;
+    sprite_cache_buf_read(&buf, hdr, sizeof(*hdr));
+    // Everything but the results of processing should match
+    struct SpriteCacheHeader cmp_hdr = *hdr;
+    cmp_hdr.ret_ok = key->hdr.ret_ok;
+    cmp_hdr.sorted_sprites = key->hdr.sorted_sprites;
+    cmp_hdr.sorted_icons = key->hdr.sorted_icons;
+    cmp_hdr.sprites_count = key->hdr.sprites_count;
+    cmp_hdr.icons_count = key->hdr.icons_count;
+    cmp_hdr.names_count = key->hdr.names_count;
+    if ((memcmp(&cmp_hdr, &key->hdr, sizeof(cmp_hdr)) != 0)
+      || (next_free_sprite + hdr->sprites_count >= KEEPERSPRITE_ADD_NUM)
+      || (next_free_icon + hdr->icons_count >= GUI_PANEL_SPRITES_NEW)
+      || (num_added_sprite + hdr->names_count >= KEEPERSPRITE_ADD_NUM)
+      || (num_added_icons + hdr->names_count >= GUI_PANEL_SPRITES_NEW))
+    {
+        sprite_cache_buf_free(&buf);
+        return false;
+    }
+    size_t items_pos = buf.pos;
+    if (!sprite_cache_read_items(&buf, hdr, false) || (buf.pos != buf.size))
+    {
+        WARNLOG("Damaged sprite cache file \"%s\"", key->fname);
+        sprite_cache_buf_free(&buf);
+        return false;
+    }
+    buf.pos = items_pos;
+    sprite_cache_read_items(&buf, hdr, true);
+    *ret_ok = hdr->ret_ok;
+    SYNCDBG(7, "Loaded %lu sprites and %lu icons from cache", (unsigned long)hdr->sprites_count, (unsigned long)hdr->icons_count);
+    sprite_cache_buf_free(&buf);
+    return true;
+}
+
+static void sprite_cache_record_start(void)
+{
+    struct SpriteCacheRecording *rec = &sprite_cache_rec;
+    rec->active = true;
+    rec->sprite_base = next_free_sprite;
+    rec->icon_base = next_free_icon;
+    rec->num_added_sprite_base = num_added_sprite;
+    rec->num_added_icons_base = num_added_icons;
+    rec->sorted_sprites = false;
+    rec->sorted_icons = false;
+    rec->names_count = 0;
+    sprite_cache_buf_free(&rec->names);
+    // Entries of new sprites are cleared, to know which ones the processing sets
+    memcpy(rec->td_iso_prev, td_iso_add, sizeof(td_iso_add));
+    memcpy(rec->iso_td_prev, iso_td_add, sizeof(iso_td_add));
+    memset(&td_iso_add[rec->sprite_base], 0, sizeof(td_iso_add[0]) * (KEEPERSPRITE_ADD_NUM - rec->sprite_base));
+    memset(&iso_td_add[rec->sprite_base], 0, sizeof(iso_td_add[0]) * (KEEPERSPRITE_ADD_NUM - rec->sprite_base));
+}
+
+static void sprite_cache_record_name(enum SpriteCacheNameKind kind, const char *name, int num, int count)
+{
+    struct SpriteCacheRecording *rec = &sprite_cache_rec;
+    if (!rec->active)
+        return;
+    uint8_t kind_val = kind;
+    int32_t nums[2];
+    if (kind == SCNK_Sprite)
+        nums[0] = num - KEEPERSPRITE_ADD_OFFSET - rec->sprite_base;
+    else
+        nums[0] = (num != 0) ? num - GUI_PANEL_SPRITES_COUNT - rec->icon_base : -1;
+    nums[1] = count;
+    uint16_t name_len = strlen(name);
+    sprite_cache_buf_put(&rec->names, &kind_val, sizeof(kind_val));
+    sprite_cache_buf_put(&rec->names, nums, sizeof(nums));
+    sprite_cache_buf_put(&rec->names, &name_len, sizeof(name_len));
+    sprite_cache_buf_put(&rec->names, name, name_len);
+    rec->names_count++;
+}
+
+/**
+ * Stores what the processing of a zip changed into cache file, and restores sprite
+ * entries which were not set by it.
+ */
+static void sprite_cache_record_finish(struct SpriteCacheKey *key, TbBool ret_ok)
+{
+    struct SpriteCacheRecording *rec = &sprite_cache_rec;
+    struct SpriteCacheHeader *hdr = &key->hdr;
+    struct SpriteCacheBuf buf = {0};
+    rec->active = false;
+    hdr->ret_ok = ret_ok;
+    hdr->sorted_sprites = rec->sorted_sprites;
+    hdr->sorted_icons = rec->sorted_icons;
+    hdr->sprites_count = next_free_sprite - rec->sprite_base;
+    hdr->icons_count = next_free_icon - rec->icon_base;
+    hdr->names_count = rec->names_count;
+    sprite_cache_buf_put(&buf, hdr, sizeof(*hdr));
+    for (short i = rec->sprite_base; i < next_free_sprite; i++)
+    {
+        int16_t ids[2];
+        ids[0] = (td_iso_add[i] != 0) ? td_iso_add[i] - KEEPERSPRITE_ADD_OFFSET - rec->sprite_base : SPRITE_CACHE_UNSET_ID;
+        ids[1] = (iso_td_add[i] != 0) ? iso_td_add[i] - KEEPERSPRITE_ADD_OFFSET - rec->sprite_base : SPRITE_CACHE_UNSET_ID;
+        uint32_t data_len = sprite_rle_data_size(keepersprite_add[i], creature_table_add[i].SHeight);
+        sprite_cache_buf_put(&buf, &creature_table_add[i], sizeof(struct KeeperSprite));
+        sprite_cache_buf_put(&buf, ids, sizeof(ids));
+        sprite_cache_buf_put(&buf, &data_len, sizeof(data_len));
+        sprite_cache_buf_put(&buf, keepersprite_add[i], data_len);
+    }
+    for (short i = rec->icon_base; i < next_free_icon; i++)
+    {
+        const struct TbSprite *spr = &gui_panel_sprites[GUI_PANEL_SPRITES_COUNT + i];
+        uint16_t dims[2] = {spr->SWidth, spr->SHeight};
+        uint32_t data_len = sprite_rle_data_size(spr->Data, spr->SHeight);
+        sprite_cache_buf_put(&buf, dims, sizeof(dims));
+        sprite_cache_buf_put(&buf, &data_len, sizeof(data_len));
+        sprite_cache_buf_put(&buf, spr->Data, data_len);
+    }
+    sprite_cache_buf_put(&buf, rec->names.data, rec->names.size);
+    for (short i = rec->sprite_base; i < KEEPERSPRITE_ADD_NUM; i++)
+    {
+        if ((i >= next_free_sprite) || (td_iso_add[i] == 0))
+            td_iso_add[i] = rec->td_iso_prev[i];
+        if ((i >= next_free_sprite) || (iso_td_add[i] == 0))
+            iso_td_add[i] = rec->iso_td_prev[i];
+    }
+    // If any limit was reached, results would be different when loaded in another order
+    TbBool limits_reached = (next_free_sprite >= KEEPERSPRITE_ADD_NUM) || (next_free_icon >= GUI_PANEL_SPRITES_NEW)
+      || (num_added_sprite >= KEEPERSPRITE_ADD_NUM) || (num_added_icons >= GUI_PANEL_SPRITES_NEW);
+    if (!buf.failed && !rec->names.failed && !limits_reached)
+    {
+        if (LbFileSaveAt(key->fname, buf.data, buf.size) != (long)buf.size)
+        {
+            SYNCDBG(3, "Unable to write sprite cache file \"%s\"", key->fname);
+        } else
+        {
+            sprite_cache_remove_stale(key);
+        }
+    }
+    sprite_cache_buf_free(&buf);
+    sprite_cache_buf_free(&rec->names);
+}
+
+/* end of cache stuff */
+
 static int pal_compare_fn(const void *a, const void *b)
 {
     const struct PaletteRecord *rec_a = a;
@@ -327,6 +809,8 @@ void init_custom_sprites(LevelNumber lvnum)
     }
 
     init_pal_conversion();
+    // Zips could have been changed since last load
+    sprite_cache_last_path[0] = '\0';
     load_system_sprites(FGrp_FxData);
     load_system_sprites(FGrp_CmpgConfig);
 
@@ -421,6 +905,24 @@ static void init_pal_conversion()
         }
     }
 #undef NEAREST_DEPTH
+    // 5. Filling lookup table; the palette rarely changes, so it is kept if possible
+    uint32_t crc = crc32(crc32(0L, Z_NULL, 0), base_pal, PALETTE_SIZE);
+    if (!pal_lut_valid || (pal_lut_crc != crc))
+    {
+        for (uint32_t b = 0; b < MAX_COLOR_VALUE; b++)
+        {
+            for (uint32_t g = 0; g < MAX_COLOR_VALUE; g++)
+            {
+                for (uint32_t r = 0; r < MAX_COLOR_VALUE; r++)
+                {
+                    uint32_t data = (r * 4) | ((g * 4) << 8) | ((b * 4) << 16);
+                    pal_lut[(b * MAX_COLOR_VALUE + g) * MAX_COLOR_VALUE + r] = pal_nearest_color(data);
+                }
+            }
+        }
+        pal_lut_crc = crc;
+        pal_lut_valid = true;
+    }
     SYNCDBG(8, "Finished");
 }
 
@@ -677,53 +1179,189 @@ static int read_png_info(unzFile zip, const char *path, struct SpriteContext *co
     return 0;
 }
 
-static int read_png_icon(unzFile zip, const char *path, const char *subpath, int *icon_ptr)
+/*
+ * Decoding of sprite files on worker threads
+ * Files are read from zip on the main thread, in order; then they are decoded
+ * and converted to palette in parallel, and installed in original order again,
+ * so that sprite and icon indices do not depend on timing of the threads.
+ */
+enum PngJobState {
+    PJS_Read = 0, // File was read, decoding results are in the job
+    PJS_NoName,   // Record has no file name
+    PJS_NotFound,
+    PJS_OpenFail,
+};
+
+enum PngJobError {
+    PJE_None = 0,
+    PJE_Header,   // spng_get_ihdr() failed
+    PJE_BitDepth,
+    PJE_TooBig,   // Decoded image would be over the limit
+};
+
+struct PngJob
 {
-    struct TbHugeSprite sprite = {0};
-    size_t out_size;
+    const char *name;
+    VALUE *itm;
+    enum PngJobState state;
+    TbBool close_ok;
+    unsigned char *png;
+    size_t png_size;
+    unsigned long x, y;
+    enum PngJobError error;
+    int spng_err;
+    TbBool decoded;
+    unsigned long width, height;
+    /** Sprite data with RLE coded transparency; allocated for (width+2)*(height+3) bytes. */
+    unsigned char *data;
+};
 
-    spng_ctx *ctx = NULL;
-    ctx = spng_ctx_new(0);
+/**
+ * Reads file of the job from zip; stops on first error, like the installing will.
+ */
+static void png_job_read(unzFile zip, struct PngJob *job)
+{
+    unz_file_info64 zip_info = {0};
+    if ((job->name == NULL) || fastUnzLocateFile(zip, job->name, 0))
+    {
+        job->state = PJS_NotFound;
+        return;
+    }
+    if ((UNZ_OK != unzGetCurrentFileInfo64(zip, &zip_info, NULL, 0, NULL, 0, NULL, 0))
+        || (UNZ_OK != unzOpenCurrentFile(zip)))
+    {
+        job->state = PJS_OpenFail;
+        return;
+    }
+    job->png = malloc(zip_info.uncompressed_size + 1);
+    int len = 0;
+    if (job->png != NULL)
+        len = unzReadCurrentFile(zip, job->png, zip_info.uncompressed_size);
+    // Short file will make decoding fail
+    job->png_size = (len > 0) ? len : 0;
+    job->close_ok = (UNZ_OK == unzCloseCurrentFile(zip));
+    job->state = PJS_Read;
+}
+
+static void png_job_decode(struct PngJob *job)
+{
+    size_t out_size;
+    spng_ctx *ctx = spng_ctx_new(0);
     spng_set_crc_action(ctx, SPNG_CRC_USE, SPNG_CRC_USE);
 
     size_t limit = 1024 * 1024 * 2;
     spng_set_chunk_limits(ctx, limit, limit);
 
-    spng_set_png_stream(ctx, zip_read_fn, (void *) zip);
+    spng_set_png_buffer(ctx, job->png, job->png_size);
     struct spng_ihdr ihdr;
-    int r = spng_get_ihdr(ctx, &ihdr);
-
-    if (r)
+    job->spng_err = spng_get_ihdr(ctx, &ihdr);
+    if (job->spng_err)
     {
-        ERRORLOG("spng_get_ihdr() error: %s", spng_strerror(r));
+        job->error = PJE_Header;
         spng_ctx_free(ctx);
-        return 0;
+        return;
     }
-
     if (ihdr.bit_depth != 8)
     {
-        ERRORLOG("Wrong spec: %s/%s should be 8bit truecolor or indexed .png", path, subpath);
+        job->error = PJE_BitDepth;
         spng_ctx_free(ctx);
-        return 0;
+        return;
     }
     struct spng_plte plte = {0};
-    r = spng_get_plte(ctx, &plte);
+    job->spng_err = spng_get_plte(ctx, &plte);
 
-    sprite.SWidth = ihdr.width;
-    sprite.SHeight = ihdr.height;
+    job->width = ihdr.width;
+    job->height = ihdr.height;
 
     int fmt = SPNG_FMT_RGBA8; // for indexed should be SPNG_FMT_PNG
 
     spng_decoded_image_size(ctx, fmt, &out_size);
     if (limit < out_size) // Image is too big
     {
-        ERRORLOG("Unable to decode %s error: %s", path, spng_strerror(r));
+        job->error = PJE_TooBig;
+        spng_ctx_free(ctx);
+        return;
+    }
+    unsigned char *dst_buf = calloc(out_size, 1);
+    if (dst_buf == NULL)
+    {
         spng_ctx_free(ctx);
+        return;
+    }
+    job->decoded = (spng_decode_image(ctx, dst_buf, out_size, fmt, SPNG_DECODE_TRNS) == 0);
+    spng_ctx_free(ctx);
+    // Bigger sprites are refused when installing
+    if ((job->width < 255) && (job->height < 255))
+    {
+        struct TbHugeSprite sprite = {0};
+        sprite.SWidth = job->width;
+        sprite.SHeight = job->height;
+        sprite.Data = malloc((sprite.SWidth + 2) * (sprite.SHeight + 3));
+        if (sprite.Data != NULL)
+            compress_raw(&sprite, dst_buf, job->x, job->y, sprite.SWidth, sprite.SHeight);
+        job->data = sprite.Data;
+    }
+    free(dst_buf);
+}
+
+static void png_jobs_decode_job(void *data, long item_beg, long item_end)
+{
+    struct PngJob *jobs = data;
+    for (long i = item_beg; i < item_end; i++)
+    {
+        if (jobs[i].state == PJS_Read)
+        {
+            png_job_decode(&jobs[i]);
+            free(jobs[i].png);
+            jobs[i].png = NULL;
+        }
+    }
+}
+
+static void png_jobs_free(struct PngJob *jobs, long jobs_count)
+{
+    for (long i = 0; i < jobs_count; i++)
+    {
+        free(jobs[i].png);
+        free(jobs[i].data);
+    }
+    free(jobs);
+}
+
+/**
+ * Logs the decoding error, if the job has one.
+ * @return True if image header was decoded correctly.
+ */
+static TbBool png_job_check(const char *path, const struct PngJob *job)
+{
+    switch (job->error)
+    {
+    case PJE_Header:
+        ERRORLOG("spng_get_ihdr() error: %s", spng_strerror(job->spng_err));
+        return false;
+    case PJE_BitDepth:
+        ERRORLOG("Wrong spec: %s/%s should be 8bit truecolor or indexed .png", path, job->name);
+        return false;
+    case PJE_TooBig:
+        ERRORLOG("Unable to decode %s error: %s", path, spng_strerror(job->spng_err));
+        return false;
+    default:
+        break;
+    }
+    return true;
+}
+
+static int read_png_icon(const char *path, struct PngJob *job, int *icon_ptr)
+{
+    struct TbHugeSprite sprite = {0};
+
+    if (!png_job_check(path, job))
+    {
         return 0;
     }
 
-    unsigned char *dst_buf = big_scratch;
-    spng_decode_image(ctx, dst_buf, out_size, fmt, SPNG_DECODE_TRNS);
+    sprite.SWidth = job->width;
+    sprite.SHeight = job->height;
 
     if (sprite.SWidth >= 255 || sprite.SHeight >= 255)
     {
@@ -731,19 +1369,15 @@ static int read_png_icon(unzFile zip, const char *path, const char *subpath, int
         return 0;
     }
 
-    size_t sz = (sprite.SWidth + 2) * (sprite.SHeight + 3);
-    sprite.Data = malloc(sz);
-
-    compress_raw(&sprite, dst_buf, 0, 0, sprite.SWidth, sprite.SHeight);
-
-    spng_ctx_free(ctx);
-
     if (next_free_icon >= GUI_PANEL_SPRITES_NEW)
     {
         ERRORLOG("Too many custom icons allocated");
         return 0;
     }
 
+    sprite.Data = job->data;
+    job->data = NULL;
+
     gui_panel_sprites[next_free_icon + GUI_PANEL_SPRITES_COUNT].Data = sprite.Data;
     gui_panel_sprites[next_free_icon + GUI_PANEL_SPRITES_COUNT].SHeight = sprite.SHeight;
     gui_panel_sprites[next_free_icon + GUI_PANEL_SPRITES_COUNT].SWidth = sprite.SWidth;
@@ -755,60 +1389,24 @@ static int read_png_icon(unzFile zip, const char *path, const char *subpath, int
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "bugprone-branch-clone"
-static int read_png_data(unzFile zip, const char *path, struct SpriteContext *context, const char *subpath,
+static int read_png_data(const char *path, struct SpriteContext *context, struct PngJob *job,
                          int fp, VALUE *def, VALUE *itm)
 {
     struct TbHugeSprite *sprite = &context->sprite;
-    size_t out_size;
     sprite->SHeight = 0;
     sprite->SWidth = 0;
 
-    spng_ctx *ctx = NULL;
-    ctx = spng_ctx_new(0);
-    spng_set_crc_action(ctx, SPNG_CRC_USE, SPNG_CRC_USE);
-
-    size_t limit = 1024 * 1024 * 2;
-    spng_set_chunk_limits(ctx, limit, limit);
-
-    spng_set_png_stream(ctx, zip_read_fn, (void *) zip);
-    struct spng_ihdr ihdr;
-    int r = spng_get_ihdr(ctx, &ihdr);
-
-    if (r)
-    {
-        ERRORLOG("spng_get_ihdr() error: %s", spng_strerror(r));
-        spng_ctx_free(ctx);
-        return 0;
-    }
-
-    if (ihdr.bit_depth != 8)
+    if (!png_job_check(path, job))
     {
-        ERRORLOG("Wrong spec: %s/%s should be 8bit truecolor or indexed .png", path, subpath);
-        spng_ctx_free(ctx);
         return 0;
     }
-    struct spng_plte plte = {0};
-    r = spng_get_plte(ctx, &plte);
-    // TODO: should we check palette?
 
-    sprite->SWidth = ihdr.width;
-    sprite->SHeight = ihdr.height;
-
-    int fmt = SPNG_FMT_RGBA8; // for indexed should be SPNG_FMT_PNG
+    sprite->SWidth = job->width;
+    sprite->SHeight = job->height;
 
-    spng_decoded_image_size(ctx, fmt, &out_size);
-    if (limit < out_size) // Image is too big
-    {
-        ERRORLOG("Unable to decode %s error: %s", path, spng_strerror(r));
-        spng_ctx_free(ctx);
-        return 0;
-    }
-
-    unsigned char *dst_buf = big_scratch;
-    if (spng_decode_image(ctx, dst_buf, out_size, fmt, SPNG_DECODE_TRNS))
+    if (!job->decoded)
     {
-        ERRORLOG("Unable to decode %s/%s", path, subpath);
-        spng_ctx_free(ctx);
+        ERRORLOG("Unable to decode %s/%s", path, job->name);
         return 0;
     }
 
@@ -833,10 +1431,9 @@ static int read_png_data(unzFile zip, const char *path, struct SpriteContext *co
         *context->id_ptr = sprite_idx + KEEPERSPRITE_ADD_OFFSET;
     (*context->id_sz_ptr)++; // Add new sprite for current view (FP/TD)
 
-    size_t sz = (dst_w + 2) * (dst_h + 3);
-    keepersprite_add[sprite_idx] = malloc(sz);
+    keepersprite_add[sprite_idx] = job->data;
+    job->data = NULL;
     context->sprite.Data = keepersprite_add[sprite_idx];
-    compress_raw(&context->sprite, dst_buf, context->x, context->y, dst_w, dst_h);
     struct KeeperSprite *ksprite = &creature_table_add[sprite_idx];
 
     if (context->ksp_first == NULL)
@@ -883,38 +1480,45 @@ static int read_png_data(unzFile zip, const char *path, struct SpriteContext *co
 
 #undef READ_WITH_DEFAULT
 
-    spng_ctx_free(ctx);
     return 1;
 }
 #pragma clang diagnostic pop
 
-static void convert_row(unsigned char *dst_buf, uint32_t *src_buf, int len)
+/**
+ * Finds palette color nearest to given RGB color; only used to fill pal_lut.
+ */
+static unsigned char pal_nearest_color(uint32_t data)
 {
 #define SCALE 4
-    for (int i = 0; i < len; i++, src_buf++, dst_buf++)
-    {
-        uint32_t data = *src_buf;
-        int idx = ((data & 0x00FF00) >> 8) / SCALE;
-        const struct PaletteNode *node = &pal_tree[idx];
-        uint8_t max_val = 255;
-        uint32_t max_dst = 3 * 64 * 64;
+    int idx = ((data & 0x00FF00) >> 8) / SCALE;
+    const struct PaletteNode *node = &pal_tree[idx];
+    uint8_t max_val = 255;
+    uint32_t max_dst = 3 * 64 * 64;
 
-        for (struct PaletteRecord *rec = node->rec; rec != node->rec + node->size; rec++)
+    for (struct PaletteRecord *rec = node->rec; rec != node->rec + node->size; rec++)
+    {
+        int8_t dr = (rec->color & 0x00000FF) - (data & 0x0000FF) / SCALE;
+        int8_t dg = ((rec->color & 0xFF00) >> 8) - ((data & 0xFF00) >> 8) / SCALE;
+        int8_t db = ((rec->color & 0xFF0000) >> 16) - ((data & 0xFF0000) >> 16) / SCALE;
+        if (dr * dr + dg * dg + db * db < max_dst)
         {
-            int8_t dr = (rec->color & 0x00000FF) - (data & 0x0000FF) / SCALE;
-            int8_t dg = ((rec->color & 0xFF00) >> 8) - ((data & 0xFF00) >> 8) / SCALE;
-            int8_t db = ((rec->color & 0xFF0000) >> 16) - ((data & 0xFF0000) >> 16) / SCALE;
-            if (dr * dr + dg * dg + db * db < max_dst)
-            {
-                max_dst = dr * dr + dg * dg + db * db;
-                max_val = rec->color_idx;
-            }
+            max_dst = dr * dr + dg * dg + db * db;
+            max_val = rec->color_idx;
         }
-        *dst_buf = max_val;
     }
+    return max_val;
 #undef SCALE
 }
 
+static void convert_row(unsigned char *dst_buf, uint32_t *src_buf, int len)
+{
+    for (int i = 0; i < len; i++, src_buf++, dst_buf++)
+    {
+        uint32_t data = *src_buf;
+        *dst_buf = pal_lut[((data & 0xFC0000) >> 6) | ((data & 0x00FC00) >> 4) | ((data & 0x0000FC) >> 2)];
+    }
+}
+
 static void compress_raw(struct TbHugeSprite *sprite, unsigned char *inp_buf, int x, int y, int w, int h)
 {
 #define TEST_TRANSP(x) ((x & 0xFF000000u) < 0x40000000u)
@@ -1052,6 +1656,59 @@ collect_sprites(const char *path, unzFile zip, const char *blender_scene, struct
 #endif
     context->rotatable = (value_bool(value_dict_get(node, "rotatable")) > 0);
 
+    // Files are read in the same order they are installed, so reading can stop at the first failure
+    long jobs_count = 0;
+    for (int fp = 0; fp < 2; fp++)
+    {
+        VALUE *ud_lst = value_dict_get(node, fp ? "fp" : "td");
+        for (int lr = 0; lr < (context->rotatable ? 5 : 1); lr++)
+            jobs_count += value_array_size(value_array_get(ud_lst, lr));
+    }
+    struct PngJob *jobs = calloc(jobs_count + 1, sizeof(struct PngJob));
+    if (jobs == NULL)
+    {
+        ERRORLOG("Can't allocate memory for %ld sprites of '%s'", jobs_count, path);
+        return 1;
+    }
+    long job_idx = 0;
+    for (int fp = 0; fp < 2; fp++)
+    {
+        VALUE *ud_lst = value_dict_get(node, fp ? "fp" : "td");
+        for (int lr = 0; lr < (context->rotatable ? 5 : 1); lr++)
+        {
+            VALUE *lr_list = value_array_get(ud_lst, lr);
+            for (int frame = 0; frame < value_array_size(lr_list); frame++)
+            {
+                struct PngJob *job = &jobs[job_idx++];
+                job->itm = value_array_get(lr_list, frame);
+                job->name = value_string(value_dict_get(job->itm, "file"));
+                job->x = context->x;
+                job->y = context->y;
+                png_job_read(zip, job);
+                if ((job->state != PJS_Read) || !job->close_ok)
+                {
+                    if (job->name == NULL)
+                        job->state = PJS_NoName;
+                    fp = 2;
+                    lr = 5;
+                    break;
+                }
+            }
+        }
+    }
+    LbThreadPoolRun(png_jobs_decode_job, jobs, job_idx, 1);
+    int ret = install_sprites(path, context, node, jobs);
+    png_jobs_free(jobs, jobs_count);
+    return ret;
+}
+
+/**
+ * Installs decoded sprites in the order they are listed.
+ * Jobs are consumed in the same order they were created by collect_sprites().
+ */
+static int install_sprites(const char *path, struct SpriteContext *context, VALUE *node, struct PngJob *jobs)
+{
+    long job_idx = 0;
     int prev_sz;
     VALUE *ud_lst;
     for (int fp = 0; fp < 2; fp++)
@@ -1085,19 +1742,20 @@ collect_sprites(const char *path, unzFile zip, const char *blender_scene, struct
 
             for (int frame = 0; frame < value_array_size(lr_list); frame++)
             {
-                VALUE *itm = value_array_get(lr_list, frame);
-                const char *name = value_string(value_dict_get(itm, "file"));
-                if (name == NULL)
+                struct PngJob *job = &jobs[job_idx++];
+                VALUE *itm = job->itm;
+                const char *name = job->name;
+                if (job->state == PJS_NoName)
                 {
                     WARNLOG("Invalid sprite file record in '%s/sprites.json'", path);
                     return 1;
                 }
-                if (fastUnzLocateFile(zip, name, 0))
+                if (job->state == PJS_NotFound)
                 {
                     WARNLOG("Png '%s' not found in '%s'", name, path);
                     return 1;
                 }
-                if (UNZ_OK != unzOpenCurrentFile(zip))
+                if (job->state == PJS_OpenFail)
                 {
                     WARNLOG("Unable to open '%s/%s'", path, name);
                     return 1;
@@ -1112,7 +1770,7 @@ collect_sprites(const char *path, unzFile zip, const char *blender_scene, struct
                 fprintf(stderr, "F:%s/%s\n", path, name);
                 fprintf(stderr, "A:%d\n", SDL_GetTicks());
 #endif
-                if (!read_png_data(zip, path, context, name, fp, node, itm))
+                if (!read_png_data(path, context, job, fp, node, itm))
                 {
                     // Reverting possible changes
                     *context->id_ptr = store_p;
@@ -1121,14 +1779,13 @@ collect_sprites(const char *path, unzFile zip, const char *blender_scene, struct
                     if (store_ksp)
                         context->ksp_first->FramesCount = store_ksp_fc;
 
-                    unzCloseCurrentFile(zip);
                     WARNLOG("Unable to read '%s/%s'", path, name);
                     return 1;
                 }
 #ifdef INNER
                 fprintf(stderr, "B:%d\n", SDL_GetTicks());
 #endif
-                if (UNZ_OK != unzCloseCurrentFile(zip))
+                if (!job->close_ok)
                 {
                     return 1;
                 }
@@ -1193,13 +1850,19 @@ static int process_sprite_from_list(const char *path, unzFile zip, int idx, VALU
         return 0;
     }
 
+    return add_sprite_name(name, context.td_id);
+}
+
+static TbBool add_sprite_name(const char *name, short td_id)
+{
+    sprite_cache_record_name(SCNK_Sprite, name, td_id, 0);
     struct NamedCommand key = {name, 0};
     struct NamedCommand *spr = bsearch(&key, added_sprites, num_added_sprite, sizeof(added_sprites[0]),
                                        &cmp_named_command);
     if (spr)
     {
         // TODO: remove old spr->num (all of them are removed on each map load)
-        spr->num = context.td_id;
+        spr->num = td_id;
         JUSTLOG("Overriding sprite '%s'", name);
     }
     else
@@ -1211,16 +1874,38 @@ static int process_sprite_from_list(const char *path, unzFile zip, int idx, VALU
         }
         spr = &added_sprites[num_added_sprite++];
         spr->name = strdup(name);
-        spr->num = context.td_id;
+        spr->num = td_id;
     }
 
     return 1;
 }
 
+/**
+ * Processes given json file from a zip, or loads results of processing it from cache.
+ */
 static TbBool
 add_custom_json(const char *path, const char *name, TbBool (*process)(const char *path, unzFile zip, VALUE *root))
 {
     SYNCDBG(8, "Starting");
+    struct SpriteCacheKey key;
+    TbBool ret_ok;
+    if (!sprite_cache_make_key(path, name, &key))
+    {
+        return add_custom_json_uncached(path, name, process);
+    }
+    if (sprite_cache_load(&key, &ret_ok))
+    {
+        return ret_ok;
+    }
+    sprite_cache_record_start();
+    ret_ok = add_custom_json_uncached(path, name, process);
+    sprite_cache_record_finish(&key, ret_ok);
+    return ret_ok;
+}
+
+static TbBool
+add_custom_json_uncached(const char *path, const char *name, TbBool (*process)(const char *path, unzFile zip, VALUE *root))
+{
     unz_file_info64 zip_info = {0};
     VALUE root;
     JSON_INPUT_POS json_input_pos;
@@ -1336,36 +2021,61 @@ static int process_icon_from_list(const char *path, unzFile zip, int idx, VALUE
 
     int first_icon = 0;
     int icons_count = value_array_size(file_value);
-    for (int i = 0; i < icons_count; i++)
+    struct PngJob *jobs = calloc(icons_count + 1, sizeof(struct PngJob));
+    if (jobs == NULL)
     {
-        const char *file = value_string(value_array_get(file_value, i));
-
+        ERRORLOG("Can't allocate memory for %d icons of '%s'", icons_count, path);
+        return 0;
+    }
+    int jobs_count;
+    for (jobs_count = 0; jobs_count < icons_count; )
+    {
+        struct PngJob *job = &jobs[jobs_count++];
+        job->name = value_string(value_array_get(file_value, jobs_count - 1));
+        png_job_read(zip, job);
+        if ((job->state != PJS_Read) || !job->close_ok)
+            break;
+    }
+    LbThreadPoolRun(png_jobs_decode_job, jobs, jobs_count, 1);
 
-        if (fastUnzLocateFile(zip, file, 0))
+    for (int i = 0; i < icons_count; i++)
+    {
+        struct PngJob *job = &jobs[i];
+        if (job->state == PJS_NotFound)
         {
-            WARNLOG("Png '%s' not found in '%s'", file, path);
+            WARNLOG("Png '%s' not found in '%s'", job->name, path);
+            png_jobs_free(jobs, icons_count);
             return 0;
         }
-        if (UNZ_OK != unzOpenCurrentFile(zip))
+        if (job->state != PJS_Read)
         {
+            png_jobs_free(jobs, icons_count);
             return 0;
         }
 
         int icon;
-        if (!read_png_icon(zip, path, file, &icon))
+        if (!read_png_icon(path, job, &icon))
         {
-            unzCloseCurrentFile(zip);
+            png_jobs_free(jobs, icons_count);
             return 0;
         }
         if (first_icon == 0)
             first_icon = icon;
 
-        if (UNZ_OK != unzCloseCurrentFile(zip))
+        if (!job->close_ok)
         {
+            png_jobs_free(jobs, icons_count);
             return 0;
         }
     }
+    png_jobs_free(jobs, icons_count);
+
+    return add_icon_name(name, first_icon, icons_count);
+}
 
+static TbBool add_icon_name(const char *name, int first_icon, int icons_count)
+{
+    sprite_cache_record_name(SCNK_Icon, name, first_icon, icons_count);
     struct NamedCommand key = {name, 0};
     struct NamedCommand *spr = bsearch(&key, added_icons, num_added_icons, sizeof(added_icons[0]),
                                        &cmp_named_command);
@@ -1405,6 +2115,7 @@ static TbBool process_icon(const char *path, unzFile zip, VALUE *root)
     }
 
     qsort(added_icons, num_added_icons, sizeof(added_icons[0]), &cmp_named_command);
+    sprite_cache_rec.sorted_icons = true;
     return ret_ok;
 }
 
@@ -1422,6 +2133,7 @@ static TbBool process_sprite(const char *path, unzFile zip, VALUE *root)
     }
 
     qsort(added_sprites, num_added_sprite, sizeof(added_sprites[0]), &cmp_named_command);
+    sprite_cache_rec.sorted_sprites = true;
     return ret_ok;
 }
 
@@ -445,7 +445,7 @@ long map_fade_out(long a)
 
 void set_sprite_view_3d(void)
 {
-    for (long i = 1; i < THINGS_COUNT; i++)
+    for (long i = 1; i < game.thing_slots_count; i++)
     {
         struct Thing* thing = thing_get(i);
         if (thing_exists(thing))
@@ -476,7 +476,7 @@ void set_sprite_view_3d(void)
 
 void set_sprite_view_isometric(void)
 {
-    for (long i = 1; i < THINGS_COUNT; i++)
+    for (long i = 1; i < game.thing_slots_count; i++)
     {
         struct Thing* thing = thing_get(i);
         if (thing_exists(thing))
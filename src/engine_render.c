@@ -31,6 +31,7 @@
 #include "bflib_sprite.h"
 #include "bflib_vidraw.h"
 #include "bflib_render.h"
+#include "bflib_threadpool.h"
 
 #include "engine_lenses.h"
 #include "engine_camera.h"
@@ -418,6 +419,8 @@ static int water_wibble_angle = 0;
 static float render_water_wibble = 0; // Rendering float
 static unsigned long render_problems;
 static long render_prob_kind;
+/** Whether triangles drawn by trig() are queued and rasterized in bands by worker threads. */
+static TbBool render_trig_queue_enabled = false;
 static long sp_x, sp_y, sp_dx, sp_dy;
 
 Offset vert_offset[3];
@@ -473,6 +476,7 @@ TbSpriteData *keepsprite[KEEPSPRITE_LENGTH];
 TbSpriteData sprite_heap_handle[KEEPSPRITE_LENGTH];
 struct HeapMgrHeader *graphics_heap;
 TbFileHandle jty_file_handle;
+struct TbFileMapping jty_file_map;
 
 struct MapVolumeBox map_volume_box;
 long view_height_over_2;
@@ -5735,6 +5739,17 @@ static void draw_map_who(struct BucketKindRotableSprite *spr)
     // empty
 }
 
+/**
+ * Draws a triangle with trig(), or queues it for banded rendering if that mode is active.
+ */
+static void draw_trig(struct PolyPoint *point_a, struct PolyPoint *point_b, struct PolyPoint *point_c)
+{
+    if (render_trig_queue_enabled)
+        trig_queue_add(point_a, point_b, point_c);
+    else
+        trig(point_a, point_b, point_c);
+}
+
 static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
 {
     struct XYZ coord_a;
@@ -6147,7 +6162,7 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
     case 12:
         vec_mode = VM_Unknown7;
         vec_colour = (unk09->p3.S + unk09->p2.S + unk09->p1.S) / 3 >> 16;
-        trig(&unk09->p1, &unk09->p2, &unk09->p3);
+        draw_trig(&unk09->p1, &unk09->p2, &unk09->p3);
         break;
     case 13:
         vec_mode = VM_Unknown7;
@@ -6158,8 +6173,8 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_a.U = (unk09->p1.U + unk09->p2.U) >> 1;
         point_a.V = (unk09->p2.V + unk09->p1.V) >> 1;
         perspective(&coord_a, &point_a);
-        trig(&unk09->p1, &point_a, &unk09->p3);
-        trig(&point_a, &unk09->p2, &unk09->p3);
+        draw_trig(&unk09->p1, &point_a, &unk09->p3);
+        draw_trig(&point_a, &unk09->p2, &unk09->p3);
         break;
     case 14:
         vec_mode = VM_Unknown7;
@@ -6170,8 +6185,8 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_a.U = (unk09->p3.U + unk09->p2.U) >> 1;
         point_a.V = (unk09->p3.V + unk09->p2.V) >> 1;
         perspective(&coord_a, &point_a);
-        trig(&unk09->p1, &unk09->p2, &point_a);
-        trig(&unk09->p1, &point_a, &unk09->p3);
+        draw_trig(&unk09->p1, &unk09->p2, &point_a);
+        draw_trig(&unk09->p1, &point_a, &unk09->p3);
         break;
     case 15:
         vec_mode = VM_Unknown7;
@@ -6182,8 +6197,8 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_a.U = (unk09->p1.U + unk09->p3.U) >> 1;
         point_a.V = (unk09->p3.V + unk09->p1.V) >> 1;
         perspective(&coord_a, &point_a);
-        trig(&unk09->p1, &unk09->p2, &point_a);
-        trig(&point_a, &unk09->p2, &unk09->p3);
+        draw_trig(&unk09->p1, &unk09->p2, &point_a);
+        draw_trig(&point_a, &unk09->p2, &unk09->p3);
         break;
     case 16:
         vec_mode = VM_Unknown7;
@@ -6206,10 +6221,10 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_c.U = (unk09->p1.U + unk09->p3.U) >> 1;
         point_c.V = (unk09->p3.V + unk09->p1.V) >> 1;
         perspective(&coord_c, &point_c);
-        trig(&unk09->p1, &point_a, &point_c);
-        trig(&point_a, &unk09->p2, &point_b);
-        trig(&point_a, &point_b, &point_c);
-        trig(&point_c, &point_b, &unk09->p3);
+        draw_trig(&unk09->p1, &point_a, &point_c);
+        draw_trig(&point_a, &unk09->p2, &point_b);
+        draw_trig(&point_a, &point_b, &point_c);
+        draw_trig(&point_c, &point_b, &unk09->p3);
         break;
     case 17:
         vec_mode = VM_Unknown7;
@@ -6232,10 +6247,10 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_c.U = (point_a.U + unk09->p2.U) >> 1;
         point_c.V = (point_a.V + unk09->p2.V) >> 1;
         perspective(&coord_c, &point_c);
-        trig(&unk09->p1, &point_b, &unk09->p3);
-        trig(&point_b, &point_a, &unk09->p3);
-        trig(&point_a, &point_c, &unk09->p3);
-        trig(&point_c, &unk09->p2, &unk09->p3);
+        draw_trig(&unk09->p1, &point_b, &unk09->p3);
+        draw_trig(&point_b, &point_a, &unk09->p3);
+        draw_trig(&point_a, &point_c, &unk09->p3);
+        draw_trig(&point_c, &unk09->p2, &unk09->p3);
         break;
     case 18:
         vec_mode = VM_Unknown7;
@@ -6258,10 +6273,10 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_c.U = (point_a.U + unk09->p3.U) >> 1;
         point_c.V = (point_a.V + unk09->p3.V) >> 1;
         perspective(&coord_c, &point_c);
-        trig(&unk09->p1, &unk09->p2, &point_b);
-        trig(&unk09->p1, &point_b, &point_a);
-        trig(&unk09->p1, &point_a, &point_c);
-        trig(&unk09->p1, &point_c, &unk09->p3);
+        draw_trig(&unk09->p1, &unk09->p2, &point_b);
+        draw_trig(&unk09->p1, &point_b, &point_a);
+        draw_trig(&unk09->p1, &point_a, &point_c);
+        draw_trig(&unk09->p1, &point_c, &unk09->p3);
         break;
     case 19:
         vec_mode = VM_Unknown7;
@@ -6284,10 +6299,10 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_c.U = (point_a.U + unk09->p1.U) >> 1;
         point_c.V = (point_a.V + unk09->p1.V) >> 1;
         perspective(&coord_c, &point_c);
-        trig(&unk09->p2, &unk09->p3, &point_b);
-        trig(&unk09->p2, &point_b, &point_a);
-        trig(&unk09->p2, &point_a, &point_c);
-        trig(&unk09->p2, &point_c, &unk09->p1);
+        draw_trig(&unk09->p2, &unk09->p3, &point_b);
+        draw_trig(&unk09->p2, &point_b, &point_a);
+        draw_trig(&unk09->p2, &point_a, &point_c);
+        draw_trig(&unk09->p2, &point_c, &unk09->p1);
         break;
     case 20:
         vec_mode = VM_Unknown7;
@@ -6322,12 +6337,12 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_e.U = (point_a.U + unk09->p2.U) >> 1;
         point_e.V = (point_a.V + unk09->p2.V) >> 1;
         perspective(&coord_e, &point_e);
-        trig(&unk09->p1, &point_d, &point_c);
-        trig(&point_d, &point_a, &point_c);
-        trig(&point_a, &point_e, &point_b);
-        trig(&point_e, &unk09->p2, &point_b);
-        trig(&point_a, &point_b, &point_c);
-        trig(&point_c, &point_b, &unk09->p3);
+        draw_trig(&unk09->p1, &point_d, &point_c);
+        draw_trig(&point_d, &point_a, &point_c);
+        draw_trig(&point_a, &point_e, &point_b);
+        draw_trig(&point_e, &unk09->p2, &point_b);
+        draw_trig(&point_a, &point_b, &point_c);
+        draw_trig(&point_c, &point_b, &unk09->p3);
         break;
     case 21:
         vec_mode = VM_Unknown7;
@@ -6362,12 +6377,12 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_e.U = (point_b.U + unk09->p3.U) >> 1;
         point_e.V = (point_b.V + unk09->p3.V) >> 1;
         perspective(&coord_e, &point_e);
-        trig(&unk09->p1, &point_a, &point_c);
-        trig(&point_a, &point_b, &point_c);
-        trig(&point_a, &unk09->p2, &point_d);
-        trig(&point_a, &point_d, &point_b);
-        trig(&point_c, &point_b, &point_e);
-        trig(&point_c, &point_e, &unk09->p3);
+        draw_trig(&unk09->p1, &point_a, &point_c);
+        draw_trig(&point_a, &point_b, &point_c);
+        draw_trig(&point_a, &unk09->p2, &point_d);
+        draw_trig(&point_a, &point_d, &point_b);
+        draw_trig(&point_c, &point_b, &point_e);
+        draw_trig(&point_c, &point_e, &unk09->p3);
         break;
     case 22:
         vec_mode = VM_Unknown7;
@@ -6402,12 +6417,12 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_e.U = (point_c.U + unk09->p1.U) >> 1;
         point_e.V = (point_c.V + unk09->p1.V) >> 1;
         perspective(&coord_e, &point_e);
-        trig(&point_a, &unk09->p2, &point_b);
-        trig(&point_a, &point_b, &point_c);
-        trig(&unk09->p1, &point_a, &point_e);
-        trig(&point_e, &point_a, &point_c);
-        trig(&point_c, &point_b, &point_d);
-        trig(&point_d, &point_b, &unk09->p3);
+        draw_trig(&point_a, &unk09->p2, &point_b);
+        draw_trig(&point_a, &point_b, &point_c);
+        draw_trig(&unk09->p1, &point_a, &point_e);
+        draw_trig(&point_e, &point_a, &point_c);
+        draw_trig(&point_c, &point_b, &point_d);
+        draw_trig(&point_d, &point_b, &unk09->p3);
         break;
     case 23:
         vec_mode = VM_Unknown7;
@@ -6484,22 +6499,22 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
         point_l.U = (point_b.U + point_c.U) >> 1;
         point_l.V = (point_b.V + point_c.V) >> 1;
         perspective(&coord_d, &point_l);
-        trig(&unk09->p1, &point_d, &point_i);
-        trig(&point_d, &point_a, &point_j);
-        trig(&point_a, &point_e, &point_k);
-        trig(&point_e, &unk09->p2, &point_f);
-        trig(&point_d, &point_j, &point_i);
-        trig(&point_a, &point_k, &point_j);
-        trig(&point_e, &point_f, &point_k);
-        trig(&point_i, &point_j, &point_c);
-        trig(&point_j, &point_k, &point_l);
-        trig(&point_k, &point_f, &point_b);
-        trig(&point_j, &point_l, &point_c);
-        trig(&point_k, &point_b, &point_l);
-        trig(&point_c, &point_l, &point_h);
-        trig(&point_l, &point_b, &point_g);
-        trig(&point_l, &point_g, &point_h);
-        trig(&point_h, &point_g, &unk09->p3);
+        draw_trig(&unk09->p1, &point_d, &point_i);
+        draw_trig(&point_d, &point_a, &point_j);
+        draw_trig(&point_a, &point_e, &point_k);
+        draw_trig(&point_e, &unk09->p2, &point_f);
+        draw_trig(&point_d, &point_j, &point_i);
+        draw_trig(&point_a, &point_k, &point_j);
+        draw_trig(&point_e, &point_f, &point_k);
+        draw_trig(&point_i, &point_j, &point_c);
+        draw_trig(&point_j, &point_k, &point_l);
+        draw_trig(&point_k, &point_f, &point_b);
+        draw_trig(&point_j, &point_l, &point_c);
+        draw_trig(&point_k, &point_b, &point_l);
+        draw_trig(&point_c, &point_l, &point_h);
+        draw_trig(&point_l, &point_b, &point_g);
+        draw_trig(&point_l, &point_g, &point_h);
+        draw_trig(&point_h, &point_g, &unk09->p3);
         break;
     default:
         render_problems++;
@@ -6508,6 +6523,27 @@ static void draw_unkn09(struct BucketKindPolygonNearFP *unk09)
     }
 
 }
+/**
+ * Checks whether drawing given bucket item only uses trig(). Such items may be queued
+ * for banded rendering together, without changing the order of drawing anything else.
+ */
+static TbBool bucket_item_draws_only_trigs(const struct BasicQ *bq)
+{
+    switch (bq->kind)
+    {
+    case QK_PolygonSimple:
+    case QK_TrigMode2:
+    case QK_TrigMode3:
+    case QK_TrigMode6:
+        return true;
+    case QK_PolygonNearFP:
+        // Subtypes below 12 are drawn with draw_gpoly()
+        return (((const struct BucketKindPolygonNearFP *)bq)->subtype >= 12);
+    default:
+        return false;
+    }
+}
+
 static void display_drawlist(void) // Draws isometric and 1st person view. Not frontview.
 {
     struct PlayerInfo *player;
@@ -6544,12 +6580,16 @@ static void display_drawlist(void) // Draws isometric and 1st person view. Not f
     render_alpha = (unsigned char *)&alpha_sprite_table;
     render_problems = 0;
     thing_pointed_at = 0;
+    render_trig_queue_enabled = is_feature_on(Ft_MultithreadedRender) && (LbThreadPoolThreadsCount() > 1);
 
     // The bucket list is the final step in drawing something to the screen. Visuals are added to the bucket list in previous functions.
     for (bucket_num = BUCKETS_COUNT-1; bucket_num > 0; bucket_num--)
     {
         for (item.b = buckets[bucket_num]; item.b != NULL; item.b = item.b->next)
         {
+            // Anything not drawn by trig() must be drawn after the triangles queued before it
+            if (render_trig_queue_enabled && !bucket_item_draws_only_trigs(item.b))
+                trig_queue_flush();
             //JUSTLOG("%d",(int)item.b->kind);
             switch ( item.b->kind )
             {
@@ -6562,7 +6602,7 @@ static void display_drawlist(void) // Draws isometric and 1st person view. Not f
                 vec_mode = VM_Unknown7;
                 vec_colour = ((item.polygonSimple->p3.S + item.polygonSimple->p2.S + item.polygonSimple->p1.S)/3) >> 16;
                 vec_map = block_ptrs[item.polygonSimple->block];
-                trig(&item.polygonSimple->p1, &item.polygonSimple->p2, &item.polygonSimple->p3);
+                draw_trig(&item.polygonSimple->p1, &item.polygonSimple->p2, &item.polygonSimple->p3);
                 break;
             case QK_PolyMode0: // Possibly unused
                 vec_mode = VM_Unknown0;
@@ -6603,7 +6643,7 @@ static void display_drawlist(void) // Draws isometric and 1st person view. Not f
                 point_b.V = item.trigMode2->vf2 << 16;
                 point_c.U = item.trigMode2->uf3 << 16;
                 point_c.V = item.trigMode2->vf3 << 16;
-                trig(&point_a, &point_b, &point_c);
+                draw_trig(&point_a, &point_b, &point_c);
                 break;
             case QK_PolyMode5: // Possibly unused
                 vec_mode = VM_Unknown5;
@@ -6638,7 +6678,7 @@ static void display_drawlist(void) // Draws isometric and 1st person view. Not f
                 point_b.V = item.trigMode3->vf2 << 16;
                 point_c.U = item.trigMode3->uf3 << 16;
                 point_c.V = item.trigMode3->vf3 << 16;
-                trig(&point_a, &point_b, &point_c);
+                draw_trig(&point_a, &point_b, &point_c);
                 break;
             case QK_TrigMode6: // Possibly unused
                 vec_mode = VM_Unknown6;
@@ -6657,7 +6697,7 @@ static void display_drawlist(void) // Draws isometric and 1st person view. Not f
                 point_a.S = item.trigMode6->wf1 << 16;
                 point_b.S = item.trigMode6->wf2 << 16;
                 point_c.S = item.trigMode6->wf3 << 16;
-                trig(&point_a, &point_b, &point_c);
+                draw_trig(&point_a, &point_b, &point_c);
                 break;
             case QK_RotableSprite: // Possibly unused
                 draw_map_who(item.rotableSprite);
@@ -6678,8 +6718,8 @@ static void display_drawlist(void) // Draws isometric and 1st person view. Not f
                 vec_map = big_scratch;
                 vec_mode = VM_Unknown10;
                 vec_colour = item.creatureShadow->p1.S;
-                trig(&item.creatureShadow->p1, &item.creatureShadow->p2, &item.creatureShadow->p3);
-                trig(&item.creatureShadow->p1, &item.creatureShadow->p3, &item.creatureShadow->p4);
+                draw_trig(&item.creatureShadow->p1, &item.creatureShadow->p2, &item.creatureShadow->p3);
+                draw_trig(&item.creatureShadow->p1, &item.creatureShadow->p3, &item.creatureShadow->p4);
                 break;
             case QK_SlabSelector: // Selection outline box for placing/digging slabs
                 draw_clipped_line(
@@ -6718,6 +6758,11 @@ static void display_drawlist(void) // Draws isometric and 1st person view. Not f
             }
         }
     }
+    if (render_trig_queue_enabled)
+    {
+        trig_queue_flush();
+        render_trig_queue_enabled = false;
+    }
     if (render_problems > 0)
       WARNLOG("Incurred %lu rendering problems; last was with poly kind %ld",render_problems,render_prob_kind);
 }
@@ -7560,6 +7605,18 @@ static long load_single_frame(TbSpriteData *data_ptr, unsigned short kspr_idx)
 {
     long nlength;
     nlength = creature_table[kspr_idx+1].DataOffset - creature_table[kspr_idx].DataOffset;
+    if (jty_file_map.data != NULL)
+    {
+        // Frames are used directly from the mapped file
+        if (creature_table[kspr_idx+1].DataOffset > (unsigned long)jty_file_map.length)
+        {
+            ERRORLOG("KeeperSprite %d data is beyond end of JTY file",(int)kspr_idx);
+            return 0;
+        }
+        *data_ptr = jty_file_map.data + creature_table[kspr_idx].DataOffset;
+        keepsprite[kspr_idx] = data_ptr;
+        return 1;
+    }
     *data_ptr = he_alloc(nlength);
 
     LbFileSeek(jty_file_handle, creature_table[kspr_idx].DataOffset, 0);
@@ -24,6 +24,7 @@
 #include "game_legacy.h"
 #include "bflib_render.h"
 #include "bflib_sprite.h"
+#include "bflib_fileio.h"
 #include "engine_lenses.h"
 
 #ifdef __cplusplus
@@ -120,6 +121,7 @@ extern TbSpriteData *keepsprite[KEEPSPRITE_LENGTH];
 extern TbSpriteData sprite_heap_handle[KEEPSPRITE_LENGTH];
 extern struct HeapMgrHeader *graphics_heap;
 extern TbFileHandle jty_file_handle;
+extern struct TbFileMapping jty_file_map;
 
 extern long x_init_off;
 extern long y_init_off;
@@ -24,10 +24,14 @@
 #include "bflib_memory.h"
 #include "bflib_fileio.h"
 #include "bflib_dernc.h"
+#include "bflib_threadpool.h"
 #include "engine_lenses.h"
 #include "front_simple.h"
 #include "config.h"
+#include "config_campaigns.h"
 #include "game_legacy.h"
+
+#include <errno.h>
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -41,6 +45,44 @@ long block_dimension = 32;
 long block_count_per_row = 8;
 
 static long anim_counter;
+
+// Size of decompressed tmapa and tmapb files of one variation
+#define TEXTURE_VARIATION_SIZE_A (TEXTURE_BLOCKS_STAT_COUNT_A * 32 * 32)
+#define TEXTURE_VARIATION_SIZE (TEXTURE_BLOCKS_STAT_COUNT * 32 * 32)
+// One entry more than variations, so that the level one can change without dropping the others
+#define TEXTURE_CACHE_ENTRIES (TEXTURE_VARIATIONS_COUNT + 1)
+
+/** Decompressed texture files of one variation, kept between level loads. */
+struct TextureCacheEntry {
+    char campaign_fname[DISKPATH_SIZE];
+    unsigned long tmapidx;
+    /** Both files were loaded correctly, so data can be reused. */
+    TbBool complete;
+    /** Number of the texture map load which used this entry last. */
+    unsigned long last_use;
+    unsigned char *data;
+};
+
+enum TextureLoadFailure {
+    TxLd_Ok = 0,
+    TxLd_ReadFailed,
+    TxLd_UnpackFailed,
+    TxLd_TooSmall,
+};
+
+struct TextureLoadJob {
+    struct TextureCacheEntry *entry;
+    unsigned char *dst;
+    char fname[2][DISKPATH_SIZE];
+    TbBool loaded[2];
+    /** Reason of failure, to be logged after the job; logging from pool threads is not safe. */
+    unsigned char failure[2];
+    int failure_errno[2];
+};
+
+static struct TextureCacheEntry texture_cache[TEXTURE_CACHE_ENTRIES];
+static unsigned long texture_cache_loads_count;
+static struct TextureLoadJob texture_load_jobs[TEXTURE_VARIATIONS_COUNT];
 /******************************************************************************/
 #ifdef __cplusplus
 }
@@ -116,54 +158,194 @@ short update_animating_texture_maps(void)
   return result;
 }
 
-static TbBool load_one_file(unsigned long tmapidx,char letter, void *dst)
+/**
+ * Finds file name of given texture file, and checks if it can be loaded.
+ */
+static TbBool prepare_texture_file_name(unsigned long tmapidx, char letter, char *fname, size_t max_fname_len, long max_size)
 {
     SYNCDBG(9,"Starting");
-
-    char* fname = prepare_file_fmtpath(FGrp_CmpgConfig, "tmap%c%03d.dat",letter, tmapidx);
-    if (!LbFileExists(fname))
+    char* tmp_fname = prepare_file_fmtpath(FGrp_CmpgConfig, "tmap%c%03d.dat",letter, tmapidx);
+    if (!LbFileExists(tmp_fname))
     {
-        fname = prepare_file_fmtpath(FGrp_StdData, "tmap%c%03d.dat",letter, tmapidx);
+        tmp_fname = prepare_file_fmtpath(FGrp_StdData, "tmap%c%03d.dat",letter, tmapidx);
     }
-
-    if (!wait_for_cd_to_be_available())
-        return false;
-    if (!LbFileExists(fname))
+    if (!LbFileExists(tmp_fname))
     {
-        WARNMSG("Texture file \"%s\" doesn't exist.",fname);
+        WARNMSG("Texture file \"%s\" doesn't exist.",tmp_fname);
         return false;
     }
-    
-    if (LbFileLoadAt(fname, dst) < 1024)
+    if (LbFileLengthRnc(tmp_fname) > max_size)
     {
-        WARNMSG("Texture file \"%s\" can't be loaded or is too small.",fname);
+        WARNMSG("Texture file \"%s\" is too large.",tmp_fname);
         return false;
     }
+    snprintf(fname, max_fname_len, "%s", tmp_fname);
     return true;
 }
 
+/**
+ * Loads and unpacks one texture file, like LbFileLoadAt() does, but without logging.
+ */
+static enum TextureLoadFailure load_one_file(struct TextureLoadJob *job, int n, void *dst)
+{
+    const char *fname = job->fname[n];
+    long filelength = LbFileLengthRnc(fname);
+    TbFileHandle handle = -1;
+    if (filelength != -1)
+    {
+        handle = LbFileOpen(fname,Lb_FILE_MODE_READ_ONLY);
+    }
+    int read_status = -1;
+    if (handle != -1)
+    {
+        read_status = LbFileRead(handle, dst, filelength);
+        LbFileClose(handle);
+    }
+    if (read_status == -1)
+    {
+        job->failure_errno[n] = errno;
+        return TxLd_ReadFailed;
+    }
+    long unp_length = UnpackM1(dst, filelength);
+    if (unp_length < 0)
+        return TxLd_UnpackFailed;
+    if (unp_length == 0)
+        unp_length = filelength;
+    if (unp_length < 1024)
+        return TxLd_TooSmall;
+    return TxLd_Ok;
+}
+
+static void load_texture_files_job(void *data, long item_beg, long item_end)
+{
+    struct TextureLoadJob *jobs = (struct TextureLoadJob *)data;
+    for (long i = item_beg; i < item_end; i++)
+    {
+        struct TextureLoadJob *job = &jobs[i];
+        memset(job->dst, 130, TEXTURE_VARIATION_SIZE);
+        for (int n = 0; n < 2; n++)
+        {
+            if (job->fname[n][0] == '\0')
+                continue;
+            job->failure[n] = load_one_file(job, n, job->dst + n * TEXTURE_VARIATION_SIZE_A);
+            job->loaded[n] = (job->failure[n] == TxLd_Ok);
+        }
+    }
+}
+
+static void log_texture_load_failures(const struct TextureLoadJob *job)
+{
+    for (int n = 0; n < 2; n++)
+    {
+        switch (job->failure[n])
+        {
+        case TxLd_ReadFailed:
+            ERRORLOG("Couldn't read \"%s\", errno %d",job->fname[n],job->failure_errno[n]);
+            break;
+        case TxLd_UnpackFailed:
+            ERRORLOG("ERROR decompressing \"%s\"",job->fname[n]);
+            break;
+        case TxLd_TooSmall:
+            WARNMSG("Texture file \"%s\" can't be loaded or is too small.",job->fname[n]);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * Gives cache entry for given texture variation; if it isn't cached, gives
+ * the entry which wasn't used for longest time, to be filled again.
+ */
+static struct TextureCacheEntry *get_texture_cache_entry(unsigned long tmapidx)
+{
+    for (int i = 0; i < TEXTURE_CACHE_ENTRIES; i++)
+    {
+        struct TextureCacheEntry *entry = &texture_cache[i];
+        if ((entry->last_use > 0) && (entry->tmapidx == tmapidx) && (strcmp(entry->campaign_fname, campaign.fname) == 0))
+            return entry;
+    }
+    // There are more entries than slots, so one not used by current load is always there
+    struct TextureCacheEntry *found = NULL;
+    for (int i = 0; i < TEXTURE_CACHE_ENTRIES; i++)
+    {
+        struct TextureCacheEntry *entry = &texture_cache[i];
+        if (entry->last_use == texture_cache_loads_count)
+            continue;
+        if ((found == NULL) || (entry->last_use < found->last_use))
+            found = entry;
+    }
+    found->complete = false;
+    found->tmapidx = tmapidx;
+    snprintf(found->campaign_fname, sizeof(found->campaign_fname), "%s", campaign.fname);
+    if (found->data == NULL)
+        found->data = (unsigned char *)malloc(TEXTURE_VARIATION_SIZE);
+    return found;
+}
+
+/**
+ * Loads texture of the level and all texture variations into block_mem.
+ * Decompressed files are cached, so only the ones which weren't loaded
+ * before are read; these are read in parallel.
+ */
 TbBool load_texture_map_file(unsigned long tmapidx)
 {
     SYNCDBG(7,"Starting");
-    memset(block_mem, 130, sizeof(block_mem));
-    if (!load_one_file(tmapidx,'a', block_mem))
+    if (!wait_for_cd_to_be_available())
     {
+        memset(block_mem, 130, sizeof(block_mem));
         return false;
     }
-    unsigned char *dst = block_mem + (TEXTURE_BLOCKS_STAT_COUNT_A * 32 * 32);    
-    load_one_file(tmapidx,'b', dst);
-    dst += (TEXTURE_BLOCKS_STAT_COUNT_B * 32 * 32);
-
-    for (int i = 0; i < TEXTURE_VARIATIONS_COUNT-1; i++)
-    
+    texture_cache_loads_count++;
+    struct TextureCacheEntry *entries[TEXTURE_VARIATIONS_COUNT];
+    long jobs_count = 0;
+    for (int slot = 0; slot < TEXTURE_VARIATIONS_COUNT; slot++)
     {
-        load_one_file(i,'a', dst);
-        
-        dst += (TEXTURE_BLOCKS_STAT_COUNT_A * 32 * 32);
-        load_one_file(i,'b', dst);
-        dst += (TEXTURE_BLOCKS_STAT_COUNT_B * 32 * 32);
-        
+        // First slot is for the level texture, then there are all variations
+        unsigned long idx = (slot == 0) ? tmapidx : (unsigned long)(slot - 1);
+        struct TextureCacheEntry *entry = get_texture_cache_entry(idx);
+        TbBool first_use = (entry->last_use != texture_cache_loads_count);
+        entry->last_use = texture_cache_loads_count;
+        entries[slot] = entry;
+        if (entry->complete || !first_use)
+            continue;
+        struct TextureLoadJob *job = &texture_load_jobs[jobs_count];
+        memset(job, 0, sizeof(struct TextureLoadJob));
+        job->entry = entry;
+        // Without memory for caching, load straight into the slot
+        if (entry->data != NULL)
+            job->dst = entry->data;
+        else
+            job->dst = block_mem + slot * TEXTURE_VARIATION_SIZE;
+        if (!prepare_texture_file_name(idx, 'a', job->fname[0], sizeof(job->fname[0]), TEXTURE_VARIATION_SIZE_A))
+            job->fname[0][0] = '\0';
+        if (!prepare_texture_file_name(idx, 'b', job->fname[1], sizeof(job->fname[1]), TEXTURE_VARIATION_SIZE - TEXTURE_VARIATION_SIZE_A))
+            job->fname[1][0] = '\0';
+        jobs_count++;
+    }
+    // CRC table is filled on first use; make sure it's not done by many threads at once
+    rnc_crc(block_mem, 0);
+    LbThreadPoolRun(load_texture_files_job, texture_load_jobs, jobs_count, 1);
+    for (long i = 0; i < jobs_count; i++)
+    {
+        struct TextureLoadJob *job = &texture_load_jobs[i];
+        log_texture_load_failures(job);
+        job->entry->complete = (job->entry->data != NULL) && job->loaded[0] && job->loaded[1];
+    }
+    SYNCDBG(8,"Loaded %ld texture variations, %ld were cached",jobs_count,(long)TEXTURE_VARIATIONS_COUNT-jobs_count);
+    // Level texture is required; if it's not cached, it's the first job
+    if (!entries[0]->complete && !texture_load_jobs[0].loaded[0])
+    {
+        memset(block_mem, 130, sizeof(block_mem));
+        return false;
+    }
+    for (int slot = 0; slot < TEXTURE_VARIATIONS_COUNT; slot++)
+    {
+        if (entries[slot]->data != NULL)
+            memcpy(block_mem + slot * TEXTURE_VARIATION_SIZE, entries[slot]->data, TEXTURE_VARIATION_SIZE);
     }
     return true;
 }
+
 /******************************************************************************/
@@ -42,6 +42,7 @@
 #include "vidfade.h"
 #include "game_legacy.h"
 #include "sprites.h"
+#include "light_data.h"
 
 #include "keeperfx.hpp"
 #include "post_inc.h"
@@ -807,6 +808,14 @@ void draw_frametime()
         }
         LbTextDrawResized(0, (28+i)*tx_units_per_px, tx_units_per_px, text);
     }
+
+    // Light rendering
+    struct LightRenderStats lrstats;
+    light_get_render_stats(&lrstats);
+    text = buf_sprintf("Dyn lights: %ld, skipped %ld", lrstats.rendered_dynamic_lights, lrstats.skipped_dynamic_lights);
+    LbTextDrawResized(0, (28+TOTAL_FRAMETIME_KINDS)*tx_units_per_px, tx_units_per_px, text);
+    text = buf_sprintf("Stat lights: %ld/%ld, rows %ld", lrstats.updated_stat_lights, lrstats.out_of_date_stat_lights, lrstats.recomposited_rows);
+    LbTextDrawResized(0, (29+TOTAL_FRAMETIME_KINDS)*tx_units_per_px, tx_units_per_px, text);
     lbDisplay.DrawFlags = Lb_TEXT_HALIGN_LEFT;
 }
 /******************************************************************************/
@@ -28,7 +28,14 @@
 #include "config.h"
 #include "front_simple.h"
 #include "engine_render.h"
+#include "engine_arrays.h"
+#include "creature_control.h"
+#include "creature_graphics.h"
+#include "config_creature.h"
+#include "game_legacy.h"
 #include "sounds.h"
+
+#include <SDL2/SDL.h>
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -45,6 +52,17 @@ static unsigned char *sound_heap_memory;
 static unsigned char *heap;
 static long heap_size;
 static long sound_heap_size;
+
+/** Part of JTY file to be read into memory in background. */
+struct JtyPrefetchRange {
+    unsigned long beg;
+    unsigned long end;
+};
+// Every animation is prefetched along with its variants for top-down and isometric view
+static struct JtyPrefetchRange jty_prefetch_ranges[CREATURE_TYPES_MAX*CREATURE_GRAPHICS_INSTANCES*3];
+static long jty_prefetch_count;
+static SDL_Thread *jty_prefetch_thread;
+static SDL_atomic_t jty_prefetch_stop;
 /******************************************************************************/
 long get_smaller_memory_amount(long amount)
 {
@@ -83,6 +101,10 @@ TbBool setup_heap_manager(void)
         ERRORLOG("Can not open JTY file, \"%s\"",fname);
         return false;
     }
+    // With the file mapped, sprites are used from it directly; otherwise they're read on first use
+    if (!LbFileMapOpen(&jty_file_map, jty_file_handle)) {
+        WARNLOG("Can not map JTY file, \"%s\"; sprites will be read when needed",fname);
+    }
     for (i=0; i < KEEPSPRITE_LENGTH; i++)
         keepsprite[i] = NULL;
     for (i=0; i < KEEPSPRITE_LENGTH; i++)
@@ -132,6 +154,8 @@ void reset_heap_manager(void)
 {
     long i;
     SYNCDBG(8,"Starting");
+    stop_creature_sprites_prefetch();
+    LbFileMapClose(&jty_file_map);
     if (jty_file_handle != -1)
     {
         LbFileClose(jty_file_handle);
@@ -287,6 +311,81 @@ TbBool setup_heaps(void)
     return true;
 }
 
+static void add_creature_sprites_prefetch_range(short n)
+{
+    if ((n <= 0) || (n >= CREATURE_FRAMELIST_LENGTH))
+        return;
+    unsigned long kspr_idx = keepersprite_index(n);
+    struct KeeperSprite *kspr = &creature_table[kspr_idx];
+    long frame_count = kspr->Rotable ? 5 * kspr->FramesCount : kspr->FramesCount;
+    if (kspr_idx + frame_count >= KEEPSPRITE_LENGTH)
+        return;
+    struct JtyPrefetchRange *range = &jty_prefetch_ranges[jty_prefetch_count];
+    range->beg = kspr->DataOffset;
+    range->end = creature_table[kspr_idx + frame_count].DataOffset;
+    if ((range->end <= range->beg) || (range->end > (unsigned long)jty_file_map.length))
+        return;
+    jty_prefetch_count++;
+}
+
+/**
+ * Touches every memory page of the listed ranges, so that the system reads them from disk.
+ */
+static int creature_sprites_prefetch_worker(void *data)
+{
+    volatile unsigned char sum = 0;
+    for (long i = 0; i < jty_prefetch_count; i++)
+    {
+        const struct JtyPrefetchRange *range = &jty_prefetch_ranges[i];
+        for (unsigned long pos = range->beg; pos < range->end; pos += 4096)
+        {
+            sum += jty_file_map.data[pos];
+        }
+        sum += jty_file_map.data[range->end - 1];
+        if (SDL_AtomicGet(&jty_prefetch_stop))
+            break;
+    }
+    return sum;
+}
+
+void stop_creature_sprites_prefetch(void)
+{
+    if (jty_prefetch_thread == NULL)
+        return;
+    SDL_AtomicSet(&jty_prefetch_stop, 1);
+    SDL_WaitThread(jty_prefetch_thread, NULL);
+    jty_prefetch_thread = NULL;
+}
+
+/**
+ * Starts reading sprites of all creatures in the creature pool in background,
+ * so that they don't have to be read from disk when the creature is first drawn.
+ */
+void prefetch_creature_pool_sprites(void)
+{
+    stop_creature_sprites_prefetch();
+    if (jty_file_map.data == NULL)
+        return;
+    jty_prefetch_count = 0;
+    for (long crmodel = 1; crmodel < game.conf.crtr_conf.model_count; crmodel++)
+    {
+        if (game.pool.crtr_kind[crmodel] <= 0)
+            continue;
+        for (int seq_idx = 0; seq_idx < CREATURE_GRAPHICS_INSTANCES; seq_idx++)
+        {
+            short n = get_creature_model_graphics(crmodel, seq_idx);
+            add_creature_sprites_prefetch_range(n);
+            add_creature_sprites_prefetch_range(straight_td_iso(n));
+            add_creature_sprites_prefetch_range(straight_iso_td(n));
+        }
+    }
+    if (jty_prefetch_count <= 0)
+        return;
+    SYNCDBG(8,"Prefetching %ld creature animations",jty_prefetch_count);
+    SDL_AtomicSet(&jty_prefetch_stop, 0);
+    jty_prefetch_thread = SDL_CreateThread(creature_sprites_prefetch_worker, "SpritePrefetch", NULL);
+}
+
 void *he_alloc(size_t size)
 {
     // We could need some wrapper
@@ -32,6 +32,8 @@ TbBool setup_heap_memory(void);
 void reset_heap_manager(void);
 void reset_heap_memory(void);
 TbBool setup_heaps(void);
+void prefetch_creature_pool_sprites(void);
+void stop_creature_sprites_prefetch(void);
 
 /******************************************************************************/
 void *he_alloc(size_t size);
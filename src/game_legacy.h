@@ -157,8 +157,6 @@ char numfield_1A;
     struct SlabObj slabobjs[SLABOBJS_COUNT];
     unsigned char land_map_start;
     struct LightsShadows lish;
-    struct CreatureControl cctrl_data[CREATURES_COUNT];
-    struct Thing things_data[THINGS_COUNT];
     NavColour navigation_map[MAX_SUBTILES_X*MAX_SUBTILES_Y];
     struct Map map[MAX_SUBTILES_X*MAX_SUBTILES_Y];
     struct ComputerTask computer_task[COMPUTER_TASKS_COUNT];
@@ -199,8 +197,12 @@ unsigned int packet_file_pos;
     unsigned short columns_used;
     unsigned char texture_id;
     unsigned short free_things[THINGS_COUNT-1];
-    /** Index of the first used element in free things array. All elements BEYOND this index are free. If all things are free, it is set to 0. */
+    /** Index of the first used element in free things array. All elements BEYOND this index, and below thing_slots_count-1, are free. If all things are free, it is set to 0. */
     ThingIndex free_things_start_index;
+    /** Amount of thing slots made available in current level. The things pool grows in chunks, up to the MaxThings rule. */
+    ThingIndex thing_slots_count;
+    /** Amount of creature control slots made available in current level, up to the MaxCreatures rule. */
+    short cctrl_slots_count;
     GameTurn play_gameturn;
     GameTurn pckt_gameturn;
     /** Synchronized random seed. used for game actions, as it's always identical for clients of network game. */
@@ -44,6 +44,9 @@
 #include "frontmenu_ingame_map.h"
 #include "gui_boxmenu.h"
 #include "keeperfx.hpp"
+
+#include <SDL2/SDL.h>
+#include <zlib.h>
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -53,11 +56,49 @@ extern "C" {
 /******************************************************************************/
 TbBool load_catalogue_entry(TbFileHandle fh,struct FileChunkHeader *hdr,struct CatalogueEntry *centry);
 /******************************************************************************/
+#define SAVE_SNAPSHOT_CHUNKS_MAX 8
+
+/**
+ * Chunk of game state copied for saving.
+ */
+struct SaveSnapshotChunk {
+    unsigned long id;
+    unsigned long len;
+    unsigned char *data;
+    /** Whether the chunk is to be compressed; the info block never is, as catalogue reads it directly. */
+    TbBool packed;
+};
+
+/**
+ * Copy of the whole game state, which can be compressed and written while the game goes on.
+ */
+struct SaveSnapshot {
+    TbFileHandle fhandle;
+    char fname[2048];
+    struct SaveSnapshotChunk chunks[SAVE_SNAPSHOT_CHUNKS_MAX];
+    int chunks_count;
+    unsigned char *buf;
+};
+
+/**
+ * Source of chunk data when loading; either the file itself, or unpacked content of a compressed chunk.
+ */
+struct SaveChunkReader {
+    TbFileHandle fhandle;
+    unsigned char *buf;
+    unsigned long len;
+    unsigned long pos;
+};
+/******************************************************************************/
 long const VersionMajor = 1;
-long const VersionMinor = 12;
+long const VersionMinor = 13;
 
 const char *continue_game_filename="fx1contn.sav";
 const char *saved_game_filename="fx1g%04d.sav";
+
+static struct SaveSnapshot save_snapshot;
+static SDL_Thread *save_writer_thread = NULL;
+static TbBool save_writer_result = true;
 const char *packet_filename="fx1rp%04d.pck";
 
 struct CatalogueEntry save_game_catalogue[TOTAL_SAVE_SLOTS_COUNT];
@@ -94,20 +135,183 @@ short save_version_compatible(long filesize,struct Game *header)
   return false;
 }*/
 
-TbBool save_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
+/**
+ * Prepares reading data of a chunk which header was just read.
+ * Compressed chunks are unpacked at once, and the header is changed to describe the unpacked data.
+ */
+static TbBool save_chunk_reader_open(struct SaveChunkReader *rd, TbFileHandle fhandle, struct FileChunkHeader *hdr)
+{
+    rd->fhandle = fhandle;
+    rd->buf = NULL;
+    rd->len = hdr->len;
+    rd->pos = 0;
+    if ((hdr->ver & SGC_VER_ZLIB) == 0)
+        return true;
+    long chunk_pos = LbFilePosition(fhandle);
+    unsigned long raw_len = 0;
+    unsigned char* packed = NULL;
+    TbBool done = (hdr->len > sizeof(raw_len)) && (LbFileRead(fhandle, &raw_len, sizeof(raw_len)) == sizeof(raw_len));
+    unsigned long packed_len = hdr->len - sizeof(raw_len);
+    if (done)
+    {
+        packed = LbMemoryAlloc(packed_len);
+        rd->buf = LbMemoryAlloc(raw_len + 1);
+    }
+    uLongf unpacked_len = raw_len;
+    done = done && (packed != NULL) && (rd->buf != NULL)
+        && (LbFileRead(fhandle, packed, packed_len) == (long)packed_len)
+        && (uncompress(rd->buf, &unpacked_len, packed, packed_len) == Z_OK) && (unpacked_len == raw_len);
+    if (packed != NULL)
+        LbMemoryFree(packed);
+    if (!done)
+    {
+        if (rd->buf != NULL)
+            LbMemoryFree(rd->buf);
+        rd->buf = NULL;
+        if (LbFileSeek(fhandle, chunk_pos + hdr->len, Lb_FILE_SEEK_BEGINNING) < 0)
+            LbFileSeek(fhandle, 0, Lb_FILE_SEEK_END);
+        WARNLOG("Could not unpack chunk, ID = %08lx",hdr->id);
+        return false;
+    }
+    hdr->len = raw_len;
+    hdr->ver &= ~SGC_VER_ZLIB;
+    rd->len = raw_len;
+    return true;
+}
+
+static long save_chunk_read(struct SaveChunkReader *rd, void *buf, unsigned long len)
+{
+    if (rd->buf == NULL)
+        return LbFileRead(rd->fhandle, buf, len);
+    if (len > rd->len - rd->pos)
+        len = rd->len - rd->pos;
+    LbMemoryCopy(buf, rd->buf + rd->pos, len);
+    rd->pos += len;
+    return len;
+}
+
+static void save_chunk_skip(struct SaveChunkReader *rd, unsigned long len)
+{
+    if (rd->buf == NULL)
+    {
+        if (LbFileSeek(rd->fhandle, len, Lb_FILE_SEEK_CURRENT) < 0)
+            LbFileSeek(rd->fhandle, 0, Lb_FILE_SEEK_END);
+        return;
+    }
+    rd->pos = (len < rd->len - rd->pos) ? rd->pos + len : rd->len;
+}
+
+static void save_chunk_reader_close(struct SaveChunkReader *rd)
+{
+    if (rd->buf != NULL)
+        LbMemoryFree(rd->buf);
+    rd->buf = NULL;
+}
+
+/**
+ * Writes chunk with the used part of things pool.
+ * Things are stored in separately allocated blocks, so they're written block by block.
+ */
+static TbBool save_things_pool_chunk(TbFileHandle fhandle)
+{
+    struct FileChunkHeader hdr;
+    long slots_count = game.thing_slots_count;
+    hdr.id = SGC_ThingsData;
+    hdr.ver = 0;
+    hdr.len = slots_count * sizeof(struct Thing);
+    if (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) != sizeof(struct FileChunkHeader))
+        return false;
+    for (long i = 0; i < slots_count; i += THINGS_POOL_CHUNK)
+    {
+        long len = min(THINGS_POOL_CHUNK, slots_count - i) * sizeof(struct Thing);
+        if (LbFileWrite(fhandle, game.things.lookup[i], len) != len)
+            return false;
+    }
+    return true;
+}
+
+static TbBool load_things_pool_chunk(struct SaveChunkReader *rd, const struct FileChunkHeader *hdr)
+{
+    long slots_count = hdr->len / sizeof(struct Thing);
+    if ((hdr->len % sizeof(struct Thing) != 0) || (slots_count < 1) || (slots_count > THINGS_COUNT))
+    {
+        save_chunk_skip(rd, hdr->len);
+        WARNLOG("Incompatible ThingsData chunk");
+        return false;
+    }
+    // Lookup array was overwritten when loading the game structure
+    things_pool_update_lookups();
+    if (!things_pool_reserve(slots_count))
+        return false;
+    for (long i = 0; i < slots_count; i += THINGS_POOL_CHUNK)
+    {
+        long len = min(THINGS_POOL_CHUNK, slots_count - i) * sizeof(struct Thing);
+        if (save_chunk_read(rd, game.things.lookup[i], len) != len)
+        {
+            WARNLOG("Could not read ThingsData chunk");
+            return false;
+        }
+    }
+    game.thing_slots_count = slots_count;
+    things_pool_clear_unavailable();
+    return true;
+}
+
+static TbBool save_creature_controls_pool_chunk(TbFileHandle fhandle)
+{
+    struct FileChunkHeader hdr;
+    long slots_count = game.cctrl_slots_count;
+    hdr.id = SGC_CreatureCtrls;
+    hdr.ver = 0;
+    hdr.len = slots_count * sizeof(struct CreatureControl);
+    if (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) != sizeof(struct FileChunkHeader))
+        return false;
+    for (long i = 0; i < slots_count; i += CREATURES_POOL_CHUNK)
+    {
+        long len = min(CREATURES_POOL_CHUNK, slots_count - i) * sizeof(struct CreatureControl);
+        if (LbFileWrite(fhandle, game.persons.cctrl_lookup[i], len) != len)
+            return false;
+    }
+    return true;
+}
+
+static TbBool load_creature_controls_pool_chunk(struct SaveChunkReader *rd, const struct FileChunkHeader *hdr)
+{
+    long slots_count = hdr->len / sizeof(struct CreatureControl);
+    if ((hdr->len % sizeof(struct CreatureControl) != 0) || (slots_count < 1) || (slots_count > CREATURES_COUNT))
+    {
+        save_chunk_skip(rd, hdr->len);
+        WARNLOG("Incompatible CreatureCtrls chunk");
+        return false;
+    }
+    creature_controls_pool_update_lookups();
+    if (!creature_controls_pool_reserve(slots_count))
+        return false;
+    for (long i = 0; i < slots_count; i += CREATURES_POOL_CHUNK)
+    {
+        long len = min(CREATURES_POOL_CHUNK, slots_count - i) * sizeof(struct CreatureControl);
+        if (save_chunk_read(rd, game.persons.cctrl_lookup[i], len) != len)
+        {
+            WARNLOG("Could not read CreatureCtrls chunk");
+            return false;
+        }
+    }
+    game.cctrl_slots_count = slots_count;
+    creature_controls_pool_clear_unavailable();
+    return true;
+}
+
+/**
+ * Writes chunks with the whole state of the game, without the catalogue entry.
+ * These are the chunks save_game_chunks() writes after the info block; packet files
+ * store them as keyframes.
+ */
+TbBool save_game_state_chunks(TbFileHandle fhandle)
 {
     struct FileChunkHeader hdr;
     long chunks_done = 0;
     // Currently there is some game data oustide of structs - make sure it is updated
     light_export_system_state(&gameadd.lightst);
-    { // Info chunk
-        hdr.id = SGC_InfoBlock;
-        hdr.ver = 0;
-        hdr.len = sizeof(struct CatalogueEntry);
-        if (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
-        if (LbFileWrite(fhandle, centry, sizeof(struct CatalogueEntry)) == sizeof(struct CatalogueEntry))
-            chunks_done |= SGF_InfoBlock;
-    }
     { // Game data chunk
         hdr.id = SGC_GameOrig;
         hdr.ver = 0;
@@ -124,6 +328,11 @@ TbBool save_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
         if (LbFileWrite(fhandle, &gameadd, sizeof(struct GameAdd)) == sizeof(struct GameAdd))
             chunks_done |= SGF_GameAdd;
     }
+    // Things and creature controls data chunks
+    if (save_things_pool_chunk(fhandle))
+        chunks_done |= SGF_ThingsData;
+    if (save_creature_controls_pool_chunk(fhandle))
+        chunks_done |= SGF_CreatureCtrls;
     { // IntralevelData data chunk
         hdr.id = SGC_IntralevelData;
         hdr.ver = 0;
@@ -132,11 +341,204 @@ TbBool save_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
         if (LbFileWrite(fhandle, &intralvl, sizeof(struct IntralevelData)) == sizeof(struct IntralevelData))
             chunks_done |= SGF_IntralevelData;
     }
-    if (chunks_done != SGF_SavedGame)
+    if (chunks_done != SGF_GameState)
+        return false;
+    return true;
+}
+
+/**
+ * Copies used parts of things and creature controls pools into given buffers.
+ * They're stored in separately allocated blocks, so they're copied block by block.
+ */
+static void save_pools_copy(unsigned char *things_dst, unsigned char *cctrl_dst)
+{
+    for (long i = 0; i < game.thing_slots_count; i += THINGS_POOL_CHUNK)
+    {
+        long len = min(THINGS_POOL_CHUNK, game.thing_slots_count - i) * sizeof(struct Thing);
+        LbMemoryCopy(things_dst, game.things.lookup[i], len);
+        things_dst += len;
+    }
+    for (long i = 0; i < game.cctrl_slots_count; i += CREATURES_POOL_CHUNK)
+    {
+        long len = min(CREATURES_POOL_CHUNK, game.cctrl_slots_count - i) * sizeof(struct CreatureControl);
+        LbMemoryCopy(cctrl_dst, game.persons.cctrl_lookup[i], len);
+        cctrl_dst += len;
+    }
+}
+
+static unsigned char *save_buffer_chunk_add(unsigned char **pos, unsigned long id, unsigned long len)
+{
+    struct FileChunkHeader hdr;
+    hdr.id = id;
+    hdr.ver = 0;
+    hdr.len = len;
+    LbMemoryCopy(*pos, &hdr, sizeof(struct FileChunkHeader));
+    unsigned char* data = *pos + sizeof(struct FileChunkHeader);
+    *pos = data + len;
+    return data;
+}
+
+/**
+ * Copies chunks with the whole state of the game into one memory buffer, in the same layout
+ * save_game_state_chunks() writes them into a file.
+ * @param len Gets size of the returned buffer.
+ * @return The buffer, to be freed with LbMemoryFree(); or NULL if it couldn't be allocated.
+ */
+unsigned char *save_game_state_to_buffer(unsigned long *len)
+{
+    long things_len = game.thing_slots_count * sizeof(struct Thing);
+    long cctrl_len = game.cctrl_slots_count * sizeof(struct CreatureControl);
+    unsigned long total_len = 5 * sizeof(struct FileChunkHeader) + sizeof(struct Game) + sizeof(struct GameAdd)
+        + things_len + cctrl_len + sizeof(struct IntralevelData);
+    // Currently there is some game data oustide of structs - make sure it is updated
+    light_export_system_state(&gameadd.lightst);
+    unsigned char* buf = LbMemoryAlloc(total_len);
+    if (buf == NULL)
+        return NULL;
+    unsigned char* pos = buf;
+    LbMemoryCopy(save_buffer_chunk_add(&pos, SGC_GameOrig, sizeof(struct Game)), &game, sizeof(struct Game));
+    LbMemoryCopy(save_buffer_chunk_add(&pos, SGC_GameAdd, sizeof(struct GameAdd)), &gameadd, sizeof(struct GameAdd));
+    unsigned char* things_dst = save_buffer_chunk_add(&pos, SGC_ThingsData, things_len);
+    unsigned char* cctrl_dst = save_buffer_chunk_add(&pos, SGC_CreatureCtrls, cctrl_len);
+    save_pools_copy(things_dst, cctrl_dst);
+    LbMemoryCopy(save_buffer_chunk_add(&pos, SGC_IntralevelData, sizeof(struct IntralevelData)), &intralvl, sizeof(struct IntralevelData));
+    *len = total_len;
+    return buf;
+}
+
+static unsigned char *save_snapshot_add(struct SaveSnapshot *snap, unsigned char **pos, unsigned long id, unsigned long len, TbBool packed)
+{
+    struct SaveSnapshotChunk* chunk = &snap->chunks[snap->chunks_count];
+    snap->chunks_count++;
+    chunk->id = id;
+    chunk->len = len;
+    chunk->data = *pos;
+    chunk->packed = packed;
+    *pos += len;
+    return chunk->data;
+}
+
+/**
+ * Copies all chunks of a saved game into one memory buffer.
+ */
+static TbBool save_snapshot_take(struct SaveSnapshot *snap, const struct CatalogueEntry *centry)
+{
+    long things_len = game.thing_slots_count * sizeof(struct Thing);
+    long cctrl_len = game.cctrl_slots_count * sizeof(struct CreatureControl);
+    unsigned long total_len = sizeof(struct CatalogueEntry) + sizeof(struct Game) + sizeof(struct GameAdd)
+        + things_len + cctrl_len + sizeof(struct IntralevelData);
+    // Currently there is some game data oustide of structs - make sure it is updated
+    light_export_system_state(&gameadd.lightst);
+    snap->chunks_count = 0;
+    snap->buf = LbMemoryAlloc(total_len);
+    if (snap->buf == NULL)
         return false;
+    unsigned char* pos = snap->buf;
+    LbMemoryCopy(save_snapshot_add(snap, &pos, SGC_InfoBlock, sizeof(struct CatalogueEntry), false), centry, sizeof(struct CatalogueEntry));
+    LbMemoryCopy(save_snapshot_add(snap, &pos, SGC_GameOrig, sizeof(struct Game), true), &game, sizeof(struct Game));
+    LbMemoryCopy(save_snapshot_add(snap, &pos, SGC_GameAdd, sizeof(struct GameAdd), true), &gameadd, sizeof(struct GameAdd));
+    unsigned char* things_dst = save_snapshot_add(snap, &pos, SGC_ThingsData, things_len, true);
+    unsigned char* cctrl_dst = save_snapshot_add(snap, &pos, SGC_CreatureCtrls, cctrl_len, true);
+    save_pools_copy(things_dst, cctrl_dst);
+    LbMemoryCopy(save_snapshot_add(snap, &pos, SGC_IntralevelData, sizeof(struct IntralevelData), true), &intralvl, sizeof(struct IntralevelData));
     return true;
 }
 
+static void save_snapshot_free(struct SaveSnapshot *snap)
+{
+    if (snap->buf != NULL)
+        LbMemoryFree(snap->buf);
+    snap->buf = NULL;
+    snap->chunks_count = 0;
+}
+
+/**
+ * Compresses chunks of the snapshot and writes them into given file.
+ * Doesn't touch any game structures, so it can be called from any thread.
+ */
+static TbBool save_snapshot_write(const struct SaveSnapshot *snap, TbFileHandle fhandle)
+{
+    struct FileChunkHeader hdr;
+    uLongf packed_max = 0;
+    for (int i = 0; i < snap->chunks_count; i++)
+    {
+        if (packed_max < compressBound(snap->chunks[i].len))
+            packed_max = compressBound(snap->chunks[i].len);
+    }
+    unsigned char* packed = LbMemoryAlloc(packed_max);
+    if (packed == NULL)
+        return false;
+    TbBool done = true;
+    for (int i = 0; (i < snap->chunks_count) && done; i++)
+    {
+        const struct SaveSnapshotChunk* chunk = &snap->chunks[i];
+        hdr.id = chunk->id;
+        if (!chunk->packed)
+        {
+            hdr.ver = 0;
+            hdr.len = chunk->len;
+            done = (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
+                && (LbFileWrite(fhandle, chunk->data, chunk->len) == (long)chunk->len);
+            continue;
+        }
+        unsigned long raw_len = chunk->len;
+        uLongf packed_len = packed_max;
+        if (compress2(packed, &packed_len, chunk->data, raw_len, Z_BEST_SPEED) != Z_OK)
+        {
+            done = false;
+            break;
+        }
+        hdr.ver = SGC_VER_ZLIB;
+        hdr.len = sizeof(raw_len) + packed_len;
+        done = (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
+            && (LbFileWrite(fhandle, &raw_len, sizeof(raw_len)) == sizeof(raw_len))
+            && (LbFileWrite(fhandle, packed, packed_len) == (long)packed_len);
+    }
+    LbMemoryFree(packed);
+    return done;
+}
+
+/**
+ * Writes saved game from the snapshot into its file, then frees the snapshot.
+ * This is the body of the background save writer thread.
+ */
+static int save_snapshot_writer(void *data)
+{
+    struct SaveSnapshot* snap = (struct SaveSnapshot*)data;
+    TbBool done = save_snapshot_write(snap, snap->fhandle);
+    LbFileClose(snap->fhandle);
+    snap->fhandle = -1;
+    if (!done)
+        WARNMSG("Cannot write to save file, \"%s\".",snap->fname);
+    save_snapshot_free(snap);
+    return done;
+}
+
+/**
+ * Waits until the saved game which is written in background is finished.
+ * @return False if writing the last saved game has failed.
+ */
+TbBool wait_for_saved_game_written(void)
+{
+    if (save_writer_thread == NULL)
+        return save_writer_result;
+    int status = 0;
+    SDL_WaitThread(save_writer_thread, &status);
+    save_writer_thread = NULL;
+    save_writer_result = (status != 0);
+    return save_writer_result;
+}
+
+TbBool save_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
+{
+    struct SaveSnapshot snap;
+    if (!save_snapshot_take(&snap, centry))
+        return false;
+    TbBool done = save_snapshot_write(&snap, fhandle);
+    save_snapshot_free(&snap);
+    return done;
+}
+
 TbBool save_packet_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
 {
     struct FileChunkHeader hdr;
@@ -176,10 +578,15 @@ TbBool save_packet_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
             if (LbFileWrite(fhandle, &gameadd, sizeof(struct GameAdd)) == sizeof(struct GameAdd))
                 chunks_done |= SGF_GameAdd;
         }
+        // Things and creature controls data chunks
+        if (save_things_pool_chunk(fhandle))
+            chunks_done |= SGF_ThingsData;
+        if (save_creature_controls_pool_chunk(fhandle))
+            chunks_done |= SGF_CreatureCtrls;
     }
     { // Packet file data start indicator
         hdr.id = SGC_PacketData;
-        hdr.ver = 0;
+        hdr.ver = PACKET_FILE_VERSION;
         hdr.len = 0;
         if (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
             chunks_done |= SGF_PacketData;
@@ -189,19 +596,88 @@ TbBool save_packet_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
     return true;
 }
 
+/**
+ * Loads one of the chunks written by save_game_state_chunks(), which make the whole game state.
+ * @return Flag of the loaded chunk, 0 if it couldn't be loaded, or -1 if it's not a game state chunk.
+ */
+static long load_game_state_chunk(struct SaveChunkReader *rd, const struct FileChunkHeader *hdr)
+{
+    switch(hdr->id)
+    {
+    case SGC_GameAdd:
+        if (hdr->len != sizeof(struct GameAdd))
+        {
+            save_chunk_skip(rd, hdr->len);
+            WARNLOG("Incompatible GameAdd chunk");
+            return 0;
+        }
+        if (save_chunk_read(rd, &gameadd, sizeof(struct GameAdd)) == sizeof(struct GameAdd)) {
+        //accept invalid saves -- if (save_chunk_read(rd, &gameadd, hdr->len) == hdr->len) {
+            return SGF_GameAdd;
+        }
+        WARNLOG("Could not read GameAdd chunk");
+        return 0;
+    case SGC_GameOrig:
+        if (hdr->len != sizeof(struct Game))
+        {
+            save_chunk_skip(rd, hdr->len);
+            WARNLOG("Incompatible GameOrig chunk");
+            return 0;
+        }
+        if (save_chunk_read(rd, &game, sizeof(struct Game)) == sizeof(struct Game)) {
+            // Names of config items and columns are stored within the game structure
+            named_commands_changed();
+            invalidate_column_lookup();
+            return SGF_GameOrig;
+        }
+        WARNLOG("Could not read GameOrig chunk");
+        return 0;
+    case SGC_ThingsData:
+        return load_things_pool_chunk(rd, hdr) ? SGF_ThingsData : 0;
+    case SGC_CreatureCtrls:
+        return load_creature_controls_pool_chunk(rd, hdr) ? SGF_CreatureCtrls : 0;
+    case SGC_IntralevelData:
+        if (hdr->len != sizeof(struct IntralevelData))
+        {
+            save_chunk_skip(rd, hdr->len);
+            WARNLOG("Incompatible IntralevelData chunk");
+            return 0;
+        }
+        if (save_chunk_read(rd, &intralvl, sizeof(struct IntralevelData)) == sizeof(struct IntralevelData)) {
+            return SGF_IntralevelData;
+        }
+        WARNLOG("Could not read IntralevelData chunk");
+        return 0;
+    default:
+        return -1;
+    }
+}
+
 int load_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
 {
     long chunks_done = 0;
     while (!LbFileEof(fhandle))
     {
         struct FileChunkHeader hdr;
+        struct SaveChunkReader rd;
+        // Chunk headers are never compressed; the reader is prepared after the header is known
         if (LbFileRead(fhandle, &hdr, sizeof(struct FileChunkHeader)) != sizeof(struct FileChunkHeader))
             break;
+        if (!save_chunk_reader_open(&rd, fhandle, &hdr))
+            continue;
         switch(hdr.id)
         {
         case SGC_InfoBlock:
-            if (load_catalogue_entry(fhandle,&hdr,centry))
+            // Info block is never compressed, as the catalogue reads it directly from file
+            if ((rd.buf == NULL) && load_catalogue_entry(fhandle,&hdr,centry))
             {
+                // Layout of game state chunks changes between versions; refuse before anything is modified
+                if (centry->version != (unsigned long)((VersionMajor << 16) + VersionMinor))
+                {
+                    WARNMSG("Saved game version %lu.%lu is not compatible with %ld.%ld",
+                        centry->version >> 16, centry->version & 0xFFFF, VersionMajor, VersionMinor);
+                    return GLoad_Failed;
+                }
                 chunks_done |= SGF_InfoBlock;
                 if (!change_campaign(centry->campaign_fname)) {
                     ERRORLOG("Unable to load campaign");
@@ -216,44 +692,14 @@ int load_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
                 snprintf(high_score_entry, PLAYER_NAME_LENGTH, "%s", centry->player_name);
             }
             break;
-        case SGC_GameAdd:
-            if (hdr.len != sizeof(struct GameAdd))
-            {
-                if (LbFileSeek(fhandle, hdr.len, Lb_FILE_SEEK_CURRENT) < 0)
-                    LbFileSeek(fhandle, 0, Lb_FILE_SEEK_END);
-                WARNLOG("Incompatible GameAdd chunk");
-                break;
-            }
-            if (LbFileRead(fhandle, &gameadd, sizeof(struct GameAdd)) == sizeof(struct GameAdd)) {
-            //accept invalid saves -- if (LbFileRead(fhandle, &gameadd, hdr.len) == hdr.len) {
-                chunks_done |= SGF_GameAdd;
-            } else {
-                WARNLOG("Could not read GameAdd chunk");
-            }
-            break;
-        case SGC_GameOrig:
-            if (hdr.len != sizeof(struct Game))
-            {
-                if (LbFileSeek(fhandle, hdr.len, Lb_FILE_SEEK_CURRENT) < 0)
-                    LbFileSeek(fhandle, 0, Lb_FILE_SEEK_END);
-                WARNLOG("Incompatible GameOrig chunk");
-                break;
-            }
-            if (LbFileRead(fhandle, &game, sizeof(struct Game)) == sizeof(struct Game)) {
-                chunks_done |= SGF_GameOrig;
-            } else {
-                WARNLOG("Could not read GameOrig chunk");
-            }
-            break;
         case SGC_PacketHeader:
             if (hdr.len != sizeof(struct PacketSaveHead))
             {
-                if (LbFileSeek(fhandle, hdr.len, Lb_FILE_SEEK_CURRENT) < 0)
-                    LbFileSeek(fhandle, 0, Lb_FILE_SEEK_END);
+                save_chunk_skip(&rd, hdr.len);
                 WARNLOG("Incompatible PacketHeader chunk");
                 break;
             }
-            if (LbFileRead(fhandle, &game.packet_save_head, sizeof(struct PacketSaveHead))
+            if (save_chunk_read(&rd, &game.packet_save_head, sizeof(struct PacketSaveHead))
                 == sizeof(struct PacketSaveHead)) {
                 chunks_done |= SGF_PacketHeader;
             } else {
@@ -263,8 +709,7 @@ int load_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
         case SGC_PacketData:
             if (hdr.len != 0)
             {
-                if (LbFileSeek(fhandle, hdr.len, Lb_FILE_SEEK_CURRENT) < 0)
-                    LbFileSeek(fhandle, 0, Lb_FILE_SEEK_END);
+                save_chunk_skip(&rd, hdr.len);
                 WARNLOG("Incompatible PacketData chunk");
                 break;
             }
@@ -274,24 +719,17 @@ int load_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
             if ((chunks_done & SGF_PacketStart) == SGF_PacketStart)
                 return GLoad_PacketStart;
             return GLoad_Failed;
-        case SGC_IntralevelData:
-            if (hdr.len != sizeof(struct IntralevelData))
-            {
-                if (LbFileSeek(fhandle, hdr.len, Lb_FILE_SEEK_CURRENT) < 0)
-                    LbFileSeek(fhandle, 0, Lb_FILE_SEEK_END);
-                WARNLOG("Incompatible IntralevelData chunk");
-                break;
-            }
-            if (LbFileRead(fhandle, &intralvl, sizeof(struct IntralevelData)) == sizeof(struct IntralevelData)) {
-                chunks_done |= SGF_IntralevelData;
-            } else {
-                WARNLOG("Could not read IntralevelData chunk");
-            }
-            break;
         default:
-            WARNLOG("Unrecognized chunk, ID = %08lx",hdr.id);
+        {
+            long flag = load_game_state_chunk(&rd, &hdr);
+            if (flag < 0)
+                WARNLOG("Unrecognized chunk, ID = %08lx",hdr.id);
+            else
+                chunks_done |= flag;
             break;
         }
+        }
+        save_chunk_reader_close(&rd);
     }
     if ((chunks_done & SGF_SavedGame) == SGF_SavedGame)
     {
@@ -300,6 +738,45 @@ int load_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
         update_room_tab_to_config();
         return GLoad_SavedGame;
     }
+    // Keyframes of packet files have game state without the info block
+    if ((chunks_done & SGF_SavedGame) == SGF_GameState)
+        return GLoad_GameState;
+    return GLoad_Failed;
+}
+
+/**
+ * Loads game state from chunks stored in memory by save_game_state_to_buffer().
+ * @return GLoad_GameState if the whole state was loaded, GLoad_Failed otherwise.
+ */
+int load_game_state_from_buffer(const unsigned char *buf, unsigned long len)
+{
+    long chunks_done = 0;
+    unsigned long pos = 0;
+    while (pos + sizeof(struct FileChunkHeader) <= len)
+    {
+        struct FileChunkHeader hdr;
+        struct SaveChunkReader rd;
+        LbMemoryCopy(&hdr, buf + pos, sizeof(struct FileChunkHeader));
+        pos += sizeof(struct FileChunkHeader);
+        if ((hdr.len > len - pos) || ((hdr.ver & SGC_VER_ZLIB) != 0))
+        {
+            WARNLOG("Invalid game state chunk, ID = %08lx",hdr.id);
+            break;
+        }
+        // The reader doesn't own the buffer, so it isn't closed
+        rd.fhandle = -1;
+        rd.buf = (unsigned char *)buf + pos;
+        rd.len = hdr.len;
+        rd.pos = 0;
+        long flag = load_game_state_chunk(&rd, &hdr);
+        if (flag < 0)
+            WARNLOG("Unrecognized chunk, ID = %08lx",hdr.id);
+        else
+            chunks_done |= flag;
+        pos += hdr.len;
+    }
+    if ((chunks_done & SGF_GameState) == SGF_GameState)
+        return GLoad_GameState;
     return GLoad_Failed;
 }
 
@@ -317,6 +794,8 @@ TbBool save_game(long slot_num)
 /*  game.version_major = VersionMajor;
     game.version_minor = VersionMinor;
     game.load_restart_level = get_loaded_level_number();*/
+    // Only one saved game is written at a time
+    wait_for_saved_game_written();
     char* fname = prepare_file_fmtpath(FGrp_Save, saved_game_filename, slot_num);
     TbFileHandle handle = LbFileOpen(fname, Lb_FILE_MODE_NEW);
     if (handle == -1)
@@ -324,18 +803,27 @@ TbBool save_game(long slot_num)
         WARNMSG("Cannot open file to save, \"%s\".",fname);
         return false;
     }
-    if (!save_game_chunks(handle,&save_game_catalogue[slot_num]))
+    if (!save_snapshot_take(&save_snapshot, &save_game_catalogue[slot_num]))
     {
         LbFileClose(handle);
-        WARNMSG("Cannot write to save file, \"%s\".",fname);
+        WARNMSG("Cannot prepare game state for saving into \"%s\".",fname);
         return false;
     }
-    LbFileClose(handle);
+    save_snapshot.fhandle = handle;
+    snprintf(save_snapshot.fname, sizeof(save_snapshot.fname), "%s", fname);
+    // Compressing and writing is done in background, so that saving doesn't stop the game
+    save_writer_thread = SDL_CreateThread(save_snapshot_writer, "SaveWriter", &save_snapshot);
+    if (save_writer_thread == NULL)
+    {
+        save_writer_result = save_snapshot_writer(&save_snapshot);
+        return save_writer_result;
+    }
     return true;
 }
 
 TbBool is_save_game_loadable(long slot_num)
 {
+    wait_for_saved_game_written();
     // Prepare filename and open the file
     char* fname = prepare_file_fmtpath(FGrp_Save, saved_game_filename, slot_num);
     TbFileHandle fh = LbFileOpen(fname, Lb_FILE_MODE_READ_ONLY);
@@ -359,6 +847,7 @@ TbBool load_game(long slot_num)
 //  unsigned char buf[14];
 //  char cmpgn_fname[CAMPAIGN_FNAME_LEN];
     SYNCDBG(6,"Starting");
+    wait_for_saved_game_written();
     reset_eye_lenses();
     {
         // Use fname only here - it is overwritten by next use of prepare_file_fmtpath()
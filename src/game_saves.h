@@ -38,19 +38,32 @@ enum SaveGameChunks {
      SGC_PacketHeader   = 0x52444850, //"PHDR"
      SGC_PacketData     = 0x544B4350, //"PCKT"
      SGC_IntralevelData = 0x4C564C49, //"ILVL"
+     SGC_ThingsData     = 0x474E4854, //"THNG"
+     SGC_CreatureCtrls  = 0x4C525443, //"CTRL"
+     SGC_PacketTurns    = 0x4E525450, //"PTRN"
+     SGC_PacketKeyframe = 0x59454B50, //"PKEY"
+     SGC_PacketIndex    = 0x58444950, //"PIDX"
 };
 
+/** Chunk version flag; data of such chunk is compressed with zlib, and starts with its unpacked size. */
+#define SGC_VER_ZLIB 0x80000000
+/** Version of the PacketData chunk; version 0 files have raw turns after it, version 1 have chunks. */
+#define PACKET_FILE_VERSION 1
+
 enum SaveGameChunkFlags {
      SGF_InfoBlock      = 0x0001,
      SGF_GameOrig       = 0x0002,
      SGF_GameAdd        = 0x0004,
+     SGF_ThingsData     = 0x0008,
+     SGF_CreatureCtrls  = 0x0010,
      SGF_PacketHeader   = 0x0100,
      SGF_PacketData     = 0x0200,
      SGF_IntralevelData = 0x0400,
 };
-#define SGF_SavedGame      (SGF_InfoBlock|SGF_GameOrig|SGF_GameAdd|SGF_IntralevelData)
+#define SGF_SavedGame      (SGF_InfoBlock|SGF_GameOrig|SGF_GameAdd|SGF_ThingsData|SGF_CreatureCtrls|SGF_IntralevelData)
 #define SGF_PacketStart    (SGF_PacketHeader|SGF_PacketData|SGF_InfoBlock)
-#define SGF_PacketContinue (SGF_PacketHeader|SGF_PacketData|SGF_InfoBlock|SGF_GameOrig|SGF_GameAdd)
+#define SGF_PacketContinue (SGF_PacketHeader|SGF_PacketData|SGF_InfoBlock|SGF_GameOrig|SGF_GameAdd|SGF_ThingsData|SGF_CreatureCtrls)
+#define SGF_GameState      (SGF_GameOrig|SGF_GameAdd|SGF_ThingsData|SGF_CreatureCtrls|SGF_IntralevelData)
 
 enum GameLoadStatus {
     GLoad_Failed = 0,
@@ -58,6 +71,7 @@ enum GameLoadStatus {
     GLoad_ContinueGame,
     GLoad_PacketStart,
     GLoad_PacketContinue,
+    GLoad_GameState,
 };
 /******************************************************************************/
 #pragma pack(1)
@@ -97,6 +111,10 @@ extern struct CatalogueEntry save_game_catalogue[];
 int load_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry);
 TbBool fill_game_catalogue_entry(struct CatalogueEntry *centry,const char *textname);
 TbBool save_game_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry);
+TbBool save_game_state_chunks(TbFileHandle fhandle);
+unsigned char *save_game_state_to_buffer(unsigned long *len);
+int load_game_state_from_buffer(const unsigned char *buf, unsigned long len);
+TbBool wait_for_saved_game_written(void);
 TbBool save_packet_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry);
 /******************************************************************************/
 TbBool load_game(long slot_idx);
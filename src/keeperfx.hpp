@@ -147,6 +147,8 @@ struct StartupParameters {
     TbBool overrides[CMDLINE_OVERRIDES];
     char config_file[CMDLN_MAXLEN+1];
     GameTurn pause_at_gameturn;
+    TbBool headless_replay;
+    GameTurn packet_seek_turn;
 #ifdef FUNCTESTING
     unsigned char functest_flags;
     char functest_name[FTEST_MAX_NAME_LENGTH];
@@ -215,6 +217,7 @@ extern struct StartupParameters start_params;
 //Functions - reworked
 short setup_game(void);
 void game_loop(void);
+TbBool headless_replay_loop(void);
 short reset_game(void);
 void update(void);
 
@@ -32,6 +32,7 @@
 #include "thing_stats.h"
 #include "game_legacy.h"
 #include "value_util.h"
+#include "net_sync.h"
 
 #include "post_inc.h"
 
@@ -51,6 +52,74 @@ static long light_rendered_dynamic_lights;
 static long light_rendered_optimised_dynamic_lights;
 static long light_updated_stat_lights;
 static long light_out_of_date_stat_lights;
+static long light_skipped_dynamic_lights;
+static long light_recomposited_rows;
+
+/**
+ * Dynamic light as it was drawn into subtile lightness by light_render_area().
+ * If none of the values changed, drawing the light again would give the same result.
+ */
+struct LightDrawnState {
+    /** Number of the render in which the light was last in view. */
+    unsigned long render_num;
+    TbBool drawn;
+    unsigned char flags;
+    unsigned char flags2;
+    unsigned char intensity;
+    unsigned char min_radius;
+    unsigned short radius;
+    unsigned short min_intensity;
+    unsigned short shadow_index;
+    MapCoord pos_x;
+    MapCoord pos_y;
+    MapCoord pos_z;
+    /** Rows of subtile lightness the light could have been drawn on. */
+    MapSubtlCoord beg_y;
+    MapSubtlCoord end_y;
+};
+
+/** State of incremental rendering; kept out of saved games, and rebuilt on every load. */
+static struct LightDrawnState light_drawn[LIGHTS_COUNT];
+static unsigned short light_drawn_list[LIGHTS_COUNT];
+static long light_drawn_count;
+static unsigned short light_visible_list[LIGHTS_COUNT];
+static TbBool light_visible_changed[LIGHTS_COUNT];
+static unsigned long light_render_num;
+/** Rows of subtile lightness which need to be copied from static light map again. */
+static TbBool light_dirty_rows[MAX_SUBTILES_Y+1];
+/** Rows copied from static light map by current render. */
+static TbBool light_recomposited[MAX_SUBTILES_Y+1];
+static TbBool light_recomposite_all = true;
+static MapSubtlCoord light_rendered_area[4];
+static long light_rendered_ambient;
+static unsigned char light_rendered_enabled;
+/** Set when some static lights may be out of date, so their list needs to be checked on render. */
+static TbBool stat_light_render_pending = true;
+/******************************************************************************/
+static void set_stat_light_needs_updating(void)
+{
+    stat_light_needs_updating = 1;
+    stat_light_render_pending = true;
+}
+
+static void light_mark_rows_dirty(MapSubtlCoord beg_y, MapSubtlCoord end_y)
+{
+    if (beg_y < 0)
+        beg_y = 0;
+    if (end_y > gameadd.map_subtiles_y)
+        end_y = gameadd.map_subtiles_y;
+    for (MapSubtlCoord stl_y = beg_y; stl_y <= end_y; stl_y++)
+        light_dirty_rows[stl_y] = true;
+}
+
+/**
+ * Makes next light_render_area() call recomposite whole area and draw all lights again.
+ */
+static void light_invalidate_rendered_area(void)
+{
+    light_recomposite_all = true;
+    stat_light_render_pending = true;
+}
 /******************************************************************************/
 
 struct Light *light_allocate_light(void)
@@ -168,7 +237,7 @@ long light_create_light(struct InitLight *ilght)
     {
         light_total_stat_lights++;
         light_add_light_to_list(lgt, &game.thing_lists[TngList_StaticLights]);
-        stat_light_needs_updating = 1;
+        set_stat_light_needs_updating();
     }
     lgt->flags |= LgtF_Unkn02;
     lgt->flags |= LgtF_Unkn08;
@@ -181,6 +250,7 @@ long light_create_light(struct InitLight *ilght)
 
     set_flag_value(lgt->flags, LgtF_Dynamic, ilght->is_dynamic);
     lgt->attached_slb = ilght->attached_slb;
+    sync_hash_toggle_light(lgt);
     return lgt->index;
 }
 
@@ -208,7 +278,7 @@ TbBool light_create_light_adv(VALUE *init_data)
     {
         light_total_stat_lights++;
         light_add_light_to_list(lgt, &game.thing_lists[TngList_StaticLights]);
-        stat_light_needs_updating = 1;
+        set_stat_light_needs_updating();
         clear_flag(lgt->flags, LgtF_Dynamic);
     }
     lgt->flags |= LgtF_Unkn02;
@@ -219,6 +289,7 @@ TbBool light_create_light_adv(VALUE *init_data)
     lgt->radius = value_read_stl_coord(value_dict_get(init_data, "LightRange"));;
     lgt->intensity = value_uint32(value_dict_get(init_data, "LightIntensity"));
     lgt->attached_slb = value_uint32(value_dict_get(init_data, "ParentTile"));
+    sync_hash_toggle_light(lgt);
 
     /*
      * TODO: not implemented yet
@@ -283,6 +354,18 @@ void light_import_system_state(const struct LightSystemState *lightst)
     light_rendered_optimised_dynamic_lights = lightst->rendered_optimised_dynamic_lights;
     light_updated_stat_lights = lightst->updated_stat_lights;
     light_out_of_date_stat_lights = lightst->out_of_date_stat_lights;
+    // Subtile lightness was loaded with the rest of the game
+    light_invalidate_rendered_area();
+}
+
+void light_get_render_stats(struct LightRenderStats *stats)
+{
+    stats->rendered_dynamic_lights = light_rendered_dynamic_lights;
+    stats->rendered_optimised_dynamic_lights = light_rendered_optimised_dynamic_lights;
+    stats->skipped_dynamic_lights = light_skipped_dynamic_lights;
+    stats->updated_stat_lights = light_updated_stat_lights;
+    stats->out_of_date_stat_lights = light_out_of_date_stat_lights;
+    stats->recomposited_rows = light_recomposited_rows;
 }
 
 TbBool lights_stats_debug_dump(void)
@@ -330,7 +413,7 @@ TbBool lights_stats_debug_dump(void)
             lights[i] = 0;
         }
     }
-    for (i=1; i < THINGS_COUNT; i++)
+    for (i=1; i < game.thing_slots_count; i++)
     {
         struct Thing* thing = thing_get(i);
         if (thing_exists(thing))
@@ -438,7 +521,7 @@ void light_set_light_position(long lgt_id, struct Coord3d *pos)
   {
     if ( (lgt->flags & LgtF_Dynamic) == 0 )
     {
-      stat_light_needs_updating = 1;
+      set_stat_light_needs_updating();
       unsigned char range = lgt->range;
       long end_y = lgt->mappos.y.stl.num + range;
       long end_x = lgt->mappos.x.stl.num + range;
@@ -462,9 +545,11 @@ void light_set_light_position(long lgt_id, struct Coord3d *pos)
       }
       light_signal_stat_light_update_in_area(beg_x, beg_y, end_x, end_y);
     }
+    sync_hash_toggle_light(lgt);
     lgt->mappos.x.val = pos->x.val;
     lgt->mappos.y.val = pos->y.val;
     lgt->mappos.z.val = pos->z.val;
+    sync_hash_toggle_light(lgt);
     lgt->flags |= LgtF_Unkn08;
   }
 }
@@ -534,7 +619,7 @@ void light_signal_stat_light_update_in_area(long x1, long y1, long x2, long y2)
         MapSubtlCoord y = lgt->mappos.y.stl.num;
         if ( range + x >= x1 && x - range <= x2 && range + y >= y1 && y - range <= y2 )
         {
-          stat_light_needs_updating = 1;
+          set_stat_light_needs_updating();
           i++;
           lgt->flags |= LgtF_Unkn08;
           lgt->flags &= ~LgtF_Unkn80;
@@ -610,7 +695,7 @@ void light_turn_light_off(long idx)
     } else {
         light_signal_stat_light_update_in_own_radius(lgt);
         light_remove_light_from_list(lgt, &game.thing_lists[TngList_StaticLights]);
-        stat_light_needs_updating = 1;
+        set_stat_light_needs_updating();
     }
 }
 
@@ -636,7 +721,7 @@ void light_turn_light_on(long idx)
     } else
     {
         light_add_light_to_list(lgt, &game.thing_lists[TngList_StaticLights]);
-        stat_light_needs_updating = 1;
+        set_stat_light_needs_updating();
         lgt->flags |= LgtF_Unkn08;
     }
 }
@@ -687,7 +772,7 @@ void light_set_light_intensity(long idx, unsigned char intensity)
           if ( x1 < 0 )
             x1 = 0;
           light_signal_stat_light_update_in_area(x1, y1, x2, y2);
-          stat_light_needs_updating = 1;
+          set_stat_light_needs_updating();
         }
         lgt->intensity = intensity;
         if ( lgt->min_intensity < intensity )
@@ -718,6 +803,7 @@ void clear_stat_light_map(void)
             game.lish.stat_light_map[i] = 0;
         }
     }
+    light_invalidate_rendered_area();
 }
 
 void light_delete_light(long idx)
@@ -746,6 +832,7 @@ void light_delete_light(long idx)
         light_signal_stat_light_update_in_own_radius(lgt);
         light_remove_light_from_list(lgt, &game.thing_lists[TngList_StaticLights]);
     }
+    sync_hash_toggle_light(lgt);
     light_free_light(lgt);
 }
 
@@ -1475,13 +1562,16 @@ void light_initialise(void)
         }
         game.lish.lighting_tables_initialised = true;
     }
-    stat_light_needs_updating = 1;
+    set_stat_light_needs_updating();
     light_total_dynamic_lights = 0;
     light_total_stat_lights = 0;
     light_rendered_dynamic_lights = 0;
     light_rendered_optimised_dynamic_lights = 0;
     light_updated_stat_lights = 0;
     light_out_of_date_stat_lights = 0;
+    light_skipped_dynamic_lights = 0;
+    light_recomposited_rows = 0;
+    light_invalidate_rendered_area();
 }
 
 static void light_stat_light_map_clear_area(MapSubtlCoord start_stl_x, MapSubtlCoord start_stl_y, MapSubtlCoord end_stl_x, MapSubtlCoord end_stl_y)
@@ -1490,6 +1580,7 @@ static void light_stat_light_map_clear_area(MapSubtlCoord start_stl_x, MapSubtlC
   unsigned short *light_map;
   if ( end_stl_y >= start_stl_y )
   {
+    light_mark_rows_dirty(start_stl_y, end_stl_y);
     for (stl_y = start_stl_y; stl_y <= end_stl_y; stl_y++)
     {
       if ( end_stl_x >= start_stl_x )
@@ -1989,10 +2080,8 @@ static int light_render_light_static(struct Light *lgt, int radius, int intensit
 }
 
 
-static char light_render_light(struct Light* lgt)
+static void light_interpolate_position(struct Light* lgt)
 {
-  int remember_original_lgt_mappos_x = lgt->mappos.x.val;
-  int remember_original_lgt_mappos_y = lgt->mappos.y.val;
   if ((lgt->interp_has_been_initialized == false) || (game.play_gameturn - lgt->last_turn_drawn > 1)) {
     lgt->interp_has_been_initialized = true;
     lgt->interp_mappos.x.val = lgt->mappos.x.val;
@@ -2004,6 +2093,15 @@ static char light_render_light(struct Light* lgt)
     lgt->interp_mappos.y.val = interpolate(lgt->interp_mappos.y.val, lgt->previous_mappos.y.val, lgt->mappos.y.val);
   }
   lgt->last_turn_drawn = game.play_gameturn;
+}
+
+/**
+ * Draws the light at its interpolated position; light_interpolate_position() should be called first.
+ */
+static char light_draw_light(struct Light* lgt)
+{
+  int remember_original_lgt_mappos_x = lgt->mappos.x.val;
+  int remember_original_lgt_mappos_y = lgt->mappos.y.val;
   lgt->mappos.x.val = lgt->interp_mappos.x.val;
   lgt->mappos.y.val = lgt->interp_mappos.y.val;
   TbBool is_dynamic = lgt->flags & LgtF_Dynamic;
@@ -2146,23 +2244,97 @@ static char light_render_light(struct Light* lgt)
   return lighting_tables_idx;
 }
 
+static char light_render_light(struct Light* lgt)
+{
+  light_interpolate_position(lgt);
+  return light_draw_light(lgt);
+}
+
+/**
+ * Returns whether the dynamic light would be drawn differently than in its previous render.
+ */
+static TbBool light_changed_since_drawn(const struct Light *lgt)
+{
+  const struct LightDrawnState *drwn = &light_drawn[lgt->index];
+  if (!drwn->drawn)
+    return true;
+  // Flickering lights are random, cache is rebuilt with flag 0x08, and uncached ones depend on the map
+  if ( ((lgt->flags2 & 0xFE) != 0) || ((lgt->flags & (LgtF_Unkn08|LgtF_NeverCached)) != 0) )
+    return true;
+  return (drwn->flags != lgt->flags) || (drwn->flags2 != lgt->flags2)
+      || (drwn->intensity != lgt->intensity) || (drwn->min_radius != lgt->min_radius)
+      || (drwn->radius != lgt->radius) || (drwn->min_intensity != lgt->min_intensity)
+      || (drwn->shadow_index != lgt->shadow_index)
+      || (drwn->pos_x != lgt->interp_mappos.x.val) || (drwn->pos_y != lgt->interp_mappos.y.val)
+      || (drwn->pos_z != lgt->mappos.z.val);
+}
+
+static void light_store_drawn_state(const struct Light *lgt)
+{
+  struct LightDrawnState *drwn = &light_drawn[lgt->index];
+  // Drawing may delete a broken light
+  drwn->drawn = ((lgt->flags & LgtF_Allocated) != 0);
+  drwn->flags = lgt->flags;
+  drwn->flags2 = lgt->flags2;
+  drwn->intensity = lgt->intensity;
+  drwn->min_radius = lgt->min_radius;
+  drwn->radius = lgt->radius;
+  drwn->min_intensity = lgt->min_intensity;
+  drwn->shadow_index = lgt->shadow_index;
+  drwn->pos_x = lgt->interp_mappos.x.val;
+  drwn->pos_y = lgt->interp_mappos.y.val;
+  drwn->pos_z = lgt->mappos.z.val;
+  // Lighting tables never reach farther than the range; one more row covers rounding of interpolated position
+  drwn->beg_y = lgt->interp_mappos.y.stl.num - lgt->range - 1;
+  drwn->end_y = lgt->interp_mappos.y.stl.num + lgt->range + 1;
+}
+
+static TbBool light_drawn_on_recomposited_rows(const struct LightDrawnState *drwn)
+{
+  MapSubtlCoord beg_y = max(drwn->beg_y, 0);
+  MapSubtlCoord end_y = min(drwn->end_y, gameadd.map_subtiles_y);
+  for (MapSubtlCoord stl_y = beg_y; stl_y <= end_y; stl_y++)
+  {
+    if (light_recomposited[stl_y])
+      return true;
+  }
+  return false;
+}
+
 static void light_render_area(MapSubtlCoord startx, MapSubtlCoord starty, MapSubtlCoord endx, MapSubtlCoord endy)
 {
   struct Light *lgt;
   int range;
   MapSubtlDelta half_width_y;
   MapSubtlDelta half_width_x;
+  long visible_count;
+  long i;
+  MapSubtlCoord stl_y;
 
   light_rendered_dynamic_lights = 0;
   light_rendered_optimised_dynamic_lights = 0;
   light_updated_stat_lights = 0;
   light_out_of_date_stat_lights = 0;
+  light_skipped_dynamic_lights = 0;
+  light_recomposited_rows = 0;
   half_width_x = (endx - startx) / 2 + 1;
   half_width_y = (endy - starty) / 2 + 1;
+  light_render_num++;
+  if ( (light_rendered_area[0] != startx) || (light_rendered_area[1] != starty)
+    || (light_rendered_area[2] != endx) || (light_rendered_area[3] != endy)
+    || (light_rendered_ambient != game.lish.global_ambient_light) || (light_rendered_enabled != game.lish.light_enabled) )
+  {
+    light_rendered_area[0] = startx;
+    light_rendered_area[1] = starty;
+    light_rendered_area[2] = endx;
+    light_rendered_area[3] = endy;
+    light_rendered_ambient = game.lish.global_ambient_light;
+    light_rendered_enabled = game.lish.light_enabled;
+    light_recomposite_all = true;
+  }
 
-
-  // this block applies to static lights
-  if ( game.lish.light_enabled )
+  // this block applies to static lights; the list is only checked if some of them were signalled
+  if ( game.lish.light_enabled && stat_light_render_pending )
   {
     for ( lgt = &game.lish.lights[game.thing_lists[TngList_StaticLights].index];
           lgt > game.lish.lights;
@@ -2181,31 +2353,16 @@ static void light_render_area(MapSubtlCoord startx, MapSubtlCoord starty, MapSub
           ++light_updated_stat_lights;
           light_render_light(lgt);
           lgt->flags &= ~(LgtF_Unkn80 | LgtF_Unkn08);
+          light_mark_rows_dirty(lgt->interp_mappos.y.stl.num - lgt->range - 1, lgt->interp_mappos.y.stl.num + lgt->range + 1);
         }
       }
     }
+    // Lights which are out of view stay out of date
+    stat_light_render_pending = (light_out_of_date_stat_lights > light_updated_stat_lights);
   }
 
-
-  SubtlCodedCoords start_num = get_subtile_number(startx, starty);
-
-
-  if ( starty <= endy )
-  {
-    unsigned short *stl_lightness = &game.lish.subtile_lightness[start_num];
-    unsigned short *stat_light_map = &game.lish.stat_light_map[start_num];
-
-    MapSubtlDelta y = endy - starty + 1;
-    do
-    {
-      memcpy(stl_lightness, stat_light_map, 2 * (endx - startx));
-      stl_lightness  += (gameadd.map_subtiles_x + 1);
-      stat_light_map += (gameadd.map_subtiles_x + 1);
-      --y;
-    }
-    while ( y );
-  }
-
+  // Find dynamic lights in view, and mark rows they no longer cover
+  visible_count = 0;
   if ( game.lish.light_enabled )
   {
     for ( lgt = &game.lish.lights[game.thing_lists[TngList_DynamLights].index]; lgt > game.lish.lights; lgt = &game.lish.lights[lgt->next_in_list] )
@@ -2274,10 +2431,73 @@ static void light_render_area(MapSubtlCoord startx, MapSubtlCoord starty, MapSub
         {
           lgt->flags |= LgtF_Unkn08;
         }
-        light_render_light(lgt);
+        light_interpolate_position(lgt);
+        struct LightDrawnState *drwn = &light_drawn[lgt->index];
+        TbBool changed = light_recomposite_all || light_changed_since_drawn(lgt);
+        if (changed && drwn->drawn)
+          light_mark_rows_dirty(drwn->beg_y, drwn->end_y);
+        drwn->render_num = light_render_num;
+        light_visible_list[visible_count] = lgt->index;
+        light_visible_changed[visible_count] = changed;
+        visible_count++;
+      }
+    }
+  }
+  for (i = 0; i < light_drawn_count; i++)
+  {
+    struct LightDrawnState *drwn = &light_drawn[light_drawn_list[i]];
+    if ( drwn->drawn && (drwn->render_num != light_render_num) )
+    {
+      light_mark_rows_dirty(drwn->beg_y, drwn->end_y);
+      drwn->drawn = false;
+    }
+  }
+
+  // Copy static light map into rows which were changed
+  if ( starty <= endy )
+  {
+    SubtlCodedCoords start_num = get_subtile_number(startx, starty);
+    unsigned short *stl_lightness = &game.lish.subtile_lightness[start_num];
+    unsigned short *stat_light_map = &game.lish.stat_light_map[start_num];
+
+    for (stl_y = starty; stl_y <= endy; stl_y++)
+    {
+      light_recomposited[stl_y] = light_recomposite_all || light_dirty_rows[stl_y];
+      if ( light_recomposited[stl_y] )
+      {
+        memcpy(stl_lightness, stat_light_map, 2 * (endx - startx));
+        light_recomposited_rows++;
       }
+      stl_lightness  += (gameadd.map_subtiles_x + 1);
+      stat_light_map += (gameadd.map_subtiles_x + 1);
     }
   }
+
+  // Draw lights which changed, or were wiped by recompositing
+  light_drawn_count = 0;
+  for (i = 0; i < visible_count; i++)
+  {
+    lgt = &game.lish.lights[light_visible_list[i]];
+    struct LightDrawnState *drwn = &light_drawn[lgt->index];
+    if ( light_visible_changed[i] || light_drawn_on_recomposited_rows(drwn) )
+    {
+      light_draw_light(lgt);
+      light_store_drawn_state(lgt);
+    } else
+    {
+      ++light_skipped_dynamic_lights;
+    }
+    if (drwn->drawn)
+      light_drawn_list[light_drawn_count++] = lgt->index;
+  }
+
+  if ( starty <= endy )
+  {
+    for (stl_y = starty; stl_y <= endy; stl_y++)
+      light_recomposited[stl_y] = false;
+  }
+  memset(light_dirty_rows, 0, sizeof(light_dirty_rows));
+  light_recomposite_all = false;
 }
 
 void update_light_render_area(void)
@@ -108,6 +108,18 @@ struct LightSystemState {
 
 typedef struct VALUE VALUE;
 
+/** Amounts of work done by the last light_render_area() call; shown in frametime overlay. */
+struct LightRenderStats {
+    long rendered_dynamic_lights;
+    long rendered_optimised_dynamic_lights;
+    /** Dynamic lights in view which were not changed, and were left drawn from previous frame. */
+    long skipped_dynamic_lights;
+    long updated_stat_lights;
+    long out_of_date_stat_lights;
+    /** Rows of subtile lightness copied from static light map. */
+    long recomposited_rows;
+};
+
 /******************************************************************************/
 void clear_stat_light_map(void);
 void update_light_render_area(void);
@@ -129,6 +141,7 @@ void light_signal_update_in_area(long sx, long sy, long ex, long ey);
 long light_get_total_dynamic_lights(void);
 void light_export_system_state(struct LightSystemState *lightst);
 void light_import_system_state(const struct LightSystemState *lightst);
+void light_get_render_stats(struct LightRenderStats *stats);
 TbBool lights_stats_debug_dump(void);
 void light_signal_stat_light_update_in_area(long x1, long y1, long x2, long y2);
 
@@ -698,6 +698,7 @@ TbBool load_column_file(LevelNumber lv_num)
         set_column_floor_filled_subtiles(colmn, n);
         i += sizeof(struct Column);
     }
+    invalidate_column_lookup();
     LbMemoryFree(buf);
     return true;
 }
@@ -756,10 +757,10 @@ static TbBool load_thing_file(LevelNumber lv_num)
         total = (fsize-2)/sizeof(struct LegacyInitThing);
         WARNMSG("Bad amount of things in TNG file; corrected to %d.",(int)total);
     }
-    if (total > THINGS_COUNT-2)
+    if (total > get_thing_slots_limit()-2)
     {
-        WARNMSG("Only %d things supported, TNG file has %d.",(int)(THINGS_COUNT-2),(int)total);
-        total = THINGS_COUNT-2;
+        WARNMSG("Only %d things supported, TNG file has %d.",(int)(get_thing_slots_limit()-2),(int)total);
+        total = get_thing_slots_limit()-2;
     }
     // Create things
     for (long k = 0; k < total; k++)
@@ -870,7 +871,7 @@ static TbBool load_kfx_toml_file(LevelNumber lv_num, const char *ext, const char
 static TbBool load_tngfx_file(LevelNumber lv_num)
 {
     return load_kfx_toml_file(lv_num, "tngfx", "TNGFX",
-                              "thing", "ThingsCount", "thing%d", THINGS_COUNT - 2,
+                              "thing", "ThingsCount", "thing%d", get_thing_slots_limit() - 2,
                               &thing_create_thing_adv);
 }
 
@@ -1493,6 +1493,7 @@ static void new_creature_type_check(const struct ScriptLine* scline)
     LbStringCopy(game.conf.crtr_conf.model[i].name, scline->tp[0], COMMAND_WORD_LEN);
     creature_desc[i-1].name = game.conf.crtr_conf.model[i].name;
     creature_desc[i-1].num = i;
+    named_commands_changed();
 
     if (load_creaturemodel_config(i, 0))
     {
@@ -1537,6 +1538,7 @@ static void new_room_type_check(const struct ScriptLine* scline)
     roomst->health = 0;
     room_desc[i].name = roomst->code_name;
     room_desc[i].num = i;
+    named_commands_changed();
 }
 
 static void new_object_type_check(const struct ScriptLine* scline)
@@ -1560,6 +1562,7 @@ static void new_object_type_check(const struct ScriptLine* scline)
     objst->draw_class = ODC_Default;
     object_desc[tmodel].name = objst->code_name;
     object_desc[tmodel].num = tmodel;
+    named_commands_changed();
 }
 
 static void new_trap_type_check(const struct ScriptLine* scline)
@@ -1617,6 +1620,7 @@ static void new_trap_type_check(const struct ScriptLine* scline)
     game.conf.trap_stats[i].shotvector.z = 0;
     trap_desc[i].name = trapst->code_name;
     trap_desc[i].num = i;
+    named_commands_changed();
     struct ManfctrConfig* mconf = &game.conf.traps_config[i];
     mconf->manufct_level = 0;
     mconf->manufct_required = 0;
@@ -3772,7 +3776,7 @@ static void set_creature_instance_process(struct ScriptContext *context)
         CrInstance old_instance = crstat->learned_instance_id[context->value->bytes[1] - 1];
         crstat->learned_instance_id[context->value->bytes[1] - 1] = context->value->bytes[2];
         crstat->learned_instance_level[context->value->bytes[1] - 1] = context->value->bytes[3];
-        for (short i = 0; i < THINGS_COUNT; i++)
+        for (long i = 0; i < game.thing_slots_count; i++)
         {
             struct Thing* thing = thing_get(i);
             if (thing_is_creature(thing))
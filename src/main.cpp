@@ -31,12 +31,14 @@
 #include "bflib_crash.h"
 #include "bflib_video.h"
 #include "bflib_vidraw.h"
+#include "bflib_render.h"
 #include "bflib_guibtns.h"
 #include "bflib_sound.h"
 #include "bflib_mouse.h"
 #include "bflib_filelst.h"
 #include "bflib_network.h"
 #include "bflib_planar.h"
+#include "bflib_threadpool.h"
 
 #include "custom_sprites.h"
 #include "version.h"
@@ -50,6 +52,7 @@
 #include "vidmode.h"
 #include "kjm_input.h"
 #include "packets.h"
+#include "net_sync.h"
 #include "config.h"
 #include "config_slabsets.h"
 #include "config_strings.h"
@@ -1119,10 +1122,18 @@ short setup_game(void)
     features_enabled |= Ft_SkipSplashScreens;
     features_enabled |= Ft_SkipHeartZoom;
   #endif
+  // Nobody would see the splash screens in headless mode
+  if (start_params.headless_replay)
+  {
+      features_enabled |= Ft_SkipSplashScreens;
+      features_enabled |= Ft_SkipHeartZoom;
+  }
 
   // Process CmdLine overrides
   process_cmdline_overrides();
 
+  LbThreadPoolInit(worker_threads_count);
+
   LbIKeyboardOpen();
 
   if (LbDataLoadAll(legal_load_files) != 0)
@@ -1634,6 +1645,7 @@ void reinit_level_after_load(void)
     player->lens_palette = 0;
     init_lookups();
     init_navigation();
+    rebuild_creature_buckets();
     reinit_packets_after_load();
     game.flags_font |= start_params.flags_font;
     parchment_loaded = 0;
@@ -1656,6 +1668,8 @@ void reinit_level_after_load(void)
     restore_computer_player_after_load();
     sound_reinit_after_load();
     music_reinit_after_load();
+    sync_hashes_reset();
+    prefetch_creature_pool_sprites();
 }
 
 /**
@@ -1691,7 +1705,9 @@ void clear_things_and_persons_data(void)
     long i;
     for (i=0; i < THINGS_COUNT; i++)
     {
-        thing = &game.things_data[i];
+        thing = game.things.lookup[i];
+        if (thing == NULL)
+            continue;
         memset(thing, 0, sizeof(struct Thing));
         thing->owner = PLAYERS_COUNT;
         thing->mappos.x.val = subtile_coord_center(gameadd.map_subtiles_x/2);
@@ -1699,7 +1715,10 @@ void clear_things_and_persons_data(void)
     }
     for (i=0; i < CREATURES_COUNT; i++)
     {
-      memset(&game.cctrl_data[i], 0, sizeof(struct CreatureControl));
+        struct CreatureControl* cctrl = game.persons.cctrl_lookup[i];
+        if (cctrl == NULL)
+            continue;
+        memset(cctrl, 0, sizeof(struct CreatureControl));
     }
 }
 
@@ -1775,10 +1794,7 @@ void delete_all_thing_structures(void)
           delete_thing_structure(thing, 1);
       }
     }
-    for (i=0; i < THINGS_COUNT-1; i++) {
-      game.free_things[i] = i+1;
-    }
-    game.free_things_start_index = 0;
+    reset_free_things_list();
 }
 
 void delete_all_structures(void)
@@ -2192,13 +2208,8 @@ void clear_lookups(void)
 {
     long i;
     SYNCDBG(8,"Starting");
-    for (i=0; i < THINGS_COUNT; i++)
-    {
-      game.things.lookup[i] = NULL;
-    }
-    game.things.end = NULL;
-
-    memset(&game.persons, 0, sizeof(struct Persons));
+    things_pool_free();
+    creature_controls_pool_free();
 
     for (i=0; i < COLUMNS_COUNT; i++)
     {
@@ -3537,6 +3548,57 @@ void keeper_gameplay_loop(void)
     SYNCDBG(0,"Gameplay loop finished after %lu turns",(unsigned long)game.play_gameturn);
 }
 
+/**
+ * Replays the packet file given in command line as fast as possible, without drawing,
+ * sound or waiting for the next turn; only the game logic is updated.
+ * @return True if all turns were loaded and verified against checksums stored in the file.
+ */
+TbBool headless_replay_loop(void)
+{
+    SYNCDBG(0,"Starting headless replay of \"%s\"",game.packet_fname);
+    faststartup_saved_packet_game();
+    if (!game.packet_fopened)
+    {
+        ERRORLOG("Headless replay: cannot load packet file \"%s\"",game.packet_fname);
+        return false;
+    }
+    clear_flag(game.operation_flags, GOF_Paused);
+    TbBool checksums_stored = game.packet_checksum_verify;
+    TbClockMSec start_time = LbTimerClock();
+    while ((!quit_game) && (!exit_keeper) && (game.pckt_gameturn < game.turns_stored))
+    {
+        // Packets are used as loaded; unlike get_packet_load_game_inputs(), there's no mouse to apply
+        load_packets_for_turn(game.pckt_gameturn);
+        game.pckt_gameturn++;
+        update();
+        if (game.turns_packetoff == game.play_gameturn)
+            break;
+    }
+    TbClockMSec elapsed = LbTimerClock() - start_time;
+    const struct PacketLoadStats *stats = get_packet_load_stats();
+    double turns_per_sec = (double)stats->turns_loaded * 1000.0 / (double)((elapsed > 0) ? elapsed : 1);
+    TbBool passed = checksums_stored && (stats->turns_skipped + stats->turns_loaded == game.turns_stored) && (stats->turns_out_of_sync == 0);
+    JUSTMSG("Headless replay: %lu of %lu turns in %lu ms, %.1f turns per second",
+        (unsigned long)stats->turns_loaded, (unsigned long)game.turns_stored, (unsigned long)elapsed, turns_per_sec);
+    if (!checksums_stored) {
+        JUSTMSG("Headless replay: FAIL, packet file has no checksums to verify");
+    } else
+    if (stats->turns_out_of_sync > 0) {
+        JUSTMSG("Headless replay: FAIL, %lu of %lu turns out of sync, first at turn %lu", (unsigned long)stats->turns_out_of_sync,
+            (unsigned long)stats->turns_verified, (unsigned long)stats->first_out_of_sync_turn);
+    } else
+    if (!passed) {
+        JUSTMSG("Headless replay: FAIL, replay ended before the last turn");
+    } else {
+        JUSTMSG("Headless replay: PASS, %lu turns verified", (unsigned long)stats->turns_verified);
+    }
+    printf("%s: %lu turns, %.1f turns/s, %lu out of sync\n", passed ? "PASS" : "FAIL",
+        (unsigned long)stats->turns_loaded, turns_per_sec, (unsigned long)stats->turns_out_of_sync);
+    close_packet_file();
+    game.packet_load_enable = false;
+    return passed;
+}
+
 TbBool can_thing_be_queried(struct Thing *thing, PlayerNumber plyr_idx)
 {
     if ( (!thing_is_creature(thing)) || !( (thing->owner == plyr_idx) || (creature_is_kept_in_custody_by_player(thing, plyr_idx)) ) || (thing->alloc_flags & TAlF_IsInLimbo) || (thing->state_flags & TF1_InCtrldLimbo) || (thing->active_state == CrSt_CreatureUnconscious) )
@@ -4084,6 +4146,18 @@ short process_command_line(unsigned short argc, char *argv[])
          set_flag(start_params.debug_flags, DFlg_ShowGameTurns | DFlg_FrameStep);
          narg++;
       } else
+      if (strcasecmp(parstr,"headless") == 0)
+      {
+         start_params.headless_replay = true;
+         start_params.no_intro = 1;
+         SoundDisabled = 1;
+         lbScreenHeadless = true;
+      } else
+      if (strcasecmp(parstr,"packetseek") == 0)
+      {
+         start_params.packet_seek_turn = atol(pr2str);
+         narg++;
+      } else
       if (strcasecmp(parstr,"packetsave") == 0)
       {
          if (start_params.packet_load_enable)
@@ -4115,6 +4189,11 @@ short process_command_line(unsigned short argc, char *argv[])
       {
           set_flag(start_params.debug_flags, DFlg_CreatrPaths);
       } else
+      if (strcasecmp(parstr, "capturetrigs") == 0)
+      {
+          trig_stream_capture_start(pr2str);
+          narg++;
+      } else
       if (strcasecmp(parstr, "show_game_turns") == 0)
       {
           set_flag(start_params.debug_flags, DFlg_ShowGameTurns);
@@ -4221,6 +4300,12 @@ short process_command_line(unsigned short argc, char *argv[])
       narg++;
   }
 
+  if ((start_params.headless_replay) && (!start_params.packet_load_enable))
+  {
+      ERRORLOG("The -headless mode requires a packet file given with -packetload.");
+      return -1;
+  }
+
   if (level_num == LEVELNUMBER_ERROR)
   {
       if (first_singleplayer_level() > 0)
@@ -4257,6 +4342,7 @@ short process_command_line(unsigned short argc, char *argv[])
 int LbBullfrogMain(unsigned short argc, char *argv[])
 {
     short retval;
+    int exit_code = 0;
     retval=0;
     LbErrorLogSetup("/", log_file_name, 5);
 
@@ -4319,9 +4405,18 @@ int LbBullfrogMain(unsigned short argc, char *argv[])
     }
     if ( retval )
     {
-        game_loop();
+        if (start_params.headless_replay)
+        {
+            if (!headless_replay_loop())
+                exit_code = 1;
+        } else
+        {
+            game_loop();
+        }
     }
     reset_game();
+    wait_for_saved_game_written();
+    LbThreadPoolFinish();
     LbScreenReset(true);
     if ( !retval )
     {
@@ -4333,7 +4428,7 @@ int LbBullfrogMain(unsigned short argc, char *argv[])
         SYNCDBG(0,"finished properly");
     }
     LbErrorLogClose();
-    return 0;
+    return exit_code;
 }
 
 void get_cmdln_args(unsigned short &argc, char *argv[])
@@ -4394,12 +4489,13 @@ LONG __stdcall Vex_handler(
 int main(int argc, char *argv[])
 {
   char *text;
+  int exit_code;
 
   AddVectoredExceptionHandler(0, &Vex_handler);
   get_cmdln_args(bf_argc, bf_argv);
 
   try {
-  LbBullfrogMain(bf_argc, bf_argv);
+  exit_code = LbBullfrogMain(bf_argc, bf_argv);
   } catch (...)
   {
       text = buf_sprintf("Exception raised!");
@@ -4415,7 +4511,7 @@ int main(int argc, char *argv[])
   }
 #endif
 
-  return 0;
+  return exit_code;
 }
 
 void update_time(void)
@@ -108,18 +108,15 @@ void init_lookups(void)
 {
     long i;
     SYNCDBG(8,"Starting");
-    for (i=0; i < THINGS_COUNT; i++)
-    {
-        game.things.lookup[i] = &game.things_data[i];
+    // Things and creature controls are in growable pools; slots in use need to be allocated
+    things_pool_update_lookups();
+    if (!things_pool_reserve(max(game.thing_slots_count, 1))) {
+        ERRORLOG("Cannot allocate memory for things");
     }
-    game.things.end = &game.things_data[THINGS_COUNT];
-
-    memset(&game.persons, 0, sizeof(struct Persons));
-    for (i=0; i < CREATURES_COUNT; i++)
-    {
-        game.persons.cctrl_lookup[i] = &game.cctrl_data[i];
+    creature_controls_pool_update_lookups();
+    if (!creature_controls_pool_reserve(max(game.cctrl_slots_count, 1))) {
+        ERRORLOG("Cannot allocate memory for creature controls");
     }
-    game.persons.cctrl_end = &game.cctrl_data[CREATURES_COUNT];
 
     for (i=0; i < COLUMNS_COUNT; i++)
     {
@@ -239,6 +236,8 @@ static void post_init_level(void)
     init_traps();
     init_all_creature_states();
     init_keepers_map_exploration();
+    sync_hashes_reset();
+    prefetch_creature_pool_sprites();
     SYNCDBG(9,"Finished");
 }
 
@@ -292,6 +291,9 @@ void startup_saved_packet_game(void)
         game.turns_fastforward = game.turns_stored;
     post_init_level();
     post_init_players();
+    // Start from a keyframe stored in the packet file, if there is one before the fast forward target
+    if (game.turns_fastforward > 0)
+        seek_packet_file_to_turn(game.turns_fastforward);
     set_selected_level_number(0);
     struct PlayerInfo* player = get_my_player();
     set_engine_view(player, rotate_mode_to_view_mode(game.packet_save_head.video_rotate_mode));
@@ -416,6 +418,8 @@ void clear_complete_game(void)
     memset(&game, 0, sizeof(struct Game));
     memset(&gameadd, 0, sizeof(struct GameAdd));
     memset(&intralvl, 0, sizeof(struct IntralevelData));
+    named_commands_changed();
+    invalidate_column_lookup();
     game.turns_packetoff = -1;
     game.local_plyr_idx = default_loc_player;
     game.packet_checksum_verify = start_params.packet_checksum_verify;
@@ -436,6 +440,7 @@ void clear_complete_game(void)
     snprintf(game.packet_fname,150, "%s", start_params.packet_fname);
     game.packet_save_enable = start_params.packet_save_enable;
     game.packet_load_enable = start_params.packet_load_enable;
+    game.turns_fastforward = start_params.packet_seek_turn;
     my_player_number = default_loc_player;
 }
 
@@ -723,8 +723,10 @@ void delete_column(ColumnIndex col_idx)
     game.columns_used--;
     struct Column *col;
     col = &game.columns_data[col_idx];
+    column_lookup_remove(col_idx);
     memcpy(col, &game.columns_data[0], sizeof(struct Column));
     col->use = 0;
+    column_lookup_add(col_idx);
 }
 
 void remove_block_from_map_element(MapSubtlCoord stl_x, MapSubtlCoord stl_y)
@@ -1611,7 +1613,7 @@ void dump_slab_on_map(SlabKind slbkind, long slabset_id, MapSubtlCoord stl_x, Ma
     }
 
     slb = get_slabmap_block(slb_x, slb_y);
-    slb->kind = slbkind;
+    slabmap_set_kind(slb, slbkind);
     panel_map_update(stl_xa, stl_ya, STL_PER_SLB, STL_PER_SLB);
     if (slab_kind_is_animated(slbkind) && !slab_kind_is_door(slbkind))
     {
@@ -1777,7 +1779,7 @@ void place_slab_type_on_map_f(SlabKind nslab, MapSubtlCoord stl_x, MapSubtlCoord
             all_players_untag_blocks_for_digging_in_area(slb_x, slb_y);
         }
     }
-    slb->kind = skind;
+    slabmap_set_kind(slb, skind);
 
     set_slab_owner(slb_x, slb_y, owner);
     place_single_slab_type_on_map(skind, slb_x, slb_y, owner);
@@ -1796,9 +1798,9 @@ void place_slab_type_on_map_f(SlabKind nslab, MapSubtlCoord stl_x, MapSubtlCoord
           if (slb->kind == SlbT_EARTH)
           {
               if (torch_flags_for_slab(spos_x, spos_y) == 0)
-                  slb->kind = SlbT_EARTH;
+                  slabmap_set_kind(slb, SlbT_EARTH);
               else
-                  slb->kind = SlbT_TORCHDIRT;
+                  slabmap_set_kind(slb, SlbT_TORCHDIRT);
           }
       }
     } else
@@ -1812,7 +1814,7 @@ void place_slab_type_on_map_f(SlabKind nslab, MapSubtlCoord stl_x, MapSubtlCoord
               continue;
           if (!slab_kind_is_animated(slb->kind))
           {
-              slb->kind = alter_rock_style(slb->kind, spos_x, spos_y, owner);
+              slabmap_set_kind(slb, alter_rock_style(slb->kind, spos_x, spos_y, owner));
           }
       }
     }
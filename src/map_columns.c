@@ -26,6 +26,22 @@
 #include "game_legacy.h"
 #include "post_inc.h"
 
+/** Amount of hash chains in the column lookup; has to be power of 2. */
+#define COLUMN_LOOKUP_HASH_SIZE 4096
+
+/**
+ * Columns of the same content are chained, from the lowest index.
+ * The lookup is outside of the game structure, so it is rebuilt whenever the columns are replaced.
+ */
+struct ColumnLookup {
+    TbBool valid;
+    ColumnIndex first[COLUMN_LOOKUP_HASH_SIZE];
+    /** Next column in the chain, or 0 at end of the chain; column 0 is never found. */
+    ColumnIndex next[COLUMNS_COUNT];
+};
+
+static struct ColumnLookup column_lookup;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -328,14 +344,87 @@ static TbBool column_is_equivalent(struct Column * const src, struct Column *dst
     return 0 == memcmp(src->cubes, dst->cubes, sizeof(src->cubes));
 }
 
+/**
+ * Returns hash of the column parts which are compared by column_is_equivalent().
+ */
+static unsigned long column_content_hash(const struct Column *col)
+{
+    unsigned long hash = 2166136261u;
+    hash = (hash ^ col->floor_texture) * 16777619u;
+    hash = (hash ^ col->solidmask) * 16777619u;
+    hash = (hash ^ col->orient) * 16777619u;
+    for (int i = 0; i < COLUMN_STACK_HEIGHT; i++)
+        hash = (hash ^ col->cubes[i]) * 16777619u;
+    return (hash ^ (hash >> 16)) & (COLUMN_LOOKUP_HASH_SIZE - 1);
+}
+
+/**
+ * Marks the column lookup as outdated; it will be rebuilt by next find_column().
+ * Needs to be called after columns were changed other than by create_column() or delete_column().
+ */
+void invalidate_column_lookup(void)
+{
+    column_lookup.valid = false;
+}
+
+static void rebuild_column_lookup(void)
+{
+    for (int i = 0; i < COLUMN_LOOKUP_HASH_SIZE; i++)
+        column_lookup.first[i] = 0;
+    // Adding from the end makes every chain start with the lowest index
+    for (ColumnIndex i = COLUMNS_COUNT-1; i > 0; i--)
+    {
+        unsigned long hash = column_content_hash(get_column(i));
+        column_lookup.next[i] = column_lookup.first[hash];
+        column_lookup.first[hash] = i;
+    }
+    column_lookup.valid = true;
+}
+
+/**
+ * Removes column from the lookup; to be called before changing content of the column.
+ */
+void column_lookup_remove(ColumnIndex col_idx)
+{
+    if (!column_lookup.valid)
+        return;
+    ColumnIndex *prev = &column_lookup.first[column_content_hash(get_column(col_idx))];
+    while ((*prev != 0) && (*prev != col_idx))
+        prev = &column_lookup.next[*prev];
+    if (*prev == 0)
+    {
+        // Column was changed without updating the lookup
+        invalidate_column_lookup();
+        return;
+    }
+    *prev = column_lookup.next[col_idx];
+}
+
+/**
+ * Adds column to the lookup; to be called after changing content of the column.
+ */
+void column_lookup_add(ColumnIndex col_idx)
+{
+    if (!column_lookup.valid)
+        return;
+    ColumnIndex *prev = &column_lookup.first[column_content_hash(get_column(col_idx))];
+    while ((*prev != 0) && (*prev < col_idx))
+        prev = &column_lookup.next[*prev];
+    column_lookup.next[col_idx] = *prev;
+    *prev = col_idx;
+}
+
+/**
+ * Returns index of the first column with the same content, or 0 if there's none.
+ */
 long find_column(struct Column *srccol)
 {
-    int i;
-    for (i=1; i < COLUMNS_COUNT; i++) {
-        struct Column *col;
-        col = get_column(i);
-        if (column_is_equivalent(srccol, col)) {
-          return i;
+    if (!column_lookup.valid)
+        rebuild_column_lookup();
+    for (ColumnIndex i = column_lookup.first[column_content_hash(srccol)]; i != 0; i = column_lookup.next[i])
+    {
+        if (column_is_equivalent(srccol, get_column(i))) {
+            return i;
         }
     }
     return 0;
@@ -362,9 +451,11 @@ long create_column(struct Column *col)
         }
     }
     // Copy data
+    column_lookup_remove(result);
     memcpy(dst, col, sizeof(struct Column));
     // Create cubemask
     make_solidmask(dst);
+    column_lookup_add(result);
 
     // Find lowest cube
     for (v6 = 0; v6 < COLUMN_STACK_HEIGHT;v6++)
@@ -428,6 +519,7 @@ void clear_columns(void)
   {
     game.col_static_entries[i] = 0;
   }
+  invalidate_column_lookup();
 }
 
 void init_columns(void)
@@ -486,6 +578,8 @@ void init_columns(void)
             }
         }
     }
+    // Solid masks were remade
+    invalidate_column_lookup();
 }
 
 void init_whole_blocks(void)
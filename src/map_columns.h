@@ -71,6 +71,9 @@ void clear_columns(void);
 void init_columns(void);
 long find_column(struct Column *col);
 long create_column(struct Column *col);
+void invalidate_column_lookup(void);
+void column_lookup_remove(ColumnIndex col_idx);
+void column_lookup_add(ColumnIndex col_idx);
 unsigned short find_column_height(struct Column *col);
 void init_whole_blocks(void);
 void init_top_texture_to_cube_table(void);
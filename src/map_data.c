@@ -29,6 +29,7 @@
 #include "map_blocks.h"
 #include "map_utils.h"
 #include "room_util.h"
+#include "thing_list.h"
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -558,6 +559,7 @@ void clear_mapwho(void)
             mapblk->mapwho = 0;
         }
   }
+  clear_creature_buckets();
 }
 
 void clear_mapmap(void)
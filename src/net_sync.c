@@ -22,6 +22,7 @@
 #include "globals.h"
 #include "bflib_basics.h"
 #include "bflib_fileio.h"
+#include "bflib_memory.h"
 #include "bflib_network.h"
 
 #include "config.h"
@@ -31,6 +32,10 @@
 #include "game_merge.h"
 #include "net_game.h"
 #include "lens_api.h"
+#include "light_data.h"
+#include "dungeon_data.h"
+#include "slab_data.h"
+#include "thing_data.h"
 #include "game_legacy.h"
 #include "keeperfx.hpp"
 #include "frontend.h"
@@ -65,6 +70,60 @@ struct Boing {
 /** Structure used for storing 'localised parameters' when resyncing net game. */
 struct Boing boing;
 /******************************************************************************/
+/**
+ * Exchanges the used parts of things and creature controls pools.
+ * The pools are outside of game structure, so they're synchronized after it -
+ * sizes of the pools are then already known to all players.
+ */
+static TbBool resync_things_pools(void)
+{
+    // Lookup arrays came within game structure from another machine
+    init_lookups();
+    things_pool_clear_unavailable();
+    creature_controls_pool_clear_unavailable();
+    long things_chunks = (game.thing_slots_count + THINGS_POOL_CHUNK - 1) / THINGS_POOL_CHUNK;
+    long cctrl_chunks = (game.cctrl_slots_count + CREATURES_POOL_CHUNK - 1) / CREATURES_POOL_CHUNK;
+    struct NetResyncArea* areas = (struct NetResyncArea*)LbMemoryAlloc((things_chunks + cctrl_chunks + 1) * sizeof(struct NetResyncArea));
+    if (areas == NULL)
+        return false;
+    int count = 0;
+    for (long i = 0; i < game.thing_slots_count; i += THINGS_POOL_CHUNK)
+    {
+        areas[count].buf = game.things.lookup[i];
+        areas[count].len = min(THINGS_POOL_CHUNK, game.thing_slots_count - i) * sizeof(struct Thing);
+        count++;
+    }
+    for (long i = 0; i < game.cctrl_slots_count; i += CREATURES_POOL_CHUNK)
+    {
+        areas[count].buf = game.persons.cctrl_lookup[i];
+        areas[count].len = min(CREATURES_POOL_CHUNK, game.cctrl_slots_count - i) * sizeof(struct CreatureControl);
+        count++;
+    }
+    TbBool result = LbNetwork_ResyncAreas(areas, count);
+    LbMemoryFree(areas);
+    return result;
+}
+
+/**
+ * Exchanges the game structures. Only parts which differ between players are sent.
+ */
+static TbBool resync_game_structures(void)
+{
+    struct NetResyncArea areas[2];
+    areas[0].buf = &game;
+    areas[0].len = sizeof(struct Game);
+    areas[1].buf = &gameadd;
+    areas[1].len = sizeof(struct GameAdd);
+    // Lights are outside of structs; make sure the state within gameadd is up to date
+    light_export_system_state(&gameadd.lightst);
+    if (!LbNetwork_ResyncAreas(areas, sizeof(areas)/sizeof(areas[0])))
+        return false;
+    named_commands_changed();
+    invalidate_column_lookup();
+    light_import_system_state(&gameadd.lightst);
+    return resync_things_pools();
+}
+
 long get_resync_sender(void)
 {
     for (int i = 0; i < NET_PLAYERS_COUNT; i++)
@@ -78,26 +137,14 @@ long get_resync_sender(void)
 
 TbBool send_resync_game(void)
 {
-  //TODO NET see if it is necessary to dump to file... probably superfluous
-  char* fname = prepare_file_path(FGrp_Save, "resync.dat");
-  TbFileHandle fh = LbFileOpen(fname, Lb_FILE_MODE_NEW);
-  if (fh == -1)
-  {
-    ERRORLOG("Can't open resync file.");
-    return false;
-  }
-
-  LbFileWrite(fh, &game, sizeof(game));
-  LbFileClose(fh);
-
-  NETLOG("Initiating re-synchronization of network game");
-  return LbNetwork_Resync(&game, sizeof(game));
+    NETLOG("Initiating re-synchronization of network game");
+    return resync_game_structures();
 }
 
 TbBool receive_resync_game(void)
 {
     NETLOG("Initiating re-synchronization of network game");
-    return LbNetwork_Resync(&game, sizeof(game));
+    return resync_game_structures();
 }
 
 void store_localised_game_structure(void)
@@ -159,6 +206,9 @@ void resync_game(void)
     {
         receive_resync_game();
     }
+    // Input scheduled before the resync was gathered in the old state, and its checksums come from it
+    if (!LbNetwork_RestartScheduled())
+        ERRORLOG("Cannot restart scheduled exchange after resync");
     recall_localised_game_structure();
     reinit_level_after_load();
     clear_flag(game.system_flags, GSF_NetGameNoSync);
@@ -173,7 +223,7 @@ CoroutineLoopState perform_checksum_verification(CoroutineLoop *con)
 {
     short result = true;
     unsigned long checksum_mem = 0;
-    for (int i = 1; i < THINGS_COUNT; i++)
+    for (int i = 1; i < game.thing_slots_count; i++)
     {
         struct Thing* thing = thing_get(i);
         if (thing_exists(thing)) {
@@ -286,6 +336,188 @@ short checksums_different()
     return false;
 }
 
+/**
+ * Hashes of game subsystems. Unlike the packet checksum, which is a sum over the whole
+ * game, they're kept separately, so that a desync can be tracked to the subsystem
+ * where it started.
+ */
+struct SyncHashes {
+    /** Sums gathered within the current turn. */
+    TbBigChecksum turn_sums[CKS_MAX];
+    /** Turn sums folded together since level start or last resync. */
+    TbBigChecksum rolling[CKS_MAX];
+    /** Turn on which a mismatch of every hash was found, to report it only once. */
+    GameTurn mismatch_turn[CKS_MAX];
+};
+
+static struct SyncHashes sync_hashes;
+
+static const char *checksum_kind_names[CKS_MAX] = {
+    "action seed", "players", "creatures of player 0", "creatures of player 1",
+    "creatures of player 2", "creatures of player 3", "heroes", "neutral creatures",
+    "things", "effects", "rooms", "dungeons", "slabs", "lights",
+};
+
+static TbBigChecksum sync_hash_mix(TbBigChecksum hash, TbBigChecksum val)
+{
+    hash ^= val + 0x9E3779B9UL + (hash << 6) + (hash >> 2);
+    return hash & 0xFFFFFFFFUL;
+}
+
+static TbBigChecksum slab_sync_hash(const struct SlabMap *slb)
+{
+    TbBigChecksum slb_num = slb - game.slabmap;
+    return sync_hash_mix(slb_num * 0x85EBCA6BUL, ((TbBigChecksum)slb->kind << 8) | (unsigned char)slb->owner);
+}
+
+static TbBigChecksum light_sync_hash(const struct Light *lgt)
+{
+    TbBigChecksum hash = sync_hash_mix(lgt->index * 0x85EBCA6BUL, lgt->mappos.x.val);
+    hash = sync_hash_mix(hash, lgt->mappos.y.val);
+    return sync_hash_mix(hash, lgt->mappos.z.val);
+}
+
+/**
+ * Computes checksum of current state of all dungeons.
+ */
+TbBigChecksum compute_dungeons_checksum(void)
+{
+    TbBigChecksum sum = 0;
+    for (int i = 0; i < DUNGEONS_COUNT; i++)
+    {
+        struct Dungeon* dungeon = get_dungeon(i);
+        if (dungeon_invalid(dungeon))
+            continue;
+        sum += (TbBigChecksum)dungeon->total_money_owned + (TbBigChecksum)dungeon->num_active_creatrs
+            + ((TbBigChecksum)dungeon->num_active_diggers << 8) + ((TbBigChecksum)dungeon->total_rooms << 16)
+            + (TbBigChecksum)dungeon->total_area + (TbBigChecksum)dungeon->research_num;
+    }
+    return sum;
+}
+
+/**
+ * Adds given value to sync hash of a subsystem, for current turn.
+ */
+void sync_hash_add(enum ChecksumKind kind, TbBigChecksum sum)
+{
+    sync_hashes.turn_sums[kind] += sum;
+}
+
+enum ChecksumKind get_thing_checksum_kind(const struct Thing *thing)
+{
+    switch (thing->class_id)
+    {
+    case TCls_Creature:
+        if (thing->owner == game.hero_player_num)
+            return CKS_Creatures_5;
+        if (thing->owner == game.neutral_player_num)
+            return CKS_Creatures_6;
+        return CKS_Creatures_1 + (thing->owner % 4);
+    case TCls_Effect:
+    case TCls_EffectElem:
+    case TCls_EffectGen:
+        return CKS_Effects;
+    default:
+        return CKS_Things;
+    }
+}
+
+/**
+ * Removes slab from the slabs hash, or adds it back. Should be called before and after
+ * changing kind or owner of the slab, so that the hash doesn't have to be recomputed.
+ */
+void sync_hash_toggle_slab(const struct SlabMap *slb)
+{
+    sync_hashes.rolling[CKS_Slabs] ^= slab_sync_hash(slb);
+}
+
+/**
+ * Removes light from the lights hash, or adds it back. Should be called before and after
+ * changing position of the light, and when the light is created or deleted.
+ */
+void sync_hash_toggle_light(const struct Light *lgt)
+{
+    sync_hashes.rolling[CKS_Lights] ^= light_sync_hash(lgt);
+}
+
+/**
+ * Clears the sync hashes and computes the ones which reflect current state.
+ * Should be called at the same moment by all players, as after that their hashes are compared.
+ */
+void sync_hashes_reset(void)
+{
+    LbMemorySet(&sync_hashes, 0, sizeof(sync_hashes));
+    for (SlabCodedCoords slb_num = 0; slb_num < gameadd.map_tiles_x * gameadd.map_tiles_y; slb_num++)
+    {
+        sync_hash_toggle_slab(&game.slabmap[slb_num]);
+    }
+    for (long i = 1; i < LIGHTS_COUNT; i++)
+    {
+        struct Light* lgt = &game.lish.lights[i];
+        if ((lgt->flags & LgtF_Allocated) != 0)
+            sync_hash_toggle_light(lgt);
+    }
+}
+
+/**
+ * Folds sums of the finished turn into sync hashes, and puts one of the hashes into the packet.
+ * Only one hash is sent every turn, so they are all compared once in CKS_MAX turns.
+ */
+void sync_hashes_fill_packet(struct Packet *pckt)
+{
+    for (int kind = 0; kind < CKS_MAX; kind++)
+    {
+        // Slabs and lights are updated on every change of their state
+        if ((kind == CKS_Slabs) || (kind == CKS_Lights))
+            continue;
+        sync_hashes.rolling[kind] = sync_hash_mix(sync_hashes.rolling[kind], sync_hashes.turn_sums[kind]);
+        sync_hashes.turn_sums[kind] = 0;
+    }
+    sync_hashes.rolling[CKS_Action] = sync_hash_mix(sync_hashes.rolling[CKS_Action], game.action_rand_seed);
+    int kind = game.play_gameturn % CKS_MAX;
+    pckt->sync_hash = (sync_hashes.rolling[kind] & ~0x0FUL) | kind;
+}
+
+/**
+ * Compares sync hashes in packets of all human players, and logs subsystems which differ.
+ * @return Returns true if all compared hashes were the same.
+ */
+TbBool sync_hashes_verify(void)
+{
+    struct Packet* first_pckt = NULL;
+    int first_plyr = -1;
+    for (int i = 0; i < PLAYERS_COUNT; i++)
+    {
+        struct PlayerInfo* player = get_player(i);
+        if (!player_exists(player) || ((player->allocflags & PlaF_CompCtrl) != 0))
+            continue;
+        struct Packet* pckt = get_packet_direct(player->packet_num);
+        if (first_pckt == NULL)
+        {
+            first_pckt = pckt;
+            first_plyr = i;
+            continue;
+        }
+        if (pckt->sync_hash == first_pckt->sync_hash)
+            continue;
+        int kind = first_pckt->sync_hash & 0x0F;
+        if ((kind >= CKS_MAX) || (sync_hashes.mismatch_turn[kind] != 0))
+            return false;
+        sync_hashes.mismatch_turn[kind] = game.play_gameturn;
+        ERRORLOG("Desync of %s found on turn %lu: player %d has %08x, player %d has %08x", checksum_kind_names[kind],
+            (unsigned long)game.play_gameturn, first_plyr, first_pckt->sync_hash, i, pckt->sync_hash);
+        for (kind = 0; kind < CKS_MAX; kind++)
+        {
+            if (sync_hashes.mismatch_turn[kind] != 0)
+                NETLOG("  %-24s first differed on turn %lu", checksum_kind_names[kind], (unsigned long)sync_hashes.mismatch_turn[kind]);
+            else
+                NETLOG("  %-24s %08lx", checksum_kind_names[kind], (unsigned long)sync_hashes.rolling[kind]);
+        }
+        return false;
+    }
+    return true;
+}
+
 TbBigChecksum get_thing_checksum(const struct Thing* thing)
 {
     SYNCDBG(18, "Starting");
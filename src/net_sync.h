@@ -22,6 +22,7 @@
 #include "globals.h"
 #include "bflib_basics.h"
 #include "bflib_coroutine.h"
+#include "packets.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,10 +33,24 @@ extern "C" {
 
 
 #pragma pack()
+/******************************************************************************/
+struct Thing;
+struct SlabMap;
+struct Light;
+
 /******************************************************************************/
 void resync_game(void);
 CoroutineLoopState perform_checksum_verification(CoroutineLoop *con);
 
+TbBigChecksum compute_dungeons_checksum(void);
+void sync_hash_add(enum ChecksumKind kind, TbBigChecksum sum);
+enum ChecksumKind get_thing_checksum_kind(const struct Thing *thing);
+void sync_hash_toggle_slab(const struct SlabMap *slb);
+void sync_hash_toggle_light(const struct Light *lgt);
+void sync_hashes_reset(void);
+void sync_hashes_fill_packet(struct Packet *pckt);
+TbBool sync_hashes_verify(void);
+
 /******************************************************************************/
 #ifdef __cplusplus
 }
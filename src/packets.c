@@ -265,7 +265,7 @@ TbBigChecksum get_thing_simple_checksum(const struct Thing *tng)
   TbBigChecksum get_packet_save_checksum(void)
   {
       TbBigChecksum sum = 0;
-      for (long tng_idx = 0; tng_idx < THINGS_COUNT; tng_idx++)
+      for (long tng_idx = 0; tng_idx < game.thing_slots_count; tng_idx++)
       {
           struct Thing* tng = thing_get(tng_idx);
           if ((tng->alloc_flags & TAlF_Exists) != 0)
@@ -1446,6 +1446,8 @@ void process_packets(void)
     SYNCDBG(5, "Starting");
     // Do the network data exchange
     lbDisplay.DrawColour = colours[15][15][15];
+    player = get_my_player();
+    sync_hashes_fill_packet(get_packet_direct(player->packet_num));
     // Exchange packets with the network
     if (game.game_kind != GKind_LocalGame)
     {
@@ -1459,9 +1461,9 @@ void process_packets(void)
         if (!game.packet_load_enable || game.numfield_149F47)
         {
             struct Packet* pckt = get_packet_direct(player->packet_num);
-            if (LbNetwork_Exchange(pckt, game.packets, sizeof(struct Packet)) != 0)
+            if (LbNetwork_ExchangeScheduled(pckt, game.packets, sizeof(struct Packet)) != 0)
             {
-                ERRORLOG("LbNetwork_Exchange failed");
+                ERRORLOG("LbNetwork_ExchangeScheduled failed");
             }
         }
         replace_with_ai(old_active_players);
@@ -1486,6 +1488,9 @@ void process_packets(void)
       clear_flag(game.system_flags, GSF_NetSeedNoSync);
     break;
   }
+  // Find which subsystem went out of sync, if any
+  if (game.game_kind != GKind_LocalGame)
+      sync_hashes_verify();
   // Write packets into file, if requested
   if ((game.packet_save_enable) && (game.packet_fopened))
     save_packets();
@@ -228,9 +228,15 @@ enum ChecksumKind {
     CKS_Things, //Objects, Traps, Shots etc
     CKS_Effects,
     CKS_Rooms,
-    CKS_MAX
+    CKS_Dungeons,
+    CKS_Slabs,
+    CKS_Lights,
+    CKS_MAX // Sync hash of a packet keeps kind in 4 bits, so there can't be more than 16
 };
 
+/** Amount of checksums stored for every player in packet file; doesn't grow with ChecksumKind, to keep the file format. */
+#define PACKET_FILE_CHECKSUMS_COUNT 11
+
 #define PCtr_LBtnAnyAction (PCtr_LBtnClick | PCtr_LBtnHeld | PCtr_LBtnRelease)
 #define PCtr_RBtnAnyAction (PCtr_RBtnClick | PCtr_RBtnHeld | PCtr_RBtnRelease)
 #define PCtr_HeldAnyButton (PCtr_LBtnHeld | PCtr_RBtnHeld)
@@ -249,7 +255,7 @@ extern unsigned long start_seed;
  * Stores data exchanged between players each turn and used to re-create their input.
  */
 struct Packet {
-    int field_0;
+    unsigned int sync_hash; //! Rolling hash of one of game subsystems, with the ChecksumKind in lowest bits
     TbChecksum chksum; //! Checksum of all things within the game and synchronized random seed
     unsigned char action; //! Action kind performed by the player which owns this packet
     long actn_par1; //! Players action parameter #1
@@ -280,10 +286,20 @@ struct PacketSaveHead {
 struct PacketEx
 {
     struct Packet packet;
-    TbBigChecksum sums[CKS_MAX];
+    TbBigChecksum sums[PACKET_FILE_CHECKSUMS_COUNT];
 };
 
 #pragma pack()
+
+/** Results of checksum verification while loading a packet file. */
+struct PacketLoadStats {
+    /** Turns not loaded because replay started from a keyframe. */
+    GameTurn turns_skipped;
+    GameTurn turns_loaded;
+    GameTurn turns_verified;
+    GameTurn turns_out_of_sync;
+    GameTurn first_out_of_sync_turn;
+};
 /******************************************************************************/
 /******************************************************************************/
 struct Packet *get_packet_direct(long pckt_idx);
@@ -316,8 +332,10 @@ void post_init_packets(void);
 TbBool open_new_packet_file_for_save(void);
 void load_packets_for_turn(GameTurn nturn);
 TbBool open_packet_file_for_load(char *fname, struct CatalogueEntry *centry);
+const struct PacketLoadStats *get_packet_load_stats(void);
 short save_packets(void);
 void close_packet_file(void);
+TbBool seek_packet_file_to_turn(GameTurn nturn);
 TbBool reinit_packets_after_load(void);
 struct Room *keeper_build_room(long stl_x,long stl_y,long plyr_idx,long rkind);
 TbBool player_sell_room_at_subtile(long plyr_idx, long stl_x, long stl_y);
@@ -19,6 +19,8 @@
 #include "pre_inc.h"
 #include "packets.h"
 
+#include "bflib_datetm.h"
+#include "bflib_dernc.h"
 #include "bflib_fileio.h"
 #include "bflib_memory.h"
 #include "front_landview.h"
@@ -26,6 +28,12 @@
 #include "game_saves.h"
 #include "gui_topmsg.h"
 #include "config_settings.h"
+#include "config.h"
+#include "keeperfx.hpp"
+#include "light_data.h"
+
+#include <SDL2/SDL.h>
+#include <zlib.h>
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -33,8 +41,85 @@ extern "C" {
 #endif
 /******************************************************************************/
 #define PACKET_TURN_SIZE (NET_PLAYERS_COUNT*sizeof(struct PacketEx) + sizeof(TbBigChecksum))
+/** Amount of turns buffered before they're written into the packet file as one chunk. */
+#define PACKET_TURNS_BATCH 64
+/** Amount of turns between game state keyframes stored in the packet file. */
+#define PACKET_KEYFRAME_INTERVAL 1000
+
+/**
+ * Entry of the packet file index; one for every chunk written after the PacketData marker.
+ */
+struct PacketFileIndexItem {
+    unsigned long id;
+    /** First turn in a turns chunk, or the turn a keyframe was made before. */
+    unsigned long turn;
+    /** Amount of turns in a turns chunk, or unpacked size of a keyframe. */
+    unsigned long count;
+    /** Position of the chunk header in file. */
+    unsigned long offset;
+};
+
+/**
+ * State of the opened packet file, which is not stored in the Game structure.
+ */
+struct PacketFileState {
+    unsigned long version;
+    struct PacketFileIndexItem *index;
+    unsigned long index_count;
+    unsigned long index_alloc;
+    /** Position of the first chunk after the PacketData marker. */
+    unsigned long data_pos;
+    /** Buffered turns; when saving these are not written yet, when loading it's the last chunk read. */
+    unsigned char batch[PACKET_TURNS_BATCH*PACKET_TURN_SIZE];
+    unsigned long batch_first_turn;
+    unsigned long batch_turns;
+    /** Amount of turns written or buffered for writing. */
+    unsigned long turns_saved;
+};
+
+/**
+ * Keyframe which is compressed and appended to the packet file by a background thread.
+ */
+struct PacketKeyframeJob {
+    SDL_Thread *thread;
+    TbFileHandle fhandle;
+    /** Turn of the packet file which comes after the keyframe. */
+    unsigned long turn;
+    /** Game state chunks, as stored by save_game_state_to_buffer(). */
+    unsigned char *raw;
+    unsigned long raw_len;
+    unsigned long packed_len;
+    /** Position of the keyframe chunk in file, known when it's written. */
+    unsigned long offset;
+    TbBool done;
+};
+
+/**
+ * Fields of the Game structure which describe the replay itself, and have to survive loading a keyframe.
+ */
+struct PacketReplayState {
+    unsigned char packet_save_enable;
+    unsigned char packet_load_enable;
+    char packet_fname[150];
+    char packet_fopened;
+    TbFileHandle packet_save_fp;
+    struct PacketSaveHead packet_save_head;
+    unsigned long turns_stored;
+    unsigned char numfield_149F38;
+    unsigned char packet_checksum_verify;
+    unsigned long log_things_start_turn;
+    unsigned long log_things_end_turn;
+    unsigned long turns_packetoff;
+    PlayerNumber local_plyr_idx;
+    unsigned char numfield_149F47;
+    enum GameKinds game_kind;
+};
+
 struct Packet bad_packet;
 unsigned long start_seed;
+static struct PacketLoadStats packet_load_stats;
+static struct PacketFileState packet_file;
+static struct PacketKeyframeJob packet_keyframe_job;
 /******************************************************************************/
 #ifdef __cplusplus
 }
@@ -122,6 +207,400 @@ void clear_packets(void)
     }
 }
 
+/******************************************************************************/
+static void packet_file_reset(void)
+{
+    if (packet_file.index != NULL)
+        LbMemoryFree(packet_file.index);
+    LbMemorySet(&packet_file, 0, sizeof(packet_file));
+}
+
+static TbBool packet_file_index_add(unsigned long id, unsigned long turn, unsigned long count, unsigned long offset)
+{
+    if (packet_file.index_count >= packet_file.index_alloc)
+    {
+        unsigned long nalloc = (packet_file.index_alloc > 0) ? 2 * packet_file.index_alloc : 256;
+        struct PacketFileIndexItem* nindex = (struct PacketFileIndexItem*)LbMemoryGrow(packet_file.index,
+            nalloc * sizeof(struct PacketFileIndexItem));
+        if (nindex == NULL)
+        {
+            ERRORLOG("Cannot grow packet file index to %lu items", nalloc);
+            return false;
+        }
+        packet_file.index = nindex;
+        packet_file.index_alloc = nalloc;
+    }
+    struct PacketFileIndexItem* item = &packet_file.index[packet_file.index_count];
+    item->id = id;
+    item->turn = turn;
+    item->count = count;
+    item->offset = offset;
+    packet_file.index_count++;
+    return true;
+}
+
+/**
+ * Gives index of the last item of given chunk kind which starts at or before given turn.
+ * @return Index item number, or -1 if there's no such item.
+ */
+static long packet_file_index_find(unsigned long id, unsigned long nturn)
+{
+    // Chunks are written in order of turns, so the index is sorted
+    long lo = 0;
+    long hi = packet_file.index_count;
+    while (lo < hi)
+    {
+        long mid = (lo + hi) / 2;
+        if (packet_file.index[mid].turn <= nturn)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (long i = lo - 1; i >= 0; i--)
+    {
+        if (packet_file.index[i].id == id)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * Compresses the keyframe and appends it to the packet file.
+ * Doesn't touch any game structures, so it can run while the game goes on; nothing else
+ * may write into the packet file until packet_file_keyframe_wait() returns.
+ */
+static int packet_file_keyframe_writer(void *data)
+{
+    struct PacketKeyframeJob* job = (struct PacketKeyframeJob*)data;
+    struct FileChunkHeader hdr;
+    unsigned long head[2];
+    uLongf packed_len = compressBound(job->raw_len);
+    unsigned char* packed = LbMemoryAlloc(packed_len);
+    job->done = (packed != NULL) && (compress2(packed, &packed_len, job->raw, job->raw_len, Z_BEST_SPEED) == Z_OK);
+    if (job->done)
+    {
+        head[0] = job->turn;
+        head[1] = job->raw_len;
+        hdr.id = SGC_PacketKeyframe;
+        hdr.ver = 0;
+        hdr.len = sizeof(head) + packed_len;
+        LbFileSeek(job->fhandle, 0, Lb_FILE_SEEK_END);
+        job->offset = LbFilePosition(job->fhandle);
+        job->packed_len = packed_len;
+        job->done = (LbFileWrite(job->fhandle, &hdr, sizeof(hdr)) == sizeof(hdr))
+            && (LbFileWrite(job->fhandle, head, sizeof(head)) == sizeof(head))
+            && (LbFileWrite(job->fhandle, packed, packed_len) == (long)packed_len);
+    }
+    if (packed != NULL)
+        LbMemoryFree(packed);
+    LbMemoryFree(job->raw);
+    job->raw = NULL;
+    return job->done;
+}
+
+/**
+ * Waits until the keyframe which is written in background is finished, and adds it to the index.
+ */
+static TbBool packet_file_keyframe_wait(void)
+{
+    struct PacketKeyframeJob* job = &packet_keyframe_job;
+    if (job->thread == NULL)
+        return true;
+    SDL_WaitThread(job->thread, NULL);
+    job->thread = NULL;
+    if (!job->done)
+    {
+        WARNLOG("Cannot store keyframe for turn %lu in packet file",job->turn);
+        return false;
+    }
+    packet_file_index_add(SGC_PacketKeyframe, job->turn, job->raw_len, job->offset);
+    SYNCDBG(7,"Keyframe for turn %lu stored, %lu bytes packed into %lu",job->turn,job->raw_len,job->packed_len);
+    return true;
+}
+
+/**
+ * Writes buffered turns into the packet file, as one chunk.
+ */
+static TbBool packet_file_write_turns(void)
+{
+    struct FileChunkHeader hdr;
+    unsigned long head[2];
+    // Keyframe written in background goes before these turns
+    packet_file_keyframe_wait();
+    if (packet_file.batch_turns == 0)
+        return true;
+    long len = packet_file.batch_turns * PACKET_TURN_SIZE;
+    head[0] = packet_file.batch_first_turn;
+    head[1] = packet_file.batch_turns;
+    packet_file.batch_turns = 0;
+    hdr.id = SGC_PacketTurns;
+    hdr.ver = 0;
+    hdr.len = sizeof(head) + len;
+    LbFileSeek(game.packet_save_fp, 0, Lb_FILE_SEEK_END);
+    unsigned long offset = LbFilePosition(game.packet_save_fp);
+    if ((LbFileWrite(game.packet_save_fp, &hdr, sizeof(hdr)) != sizeof(hdr))
+     || (LbFileWrite(game.packet_save_fp, head, sizeof(head)) != sizeof(head))
+     || (LbFileWrite(game.packet_save_fp, packet_file.batch, len) != len))
+    {
+        ERRORLOG("Packet file write error");
+        return false;
+    }
+    packet_file_index_add(SGC_PacketTurns, head[0], head[1], offset);
+    if ( !LbFileFlush(game.packet_save_fp) )
+    {
+        ERRORLOG("Unable to flush PacketSave File");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Stores current game state into the packet file, as a compressed keyframe.
+ * The state is copied into memory at once; it's compressed and written by a background thread.
+ * @param nturn Turn of the packet file which comes after the keyframe.
+ */
+static TbBool packet_file_write_keyframe(unsigned long nturn)
+{
+    struct PacketKeyframeJob* job = &packet_keyframe_job;
+    packet_file_keyframe_wait();
+    job->raw = save_game_state_to_buffer(&job->raw_len);
+    if (job->raw == NULL)
+    {
+        WARNLOG("Cannot store keyframe for turn %lu in packet file",nturn);
+        return false;
+    }
+    job->fhandle = game.packet_save_fp;
+    job->turn = nturn;
+    job->done = false;
+    job->thread = SDL_CreateThread(packet_file_keyframe_writer, "KeyframeWriter", job);
+    if (job->thread == NULL)
+    {
+        // No thread, so the keyframe is written at once
+        packet_file_keyframe_writer(job);
+        if (!job->done)
+        {
+            WARNLOG("Cannot store keyframe for turn %lu in packet file",nturn);
+            return false;
+        }
+        packet_file_index_add(SGC_PacketKeyframe, job->turn, job->raw_len, job->offset);
+    }
+    return true;
+}
+
+/**
+ * Writes the index of all chunks at end of the packet file.
+ * The index chunk ends with its own size, so it can be found by reading the last bytes of the file.
+ */
+static TbBool packet_file_write_index(void)
+{
+    struct FileChunkHeader hdr;
+    unsigned long items_len = packet_file.index_count * sizeof(struct PacketFileIndexItem);
+    unsigned long total_len = sizeof(hdr) + items_len + sizeof(unsigned long);
+    hdr.id = SGC_PacketIndex;
+    hdr.ver = 0;
+    hdr.len = items_len + sizeof(unsigned long);
+    LbFileSeek(game.packet_save_fp, 0, Lb_FILE_SEEK_END);
+    if ((LbFileWrite(game.packet_save_fp, &hdr, sizeof(hdr)) != sizeof(hdr))
+     || ((items_len > 0) && (LbFileWrite(game.packet_save_fp, packet_file.index, items_len) != (long)items_len))
+     || (LbFileWrite(game.packet_save_fp, &total_len, sizeof(total_len)) != sizeof(total_len)))
+    {
+        ERRORLOG("Cannot write packet file index");
+        return false;
+    }
+    return true;
+}
+
+static TbBool packet_file_load_index_chunk(long file_len)
+{
+    struct FileChunkHeader hdr;
+    unsigned long total_len;
+    if (file_len < (long)(packet_file.data_pos + sizeof(hdr) + sizeof(total_len)))
+        return false;
+    LbFileSeek(game.packet_save_fp, file_len - sizeof(total_len), Lb_FILE_SEEK_BEGINNING);
+    if (LbFileRead(game.packet_save_fp, &total_len, sizeof(total_len)) != sizeof(total_len))
+        return false;
+    if ((total_len < sizeof(hdr) + sizeof(total_len)) || (total_len > file_len - packet_file.data_pos))
+        return false;
+    LbFileSeek(game.packet_save_fp, file_len - total_len, Lb_FILE_SEEK_BEGINNING);
+    if (LbFileRead(game.packet_save_fp, &hdr, sizeof(hdr)) != sizeof(hdr))
+        return false;
+    unsigned long items_len = hdr.len - sizeof(total_len);
+    if ((hdr.id != SGC_PacketIndex) || (hdr.len + sizeof(hdr) != total_len) || (items_len % sizeof(struct PacketFileIndexItem) != 0))
+        return false;
+    unsigned long count = items_len / sizeof(struct PacketFileIndexItem);
+    struct PacketFileIndexItem* index = (struct PacketFileIndexItem*)LbMemoryAlloc(items_len + 1);
+    if (index == NULL)
+        return false;
+    if (LbFileRead(game.packet_save_fp, index, items_len) != (long)items_len)
+    {
+        LbMemoryFree(index);
+        return false;
+    }
+    packet_file.index = index;
+    packet_file.index_count = count;
+    packet_file.index_alloc = count;
+    return true;
+}
+
+/**
+ * Rebuilds the index from chunk headers; used if the recording wasn't closed properly.
+ */
+static void packet_file_scan_chunks(long file_len)
+{
+    struct FileChunkHeader hdr;
+    unsigned long head[2];
+    unsigned long pos = packet_file.data_pos;
+    while (pos + sizeof(hdr) + sizeof(head) <= (unsigned long)file_len)
+    {
+        LbFileSeek(game.packet_save_fp, pos, Lb_FILE_SEEK_BEGINNING);
+        if ((LbFileRead(game.packet_save_fp, &hdr, sizeof(hdr)) != sizeof(hdr))
+         || (LbFileRead(game.packet_save_fp, head, sizeof(head)) != sizeof(head)))
+            break;
+        // Last chunk may be cut if the game crashed while it was written
+        if (pos + sizeof(hdr) + hdr.len > (unsigned long)file_len)
+            break;
+        if ((hdr.id == SGC_PacketTurns) || (hdr.id == SGC_PacketKeyframe)) {
+            packet_file_index_add(hdr.id, head[0], head[1], pos);
+        } else
+        if (hdr.id != SGC_PacketIndex) {
+            WARNLOG("Unrecognized chunk in packet file, ID = %08lx",hdr.id);
+        }
+        pos += sizeof(hdr) + hdr.len;
+    }
+    WARNLOG("Packet file has no index, rebuilt it from %lu chunks",packet_file.index_count);
+}
+
+/**
+ * Reads version of the packet file and its index. Sets the amount of stored turns.
+ * Should be called just after the PacketData chunk was read.
+ */
+static TbBool packet_file_read_index(void)
+{
+    struct FileChunkHeader hdr;
+    long file_len = LbFileLengthHandle(game.packet_save_fp);
+    // The version is in header of the PacketData chunk
+    LbFileSeek(game.packet_save_fp, game.packet_file_pos - sizeof(hdr), Lb_FILE_SEEK_BEGINNING);
+    if (LbFileRead(game.packet_save_fp, &hdr, sizeof(hdr)) != sizeof(hdr))
+        return false;
+    packet_file.version = hdr.ver;
+    packet_file.data_pos = game.packet_file_pos;
+    if (packet_file.version == 0)
+    {
+        game.turns_stored = (file_len - game.packet_file_pos) / PACKET_TURN_SIZE;
+        return true;
+    }
+    if (packet_file.version > PACKET_FILE_VERSION)
+    {
+        WARNLOG("Packet file version %lu is not supported",packet_file.version);
+        return false;
+    }
+    if (!packet_file_load_index_chunk(file_len))
+        packet_file_scan_chunks(file_len);
+    game.turns_stored = 0;
+    for (unsigned long i = 0; i < packet_file.index_count; i++)
+    {
+        struct PacketFileIndexItem* item = &packet_file.index[i];
+        if (item->id == SGC_PacketTurns)
+            game.turns_stored = item->turn + item->count;
+    }
+    LbFileSeek(game.packet_save_fp, packet_file.data_pos, Lb_FILE_SEEK_BEGINNING);
+    return true;
+}
+
+/**
+ * Makes sure the chunk with given turn is in the batch buffer, reading it if needed.
+ */
+static TbBool packet_file_read_turns(unsigned long nturn)
+{
+    if ((packet_file.batch_turns > 0) && (nturn >= packet_file.batch_first_turn)
+      && (nturn < packet_file.batch_first_turn + packet_file.batch_turns))
+        return true;
+    packet_file.batch_turns = 0;
+    long i = packet_file_index_find(SGC_PacketTurns, nturn);
+    if (i < 0)
+        return false;
+    struct PacketFileIndexItem* item = &packet_file.index[i];
+    if ((nturn >= item->turn + item->count) || (item->count > PACKET_TURNS_BATCH))
+        return false;
+    long len = item->count * PACKET_TURN_SIZE;
+    unsigned long pos = item->offset + sizeof(struct FileChunkHeader) + 2 * sizeof(unsigned long);
+    if (LbFileSeek(game.packet_save_fp, pos, Lb_FILE_SEEK_BEGINNING) < 0)
+        return false;
+    if (LbFileRead(game.packet_save_fp, packet_file.batch, len) != len)
+        return false;
+    packet_file.batch_first_turn = item->turn;
+    packet_file.batch_turns = item->count;
+    game.packet_file_pos = pos + len;
+    return true;
+}
+
+static void packet_replay_state_store(struct PacketReplayState *rst)
+{
+    rst->packet_save_enable = game.packet_save_enable;
+    rst->packet_load_enable = game.packet_load_enable;
+    LbMemoryCopy(rst->packet_fname, game.packet_fname, sizeof(rst->packet_fname));
+    rst->packet_fopened = game.packet_fopened;
+    rst->packet_save_fp = game.packet_save_fp;
+    rst->packet_save_head = game.packet_save_head;
+    rst->turns_stored = game.turns_stored;
+    rst->numfield_149F38 = game.numfield_149F38;
+    rst->packet_checksum_verify = game.packet_checksum_verify;
+    rst->log_things_start_turn = game.log_things_start_turn;
+    rst->log_things_end_turn = game.log_things_end_turn;
+    rst->turns_packetoff = game.turns_packetoff;
+    rst->local_plyr_idx = game.local_plyr_idx;
+    rst->numfield_149F47 = game.numfield_149F47;
+    rst->game_kind = game.game_kind;
+}
+
+static void packet_replay_state_restore(const struct PacketReplayState *rst)
+{
+    game.packet_save_enable = rst->packet_save_enable;
+    game.packet_load_enable = rst->packet_load_enable;
+    LbMemoryCopy(game.packet_fname, rst->packet_fname, sizeof(game.packet_fname));
+    game.packet_fopened = rst->packet_fopened;
+    game.packet_save_fp = rst->packet_save_fp;
+    game.packet_save_head = rst->packet_save_head;
+    game.turns_stored = rst->turns_stored;
+    game.numfield_149F38 = rst->numfield_149F38;
+    game.packet_checksum_verify = rst->packet_checksum_verify;
+    game.log_things_start_turn = rst->log_things_start_turn;
+    game.log_things_end_turn = rst->log_things_end_turn;
+    game.turns_packetoff = rst->turns_packetoff;
+    game.local_plyr_idx = rst->local_plyr_idx;
+    game.numfield_149F47 = rst->numfield_149F47;
+    game.game_kind = rst->game_kind;
+}
+
+/**
+ * Unpacks keyframe from the packet file and loads the game state from it.
+ */
+static TbBool packet_file_load_keyframe(const struct PacketFileIndexItem *item)
+{
+    struct FileChunkHeader hdr;
+    unsigned long head[2];
+    LbFileSeek(game.packet_save_fp, item->offset, Lb_FILE_SEEK_BEGINNING);
+    if ((LbFileRead(game.packet_save_fp, &hdr, sizeof(hdr)) != sizeof(hdr))
+     || (LbFileRead(game.packet_save_fp, head, sizeof(head)) != sizeof(head)))
+        return false;
+    if ((hdr.id != SGC_PacketKeyframe) || (hdr.len <= sizeof(head)))
+        return false;
+    unsigned long packed_len = hdr.len - sizeof(head);
+    uLongf raw_len = head[1];
+    unsigned char* packed = LbMemoryAlloc(packed_len);
+    unsigned char* raw = LbMemoryAlloc(raw_len);
+    TbBool done = (packed != NULL) && (raw != NULL)
+        && (LbFileRead(game.packet_save_fp, packed, packed_len) == (long)packed_len)
+        && (uncompress(raw, &raw_len, packed, packed_len) == Z_OK) && (raw_len == head[1]);
+    if (packed != NULL)
+        LbMemoryFree(packed);
+    if (done)
+        done = (load_game_state_from_buffer(raw, raw_len) == GLoad_GameState);
+    if (raw != NULL)
+        LbMemoryFree(raw);
+    return done;
+}
+
 TbBool open_packet_file_for_load(char *fname, struct CatalogueEntry *centry)
 {
     LbMemorySet(centry, 0, sizeof(struct CatalogueEntry));
@@ -143,7 +622,16 @@ TbBool open_packet_file_for_load(char *fname, struct CatalogueEntry *centry)
         return false;
     }
     game.packet_file_pos = LbFilePosition(game.packet_save_fp);
-    game.turns_stored = (LbFileLengthHandle(game.packet_save_fp) - game.packet_file_pos) / PACKET_TURN_SIZE;
+    LbMemorySet(&packet_load_stats, 0, sizeof(packet_load_stats));
+    packet_file_reset();
+    if (!packet_file_read_index())
+    {
+        LbFileClose(game.packet_save_fp);
+        game.packet_save_fp = -1;
+        game.packet_fopened = 0;
+        WARNMSG("Couldn't read turns index of packet file \"%s\".",fname);
+        return false;
+    }
     if ((game.packet_checksum_verify) && (!game.packet_save_head.chksum_available))
     {
         WARNMSG("PacketSave checksum not available, checking disabled.");
@@ -179,7 +667,7 @@ static TbBigChecksum get_thing_simple_checksum(const struct Thing *tng)
 static TbBigChecksum get_packet_save_checksum(void)
 {
     TbBigChecksum sum = 0;
-    for (long tng_idx = 0; tng_idx < THINGS_COUNT; tng_idx++)
+    for (long tng_idx = 0; tng_idx < game.thing_slots_count; tng_idx++)
     {
         struct Thing* tng = thing_get(tng_idx);
         if ((tng->alloc_flags & TAlF_Exists) != 0)
@@ -197,28 +685,33 @@ static TbBigChecksum get_packet_save_checksum(void)
 
 short save_packets(void)
 {
-    const int turn_data_size = PACKET_TURN_SIZE;
-    unsigned char pckt_buf[PACKET_TURN_SIZE+4];
     TbBigChecksum chksum;
     SYNCDBG(6,"Starting");
     if (game.packet_checksum_verify)
         chksum = get_packet_save_checksum();
     else
         chksum = 0;
-    LbFileSeek(game.packet_save_fp, 0, Lb_FILE_SEEK_END);
+    // Keyframe goes before the turn it was made on, so the batch with previous turns has to be written first
+    if ((packet_file.turns_saved > 0) && (packet_file.turns_saved % PACKET_KEYFRAME_INTERVAL == 0)
+      && (packet_file.batch_turns == 0))
+    {
+        packet_file_write_keyframe(packet_file.turns_saved);
+    }
     // Prepare data in the buffer
+    unsigned char* pckt_buf = &packet_file.batch[packet_file.batch_turns * PACKET_TURN_SIZE];
+    LbMemorySet(pckt_buf, 0, PACKET_TURN_SIZE);
     for (int i = 0; i < NET_PLAYERS_COUNT; i++)
         LbMemoryCopy(&pckt_buf[i*sizeof(struct Packet)], &game.packets[i], sizeof(struct Packet));
     LbMemoryCopy(&pckt_buf[NET_PLAYERS_COUNT*sizeof(struct Packet)], &chksum, sizeof(TbBigChecksum));
-    // Write buffer into file
-    if (LbFileWrite(game.packet_save_fp, &pckt_buf, turn_data_size) != turn_data_size)
-    {
-        ERRORLOG("Packet file write error");
-    }
-    if ( !LbFileFlush(game.packet_save_fp) )
+    if (packet_file.batch_turns == 0)
+        packet_file.batch_first_turn = packet_file.turns_saved;
+    packet_file.batch_turns++;
+    packet_file.turns_saved++;
+    // Write the buffer into file when it's full, or when a keyframe is to be made on next turn
+    if ((packet_file.batch_turns >= PACKET_TURNS_BATCH) || (packet_file.turns_saved % PACKET_KEYFRAME_INTERVAL == 0))
     {
-        ERRORLOG("Unable to flush PacketSave File");
-        return false;
+        if (!packet_file_write_turns())
+            return false;
     }
     return true;
 }
@@ -227,10 +720,16 @@ void close_packet_file(void)
 {
     if ( game.packet_fopened )
     {
+        if (game.packet_save_enable)
+        {
+            packet_file_write_turns();
+            packet_file_write_index();
+        }
         LbFileClose(game.packet_save_fp);
         game.packet_fopened = 0;
         game.packet_save_fp = -1;
     }
+    packet_file_reset();
 }
 
 void dump_memory_to_file(const char * fname, const char * buf, size_t len)
@@ -310,6 +809,9 @@ TbBool open_new_packet_file_for_save(void)
         game.packet_save_fp = -1;
         return false;
     }
+    packet_file_reset();
+    packet_file.version = PACKET_FILE_VERSION;
+    packet_file.data_pos = LbFilePosition(game.packet_save_fp);
     game.packet_fopened = 1;
     return true;
 }
@@ -327,14 +829,26 @@ void load_packets_for_turn(GameTurn nturn)
         erstat_inc(ESE_CantReadPackets);
         return;
     }
-
-    if (LbFileRead(game.packet_save_fp, &pckt_buf, turn_data_size) == -1)
+    if (packet_file.version == 0)
     {
-        ERRORDBG(18,"Cannot read turn data from Packet File");
-        erstat_inc(ESE_CantReadPackets);
-        return;
+        if (LbFileRead(game.packet_save_fp, &pckt_buf, turn_data_size) == -1)
+        {
+            ERRORDBG(18,"Cannot read turn data from Packet File");
+            erstat_inc(ESE_CantReadPackets);
+            return;
+        }
+        game.packet_file_pos += turn_data_size;
+    } else
+    {
+        if (!packet_file_read_turns(nturn))
+        {
+            ERRORDBG(18,"Cannot read turn data from Packet File");
+            erstat_inc(ESE_CantReadPackets);
+            return;
+        }
+        LbMemoryCopy(pckt_buf, &packet_file.batch[(nturn - packet_file.batch_first_turn) * turn_data_size], turn_data_size);
     }
-    game.packet_file_pos += turn_data_size;
+    packet_load_stats.turns_loaded++;
     for (long i = 0; i < NET_PLAYERS_COUNT; i++)
         LbMemoryCopy(&game.packets[i], &pckt_buf[i * sizeof(struct Packet)], sizeof(struct Packet));
     TbBigChecksum tot_chksum = llong(&pckt_buf[NET_PLAYERS_COUNT * sizeof(struct Packet)]);
@@ -342,20 +856,74 @@ void load_packets_for_turn(GameTurn nturn)
         game.turns_fastforward--;
     if (game.packet_checksum_verify)
     {
+        TbBool in_sync = true;
         pckt = get_packet(my_player_number);
         if (get_packet_save_checksum() != tot_chksum)
         {
             ERRORLOG("PacketSave checksum - Out of sync (GameTurn %d)", game.play_gameturn);
             if (!is_onscreen_msg_visible())
                 show_onscreen_msg(game_num_fps, "Out of sync");
+            in_sync = false;
         } else
         if (pckt->chksum != pckt_chksum)
         {
             ERRORLOG("Opps we are really Out Of Sync (GameTurn %d)", game.play_gameturn);
             if (!is_onscreen_msg_visible())
                 show_onscreen_msg(game_num_fps, "Out of sync");
+            in_sync = false;
         }
+        packet_load_stats.turns_verified++;
+        if (!in_sync)
+        {
+            if (packet_load_stats.turns_out_of_sync == 0)
+                packet_load_stats.first_out_of_sync_turn = game.play_gameturn;
+            packet_load_stats.turns_out_of_sync++;
+        }
+    }
+}
+
+/**
+ * Restores game state from the last keyframe made at or before given turn of the opened
+ * packet file, so the replay doesn't have to simulate all turns before it.
+ * Remaining turns up to the given one are set to be fast forwarded.
+ * @return True if a keyframe was loaded; false if the replay is to start from beginning.
+ */
+TbBool seek_packet_file_to_turn(GameTurn nturn)
+{
+    struct PacketReplayState rst;
+    if ((!game.packet_fopened) || (packet_file.version == 0))
+        return false;
+    long i = packet_file_index_find(SGC_PacketKeyframe, nturn);
+    if (i < 0)
+        return false;
+    const struct PacketFileIndexItem* item = &packet_file.index[i];
+    TbClockMSec start_time = LbTimerClock();
+    packet_replay_state_store(&rst);
+    if (!packet_file_load_keyframe(item))
+    {
+        ERRORLOG("Cannot load keyframe for turn %lu from packet file",item->turn);
+        packet_replay_state_restore(&rst);
+        return false;
     }
+    reinit_level_after_load();
+    light_import_system_state(&gameadd.lightst);
+    // Loaded Game structure comes from the recording, and reinit cleared packet settings
+    packet_replay_state_restore(&rst);
+    packet_file.batch_turns = 0;
+    game.pckt_gameturn = item->turn;
+    game.turns_fastforward = nturn - item->turn;
+    packet_load_stats.turns_skipped = item->turn;
+    SYNCMSG("Packet file seek to turn %lu, keyframe at turn %lu loaded in %lu ms",(unsigned long)nturn,
+        item->turn,(unsigned long)(LbTimerClock() - start_time));
+    return true;
+}
+
+/**
+ * Gives amount of turns loaded from the packet file opened last, and results of their verification.
+ */
+const struct PacketLoadStats *get_packet_load_stats(void)
+{
+    return &packet_load_stats;
 }
 
 void set_packet_pause_toggle()
@@ -54,6 +54,7 @@
 #include "keeperfx.hpp"
 #include "kjm_input.h"
 #include "music_player.h"
+#include "net_sync.h"
 #include "post_inc.h"
 
 /******************************************************************************/
@@ -1099,8 +1100,9 @@ void process_players(void)
             update_player_objectives(i);
         }
     }
-    TbBigChecksum sum = 0;
-    sum += compute_players_checksum();
+    TbBigChecksum sum = compute_players_checksum();
+    sync_hash_add(CKS_Players, sum);
+    sync_hash_add(CKS_Dungeons, compute_dungeons_checksum());
     sum += game.action_rand_seed;
     player_packet_checksum_add(my_player_number,sum,"players");
     SYNCDBG(17,"Finished");
@@ -41,6 +41,7 @@
 #include "game_legacy.h"
 #include "keeperfx.hpp"
 #include "frontend.h"
+#include "net_sync.h"
 #include "math.h"
 #include "post_inc.h"
 
@@ -150,6 +151,7 @@ void process_rooms(void)
       }
   }
   player_packet_checksum_add(my_player_number, sum, "rooms");
+  sync_hash_add(CKS_Rooms, sum);
   recompute_rooms_count_in_dungeons();
   SYNCDBG(9,"Finished");
 }
@@ -32,6 +32,7 @@
 #include "game_legacy.h"
 #include "creature_states.h"
 #include "map_data.h"
+#include "net_sync.h"
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -182,7 +183,19 @@ void set_slab_owner(MapSlabCoord slb_x, MapSlabCoord slb_y, PlayerNumber owner)
         }
     }
 
+    sync_hash_toggle_slab(slb);
     slb->owner = owner;
+    sync_hash_toggle_slab(slb);
+}
+
+/**
+ * Sets kind of given SlabMap, keeping sync hash of slabs up to date.
+ */
+void slabmap_set_kind(struct SlabMap *slb, SlabKind kind)
+{
+    sync_hash_toggle_slab(slb);
+    slb->kind = kind;
+    sync_hash_toggle_slab(slb);
 }
 
 /**
@@ -148,6 +148,7 @@ TbBool slabmap_block_invalid(const struct SlabMap *slb);
 TbBool slab_coords_invalid(MapSlabCoord slb_x, MapSlabCoord slb_y);
 long slabmap_owner(const struct SlabMap *slb);
 void set_slab_owner(MapSlabCoord slb_x, MapSlabCoord slb_y, PlayerNumber owner);
+void slabmap_set_kind(struct SlabMap *slb, SlabKind kind);
 PlayerNumber get_slab_owner_thing_is_on(const struct Thing *thing);
 unsigned long slabmap_wlb(struct SlabMap *slb);
 void slabmap_set_wlb(struct SlabMap *slb, unsigned long wlb_type);
@@ -41,13 +41,158 @@
 extern "C" {
 #endif
 /******************************************************************************/
+/** Memory blocks backing the thing slots. Blocks are allocated when the pool grows, and are kept until the game exits. */
+static struct Thing *things_pool_chunks[THINGS_POOL_CHUNKS_COUNT];
+/** Amount of allocated blocks; they are always allocated from the first one up. */
+static long things_pool_chunks_count = 0;
+/** Amount of effect elements deleted to make space for new things. */
+static unsigned long effects_freed_for_allocation = 0;
+/******************************************************************************/
+/**
+ * Makes sure memory for thing slots below given index is allocated.
+ * Newly allocated slots are added to the things lookup array.
+ * @param slots_count Amount of thing slots which need to be backed by memory.
+ * @return True if the memory is available, false if allocation failed.
+ */
+TbBool things_pool_reserve(long slots_count)
+{
+    if (slots_count > THINGS_COUNT)
+        slots_count = THINGS_COUNT;
+    for (long n = 0; n * THINGS_POOL_CHUNK < slots_count; n++)
+    {
+        if (things_pool_chunks[n] != NULL)
+            continue;
+        things_pool_chunks[n] = (struct Thing *)LbMemoryAlloc(THINGS_POOL_CHUNK * sizeof(struct Thing));
+        if (things_pool_chunks[n] == NULL)
+        {
+            ERRORLOG("Cannot allocate memory for thing slots %d-%d",(int)(n * THINGS_POOL_CHUNK),(int)((n + 1) * THINGS_POOL_CHUNK - 1));
+            return false;
+        }
+        things_pool_chunks_count = n + 1;
+        for (long k = 0; k < THINGS_POOL_CHUNK; k++)
+        {
+            game.things.lookup[n * THINGS_POOL_CHUNK + k] = &things_pool_chunks[n][k];
+        }
+    }
+    return true;
+}
+
+/**
+ * Fills the things lookup array with addresses of allocated thing slots.
+ * Needs to be called after the lookup array was overwritten, ie. by loading or resyncing the game.
+ */
+void things_pool_update_lookups(void)
+{
+    for (long n = 0; n < THINGS_POOL_CHUNKS_COUNT; n++)
+    {
+        for (long k = 0; k < THINGS_POOL_CHUNK; k++)
+        {
+            if (things_pool_chunks[n] != NULL)
+                game.things.lookup[n * THINGS_POOL_CHUNK + k] = &things_pool_chunks[n][k];
+            else
+                game.things.lookup[n * THINGS_POOL_CHUNK + k] = NULL;
+        }
+    }
+    game.things.end = NULL;
+}
+
+/**
+ * Clears thing slots which are allocated, but are beyond the slots available in current level.
+ * Makes sure no leftovers from previous level, or from a larger game state, are treated as existing things.
+ */
+void things_pool_clear_unavailable(void)
+{
+    for (long i = game.thing_slots_count; i < THINGS_COUNT; i++)
+    {
+        struct Thing* thing = game.things.lookup[i];
+        if (thing != NULL)
+            LbMemorySet(thing, 0, sizeof(struct Thing));
+    }
+}
+
+void things_pool_free(void)
+{
+    for (long n = 0; n < THINGS_POOL_CHUNKS_COUNT; n++)
+    {
+        LbMemoryFree(things_pool_chunks[n]);
+        things_pool_chunks[n] = NULL;
+    }
+    things_pool_chunks_count = 0;
+    things_pool_update_lookups();
+}
+
+/**
+ * Returns amount of effect elements which were deleted because there was no free thing slot.
+ * Code which walks the effect elements list may check it to detect elements disappearing.
+ */
+unsigned long get_effects_freed_for_allocation_count(void)
+{
+    return effects_freed_for_allocation;
+}
+
+/**
+ * Returns max amount of thing slots which can be used in current level.
+ */
+long get_thing_slots_limit(void)
+{
+    long limit = game.conf.rules.game.max_things;
+    if (limit > THINGS_COUNT)
+        limit = THINGS_COUNT;
+    if (limit < THINGS_POOL_CHUNK)
+        limit = THINGS_POOL_CHUNK;
+    return limit;
+}
+
+/**
+ * Makes more thing slots available, by appending them to the free things list.
+ * The list is extended in the order of indices, so things get the same indices no matter
+ * when the pool grows. That keeps the game state identical for all network players.
+ * @return Amount of slots added.
+ */
+static long things_pool_grow(void)
+{
+    long slots_count = game.thing_slots_count;
+    if (slots_count < 1)
+        slots_count = 1;
+    long limit = get_thing_slots_limit();
+    if (slots_count >= limit)
+        return 0;
+    long n = THINGS_POOL_CHUNK - (slots_count % THINGS_POOL_CHUNK);
+    if (slots_count + n > limit)
+        n = limit - slots_count;
+    if (!things_pool_reserve(slots_count + n))
+        return 0;
+    for (long k = 0; k < n; k++)
+    {
+        game.free_things[slots_count - 1 + k] = slots_count + k;
+    }
+    game.thing_slots_count = slots_count + n;
+    return n;
+}
+
+/**
+ * Empties the free things list and makes all thing slots unavailable.
+ * Slots will become available again, as the things pool grows.
+ */
+void reset_free_things_list(void)
+{
+    LbMemorySet(game.free_things, 0, sizeof(game.free_things));
+    game.free_things_start_index = 0;
+    game.thing_slots_count = 1;
+}
+
 struct Thing *allocate_free_thing_structure_f(unsigned char allocflags, const char *func_name)
 {
     struct Thing *thing;
     // Get a thing from "free things list"
     long i = game.free_things_start_index;
-    // If there is no free thing, try to free an effect
-    if (i >= THINGS_COUNT-1)
+    // If there is no free thing, make the pool larger
+    if (i >= game.thing_slots_count-1)
+    {
+        things_pool_grow();
+    }
+    // If there is still no free thing, try to free an effect
+    if (i >= game.thing_slots_count-1)
     {
         if ((allocflags & FTAF_FreeEffectIfNoSlots) != 0)
         {
@@ -55,6 +200,7 @@ struct Thing *allocate_free_thing_structure_f(unsigned char allocflags, const ch
             if (!thing_is_invalid(thing))
             {
                 delete_thing_structure(thing, 0);
+                effects_freed_for_allocation++;
             } else
             {
 #if (BFDEBUG_LEVEL > 0)
@@ -65,7 +211,7 @@ struct Thing *allocate_free_thing_structure_f(unsigned char allocflags, const ch
         i = game.free_things_start_index;
     }
     // Now, if there is still no free thing (we couldn't free any)
-    if (i >= THINGS_COUNT-1)
+    if (i >= game.thing_slots_count-1)
     {
 #if (BFDEBUG_LEVEL > 0)
         ERRORMSG("%s: Cannot allocate new thing, no free slots!",func_name);
@@ -96,7 +242,10 @@ struct Thing *allocate_free_thing_structure_f(unsigned char allocflags, const ch
 TbBool i_can_allocate_free_thing_structure(unsigned char allocflags)
 {
     // Check if there are free slots
-    if (game.free_things_start_index < THINGS_COUNT-1)
+    if (game.free_things_start_index < game.thing_slots_count-1)
+        return true;
+    // Check if the pool can grow
+    if (game.thing_slots_count < get_thing_slots_limit())
         return true;
     // Check if there are effect slots that could be freed
     if ((allocflags & FTAF_FreeEffectIfNoSlots) != 0)
@@ -112,9 +261,9 @@ TbBool i_can_allocate_free_thing_structure(unsigned char allocflags)
         ERRORLOG("Cannot allocate thing structure.");
         things_stats_debug_dump();
     }
-    if ((game.free_things_start_index > THINGS_COUNT - 2) && ((allocflags & FTAF_FreeEffectIfNoSlots) != 0))
+    if ((game.free_things_start_index > game.thing_slots_count - 2) && ((allocflags & FTAF_FreeEffectIfNoSlots) != 0))
     {
-        show_onscreen_msg(2 * game_num_fps, "Warning: Cannot create thing, %d/%d thing slots used.", game.free_things_start_index + 1, THINGS_COUNT);
+        show_onscreen_msg(2 * game_num_fps, "Warning: Cannot create thing, %d/%d thing slots used.", game.free_things_start_index + 1, (int)get_thing_slots_limit());
     }
     return false;
 }
@@ -126,7 +275,7 @@ TbBool i_can_allocate_free_thing_structure(unsigned char allocflags)
  */
 TbBool is_in_free_things_list(long tng_idx)
 {
-    for (int i = game.free_things_start_index; i < THINGS_COUNT - 1; i++)
+    for (int i = game.free_things_start_index; i < game.thing_slots_count - 1; i++)
     {
         if (game.free_things[i] == tng_idx)
             return true;
@@ -186,7 +335,10 @@ void delete_thing_structure_f(struct Thing *thing, long a2, const char *func_nam
 struct Thing *thing_get_f(long tng_idx, const char *func_name)
 {
     if ((tng_idx > 0) && (tng_idx < THINGS_COUNT)) {
-        return game.things.lookup[tng_idx];
+        struct Thing* thing = game.things.lookup[tng_idx];
+        if (thing != NULL)
+            return thing;
+        return INVALID_THING;
     }
     if ((tng_idx < -1) || (tng_idx >= THINGS_COUNT)) {
         ERRORMSG("%s: Request of invalid thing (no %d) intercepted",func_name,(int)tng_idx);
@@ -196,15 +348,27 @@ struct Thing *thing_get_f(long tng_idx, const char *func_name)
 
 long thing_get_index(const struct Thing *thing)
 {
-    long tng_idx = (thing - game.things.lookup[0]);
-    if ((tng_idx > 0) && (tng_idx < THINGS_COUNT))
+    if (thing_is_invalid(thing))
+        return 0;
+    long tng_idx = thing->index;
+    if ((tng_idx > 0) && (tng_idx < THINGS_COUNT) && (game.things.lookup[tng_idx] == thing))
         return tng_idx;
     return 0;
 }
 
 short thing_is_invalid(const struct Thing *thing)
 {
-    return (thing <= game.things.lookup[0]) || (thing > game.things.lookup[THINGS_COUNT-1]) || (thing == NULL);
+    if ((thing == NULL) || (thing == game.things.lookup[0]))
+        return true;
+    // Things are stored in separately allocated chunks; addresses are compared as integers,
+    // as comparing pointers into different blocks is undefined
+    uintptr_t addr = (uintptr_t)thing;
+    for (long n = 0; n < things_pool_chunks_count; n++)
+    {
+        if (addr - (uintptr_t)things_pool_chunks[n] < THINGS_POOL_CHUNK * sizeof(struct Thing))
+            return false;
+    }
+    return true;
 }
 
 TbBool thing_exists_idx(long tng_idx)
@@ -219,8 +383,8 @@ TbBool thing_exists(const struct Thing *thing)
     if ((thing->alloc_flags & TAlF_Exists) == 0)
         return false;
 #if (BFDEBUG_LEVEL > 0)
-    if (thing->index != (thing-thing_get(0)))
-        WARNLOG("Incorrectly indexed thing (%d) at pos %d",(int)thing->index,(int)(thing-thing_get(0)));
+    if ((thing->index >= THINGS_COUNT) || (game.things.lookup[thing->index] != thing))
+        WARNLOG("Incorrectly indexed thing (%d)",(int)thing->index);
     if ((thing->class_id < 1) || (thing->class_id >= THING_CLASSES_COUNT))
         WARNLOG("Thing %d is of invalid class %d",(int)thing->index,(int)thing->class_id);
 #endif
@@ -318,6 +318,14 @@ enum ThingAddFlags //named this way because they were part of the ThingAdd struc
 
 #pragma pack()
 /******************************************************************************/
+TbBool things_pool_reserve(long slots_count);
+void things_pool_update_lookups(void);
+void things_pool_clear_unavailable(void);
+void things_pool_free(void);
+long get_thing_slots_limit(void);
+unsigned long get_effects_freed_for_allocation_count(void);
+void reset_free_things_list(void);
+
 #define allocate_free_thing_structure(a1) allocate_free_thing_structure_f(a1, __func__)
 struct Thing *allocate_free_thing_structure_f(unsigned char a1, const char *func_name);
 TbBool i_can_allocate_free_thing_structure(unsigned char allocflags);
@@ -382,33 +382,58 @@ void move_effect_blocked(struct Thing *thing, struct Coord3d *prev_pos, struct C
     remove_relevant_forces_from_thing_after_slide(thing, next_pos, blocked_flags);
 }
 
-TngUpdateRet move_effect_element(struct Thing *thing)
+/**
+ * Computes where the effect element moves in this turn, and whether it hits a wall.
+ * Only reads the element and the map, so it can be used on a copy of the element.
+ * @param thing The effect element.
+ * @param pos Target position of the element.
+ * @return Flags from EffectElementStepFlags enumeration.
+ */
+static unsigned char get_effect_element_move_flags(const struct Thing *thing, struct Coord3d *pos)
 {
-    SYNCDBG(18,"Starting");
-    TRACE_THING(thing);
-    struct Coord3d pos;
-    TbBool move_allowed = get_thing_next_position(&pos, thing);
-    if ( positions_equivalent(&thing->mappos, &pos) ) {
-        return TUFRet_Unchanged;
+    TbBool move_allowed = get_thing_next_position(pos, thing);
+    if ( positions_equivalent(&thing->mappos, pos) ) {
+        return EESF_None;
     }
     if ((thing->movement_flags & TMvF_Unknown10) == 0)
     {
         if (!move_allowed)
         {
-            move_effect_blocked(thing, &thing->mappos, &pos);
+            return EESF_Moved|EESF_Blocked;
         } else
-        if ( !thing_covers_same_blocks_in_two_positions(thing, &thing->mappos, &pos) )
+        if ( !thing_covers_same_blocks_in_two_positions((struct Thing *)thing, (struct Coord3d *)&thing->mappos, pos) )
         {
-            if ( thing_in_wall_at(thing, &pos) )
+            if ( thing_in_wall_at(thing, pos) )
             {
-                move_effect_blocked(thing, &thing->mappos, &pos);
+                return EESF_Moved|EESF_Blocked;
             }
         }
     }
-    move_thing_in_map(thing, &pos);
+    return EESF_Moved;
+}
+
+static TngUpdateRet move_effect_element_to(struct Thing *thing, struct Coord3d *pos, unsigned char move_flags)
+{
+    if ((move_flags & EESF_Moved) == 0) {
+        return TUFRet_Unchanged;
+    }
+    if ((move_flags & EESF_Blocked) != 0)
+    {
+        move_effect_blocked(thing, &thing->mappos, pos);
+    }
+    move_thing_in_map(thing, pos);
     return TUFRet_Modified;
 }
 
+TngUpdateRet move_effect_element(struct Thing *thing)
+{
+    SYNCDBG(18,"Starting");
+    TRACE_THING(thing);
+    struct Coord3d pos;
+    unsigned char move_flags = get_effect_element_move_flags(thing, &pos);
+    return move_effect_element_to(thing, &pos, move_flags);
+}
+
 void change_effect_element_into_another(struct Thing *thing, long nmodel)
 {
     SYNCDBG(18,"Starting");
@@ -430,26 +455,12 @@ void change_effect_element_into_another(struct Thing *thing, long nmodel)
     thing->max_frames = keepersprite_frames(thing->anim_sprite);
 }
 
-TngUpdateRet update_effect_element(struct Thing *elemtng)
+/**
+ * Updates effect element properties which depend only on the element itself and the map.
+ */
+static void update_effect_element_state(struct Thing *elemtng, const struct EffectElementConfigStats *eestats)
 {
-    long i;
-    SYNCDBG(18,"Starting");
-    TRACE_THING(elemtng);
-    struct EffectElementConfigStats* eestats = get_effect_element_model_stats(elemtng->model);
-    // Check if effect health dropped to zero; delete it, or decrease health for the next check
-    long health = elemtng->health;
-    if (health <= 0)
-    {
-        if (eestats->transform_model != 0)
-        {
-            change_effect_element_into_another(elemtng, eestats->transform_model);
-        } else
-        {
-            delete_thing_structure(elemtng, 0);
-        }
-        return TUFRet_Deleted;
-    }
-    elemtng->health = health-1;
+    elemtng->health--;
     // Set dynamic properties of the effect
     if (!eestats->animate_on_floor)
     {
@@ -462,7 +473,7 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
         elemtng->movement_flags &= ~TMvF_IsOnLava;
         if (thing_touching_floor(elemtng))
         {
-            i = get_top_cube_at(elemtng->mappos.x.stl.num, elemtng->mappos.y.stl.num, NULL);
+            long i = get_top_cube_at(elemtng->mappos.x.stl.num, elemtng->mappos.y.stl.num, NULL);
             if (cube_is_water(i)) {
                 elemtng->movement_flags |= TMvF_IsOnWater;
             } else
@@ -471,17 +482,30 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
             }
         }
     }
-    i = eestats->subeffect_delay;
+}
+
+static void update_effect_element_subeffect(struct Thing *elemtng, const struct EffectElementConfigStats *eestats)
+{
+    long i = eestats->subeffect_delay;
     if (i > 0)
     {
       if (((elemtng->creation_turn - game.play_gameturn) % i) == 0) {
           create_effect_element(&elemtng->mappos, eestats->subeffect_model, elemtng->owner);
       }
     }
+}
+
+/**
+ * Updates effect element velocity according to its move type.
+ * @return True if the element should be moved, false if it doesn't move.
+ */
+static TbBool update_effect_element_velocity(struct Thing *elemtng, const struct EffectElementConfigStats *eestats)
+{
+    long i;
+    long health;
     switch (eestats->move_type)
     {
     case 1:
-        move_effect_element(elemtng);
         break;
     case 2:
         i = elemtng->veloc_base.x.val;
@@ -508,11 +532,9 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
             if (i > 16) i = 16;
             elemtng->veloc_base.z.val = i;
         }
-        move_effect_element(elemtng);
         break;
     case 3:
         elemtng->veloc_base.z.val = 32;
-        move_effect_element(elemtng);
         break;
     case 4:
         health = elemtng->health;
@@ -523,20 +545,22 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
         {
             ERRORLOG("Illegal effect element bounce life: %d", (int)health);
         }
-        move_effect_element(elemtng);
         break;
     case 5:
-        break;
+        return false;
     default:
         ERRORLOG("Invalid effect element move type %d!",(int)eestats->move_type);
         JUSTLOG("elemtng->model %d",elemtng->model);
-        move_effect_element(elemtng);
         break;
     }
+    return true;
+}
 
+static void update_effect_element_angles(struct Thing *elemtng, const struct EffectElementConfigStats *eestats)
+{
     if (eestats->unanimated != 1)
-      return TUFRet_Modified;
-    i = get_angle_yz_to_vec(&elemtng->veloc_base);
+      return;
+    long i = get_angle_yz_to_vec(&elemtng->veloc_base);
     if (i > LbFPMath_PI)
       i -= LbFPMath_PI;
     long prop_val = i / (LbFPMath_PI / 8);
@@ -544,6 +568,97 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
     elemtng->current_frame = prop_val;
     elemtng->anim_speed = 0;
     elemtng->anim_time = (prop_val & 0xff) << 8;
+}
+
+TngUpdateRet update_effect_element(struct Thing *elemtng)
+{
+    SYNCDBG(18,"Starting");
+    TRACE_THING(elemtng);
+    struct EffectElementConfigStats* eestats = get_effect_element_model_stats(elemtng->model);
+    // Check if effect health dropped to zero; delete it, or decrease health for the next check
+    if (elemtng->health <= 0)
+    {
+        if (eestats->transform_model != 0)
+        {
+            change_effect_element_into_another(elemtng, eestats->transform_model);
+        } else
+        {
+            delete_thing_structure(elemtng, 0);
+        }
+        return TUFRet_Deleted;
+    }
+    update_effect_element_state(elemtng, eestats);
+    update_effect_element_subeffect(elemtng, eestats);
+    if (update_effect_element_velocity(elemtng, eestats)) {
+        move_effect_element(elemtng);
+    }
+    update_effect_element_angles(elemtng, eestats);
+    SYNCDBG(18,"Finished");
+    return TUFRet_Modified;
+}
+
+/**
+ * First phase of effect element update, which can be executed concurrently for many elements.
+ * Applies pending velocity pushes and computes the new state and movement of the element,
+ * without modifying the element or anything else in the game.
+ * @param elemtng The effect element.
+ * @param step Structure which receives the computed state.
+ * @return True if the step was computed; false if the element requires full update
+ *     with update_effect_element(), ie. because it is going to be deleted or transformed.
+ */
+TbBool update_effect_element_prepare(const struct Thing *elemtng, struct EffectElementStep *step)
+{
+    struct EffectElementConfigStats* eestats = get_effect_element_model_stats(elemtng->model);
+    step->flags = EESF_None;
+    if (elemtng->health <= 0)
+        return false;
+    // Cases which produce error messages are left for the full update
+    if ((eestats->move_type < 1) || (eestats->move_type > 5))
+        return false;
+    if ((eestats->move_type == 4) && ((elemtng->health-1 < 0) || (elemtng->health-1 >= 16)))
+        return false;
+    struct Thing worktng = *elemtng;
+    update_thing_velocity_from_pushes(&worktng);
+    update_effect_element_state(&worktng, eestats);
+    if (update_effect_element_velocity(&worktng, eestats)) {
+        step->flags |= get_effect_element_move_flags(&worktng, &step->pos);
+    }
+    step->health = worktng.health;
+    step->anim_speed = worktng.anim_speed;
+    step->movement_flags = worktng.movement_flags;
+    step->state_flags = worktng.state_flags;
+    step->veloc_push_once = worktng.veloc_push_once;
+    step->veloc_base = worktng.veloc_base;
+    step->veloc_push_add = worktng.veloc_push_add;
+    step->velocity = worktng.velocity;
+    step->flags |= EESF_Prepared;
+    return true;
+}
+
+/**
+ * Second phase of effect element update; stores the state computed by update_effect_element_prepare()
+ * and does the part of update which affects other things. Gives the same result as update_thing()
+ * up to the class function, and update_effect_element().
+ * @param elemtng The effect element.
+ * @param step The prepared state.
+ */
+TngUpdateRet update_effect_element_apply(struct Thing *elemtng, const struct EffectElementStep *step)
+{
+    SYNCDBG(18,"Starting");
+    TRACE_THING(elemtng);
+    struct EffectElementConfigStats* eestats = get_effect_element_model_stats(elemtng->model);
+    elemtng->health = step->health;
+    elemtng->anim_speed = step->anim_speed;
+    elemtng->movement_flags = step->movement_flags;
+    elemtng->state_flags = step->state_flags;
+    elemtng->veloc_push_once = step->veloc_push_once;
+    elemtng->veloc_base = step->veloc_base;
+    elemtng->veloc_push_add = step->veloc_push_add;
+    elemtng->velocity = step->velocity;
+    update_effect_element_subeffect(elemtng, eestats);
+    struct Coord3d pos = step->pos;
+    move_effect_element_to(elemtng, &pos, step->flags);
+    update_effect_element_angles(elemtng, eestats);
     SYNCDBG(18,"Finished");
     return TUFRet_Modified;
 }
@@ -261,6 +261,32 @@ struct Thing;
 
 #pragma pack()
 /******************************************************************************/
+enum EffectElementStepFlags {
+    EESF_None     = 0x00,
+    EESF_Prepared = 0x01, // The step was computed and can be applied
+    EESF_Moved    = 0x02, // The element changes its position
+    EESF_Blocked  = 0x04, // The element hits a wall while moving
+};
+
+/**
+ * Result of the first phase of effect element update.
+ * Stores the state computed from the element and the map only; it is applied
+ * to the element later, so the computation can be done for many elements at once.
+ */
+struct EffectElementStep {
+    ThingIndex index;
+    unsigned char flags;
+    long health;
+    short anim_speed;
+    unsigned char movement_flags;
+    unsigned char state_flags;
+    struct CoordDelta3d veloc_push_once;
+    struct CoordDelta3d veloc_base;
+    struct CoordDelta3d veloc_push_add;
+    struct CoordDelta3d velocity;
+    struct Coord3d pos;
+};
+/******************************************************************************/
 extern const int birth_effect_element[];
 /******************************************************************************/
 struct EffectElementConfigStats *get_effect_element_model_stats(ThingModel tngmodel);
@@ -271,6 +297,8 @@ struct Thing *create_effect_generator(struct Coord3d *pos, unsigned short model,
 struct Thing *create_effect_element(const struct Coord3d *pos, unsigned short eelmodel, PlayerNumber owner);
 struct Thing* create_used_effect_or_element(const struct Coord3d* pos, EffectOrEffElModel effect_id, PlayerNumber plyr_idx);
 TngUpdateRet update_effect_element(struct Thing *thing);
+TbBool update_effect_element_prepare(const struct Thing *elemtng, struct EffectElementStep *step);
+TngUpdateRet update_effect_element_apply(struct Thing *elemtng, const struct EffectElementStep *step);
 TngUpdateRet update_effect(struct Thing *thing);
 TngUpdateRet process_effect_generator(struct Thing *thing);
 void process_spells_affected_by_effect_elements(struct Thing *thing);
@@ -48,6 +48,8 @@
 #include "game_legacy.h"
 #include "keeperfx.hpp"
 #include "bflib_planar.h"
+#include "bflib_threadpool.h"
+#include "net_sync.h"
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -76,6 +78,20 @@ Thing_Class_Func class_functions[] = {
 };
 
 unsigned long thing_create_errors = 0;
+
+/** First creature in each bucket of the creature spatial index. */
+static ThingIndex creature_bucket_first[CREATURE_BUCKETS_Y*CREATURE_BUCKETS_X];
+/** Links between creatures within one bucket, indexed by thing index. */
+static ThingIndex creature_bucket_next[THINGS_COUNT];
+static ThingIndex creature_bucket_prev[THINGS_COUNT];
+/** Bucket number plus one for every indexed thing; zero means the thing is not in any bucket. */
+static unsigned short creature_bucket_of[THINGS_COUNT];
+/** Largest clipbox of creatures added to the buckets, used to widen combat distance queries. */
+static MapCoordDelta creature_buckets_max_size_xy = 0;
+/** Effect elements to be updated in current turn, in list order, with their prepared state. */
+static struct EffectElementStep effect_element_steps[THINGS_COUNT];
+/******************************************************************************/
+static void update_thing_after_class_function(struct Thing *thing);
 /******************************************************************************/
 
 void set_previous_thing_position(struct Thing *thing) {
@@ -1032,7 +1048,9 @@ TbBigChecksum update_things_in_list(struct StructureList *list)
           }
       }
       set_previous_thing_position(thing);
-      sum += get_thing_checksum(thing);
+      TbBigChecksum csum = get_thing_checksum(thing);
+      sum += csum;
+      sync_hash_add(get_thing_checksum_kind(thing), csum);
       // Per-thing code ends
       k++;
       if (k > THINGS_COUNT)
@@ -1148,6 +1166,94 @@ unsigned long update_creatures_not_in_list(void)
   return k;
 }
 
+static void prepare_effect_elements_job(void *data, long item_beg, long item_end)
+{
+    struct EffectElementStep *steps = (struct EffectElementStep *)data;
+    for (long n = item_beg; n < item_end; n++)
+    {
+        struct EffectElementStep *step = &steps[n];
+        const struct Thing* thing = thing_get(step->index);
+        step->flags = EESF_None;
+        if ((thing->alloc_flags & (TAlF_IsFollowingLeader|TAlF_IsInLimbo)) != 0)
+            continue;
+        update_effect_element_prepare(thing, step);
+    }
+}
+
+/**
+ * Makes per game turn update of effect elements, using worker threads.
+ * Element state is computed concurrently; then everything which may affect other things,
+ * or uses random numbers, is applied in list order. The result is the same as from
+ * update_things_in_list(), so the checksum and game state don't depend on threads count.
+ * @param list List of effect elements to process.
+ * @return Returns checksum computed from status of all things in list.
+ */
+static TbBigChecksum update_effect_elements_in_list(struct StructureList *list)
+{
+    SYNCDBG(18,"Starting");
+    long steps_count = 0;
+    int i = list->index;
+    while (i != 0)
+    {
+        struct Thing* thing = thing_get(i);
+        if (thing_is_invalid(thing))
+            break;
+        if (steps_count >= THINGS_COUNT)
+            break;
+        effect_element_steps[steps_count].index = i;
+        steps_count++;
+        i = thing->next_of_class;
+    }
+    LbThreadPoolRun(prepare_effect_elements_job, effect_element_steps, steps_count, 64);
+    // Prepared steps can be used only while no element was deleted by another one
+    unsigned long freed_count = get_effects_freed_for_allocation_count();
+    TbBigChecksum sum = 0;
+    unsigned long k = 0;
+    i = list->index;
+    while (i != 0)
+    {
+        struct Thing* thing = thing_get(i);
+        if (thing_is_invalid(thing))
+        {
+            ERRORLOG("Jump to invalid thing detected");
+            break;
+        }
+        i = thing->next_of_class;
+        // Per-thing code
+        struct EffectElementStep *step = NULL;
+        if ((k < steps_count) && (effect_element_steps[k].index == thing->index) &&
+            (freed_count == get_effects_freed_for_allocation_count()))
+        {
+            step = &effect_element_steps[k];
+        }
+        if ((thing->alloc_flags & TAlF_IsFollowingLeader) == 0)
+        {
+            if ((thing->alloc_flags & TAlF_IsInLimbo) != 0) {
+                update_thing_animation(thing);
+            } else
+            if ((step != NULL) && ((step->flags & EESF_Prepared) != 0)) {
+                update_effect_element_apply(thing, step);
+                update_thing_after_class_function(thing);
+            } else {
+                update_thing(thing);
+            }
+        }
+        set_previous_thing_position(thing);
+        TbBigChecksum csum = get_thing_checksum(thing);
+        sum += csum;
+        sync_hash_add(get_thing_checksum_kind(thing), csum);
+        // Per-thing code ends
+        k++;
+        if (k > THINGS_COUNT)
+        {
+            ERRORLOG("Infinite loop detected when sweeping things list");
+            break;
+        }
+    }
+    SYNCDBG(19,"Finished, %d items, checksum %06lX",(int)k,(unsigned long)sum);
+    return sum;
+}
+
 void update_things(void)
 {
     SYNCDBG(7,"Starting");
@@ -1163,7 +1269,11 @@ void update_things(void)
     sum += update_things_in_list(&game.thing_lists[TngList_Shots]);
     sum += update_things_in_list(&game.thing_lists[TngList_Objects]);
     sum += update_things_in_list(&game.thing_lists[TngList_Effects]);
-    sum += update_things_in_list(&game.thing_lists[TngList_EffectElems]);
+    if (LbThreadPoolThreadsCount() > 1) {
+        sum += update_effect_elements_in_list(&game.thing_lists[TngList_EffectElems]);
+    } else {
+        sum += update_things_in_list(&game.thing_lists[TngList_EffectElems]);
+    }
     sum += update_things_in_list(&game.thing_lists[TngList_DeadCreatrs]);
     sum += update_things_in_list(&game.thing_lists[TngList_EffectGens]);
     sum += update_things_in_list(&game.thing_lists[TngList_Doors]);
@@ -1356,12 +1466,107 @@ void init_all_creature_states(void)
     }
 }
 
+static long creature_bucket_number(MapSubtlCoord stl_x, MapSubtlCoord stl_y)
+{
+    return (stl_y / CREATURE_BUCKET_SUBTILES) * CREATURE_BUCKETS_X + (stl_x / CREATURE_BUCKET_SUBTILES);
+}
+
+static void remove_creature_from_bucket(const struct Thing *thing)
+{
+    ThingIndex tng_idx = thing->index;
+    if ((tng_idx <= 0) || (tng_idx >= THINGS_COUNT) || (creature_bucket_of[tng_idx] == 0))
+        return;
+    long bkt_num = creature_bucket_of[tng_idx] - 1;
+    ThingIndex prev_idx = creature_bucket_prev[tng_idx];
+    ThingIndex next_idx = creature_bucket_next[tng_idx];
+    if (prev_idx > 0) {
+        creature_bucket_next[prev_idx] = next_idx;
+    } else {
+        creature_bucket_first[bkt_num] = next_idx;
+    }
+    if (next_idx > 0) {
+        creature_bucket_prev[next_idx] = prev_idx;
+    }
+    creature_bucket_next[tng_idx] = 0;
+    creature_bucket_prev[tng_idx] = 0;
+    creature_bucket_of[tng_idx] = 0;
+}
+
+static void add_creature_to_bucket(const struct Thing *thing)
+{
+    ThingIndex tng_idx = thing->index;
+    if ((tng_idx <= 0) || (tng_idx >= THINGS_COUNT))
+        return;
+    remove_creature_from_bucket(thing);
+    long bkt_num = creature_bucket_number(thing->mappos.x.stl.num, thing->mappos.y.stl.num);
+    ThingIndex next_idx = creature_bucket_first[bkt_num];
+    creature_bucket_next[tng_idx] = next_idx;
+    creature_bucket_prev[tng_idx] = 0;
+    if (next_idx > 0) {
+        creature_bucket_prev[next_idx] = tng_idx;
+    }
+    creature_bucket_first[bkt_num] = tng_idx;
+    creature_bucket_of[tng_idx] = bkt_num + 1;
+    if (creature_buckets_max_size_xy < thing->clipbox_size_xy) {
+        creature_buckets_max_size_xy = thing->clipbox_size_xy;
+    }
+}
+
+/**
+ * Clears the creature buckets spatial index.
+ * Should be called whenever mapwho is cleared.
+ */
+void clear_creature_buckets(void)
+{
+    memset(creature_bucket_first, 0, sizeof(creature_bucket_first));
+    memset(creature_bucket_next, 0, sizeof(creature_bucket_next));
+    memset(creature_bucket_prev, 0, sizeof(creature_bucket_prev));
+    memset(creature_bucket_of, 0, sizeof(creature_bucket_of));
+    creature_buckets_max_size_xy = 0;
+}
+
+/**
+ * Re-creates the creature buckets spatial index from creatures placed on mapwho.
+ * The index is not stored within Game structure, so this is required after the structure is loaded.
+ */
+void rebuild_creature_buckets(void)
+{
+    clear_creature_buckets();
+    const struct StructureList* slist = get_list_for_thing_class(TCls_Creature);
+    unsigned long k = 0;
+    long i = slist->index;
+    while (i != 0)
+    {
+        struct Thing* thing = thing_get(i);
+        if (thing_is_invalid(thing))
+        {
+            ERRORLOG("Jump to invalid thing detected");
+            break;
+        }
+        i = thing->next_of_class;
+        // Per-thing code
+        if ((thing->alloc_flags & TAlF_IsInMapWho) != 0) {
+            add_creature_to_bucket(thing);
+        }
+        // Per-thing code ends
+        k++;
+        if (k > slist->count)
+        {
+            ERRORLOG("Infinite loop detected when sweeping things list");
+            break;
+        }
+    }
+}
+
 void remove_thing_from_mapwho(struct Thing *thing)
 {
     struct Thing *mwtng;
     SYNCDBG(18,"Starting");
     if ((thing->alloc_flags & TAlF_IsInMapWho) == 0)
         return;
+    if (thing->class_id == TCls_Creature) {
+        remove_creature_from_bucket(thing);
+    }
     if (thing->prev_on_mapblk > 0)
     {
         mwtng = thing_get(thing->prev_on_mapblk);
@@ -1416,6 +1621,9 @@ void place_thing_in_mapwho(struct Thing *thing)
     set_mapwho_thing_index(mapblk, thing->index);
     thing->prev_on_mapblk = 0;
     thing->alloc_flags |= TAlF_IsInMapWho;
+    if (thing->class_id == TCls_Creature) {
+        add_creature_to_bucket(thing);
+    }
 }
 
 struct Thing *find_base_thing_on_mapwho(ThingClass oclass, ThingModel model, MapSubtlCoord stl_x, MapSubtlCoord stl_y)
@@ -1688,6 +1896,130 @@ struct Thing *get_nth_thing_of_class_with_filter(Thing_Maximizer_Filter filter,
     return retng;
 }
 
+/**
+ * Checks creatures within one bucket of the creature spatial index, updating the best match.
+ * Ties are resolved in favour of lower thing index, so the result does not depend
+ * on the order in which creatures were placed in buckets.
+ */
+static void update_best_creature_in_bucket_with_filter(long bkt_num, Thing_Maximizer_Filter filter, MaxTngFilterParam param,
+    PlayerNumber enemy_of, long *maximizer, struct Thing **retng)
+{
+    unsigned long k = 0;
+    long i = creature_bucket_first[bkt_num];
+    while (i != 0)
+    {
+        struct Thing* thing = thing_get(i);
+        if (thing_is_invalid(thing))
+        {
+            ERRORLOG("Jump to invalid thing detected");
+            break;
+        }
+        i = creature_bucket_next[thing->index];
+        // Per-thing code
+        if ((enemy_of < 0) || players_are_enemies(enemy_of, thing->owner))
+        {
+            long n = filter(thing, param, *maximizer);
+            if ((n > *maximizer) || ((n == *maximizer) && (thing_is_invalid(*retng) || (thing->index < (*retng)->index))))
+            {
+                *retng = thing;
+                *maximizer = n;
+            }
+        }
+        // Per-thing code ends
+        k++;
+        if (k > THINGS_COUNT)
+        {
+            ERRORLOG("Infinite loop detected when sweeping creature buckets");
+            break;
+        }
+    }
+}
+
+/**
+ * Returns creature within given distance which best matches given filter.
+ * Only creatures in buckets overlapping the square around given position are checked,
+ * so the filter must reject all creatures further than max_dist from pos.
+ * @param filter Filter function reference.
+ * @param param Filter function parameters struct.
+ * @param pos Position around which creatures are searched.
+ * @param max_dist Max distance from pos at which the filter may accept creatures.
+ * @param enemy_of If non-negative, only creatures of players being enemies with this player are checked.
+ * @return The best matching creature, or invalid thing pointer if not found.
+ */
+struct Thing *get_best_creature_within_distance_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param,
+    const struct Coord3d *pos, MapCoordDelta max_dist, PlayerNumber enemy_of)
+{
+    SYNCDBG(19,"Starting");
+    long maximizer = 0;
+    struct Thing* retng = INVALID_THING;
+    MapCoord coord_beg = (MapCoord)pos->x.val - max_dist;
+    MapCoord coord_end = (MapCoord)pos->x.val + max_dist;
+    long bkt_x_beg = coord_subtile(max(coord_beg, 0)) / CREATURE_BUCKET_SUBTILES;
+    long bkt_x_end = min(coord_subtile(coord_end), gameadd.map_subtiles_x) / CREATURE_BUCKET_SUBTILES;
+    coord_beg = (MapCoord)pos->y.val - max_dist;
+    coord_end = (MapCoord)pos->y.val + max_dist;
+    long bkt_y_beg = coord_subtile(max(coord_beg, 0)) / CREATURE_BUCKET_SUBTILES;
+    long bkt_y_end = min(coord_subtile(coord_end), gameadd.map_subtiles_y) / CREATURE_BUCKET_SUBTILES;
+    for (long bkt_y = bkt_y_beg; bkt_y <= bkt_y_end; bkt_y++)
+    {
+        for (long bkt_x = bkt_x_beg; bkt_x <= bkt_x_end; bkt_x++)
+        {
+            update_best_creature_in_bucket_with_filter(bkt_y * CREATURE_BUCKETS_X + bkt_x, filter, param, enemy_of, &maximizer, &retng);
+        }
+    }
+    return retng;
+}
+
+/**
+ * Returns nearest creature matching given filter, checking buckets in rings around given position.
+ * The filter is required to return LONG_MAX minus 2D distance between pos and the creature,
+ * which allows stopping the search as soon as further rings cannot contain anything closer.
+ * @param filter Filter function reference.
+ * @param param Filter function parameters struct.
+ * @param pos Position around which creatures are searched.
+ * @param max_dist Max distance from pos at which the filter may accept creatures, or non-positive if unlimited.
+ * @param enemy_of If non-negative, only creatures of players being enemies with this player are checked.
+ * @return The nearest matching creature, or invalid thing pointer if not found.
+ */
+struct Thing *get_nearest_creature_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param,
+    const struct Coord3d *pos, MapCoordDelta max_dist, PlayerNumber enemy_of)
+{
+    SYNCDBG(19,"Starting");
+    long maximizer = 0;
+    struct Thing* retng = INVALID_THING;
+    long bkt_x_org = pos->x.stl.num / CREATURE_BUCKET_SUBTILES;
+    long bkt_y_org = pos->y.stl.num / CREATURE_BUCKET_SUBTILES;
+    long bkt_x_max = gameadd.map_subtiles_x / CREATURE_BUCKET_SUBTILES;
+    long bkt_y_max = gameadd.map_subtiles_y / CREATURE_BUCKET_SUBTILES;
+    long max_ring = max(max(bkt_x_org, bkt_x_max - bkt_x_org), max(bkt_y_org, bkt_y_max - bkt_y_org));
+    for (long ring = 0; ring <= max_ring; ring++)
+    {
+        if (ring > 0)
+        {
+            // Nothing within this ring can be closer than that
+            MapCoordDelta ring_dist = (ring - 1) * CREATURE_BUCKET_SUBTILES * COORD_PER_STL;
+            if ((max_dist > 0) && (ring_dist > max_dist))
+                break;
+            if (!thing_is_invalid(retng) && (LONG_MAX - maximizer < ring_dist))
+                break;
+        }
+        for (long bkt_y = bkt_y_org - ring; bkt_y <= bkt_y_org + ring; bkt_y++)
+        {
+            if ((bkt_y < 0) || (bkt_y > bkt_y_max))
+                continue;
+            // Inner rows of the ring only have buckets at both ends
+            long bkt_x_step = ((bkt_y == bkt_y_org - ring) || (bkt_y == bkt_y_org + ring)) ? 1 : 2 * ring;
+            for (long bkt_x = bkt_x_org - ring; bkt_x <= bkt_x_org + ring; bkt_x += bkt_x_step)
+            {
+                if ((bkt_x >= 0) && (bkt_x <= bkt_x_max)) {
+                    update_best_creature_in_bucket_with_filter(bkt_y * CREATURE_BUCKETS_X + bkt_x, filter, param, enemy_of, &maximizer, &retng);
+                }
+            }
+        }
+    }
+    return retng;
+}
+
 struct Thing *get_random_thing_of_class_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param, PlayerNumber plyr_idx)
 {
     SYNCDBG(19,"Starting");
@@ -1832,7 +2164,9 @@ struct Thing* get_nearest_enemy_creature_in_sight_and_range_of_trap(struct Thing
     param.num1 = traptng->index;
     param.num2 = shotst->max_range;
     param.num3 = -1;
-    return get_nth_thing_of_class_with_filter(filter, &param, 0);
+    // Neutral traps shoot at everyone, others only at enemies
+    PlayerNumber enemy_of = is_neutral_thing(traptng) ? -1 : traptng->owner;
+    return get_nearest_creature_with_filter(filter, &param, &traptng->mappos, shotst->max_range, enemy_of);
 }
 
 struct Thing *get_nearest_enemy_creature_possible_to_attack_by(struct Thing *creatng)
@@ -1846,7 +2180,7 @@ struct Thing *get_nearest_enemy_creature_possible_to_attack_by(struct Thing *cre
     param.num1 = creatng->index;
     param.num2 = -1;
     param.num3 = -1;
-    return get_nth_thing_of_class_with_filter(filter, &param, 0);
+    return get_nearest_creature_with_filter(filter, &param, &creatng->mappos, -1, creatng->owner);
 }
 
 struct Thing* get_nearest_enemy_object_possible_to_attack_by(struct Thing* creatng)
@@ -1874,7 +2208,10 @@ struct Thing *get_highest_score_enemy_creature_within_distance_possible_to_attac
     param.num1 = creatng->index;
     param.num2 = dist;
     param.num3 = move_on_ground;
-    return get_nth_thing_of_class_with_filter(filter, &param, 0);
+    // The filter uses combat distance, which is reduced by sizes of both creatures
+    MapCoordDelta max_dist = dist + (creatng->clipbox_size_xy + creature_buckets_max_size_xy) / 2;
+    // Creatures affected by mad killing may attack allies, so owners cannot be pre-filtered
+    return get_best_creature_within_distance_with_filter(filter, &param, &creatng->mappos, max_dist, -1);
 }
 
 struct Thing *get_random_trap_of_model_owned_by_and_armed(ThingModel tngmodel, PlayerNumber plyr_idx, TbBool armed)
@@ -3147,7 +3484,7 @@ long do_to_things_with_param_spiral_near_map_block(const struct Coord3d *center_
 
 void stop_all_things_playing_samples(void)
 {
-    for (long i = 0; i < THINGS_COUNT; i++)
+    for (long i = 0; i < game.thing_slots_count; i++)
     {
         struct Thing* thing = thing_get(i);
         if ((thing->alloc_flags & TAlF_Exists) != 0)
@@ -3161,14 +3498,12 @@ void stop_all_things_playing_samples(void)
   }
 }
 
-TbBool update_thing(struct Thing *thing)
+/**
+ * Applies velocity pushes accumulated since previous turn to thing velocity.
+ * Modifies only the thing itself.
+ */
+void update_thing_velocity_from_pushes(struct Thing *thing)
 {
-    Thing_Class_Func classfunc;
-    SYNCDBG(18,"Thing index %d, class %d",(int)thing->index,(int)thing->class_id);
-    TRACE_THING(thing);
-    if (thing_is_invalid(thing))
-        return false;
-
     if ((thing->movement_flags & TMvF_Immobile) == 0)
     {
         if ((thing->state_flags & TF1_PushAdd) != 0)
@@ -3195,16 +3530,14 @@ TbBool update_thing(struct Thing *thing)
           thing->state_flags &= ~TF1_PushOnce;
         }
     }
-    if (thing->class_id < sizeof(class_functions)/sizeof(class_functions[0]))
-        classfunc = class_functions[thing->class_id];
-    else
-        classfunc = NULL;
-    if (classfunc == NULL)
-        return false;
-    if (classfunc(thing) == TUFRet_Deleted) {
-        return false;
-    }
-    SYNCDBG(18,"Class function end ok");
+}
+
+/**
+ * Finishes update of a thing after its class function; applies inertia and gravity,
+ * and updates animation, sound and light.
+ */
+static void update_thing_after_class_function(struct Thing *thing)
+{
     if ((thing->movement_flags & TMvF_Immobile) == 0)
     {
         if (thing->mappos.z.val > thing->floor_height)
@@ -3263,6 +3596,27 @@ TbBool update_thing(struct Thing *thing)
             thing->light_id = 0;
         }
     }
+}
+
+TbBool update_thing(struct Thing *thing)
+{
+    Thing_Class_Func classfunc;
+    SYNCDBG(18,"Thing index %d, class %d",(int)thing->index,(int)thing->class_id);
+    TRACE_THING(thing);
+    if (thing_is_invalid(thing))
+        return false;
+    update_thing_velocity_from_pushes(thing);
+    if (thing->class_id < sizeof(class_functions)/sizeof(class_functions[0]))
+        classfunc = class_functions[thing->class_id];
+    else
+        classfunc = NULL;
+    if (classfunc == NULL)
+        return false;
+    if (classfunc(thing) == TUFRet_Deleted) {
+        return false;
+    }
+    SYNCDBG(18,"Class function end ok");
+    update_thing_after_class_function(thing);
     SYNCDBG(18,"Finished");
     return true;
 }
@@ -30,7 +30,17 @@ extern "C" {
 
 /******************************************************************************/
 #define THING_CLASSES_COUNT    14
-#define THINGS_COUNT         8192
+/** Max amount of thing slots supported on any map; the limit for a level is set by MaxThings rule. */
+#define THINGS_COUNT        16384
+/** Default limit of thing slots, used if rules do not state otherwise. */
+#define THINGS_COUNT_DEFAULT 8192
+/** Amount of thing slots by which the things pool grows at once. */
+#define THINGS_POOL_CHUNK    1024
+#define THINGS_POOL_CHUNKS_COUNT ((THINGS_COUNT + THINGS_POOL_CHUNK - 1) / THINGS_POOL_CHUNK)
+/** Size of a square of subtiles which forms one creature bucket of the spatial index. */
+#define CREATURE_BUCKET_SUBTILES 8
+#define CREATURE_BUCKETS_X   ((MAX_SUBTILES_X + CREATURE_BUCKET_SUBTILES) / CREATURE_BUCKET_SUBTILES)
+#define CREATURE_BUCKETS_Y   ((MAX_SUBTILES_Y + CREATURE_BUCKET_SUBTILES) / CREATURE_BUCKET_SUBTILES)
 
 enum ThingClassIndex {
     TCls_Empty        =  0,
@@ -274,6 +284,11 @@ struct Thing *get_highest_score_enemy_creature_within_distance_possible_to_attac
 struct Thing *get_nth_creature_owned_by_and_matching_bool_filter(PlayerNumber plyr_idx, Thing_Bool_Filter matcher_cb, long n);
 struct Thing *get_nth_creature_owned_by_and_failing_bool_filter(PlayerNumber plyr_idx, Thing_Bool_Filter matcher_cb, long n);
 struct Thing* get_nearest_enemy_object_possible_to_attack_by(struct Thing* creatng);
+// Filters to select creature within area around given position, using creature buckets
+struct Thing *get_best_creature_within_distance_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param,
+    const struct Coord3d *pos, MapCoordDelta max_dist, PlayerNumber enemy_of);
+struct Thing *get_nearest_creature_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param,
+    const struct Coord3d *pos, MapCoordDelta max_dist, PlayerNumber enemy_of);
 
 // Routines to select all players creatures of model matching the criteria
 long count_creatures_in_dungeon_of_model_flags(const struct Dungeon *dungeon, unsigned long need_mdflags, unsigned long excl_mdflags);
@@ -311,6 +326,8 @@ void update_things(void);
 struct Thing *find_base_thing_on_mapwho(ThingClass oclass, ThingModel okind, MapSubtlCoord stl_x, MapSubtlCoord stl_y);
 void remove_thing_from_mapwho(struct Thing *thing);
 void place_thing_in_mapwho(struct Thing *thing);
+void clear_creature_buckets(void);
+void rebuild_creature_buckets(void);
 
 struct Thing *find_hero_gate_of_number(long num);
 long get_free_hero_gate_number(void);
@@ -331,6 +348,7 @@ TbBool apply_anger_to_all_players_creatures_excluding(PlayerNumber plyr_idx, lon
 void break_mapwho_infinite_chain(const struct Map *mapblk);
 
 TbBool update_thing(struct Thing *thing);
+void update_thing_velocity_from_pushes(struct Thing *thing);
 TbBigChecksum get_thing_checksum(const struct Thing *thing);
 short update_thing_sound(struct Thing *thing);
 struct Thing* find_players_dungeon_heart(PlayerNumber plyridx);
@@ -365,7 +365,8 @@ TbBool terrain_toxic_for_creature_at_position(const struct Thing *creatng, MapSu
 }
 
 /**
- * Checks if a creature can navigate to target by tracing a complete route.
+ * Checks if a creature can navigate to target.
+ * A complete route is only traced if the answer is not in reachability cache.
  * @param thing
  * @param dstpos
  * @param flags
@@ -375,8 +376,7 @@ TbBool terrain_toxic_for_creature_at_position(const struct Thing *creatng, MapSu
  */
 TbBool creature_can_navigate_to_f(const struct Thing *thing, struct Coord3d *dstpos, NaviRouteFlags flags, const char *func_name)
 {
-    long waypoints_num = ariadne_count_waypoints_on_creature_route_to_target_f(thing, &thing->mappos, dstpos, flags, func_name);
-    return (waypoints_num > 0);
+    return ariadne_creature_can_reach_target_f(thing, &thing->mappos, dstpos, flags, func_name);
 }
 
 /**
@@ -191,7 +191,7 @@ TbBool things_stats_debug_dump(void)
         count[TCls_EffectGen] +  count[TCls_AmbientSnd] + count[TCls_CaveIn],
         total
         );
-    for (i=1; i < THINGS_COUNT; i++) {
+    for (i=1; i < game.thing_slots_count; i++) {
         struct Thing* thing = thing_get(i);
         if (thing_exists(thing)) {
             realcnt[thing->class_id]++;
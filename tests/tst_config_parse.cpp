@@ -0,0 +1,193 @@
+#include "tst_main.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+#include <bflib_basics.h>
+#include <bflib_fileio.h>
+#include <bflib_dernc.h>
+#include <config.h>
+
+// Times every file is parsed in the benchmark
+#define TST_CONF_REPEATS 20
+
+struct TstConfFile {
+    std::string fname;
+    std::vector<char> buf;
+    std::vector<std::string> blocks;
+};
+
+/** Names for the commands table; kept for the whole run, as the table is indexed by address. */
+static std::vector<std::string> tst_conf_names;
+static std::vector<struct NamedCommand> tst_conf_commands;
+
+static TbBool tst_conf_name_char(char c)
+{
+    return ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9')) || (c == '_');
+}
+
+/**
+ * Loads all .cfg files from the folder given in KFX_CONFIG_DIR, or from "config/fxdata".
+ */
+static void tst_conf_load_files(std::vector<struct TstConfFile> &files)
+{
+    const char *dir = getenv("KFX_CONFIG_DIR");
+    if (dir == NULL)
+        dir = "config/fxdata";
+    char fspec[2048];
+    snprintf(fspec, sizeof(fspec), "%s/*.cfg", dir);
+    struct TbFileFind fileinfo;
+    for (int rc = LbFileFindFirst(fspec, &fileinfo, 0x21u); rc != -1; rc = LbFileFindNext(&fileinfo))
+    {
+        struct TstConfFile file;
+        file.fname = std::string(dir) + "/" + fileinfo.Filename;
+        long len = LbFileLength(file.fname.c_str());
+        if (len <= 0)
+            continue;
+        // Config loaders leave some zeros after the content
+        file.buf.resize(len + 16, '\0');
+        if (LbFileLoadAt(file.fname.c_str(), &file.buf[0]) != len)
+            continue;
+        file.buf.resize(len);
+        files.push_back(file);
+    }
+    LbFileFindEnd(&fileinfo);
+}
+
+/**
+ * Makes list of block names in every file, and commands table from words at start of lines.
+ */
+static void tst_conf_prepare_names(std::vector<struct TstConfFile> &files)
+{
+    std::set<std::string> names;
+    for (size_t f = 0; f < files.size(); f++)
+    {
+        const std::vector<char> &buf = files[f].buf;
+        for (size_t pos = 0; pos < buf.size(); pos++)
+        {
+            while ((pos < buf.size()) && ((buf[pos] == ' ') || (buf[pos] == '\t')))
+                pos++;
+            size_t end = pos;
+            if ((end < buf.size()) && (buf[end] == '['))
+            {
+                while ((end < buf.size()) && (buf[end] != ']') && (buf[end] != '\n'))
+                    end++;
+                files[f].blocks.push_back(std::string(&buf[pos+1], end - pos - 1));
+            } else
+            {
+                while ((end < buf.size()) && tst_conf_name_char(buf[end]))
+                    end++;
+                if (end > pos)
+                    names.insert(std::string(&buf[pos], end - pos));
+            }
+            pos = end;
+            while ((pos < buf.size()) && (buf[pos] != '\n'))
+                pos++;
+        }
+    }
+    if (!tst_conf_commands.empty())
+        return;
+    // Names differing only by case are kept; the first one has to be recognized
+    tst_conf_names.assign(names.begin(), names.end());
+    for (size_t i = 0; i < tst_conf_names.size(); i++)
+    {
+        struct NamedCommand cmd = {tst_conf_names[i].c_str(), (int)i + 1};
+        tst_conf_commands.push_back(cmd);
+    }
+    struct NamedCommand cmd = {NULL, 0};
+    tst_conf_commands.push_back(cmd);
+}
+
+ADD_TEST(test_config_parse_same_as_scan)
+{
+    std::vector<struct TstConfFile> files;
+    tst_conf_load_files(files);
+    tst_conf_prepare_names(files);
+    CU_ASSERT_FATAL(!files.empty());
+    for (size_t f = 0; f < files.size(); f++)
+    {
+        const char *buf = &files[f].buf[0];
+        long len = files[f].buf.size();
+        // Blocks of all files are searched in every file, to check the missing ones too
+        for (size_t g = 0; g < files.size(); g++)
+        {
+            for (size_t i = 0; i < files[g].blocks.size(); i++)
+            {
+                const char *blname = files[g].blocks[i].c_str();
+                long scan_pos = 0;
+                long pos = 0;
+                short scan_k = find_conf_block_scan(buf, &scan_pos, len, blname);
+                unsigned long scan_line = text_line_number;
+                short k = find_conf_block(buf, &pos, len, blname);
+                CU_ASSERT(k == scan_k);
+                CU_ASSERT(pos == scan_pos);
+                CU_ASSERT(text_line_number == scan_line);
+            }
+        }
+        for (long line_pos = 0; line_pos < len; line_pos++)
+        {
+            long scan_pos = line_pos;
+            long pos = line_pos;
+            int scan_cmd = recognize_conf_command_scan(buf, &scan_pos, len, &tst_conf_commands[0]);
+            int cmd = recognize_conf_command(buf, &pos, len, &tst_conf_commands[0]);
+            CU_ASSERT(cmd == scan_cmd);
+            CU_ASSERT(pos == scan_pos);
+            while ((line_pos < len) && (buf[line_pos] != '\n'))
+                line_pos++;
+        }
+    }
+}
+
+/**
+ * Finds every block and recognizes commands in it, the way config loaders do.
+ */
+static long tst_conf_parse_file(const struct TstConfFile &file, TbBool scan)
+{
+    const char *buf = &file.buf[0];
+    long len = file.buf.size();
+    long recognized = 0;
+    for (size_t i = 0; i < file.blocks.size(); i++)
+    {
+        long pos = 0;
+        const char *blname = file.blocks[i].c_str();
+        short k = scan ? find_conf_block_scan(buf, &pos, len, blname) : find_conf_block(buf, &pos, len, blname);
+        if (k < 0)
+            continue;
+        while (pos < len)
+        {
+            int cmd_num = scan ? recognize_conf_command_scan(buf, &pos, len, &tst_conf_commands[0])
+                : recognize_conf_command(buf, &pos, len, &tst_conf_commands[0]);
+            if ((cmd_num == ccr_endOfBlock) || (cmd_num == ccr_endOfFile))
+                break;
+            if (cmd_num > 0)
+                recognized++;
+            skip_conf_to_next_line(buf, &pos, len);
+        }
+    }
+    return recognized;
+}
+
+ADD_TEST(test_config_parse_benchmark)
+{
+    std::vector<struct TstConfFile> files;
+    tst_conf_load_files(files);
+    tst_conf_prepare_names(files);
+    long recognized[2] = {0, 0};
+    for (int scan = 1; scan >= 0; scan--)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int n = 0; n < TST_CONF_REPEATS; n++)
+        {
+            for (size_t f = 0; f < files.size(); f++)
+                recognized[scan] += tst_conf_parse_file(files[f], scan);
+        }
+        auto finish = std::chrono::steady_clock::now();
+        printf("%d config files, %d commands, %s: %8.3f ms\n", (int)files.size(), (int)tst_conf_names.size(),
+            scan ? "scan" : "index", std::chrono::duration<double, std::milli>(finish - start).count());
+    }
+    CU_ASSERT(recognized[0] == recognized[1]);
+}
@@ -0,0 +1,39 @@
+#ifndef GIT_TST_ENET_H
+#define GIT_TST_ENET_H
+
+#include <stddef.h>
+#include <enet/enet.h>
+
+enum NetMessageType
+{
+    NETMSG_LOGIN,           //to server: username and pass, from server: assigned id
+    NETMSG_USERUPDATE,      //changed player from server
+    NETMSG_FRAME,           //to server: ACK of frame + packets, from server: the frame itself
+    NETMSG_RESYNC,          //to server: hashes of resync blocks, from server: compressed blocks which differ
+    NETMSG_SCHEDFRAME,      //to server: packets gathered on given turn, from server: frame to be executed on given turn
+};
+
+/**
+ * Sends a message with given type; msgpack lists the values which follow:
+ * 'c' for char, 's' for short, 'i' for int, 'z' for zero-terminated string.
+ */
+void send_message(ENetPeer *client_peer, char prefix, const char *msgpack, ...);
+/**
+ * Returns a local UDP port which was free at the time of the call.
+ */
+enet_uint16 find_free_port(void);
+
+/**
+ * Creates a client host and starts connecting it; returns NULL on failure.
+ */
+ENetHost *create_client(const char *dst_addr, enet_uint16 port, ENetPeer **peer);
+/**
+ * Waits until the client is connected; returns false on timeout.
+ */
+bool wait_for_connect(ENetHost *client, int timeout);
+/**
+ * Waits for a message of given type and copies it into buf; returns its size, or 0 on timeout.
+ */
+size_t receive_message(ENetHost *client, char type, char *buf, size_t max_size, int timeout);
+
+#endif //GIT_TST_ENET_H
@@ -2,24 +2,22 @@
 // Created by Sim on 23/10/22.
 //
 #include <stdio.h>
+#include <string.h>
 #include <enet/enet.h>
 
+#include "tst_enet.h"
+
 extern "C" {
 }
 
-int run_client(int argc, char **argv)
+ENetHost *create_client(const char *dst_addr, enet_uint16 port, ENetPeer **peer)
 {
-    ENetEvent event;
     ENetHost *client;
-    const char *SRC_ADDR = "192.168.0.63";
-    const char *DST_ADDR = "192.168.0.63";
     ENetAddress address = {ENET_HOST_ANY, ENET_PORT_ANY};
-    int ret;
-    enet_initialize();
     if (enet_address_set_host(&address, "127.0.0.1") < 0)
     {
         fprintf(stderr, "Unable to listen");
-        return 1;
+        return NULL;
     }
     client = enet_host_create(&address,
                               4,
@@ -30,17 +28,70 @@ int run_client(int argc, char **argv)
     {
         fprintf(stderr,
                 "An error occurred while trying to create an ENet client host.\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 
-    if (enet_address_set_host(&address, DST_ADDR) < 0)
+    if (enet_address_set_host(&address, dst_addr) < 0)
     {
         enet_host_destroy(client);
-        return 1;
+        return NULL;
+    }
+    address.port = port;
+
+    *peer = enet_host_connect(client, &address, 2, 0);
+    if (*peer == NULL)
+    {
+        enet_host_destroy(client);
+        return NULL;
+    }
+    return client;
+}
+
+bool wait_for_connect(ENetHost *client, int timeout)
+{
+    ENetEvent event;
+    while (enet_host_service(client, &event, timeout) > 0)
+    {
+        if (event.type == ENET_EVENT_TYPE_CONNECT)
+            return true;
+        if (event.type == ENET_EVENT_TYPE_RECEIVE)
+            enet_packet_destroy(event.packet);
     }
-    address.port = 5556;
+    return false;
+}
 
-    ENetPeer *peer = enet_host_connect(client, &address, 2, 0);
+size_t receive_message(ENetHost *client, char type, char *buf, size_t max_size, int timeout)
+{
+    ENetEvent event;
+    while (enet_host_service(client, &event, timeout) > 0)
+    {
+        if (event.type != ENET_EVENT_TYPE_RECEIVE)
+            continue;
+        size_t size = event.packet->dataLength;
+        bool matches = (size > 0) && (event.packet->data[0] == type);
+        if (matches)
+            memcpy(buf, event.packet->data, (size < max_size) ? size : max_size);
+        enet_packet_destroy(event.packet);
+        if (matches)
+            return size;
+    }
+    return 0;
+}
+
+int run_client(int argc, char **argv)
+{
+    ENetEvent event;
+    ENetHost *client;
+    ENetPeer *peer;
+    const char *SRC_ADDR = "192.168.0.63";
+    const char *DST_ADDR = "192.168.0.63";
+    int ret;
+    enet_initialize();
+    client = create_client(DST_ADDR, 5556, &peer);
+    if (client == NULL)
+    {
+        return 1;
+    }
     while ((ret = enet_host_service(client, &event, 1000)) >= 0)
     {
         switch (event.type)
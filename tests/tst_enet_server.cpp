@@ -2,58 +2,78 @@
 // Created by Sim on 23/10/22.
 //
 #include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
 #include <enet/enet.h>
 
 #include "front_landview.h"
+#include "tst_enet.h"
 
-enum NetMessageType
+void send_message(ENetPeer *client_peer, char prefix, const char *msgpack, ...)
 {
-    NETMSG_LOGIN,           //to server: username and pass, from server: assigned id
-    NETMSG_USERUPDATE,      //changed player from server
-    NETMSG_FRAME,           //to server: ACK of frame + packets, from server: the frame itself
-    NETMSG_LAGWARNING,      //from server: notice that some client is lagging¨
-    NETMSG_RESYNC,          //from server: re-synchronization is occurring
-};
+    const char *P = msgpack;
+    const char *E = P + strlen(P);
+    va_list lst;
 
-namespace
-{
-    void send_message(ENetPeer *client_peer, char prefix, const char *msgpack, ...)
-    {
-        const char *P = msgpack;
-        const char *E = P + strlen(P);
-        va_list lst;
-
-        char buffer[256];
-        size_t sz = 1;
-        char *dst = buffer;
-        *dst = prefix;
-        dst++;
+    char buffer[256];
+    size_t sz = 1;
+    char *dst = buffer;
+    *dst = prefix;
+    dst++;
 
-        va_start(lst, msgpack);
-        for(int i = 0; P < E; P++, i++)
+    va_start(lst, msgpack);
+    for(int i = 0; P < E; P++, i++)
+    {
+        switch (*P)
         {
-            switch (*P)
+            case 'c':
+                sz += 1;
+                *((char*)dst) = va_arg(lst, int);
+                dst += 1;
+                break;
+            case 's':
+                sz += 2;
+                *((short*)dst) = va_arg(lst, int);
+                dst += 2;
+                break;
+            case 'i':
+                sz += 4;
+                *((int*)dst) = va_arg(lst, int);
+                dst += 4;
+                break;
+            case 'z':
             {
-                case 'c':
-                    sz += 1;
-                    *((char*)dst) = va_arg(lst, int);
-                    dst += 1;
-                    break;
-                case 's':
-                    sz += 2;
-                    *((short*)dst) = va_arg(lst, int);
-                    dst += 2;
-                    break;
-                default:
-                    fprintf(stderr, "Unknown symbol: %c", *P);
+                const char *str = va_arg(lst, const char *);
+                size_t len = strlen(str) + 1;
+                memcpy(dst, str, len);
+                sz += len;
+                dst += len;
+                break;
             }
+            default:
+                fprintf(stderr, "Unknown symbol: %c", *P);
         }
-        va_end(lst);
-        ENetPacket *packet = enet_packet_create(buffer, sz, ENET_PACKET_FLAG_RELIABLE);
-        enet_peer_send(client_peer, 0, packet);
-        fprintf(stderr, "sending %d bytes to %p\n", sz, client_peer);
     }
+    va_end(lst);
+    ENetPacket *packet = enet_packet_create(buffer, sz, ENET_PACKET_FLAG_RELIABLE);
+    enet_peer_send(client_peer, 0, packet);
+}
+
+enet_uint16 find_free_port(void)
+{
+    ENetAddress addr = {ENET_HOST_ANY, ENET_PORT_ANY};
+    enet_address_set_host(&addr, "127.0.0.1");
+    ENetHost *probe = enet_host_create(&addr, 1, 2, 0, 0);
+    if (probe == NULL)
+        return 0;
+    // Host address is updated with the port assigned by the system
+    enet_uint16 port = probe->address.port;
+    enet_host_destroy(probe);
+    return port;
+}
 
+namespace
+{
 #pragma pack(1)
     int seq_nbr = 1;
     void process_packet(ENetPeer *peer, ENetPacket *packet)
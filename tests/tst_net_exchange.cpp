@@ -0,0 +1,378 @@
+#include "tst_main.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <enet/enet.h>
+#include <SDL2/SDL.h>
+#include <bflib_network.h>
+#include <bflib_sound.h>
+#include "tst_enet.h"
+
+#define TST_NET_CLIENTS     3
+#define TST_NET_TURNS       20
+// Every client delays its frame by this amount, multiplied by client number
+#define TST_NET_DELAY_MS    10
+// Clients stop when the server sends nothing for that long
+#define TST_NET_TIMEOUT_MS  2000
+// Scheduled exchange with a resync in the middle of it
+#define TST_NET_SCHED_LAG   3
+#define TST_NET_SCHED_TURNS 12
+#define TST_NET_RESYNC_TURN 5
+
+struct TstNetFrame {
+    int client_id;
+    int turn;
+};
+
+struct TstNetClient {
+    int num;
+    enet_uint16 port;
+    int client_id;
+    int turns_done;
+    int bad_frames;
+    int bad_seq_nbrs;
+};
+
+static struct TstNetClient tst_net_clients[TST_NET_CLIENTS];
+
+/**
+ * Simulated client; logs in, then sends a frame on every turn, late by a delay
+ * unique to the client, and checks the order of combined frames it gets back.
+ */
+static int tst_net_client_thread(void *data)
+{
+    struct TstNetClient *cl = (struct TstNetClient *)data;
+    char buf[256];
+    char name[16];
+    ENetPeer *peer;
+    ENetHost *host = create_client("127.0.0.1", cl->port, &peer);
+    if (host == NULL)
+        return 1;
+    if (!wait_for_connect(host, TST_NET_TIMEOUT_MS))
+    {
+        enet_host_destroy(host);
+        return 1;
+    }
+    // Login request has empty password and a name
+    snprintf(name, sizeof(name), "client%d", cl->num);
+    send_message(peer, NETMSG_LOGIN, "zz", "", name);
+    if (receive_message(host, NETMSG_LOGIN, buf, sizeof(buf), TST_NET_TIMEOUT_MS) < 2)
+    {
+        enet_host_destroy(host);
+        return 1;
+    }
+    cl->client_id = buf[1];
+    int seq_nbr = 0;
+    for (int turn = 0; ; turn++)
+    {
+        SDL_Delay(TST_NET_DELAY_MS * (cl->num + 1));
+        send_message(peer, NETMSG_FRAME, "iii", seq_nbr, cl->client_id, turn);
+        size_t size = receive_message(host, NETMSG_FRAME, buf, sizeof(buf), TST_NET_TIMEOUT_MS);
+        if (size == 0)
+            break;
+        // Server frame has type, sequence number, amount of frames, then frames of all users
+        int frame_seq_nbr;
+        memcpy(&frame_seq_nbr, buf + 1, sizeof(int));
+        if ((turn > 0) && (frame_seq_nbr != seq_nbr + 1))
+            cl->bad_seq_nbrs++;
+        seq_nbr = frame_seq_nbr;
+        struct TstNetFrame frame = {-1, -1};
+        size_t offset = 6 + cl->client_id * sizeof(struct TstNetFrame);
+        if (size >= offset + sizeof(struct TstNetFrame))
+            memcpy(&frame, buf + offset, sizeof(frame));
+        if ((frame.client_id != cl->client_id) || (frame.turn != turn))
+            cl->bad_frames++;
+        cl->turns_done = turn + 1;
+    }
+    enet_peer_disconnect_now(peer, 0);
+    enet_host_destroy(host);
+    return 0;
+}
+
+static int tst_net_active_players(struct TbNetworkPlayerInfo *players)
+{
+    int count = 0;
+    for (int i = 0; i < MAX_N_USERS; i++)
+    {
+        if (players[i].active)
+            count++;
+    }
+    return count;
+}
+
+ADD_TEST(test_net_exchange_gathers_clients_concurrently)
+{
+    struct TbNetworkPlayerInfo players[MAX_N_USERS];
+    struct TstNetFrame frames[MAX_N_USERS];
+    int last_turns[MAX_N_USERS];
+    SDL_Thread *threads[TST_NET_CLIENTS];
+    unsigned long plyr_num;
+    char name[] = "server";
+
+    SoundDisabled = 1;
+    memset(players, 0, sizeof(players));
+    memset(frames, 0, sizeof(frames));
+    CU_ASSERT_FATAL(LbNetwork_Init(NS_ENET_UDP, MAX_N_USERS, players, NULL) == Lb_OK);
+    // Don't take the default port, other instances or tests may be using it
+    enet_uint16 port = find_free_port();
+    CU_ASSERT_FATAL(port != 0);
+    LbNetwork_SetHostingPort(port);
+    CU_ASSERT_FATAL(LbNetwork_Create(name, name, &plyr_num, NULL) == Lb_OK);
+    LbNetwork_SetHostingPort(0);
+    for (int i = 0; i < TST_NET_CLIENTS; i++)
+    {
+        memset(&tst_net_clients[i], 0, sizeof(tst_net_clients[i]));
+        tst_net_clients[i].num = i;
+        tst_net_clients[i].port = port;
+        threads[i] = SDL_CreateThread(tst_net_client_thread, "tst_net_client", &tst_net_clients[i]);
+    }
+    // Exchange until everyone has logged in
+    auto start = std::chrono::steady_clock::now();
+    while (tst_net_active_players(players) < TST_NET_CLIENTS + 1)
+    {
+        LbNetwork_ExchangeServer(frames, sizeof(struct TstNetFrame));
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10))
+            break;
+        SDL_Delay(1);
+    }
+    CU_ASSERT(tst_net_active_players(players) == TST_NET_CLIENTS + 1);
+    LbNetwork_ExchangeServer(frames, sizeof(struct TstNetFrame));
+    for (int i = 0; i < MAX_N_USERS; i++)
+        last_turns[i] = frames[i].turn;
+
+    // Every exchange has to bring exactly the next frame of every client
+    for (int turn = 0; turn < TST_NET_TURNS; turn++)
+    {
+        LbNetwork_ExchangeServer(frames, sizeof(struct TstNetFrame));
+        for (int i = 1; i <= TST_NET_CLIENTS; i++)
+        {
+            CU_ASSERT(frames[i].client_id == i);
+            CU_ASSERT(frames[i].turn == last_turns[i] + 1);
+            last_turns[i] = frames[i].turn;
+        }
+    }
+
+    for (int i = 0; i < TST_NET_CLIENTS; i++)
+    {
+        int status = 1;
+        SDL_WaitThread(threads[i], &status);
+        CU_ASSERT(status == 0);
+        CU_ASSERT(tst_net_clients[i].turns_done >= TST_NET_TURNS);
+        CU_ASSERT(tst_net_clients[i].bad_frames == 0);
+        CU_ASSERT(tst_net_clients[i].bad_seq_nbrs == 0);
+    }
+    LbNetwork_Stop();
+}
+
+static struct TstNetClient tst_net_sched_client;
+
+/**
+ * Connects a client of scheduled exchange and logs it in; returns NULL on failure.
+ */
+static ENetHost *tst_net_sched_login(struct TstNetClient *cl, ENetPeer **peer)
+{
+    char buf[256];
+    ENetHost *host = create_client("127.0.0.1", cl->port, peer);
+    if (host == NULL)
+        return NULL;
+    if (!wait_for_connect(host, TST_NET_TIMEOUT_MS))
+    {
+        enet_host_destroy(host);
+        return NULL;
+    }
+    send_message(*peer, NETMSG_LOGIN, "zz", "", "client");
+    if (receive_message(host, NETMSG_LOGIN, buf, sizeof(buf), TST_NET_TIMEOUT_MS) < 2)
+    {
+        enet_host_destroy(host);
+        return NULL;
+    }
+    cl->client_id = buf[1];
+    // One lockstep frame finishes the login on server
+    send_message(*peer, NETMSG_FRAME, "iii", 0, cl->client_id, -1);
+    receive_message(host, NETMSG_FRAME, buf, sizeof(buf), TST_NET_TIMEOUT_MS);
+    return host;
+}
+
+/**
+ * Sends scheduled frames of given turns, then waits for the last frame from server,
+ * so that the server gets all the input before the client disconnects.
+ */
+static void tst_net_sched_finish(struct TstNetClient *cl, ENetHost *host, ENetPeer *peer, int turn)
+{
+    char buf[256];
+    for (; turn < TST_NET_SCHED_TURNS; turn++)
+        send_message(peer, NETMSG_SCHEDFRAME, "iii", turn, cl->client_id, turn);
+    for (;;)
+    {
+        size_t size = receive_message(host, NETMSG_SCHEDFRAME, buf, sizeof(buf), TST_NET_TIMEOUT_MS);
+        if (size == 0)
+            break;
+        int frame_seq_nbr;
+        memcpy(&frame_seq_nbr, buf + 1, sizeof(int));
+        cl->turns_done = frame_seq_nbr + 1;
+        if (cl->turns_done >= TST_NET_SCHED_TURNS)
+            break;
+    }
+    enet_peer_disconnect_now(peer, 0);
+    enet_host_destroy(host);
+}
+
+/**
+ * Simulated client of scheduled exchange; sends its frames ahead as far as the lag allows,
+ * and asks for resync while the server hasn't read them yet.
+ */
+static int tst_net_sched_resync_client_thread(void *data)
+{
+    struct TstNetClient *cl = (struct TstNetClient *)data;
+    char buf[256];
+    ENetPeer *peer;
+    ENetHost *host = tst_net_sched_login(cl, &peer);
+    if (host == NULL)
+        return 1;
+    int turn;
+    for (turn = 0; turn < TST_NET_RESYNC_TURN + TST_NET_SCHED_LAG; turn++)
+        send_message(peer, NETMSG_SCHEDFRAME, "iii", turn, cl->client_id, turn);
+    // No hashes, so all blocks are sent
+    send_message(peer, NETMSG_RESYNC, "");
+    if (receive_message(host, NETMSG_RESYNC, buf, sizeof(buf), TST_NET_TIMEOUT_MS) < 9)
+        cl->bad_frames++;
+    tst_net_sched_finish(cl, host, peer, turn);
+    return 0;
+}
+
+/**
+ * Simulated client of scheduled exchange which gets the schedule restarted; it sends frames
+ * up to the restart, then continues from the turn the server sends.
+ */
+static int tst_net_sched_restart_client_thread(void *data)
+{
+    struct TstNetClient *cl = (struct TstNetClient *)data;
+    char buf[256];
+    ENetPeer *peer;
+    ENetHost *host = tst_net_sched_login(cl, &peer);
+    if (host == NULL)
+        return 1;
+    int turn;
+    for (turn = 0; turn < TST_NET_RESYNC_TURN; turn++)
+        send_message(peer, NETMSG_SCHEDFRAME, "iii", turn, cl->client_id, turn);
+    // Restart message has the turn on which the schedule continues
+    int restart_turn = -1;
+    if (receive_message(host, NETMSG_RESYNC, buf, sizeof(buf), TST_NET_TIMEOUT_MS) >= 1 + sizeof(int))
+        memcpy(&restart_turn, buf + 1, sizeof(int));
+    if (restart_turn != TST_NET_RESYNC_TURN)
+        cl->bad_seq_nbrs++;
+    tst_net_sched_finish(cl, host, peer, turn);
+    return 0;
+}
+
+/**
+ * Hosts a scheduled exchange and waits until the client of given thread function logs in.
+ */
+static SDL_Thread *tst_net_sched_host(struct TbNetworkPlayerInfo *players, struct TstNetFrame *frames,
+    unsigned long *plyr_num, SDL_ThreadFunction client_thread)
+{
+    char name[] = "server";
+
+    SoundDisabled = 1;
+    memset(players, 0, sizeof(struct TbNetworkPlayerInfo) * MAX_N_USERS);
+    memset(frames, 0, sizeof(struct TstNetFrame) * MAX_N_USERS);
+    if (LbNetwork_Init(NS_ENET_UDP, MAX_N_USERS, players, NULL) != Lb_OK)
+        return NULL;
+    enet_uint16 port = find_free_port();
+    LbNetwork_SetHostingPort(port);
+    LbNetwork_SetScheduledLag(TST_NET_SCHED_LAG);
+    TbError ret = LbNetwork_Create(name, name, plyr_num, NULL);
+    LbNetwork_SetHostingPort(0);
+    if ((port == 0) || (ret != Lb_OK))
+        return NULL;
+    memset(&tst_net_sched_client, 0, sizeof(tst_net_sched_client));
+    tst_net_sched_client.port = port;
+    SDL_Thread *thread = SDL_CreateThread(client_thread, "tst_net_client", &tst_net_sched_client);
+    auto start = std::chrono::steady_clock::now();
+    while (tst_net_active_players(players) < 2)
+    {
+        LbNetwork_ExchangeServer(frames, sizeof(struct TstNetFrame));
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10))
+            break;
+        SDL_Delay(1);
+    }
+    return thread;
+}
+
+static void tst_net_sched_stop(SDL_Thread *thread)
+{
+    int status = 1;
+    SDL_WaitThread(thread, &status);
+    CU_ASSERT(status == 0);
+    CU_ASSERT(tst_net_sched_client.bad_frames == 0);
+    CU_ASSERT(tst_net_sched_client.bad_seq_nbrs == 0);
+    CU_ASSERT(tst_net_sched_client.turns_done >= TST_NET_SCHED_TURNS);
+    LbNetwork_SetScheduledLag(0);
+    LbNetwork_Stop();
+}
+
+ADD_TEST(test_net_exchange_resync_keeps_scheduled_frames)
+{
+    struct TbNetworkPlayerInfo players[MAX_N_USERS];
+    struct TstNetFrame frames[MAX_N_USERS];
+    char resync_data[4000];
+    unsigned long plyr_num;
+
+    for (size_t i = 0; i < sizeof(resync_data); i++)
+        resync_data[i] = (char)(i * 7);
+    SDL_Thread *thread = tst_net_sched_host(players, frames, &plyr_num, tst_net_sched_resync_client_thread);
+    CU_ASSERT_FATAL(thread != NULL);
+    CU_ASSERT_FATAL(tst_net_active_players(players) == 2);
+
+    // Frames sent before the resync have to be executed after it, without waiting for them
+    auto start = std::chrono::steady_clock::now();
+    for (int turn = 0; turn < TST_NET_SCHED_TURNS; turn++)
+    {
+        if (turn == TST_NET_RESYNC_TURN)
+            CU_ASSERT(LbNetwork_Resync(resync_data, sizeof(resync_data)));
+        frames[plyr_num].client_id = plyr_num;
+        frames[plyr_num].turn = turn;
+        CU_ASSERT(LbNetwork_ExchangeScheduled(&frames[plyr_num], frames, sizeof(struct TstNetFrame)) == Lb_OK);
+        if (turn < TST_NET_SCHED_LAG)
+            continue;
+        int id = tst_net_sched_client.client_id;
+        CU_ASSERT(frames[id].client_id == id);
+        CU_ASSERT(frames[id].turn == turn - TST_NET_SCHED_LAG);
+    }
+    CU_ASSERT(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    tst_net_sched_stop(thread);
+}
+
+ADD_TEST(test_net_exchange_restart_drops_scheduled_frames)
+{
+    struct TbNetworkPlayerInfo players[MAX_N_USERS];
+    struct TstNetFrame frames[MAX_N_USERS];
+    unsigned long plyr_num;
+
+    SDL_Thread *thread = tst_net_sched_host(players, frames, &plyr_num, tst_net_sched_restart_client_thread);
+    CU_ASSERT_FATAL(thread != NULL);
+    CU_ASSERT_FATAL(tst_net_active_players(players) == 2);
+
+    // Input gathered before the restart is never executed; turns right after it have empty input
+    auto start = std::chrono::steady_clock::now();
+    for (int turn = 0; turn < TST_NET_SCHED_TURNS; turn++)
+    {
+        if (turn == TST_NET_RESYNC_TURN)
+            CU_ASSERT(LbNetwork_RestartScheduled());
+        frames[plyr_num].client_id = plyr_num;
+        frames[plyr_num].turn = turn;
+        CU_ASSERT(LbNetwork_ExchangeScheduled(&frames[plyr_num], frames, sizeof(struct TstNetFrame)) == Lb_OK);
+        int id = tst_net_sched_client.client_id;
+        if ((turn < TST_NET_SCHED_LAG) || ((turn >= TST_NET_RESYNC_TURN) && (turn < TST_NET_RESYNC_TURN + TST_NET_SCHED_LAG)))
+        {
+            CU_ASSERT((frames[id].client_id == 0) && (frames[id].turn == 0));
+            CU_ASSERT((frames[plyr_num].client_id == 0) && (frames[plyr_num].turn == 0));
+            continue;
+        }
+        CU_ASSERT(frames[id].client_id == id);
+        CU_ASSERT(frames[id].turn == turn - TST_NET_SCHED_LAG);
+    }
+    CU_ASSERT(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    tst_net_sched_stop(thread);
+}
@@ -0,0 +1,108 @@
+#include "tst_main.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <bflib_render.h>
+#include <bflib_vidraw.h>
+#include <bflib_threadpool.h>
+#include <vidmode.h>
+
+#define TST_SCREEN_WIDTH  320
+#define TST_SCREEN_HEIGHT 200
+#define TST_TRIGS_COUNT   2000
+#define TST_CAPTURE_SERIAL_FNAME "tst_trigs_serial.bin"
+#define TST_CAPTURE_BANDED_FNAME "tst_trigs_banded.bin"
+
+static unsigned char tst_texture[256*256];
+static unsigned char tst_screen_serial[TST_SCREEN_WIDTH*TST_SCREEN_HEIGHT];
+static unsigned char tst_screen_banded[TST_SCREEN_WIDTH*TST_SCREEN_HEIGHT];
+
+static void tst_random_point(struct PolyPoint *pt)
+{
+    // Partially outside of the window, to check clipping on band edges
+    pt->X = (rand() % (TST_SCREEN_WIDTH + 64)) - 32;
+    pt->Y = (rand() % (TST_SCREEN_HEIGHT + 64)) - 32;
+    pt->U = (rand() % 256) << 16;
+    pt->V = (rand() % 256) << 16;
+    pt->S = (rand() % 64) << 16;
+}
+
+static std::vector<unsigned char> tst_read_file(const char *fname)
+{
+    std::vector<unsigned char> data;
+    FILE *fh = fopen(fname, "rb");
+    if (fh == NULL)
+        return data;
+    unsigned char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), fh)) > 0)
+        data.insert(data.end(), buf, buf + len);
+    fclose(fh);
+    return data;
+}
+
+static void tst_draw_trigs(unsigned char *screen, TbBool banded)
+{
+    setup_vecs(screen, tst_texture, TST_SCREEN_WIDTH, TST_SCREEN_WIDTH, TST_SCREEN_HEIGHT);
+    memset(screen, 0, TST_SCREEN_WIDTH*TST_SCREEN_HEIGHT);
+    srand(7);
+    for (int i = 0; i < TST_TRIGS_COUNT; i++)
+    {
+        struct PolyPoint pt[3];
+        for (int k = 0; k < 3; k++)
+            tst_random_point(&pt[k]);
+        vec_mode = rand() % 27;
+        vec_colour = rand() % 256;
+        if (banded)
+            trig_queue_add(&pt[0], &pt[1], &pt[2]);
+        else
+            trig(&pt[0], &pt[1], &pt[2]);
+    }
+    if (banded)
+        trig_queue_flush();
+}
+
+static void tst_prepare_tables(void)
+{
+    for (int i = 0; i < (int)sizeof(tst_texture); i++)
+        tst_texture[i] = (i * 7) ^ (i >> 8);
+    for (int i = 0; i < (int)sizeof(pixmap.fade_tables); i++)
+        pixmap.fade_tables[i] = (i * 13) >> 3;
+    for (int i = 0; i < (int)sizeof(pixmap.ghost); i++)
+        pixmap.ghost[i] = (i * 31) >> 5;
+}
+
+ADD_TEST(test_render_bands_same_as_serial)
+{
+    tst_prepare_tables();
+    setup_bflib_render();
+    LbThreadPoolInit(4);
+    tst_draw_trigs(tst_screen_serial, false);
+    tst_draw_trigs(tst_screen_banded, true);
+    LbThreadPoolFinish();
+    finish_bflib_render();
+    CU_ASSERT(memcmp(tst_screen_serial, tst_screen_banded, sizeof(tst_screen_serial)) == 0);
+}
+
+ADD_TEST(test_render_bands_captured_like_serial)
+{
+    tst_prepare_tables();
+    setup_bflib_render();
+    LbThreadPoolInit(4);
+    CU_ASSERT_FATAL(trig_stream_capture_start(TST_CAPTURE_SERIAL_FNAME));
+    tst_draw_trigs(tst_screen_serial, false);
+    trig_stream_capture_stop();
+    CU_ASSERT_FATAL(trig_stream_capture_start(TST_CAPTURE_BANDED_FNAME));
+    tst_draw_trigs(tst_screen_banded, true);
+    trig_stream_capture_stop();
+    LbThreadPoolFinish();
+    finish_bflib_render();
+    std::vector<unsigned char> serial = tst_read_file(TST_CAPTURE_SERIAL_FNAME);
+    std::vector<unsigned char> banded = tst_read_file(TST_CAPTURE_BANDED_FNAME);
+    CU_ASSERT(serial.size() == sizeof(struct TrigStreamHeader) + TST_TRIGS_COUNT * sizeof(struct TrigStreamItem));
+    CU_ASSERT(serial == banded);
+    remove(TST_CAPTURE_SERIAL_FNAME);
+    remove(TST_CAPTURE_BANDED_FNAME);
+}
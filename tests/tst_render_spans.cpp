@@ -0,0 +1,208 @@
+#include "tst_main.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <bflib_render.h>
+#include <bflib_render_span.h>
+#include <bflib_vidraw.h>
+#include <vidmode.h>
+
+// Amount of triangles generated if there's no captured stream to replay
+#define TST_SPANS_GEN_TRIGS 4000
+#define TST_SPANS_MODES_COUNT 27
+
+static unsigned char tst_spans_texture[256*256];
+
+struct TstTrigStream {
+    long window_width;
+    long window_height;
+    std::vector<struct TrigStreamItem> items;
+};
+
+/**
+ * Loads triangles captured with "-capturetrigs" from file given in KFX_TRIG_STREAM,
+ * or generates random ones if there's no such file.
+ */
+static void tst_spans_load_stream(struct TstTrigStream &stream)
+{
+    const char *fname = getenv("KFX_TRIG_STREAM");
+    FILE *fh = (fname != NULL) ? fopen(fname, "rb") : NULL;
+    if (fh != NULL)
+    {
+        struct TrigStreamHeader hdr;
+        if ((fread(&hdr, sizeof(hdr), 1, fh) == 1) && (memcmp(hdr.magic, TRIG_STREAM_MAGIC, sizeof(hdr.magic)) == 0)
+          && (hdr.version == TRIG_STREAM_VERSION))
+        {
+            struct TrigStreamItem item;
+            stream.window_width = hdr.window_width;
+            stream.window_height = hdr.window_height;
+            while (fread(&item, sizeof(item), 1, fh) == 1)
+                stream.items.push_back(item);
+        }
+        fclose(fh);
+    }
+    if (!stream.items.empty())
+    {
+        printf("Replaying %d triangles from \"%s\"\n", (int)stream.items.size(), fname);
+        return;
+    }
+    stream.window_width = 640;
+    stream.window_height = 480;
+    srand(11);
+    for (int i = 0; i < TST_SPANS_GEN_TRIGS; i++)
+    {
+        struct TrigStreamItem item;
+        memset(&item, 0, sizeof(item));
+        for (int k = 0; k < 3; k++)
+        {
+            item.coords[k][0] = (rand() % (stream.window_width + 64)) - 32;
+            item.coords[k][1] = (rand() % (stream.window_height + 64)) - 32;
+            item.coords[k][2] = (rand() % 256) << 16;
+            item.coords[k][3] = (rand() % 256) << 16;
+            item.coords[k][4] = (rand() % 64) << 16;
+        }
+        item.vec_mode = (i & 1) ? 5 : 7;
+        item.vec_colour = rand() % 256;
+        stream.items.push_back(item);
+    }
+}
+
+static void tst_spans_prepare_tables(void)
+{
+    for (int i = 0; i < (int)sizeof(tst_spans_texture); i++)
+        tst_spans_texture[i] = (i * 7) ^ (i >> 8);
+    for (int i = 0; i < (int)sizeof(pixmap.fade_tables); i++)
+        pixmap.fade_tables[i] = (i * 13) >> 3;
+    for (int i = 0; i < (int)sizeof(pixmap.ghost); i++)
+        pixmap.ghost[i] = (i * 31) >> 5;
+}
+
+/**
+ * Draws all triangles of the stream; if mode is non-negative, it is used instead of captured one.
+ */
+static void tst_spans_replay(const struct TstTrigStream &stream, unsigned char *screen, int mode)
+{
+    setup_vecs(screen, tst_spans_texture, stream.window_width, stream.window_width, stream.window_height);
+    memset(screen, 0, stream.window_width * stream.window_height);
+    for (size_t i = 0; i < stream.items.size(); i++)
+    {
+        const struct TrigStreamItem &item = stream.items[i];
+        struct PolyPoint pt[3];
+        for (int k = 0; k < 3; k++)
+        {
+            pt[k].X = item.coords[k][0];
+            pt[k].Y = item.coords[k][1];
+            pt[k].U = item.coords[k][2];
+            pt[k].V = item.coords[k][3];
+            pt[k].S = item.coords[k][4];
+        }
+        vec_mode = (mode >= 0) ? mode : item.vec_mode;
+        vec_colour = item.vec_colour;
+        trig(&pt[0], &pt[1], &pt[2]);
+    }
+}
+
+ADD_TEST(test_render_spans_same_as_scalar)
+{
+    struct TstTrigStream stream;
+    tst_spans_prepare_tables();
+    tst_spans_load_stream(stream);
+    setup_bflib_render();
+    std::vector<unsigned char> scalar_screen(stream.window_width * stream.window_height);
+    std::vector<unsigned char> simd_screen(stream.window_width * stream.window_height);
+    const int modes[] = {-1, 5, 7, 11};
+    for (int kind = TSpan_Scalar + 1; kind < TSpan_KindsCount; kind++)
+    {
+        if (!trig_spans_kind_available((enum TrigSpanKind)kind))
+            continue;
+        for (size_t i = 0; i < sizeof(modes)/sizeof(modes[0]); i++)
+        {
+            trig_spans_set_kind(TSpan_Scalar);
+            tst_spans_replay(stream, &scalar_screen[0], modes[i]);
+            trig_spans_set_kind((enum TrigSpanKind)kind);
+            tst_spans_replay(stream, &simd_screen[0], modes[i]);
+            CU_ASSERT(memcmp(&scalar_screen[0], &simd_screen[0], scalar_screen.size()) == 0);
+        }
+    }
+    setup_trig_spans();
+    finish_bflib_render();
+}
+
+/**
+ * Draws mode 5 span the way the original code did, with carry of the low part taken
+ * through the middle part separately; it is lost when the middle part is 0xFFFFFFFF.
+ */
+static void tst_spans_md05_original(unsigned char *o, long count, const struct TrigSpanState *st,
+    const struct TrigSpanState *step, const unsigned char *m, const unsigned char *f)
+{
+    uint32_t rfactA = st->a;
+    uint32_t rfactB = st->b;
+    uint32_t colH = st->h;
+    for (; count > 0; count--, o++)
+    {
+        *o = f[(rfactA & 0xFF00) | m[((colH & 0xFF) << 8) | (rfactB & 0xFF)]];
+        uint32_t rfactA_carry = ((uint32_t)(rfactA + step->a) < rfactA);
+        rfactA += step->a;
+        uint32_t rfactB_carry = ((uint32_t)(rfactB + rfactA_carry + step->b) < (uint32_t)(rfactB + rfactA_carry));
+        rfactB = rfactB + step->b + rfactA_carry;
+        colH = colH + step->h + rfactB_carry;
+    }
+}
+
+ADD_TEST(test_render_spans_md05_lost_carry)
+{
+    unsigned char reference[64];
+    unsigned char drawn[64];
+    tst_spans_prepare_tables();
+    // Step of a carries on every pixel; b reaches 0xFFFFFFFF at pixel given by start
+    const struct TrigSpanState step = {0xFFFFFFFF, 0x00010000, 3};
+    for (uint32_t start = 0; start < 16; start++)
+    {
+        const struct TrigSpanState st = {0x12341078, 0xFFFFFFFF - start * 0x00010001, 7};
+        tst_spans_md05_original(reference, sizeof(reference), &st, &step, tst_spans_texture, pixmap.fade_tables);
+        for (int kind = TSpan_Scalar; kind < TSpan_KindsCount; kind++)
+        {
+            if (!trig_spans_kind_available((enum TrigSpanKind)kind))
+                continue;
+            memset(drawn, 0, sizeof(drawn));
+            trig_spans_get_funcs((enum TrigSpanKind)kind)->md05(drawn, sizeof(drawn), &st, &step,
+                tst_spans_texture, pixmap.fade_tables);
+            CU_ASSERT(memcmp(reference, drawn, sizeof(drawn)) == 0);
+        }
+    }
+}
+
+ADD_TEST(test_render_spans_benchmark)
+{
+    struct TstTrigStream stream;
+    tst_spans_prepare_tables();
+    tst_spans_load_stream(stream);
+    setup_bflib_render();
+    std::vector<unsigned char> scalar_screen(stream.window_width * stream.window_height);
+    std::vector<unsigned char> screen(stream.window_width * stream.window_height);
+    for (int mode = 0; mode < TST_SPANS_MODES_COUNT; mode++)
+    {
+        for (int kind = TSpan_Scalar; kind < TSpan_KindsCount; kind++)
+        {
+            if (!trig_spans_set_kind((enum TrigSpanKind)kind))
+                continue;
+            // Only some modes have vector span fillers; no need to measure others again
+            if ((kind != TSpan_Scalar) && (mode != 5) && (mode != 7))
+                continue;
+            unsigned char *dst = (kind == TSpan_Scalar) ? &scalar_screen[0] : &screen[0];
+            auto start = std::chrono::steady_clock::now();
+            tst_spans_replay(stream, dst, mode);
+            auto finish = std::chrono::steady_clock::now();
+            printf("Mode %2d, %-6s spans: %8.3f ms\n", mode, trig_spans->name,
+                std::chrono::duration<double, std::milli>(finish - start).count());
+            // Measured output has to be the same as the scalar one, or the timing means nothing
+            if (kind != TSpan_Scalar)
+                CU_ASSERT(memcmp(&scalar_screen[0], &screen[0], screen.size()) == 0);
+        }
+    }
+    finish_bflib_render();
+    setup_trig_spans();
+}
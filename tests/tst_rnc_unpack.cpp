@@ -0,0 +1,339 @@
+#include "tst_main.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <bflib_basics.h>
+#include <bflib_fileio.h>
+#include <bflib_dernc.h>
+
+// Times every file is unpacked in the benchmark
+#define TST_RNC_REPEATS 10
+// Files packed by the test itself, in addition to the ones found in data folder
+#define TST_RNC_GEN_FILES 6
+// Decoders may read a few bytes after the packed data
+#define TST_RNC_PADDING 16
+// Both decoders may read the word which starts at end of packed data, but nothing after it
+#define TST_RNC_END_WORD 2
+
+struct TstRncFile {
+    std::string fname;
+    std::vector<unsigned char> packed;
+    /** Known content for files packed by the test; empty for others. */
+    std::vector<unsigned char> content;
+    unsigned long unpacked_size;
+};
+
+struct TstRncWriter {
+    std::vector<unsigned char> out;
+    size_t word_pos;
+    int word_bits;
+};
+
+struct TstRncCode {
+    unsigned long code;
+    int codelen;
+};
+
+// Code lengths of the 16 symbols; the sets differ in how many codes are longer than lookup
+static const int tst_rnc_lengths[][16] = {
+    {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15},
+    {4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4},
+    {2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 8, 8},
+};
+#define TST_RNC_CODE_SETS (int)(sizeof(tst_rnc_lengths)/sizeof(tst_rnc_lengths[0]))
+
+static unsigned long tst_rnc_seed;
+
+static unsigned long tst_rnc_rand(void)
+{
+    tst_rnc_seed = tst_rnc_seed * 1103515245 + 12345;
+    return (tst_rnc_seed >> 8) & 0xFFFFFF;
+}
+
+static unsigned short tst_rnc_crc_bytewise(const unsigned char *p, unsigned long len)
+{
+    unsigned short val = 0;
+    while (len--)
+    {
+        val ^= *p++;
+        for (int j = 0; j < 8; j++)
+            val = (val & 1) ? ((val >> 1) ^ 0xA001) : (val >> 1);
+    }
+    return val;
+}
+
+/**
+ * Writes bits the way RNC decoder reads them: in 16-bit words, with literal bytes
+ * placed after the word which is currently filled.
+ */
+static void tst_rnc_put_bits(struct TstRncWriter &wr, unsigned long val, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (wr.word_bits == 16)
+        {
+            wr.word_pos = wr.out.size();
+            wr.out.push_back(0);
+            wr.out.push_back(0);
+            wr.word_bits = 0;
+        }
+        if (val & (1UL << i))
+            wr.out[wr.word_pos + wr.word_bits / 8] |= 1 << (wr.word_bits % 8);
+        wr.word_bits++;
+    }
+}
+
+/**
+ * Makes canonical codes for given lengths, the same way the decoder does.
+ */
+static void tst_rnc_make_codes(const int *lengths, struct TstRncCode *codes)
+{
+    unsigned long codeb = 0;
+    for (int len = 1; len <= 15; len++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            if (lengths[j] != len)
+                continue;
+            unsigned long code = 0;
+            for (int b = 0; b < len; b++)
+            {
+                if (codeb & (1UL << b))
+                    code |= 1UL << (len - 1 - b);
+            }
+            codes[j].code = code;
+            codes[j].codelen = len;
+            codeb++;
+        }
+        codeb <<= 1;
+    }
+}
+
+static void tst_rnc_put_value(struct TstRncWriter &wr, const struct TstRncCode *codes, unsigned long val)
+{
+    int sym = 0;
+    while ((1UL << sym) <= val)
+        sym++;
+    tst_rnc_put_bits(wr, codes[sym].code, codes[sym].codelen);
+    if (sym >= 2)
+        tst_rnc_put_bits(wr, val - (1UL << (sym - 1)), sym - 1);
+}
+
+static void tst_rnc_put_be(std::vector<unsigned char> &buf, size_t pos, unsigned long val, int len)
+{
+    for (int i = 0; i < len; i++)
+        buf[pos + i] = (val >> (8 * (len - 1 - i))) & 0xFF;
+}
+
+/**
+ * Packs random content made of literals and repeats; every chunk uses different codes.
+ */
+static void tst_rnc_make_file(struct TstRncFile &file, unsigned long seed, unsigned long min_size)
+{
+    struct TstRncWriter wr;
+    struct TstRncCode codes[3][16];
+    tst_rnc_seed = seed;
+    wr.word_pos = 0;
+    wr.word_bits = 16;
+    tst_rnc_put_bits(wr, 0, 2);
+    int chunks = 0;
+    std::vector<unsigned char> &data = file.content;
+    while (data.size() < min_size)
+    {
+        for (int t = 0; t < 3; t++)
+        {
+            const int *lengths = tst_rnc_lengths[tst_rnc_rand() % TST_RNC_CODE_SETS];
+            tst_rnc_make_codes(lengths, codes[t]);
+            tst_rnc_put_bits(wr, 16, 5);
+            for (int j = 0; j < 16; j++)
+                tst_rnc_put_bits(wr, lengths[j], 4);
+        }
+        unsigned long pieces = 1 + tst_rnc_rand() % 1000;
+        tst_rnc_put_bits(wr, pieces, 16);
+        for (unsigned long i = 0; i < pieces; i++)
+        {
+            unsigned long lit = tst_rnc_rand() % 16;
+            if ((tst_rnc_rand() % 64) == 0)
+                lit = tst_rnc_rand() % 4000;
+            if (data.empty() && (lit == 0))
+                lit = 1;
+            tst_rnc_put_value(wr, codes[0], lit);
+            for (unsigned long k = 0; k < lit; k++)
+            {
+                unsigned char c = 'a' + tst_rnc_rand() % 20;
+                data.push_back(c);
+                wr.out.push_back(c);
+            }
+            if (i + 1 == pieces)
+                break;
+            unsigned long posn = 1 + tst_rnc_rand() % ((data.size() < 32767) ? data.size() : 32767);
+            unsigned long length = 2 + tst_rnc_rand() % 40;
+            if ((tst_rnc_rand() % 32) == 0)
+                length = 2 + tst_rnc_rand() % 20000;
+            tst_rnc_put_value(wr, codes[1], posn - 1);
+            tst_rnc_put_value(wr, codes[2], length - 2);
+            for (unsigned long k = 0; k < length; k++)
+                data.push_back(data[data.size() - posn]);
+        }
+        chunks++;
+    }
+    file.packed.assign(RNC_HEADER_LEN, 0);
+    file.packed.insert(file.packed.end(), wr.out.begin(), wr.out.end());
+    memcpy(&file.packed[0], "RNC\001", 4);
+    tst_rnc_put_be(file.packed, 4, data.size(), 4);
+    tst_rnc_put_be(file.packed, 8, wr.out.size(), 4);
+    tst_rnc_put_be(file.packed, 12, tst_rnc_crc_bytewise(&data[0], data.size()), 2);
+    tst_rnc_put_be(file.packed, 14, tst_rnc_crc_bytewise(&wr.out[0], wr.out.size()), 2);
+    file.packed[17] = chunks;
+    file.packed.resize(file.packed.size() + TST_RNC_PADDING, 0);
+    file.unpacked_size = data.size();
+    char name[32];
+    snprintf(name, sizeof(name), "generated%lu", seed);
+    file.fname = name;
+}
+
+/**
+ * Loads all RNC packed files from the folder given in KFX_DATA_DIR, or from "data",
+ * and adds files packed by the test.
+ */
+static void tst_rnc_load_files(std::vector<struct TstRncFile> &files)
+{
+    const char *dir = getenv("KFX_DATA_DIR");
+    if (dir == NULL)
+        dir = "data";
+    char fspec[2048];
+    snprintf(fspec, sizeof(fspec), "%s/*.*", dir);
+    struct TbFileFind fileinfo;
+    for (int rc = LbFileFindFirst(fspec, &fileinfo, 0x21u); rc != -1; rc = LbFileFindNext(&fileinfo))
+    {
+        struct TstRncFile file;
+        file.fname = std::string(dir) + "/" + fileinfo.Filename;
+        FILE *fh = fopen(file.fname.c_str(), "rb");
+        if (fh == NULL)
+            continue;
+        unsigned char hdr[RNC_HEADER_LEN];
+        if ((fread(hdr, RNC_HEADER_LEN, 1, fh) == 1) && (memcmp(hdr, "RNC\001", 4) == 0))
+        {
+            file.packed.assign(hdr, hdr + RNC_HEADER_LEN);
+            unsigned char buf[4096];
+            size_t len;
+            while ((len = fread(buf, 1, sizeof(buf), fh)) > 0)
+                file.packed.insert(file.packed.end(), buf, buf + len);
+            file.packed.resize(file.packed.size() + TST_RNC_PADDING, 0);
+            file.unpacked_size = ((unsigned long)hdr[4] << 24) | (hdr[5] << 16) | (hdr[6] << 8) | hdr[7];
+            if (file.unpacked_size < (1 << 30))
+                files.push_back(file);
+        }
+        fclose(fh);
+    }
+    LbFileFindEnd(&fileinfo);
+    printf("%d packed files found in \"%s\"\n", (int)files.size(), dir);
+    for (int i = 0; i < TST_RNC_GEN_FILES; i++)
+    {
+        struct TstRncFile file;
+        tst_rnc_make_file(file, i + 1, 20000 << i);
+        files.push_back(file);
+    }
+}
+
+ADD_TEST(test_rnc_crc_same_as_bytewise)
+{
+    std::vector<unsigned char> buf(4096);
+    tst_rnc_seed = 7;
+    for (size_t i = 0; i < buf.size(); i++)
+        buf[i] = tst_rnc_rand() & 0xFF;
+    for (unsigned long len = 0; len < 100; len++)
+    {
+        for (unsigned long offs = 0; offs < 8; offs++)
+            CU_ASSERT(rnc_crc(&buf[offs], len) == tst_rnc_crc_bytewise(&buf[offs], len));
+    }
+    CU_ASSERT(rnc_crc(&buf[0], buf.size()) == tst_rnc_crc_bytewise(&buf[0], buf.size()));
+}
+
+ADD_TEST(test_rnc_unpack_same_as_bitwise)
+{
+    std::vector<struct TstRncFile> files;
+    tst_rnc_load_files(files);
+    for (size_t f = 0; f < files.size(); f++)
+    {
+        const struct TstRncFile &file = files[f];
+        std::vector<unsigned char> bitwise_buf(file.unpacked_size + TST_RNC_PADDING, 0);
+        std::vector<unsigned char> buf(file.unpacked_size + TST_RNC_PADDING, 0);
+        long bitwise_len = rnc_unpack_bitwise(&file.packed[0], &bitwise_buf[0], 0);
+        long len = rnc_unpack(&file.packed[0], &buf[0], 0);
+        CU_ASSERT(len == bitwise_len);
+        CU_ASSERT(memcmp(&buf[0], &bitwise_buf[0], buf.size()) == 0);
+        if (!file.content.empty())
+        {
+            CU_ASSERT(len == (long)file.content.size());
+            CU_ASSERT(memcmp(&buf[0], &file.content[0], file.content.size()) == 0);
+        }
+        if (len < 0)
+            printf("%s: %s\n", file.fname.c_str(), rnc_error(len));
+    }
+}
+
+ADD_TEST(test_rnc_unpack_without_padding)
+{
+    std::vector<struct TstRncFile> files;
+    tst_rnc_load_files(files);
+    for (size_t f = 0; f < files.size(); f++)
+    {
+        const struct TstRncFile &file = files[f];
+        if (file.unpacked_size == 0)
+            continue;
+        // Buffers of exact size, so that reading or writing after them is caught by memory checkers
+        std::vector<unsigned char> packed(file.packed.begin(), file.packed.end() - TST_RNC_PADDING);
+        packed.resize(packed.size() + TST_RNC_END_WORD, 0);
+        std::vector<unsigned char> bitwise_buf(file.unpacked_size, 0);
+        std::vector<unsigned char> buf(file.unpacked_size, 0);
+        long bitwise_len = rnc_unpack_bitwise(&packed[0], &bitwise_buf[0], 0);
+        long len = rnc_unpack(&packed[0], &buf[0], 0);
+        CU_ASSERT(len == bitwise_len);
+        CU_ASSERT(buf == bitwise_buf);
+        if (!file.content.empty())
+        {
+            CU_ASSERT(len == (long)file.content.size());
+            CU_ASSERT(buf == file.content);
+        }
+    }
+}
+
+ADD_TEST(test_rnc_unpack_benchmark)
+{
+    std::vector<struct TstRncFile> files;
+    tst_rnc_load_files(files);
+    unsigned long total_size = 0;
+    unsigned long max_size = 0;
+    for (size_t f = 0; f < files.size(); f++)
+    {
+        total_size += files[f].unpacked_size;
+        if (max_size < files[f].unpacked_size)
+            max_size = files[f].unpacked_size;
+    }
+    std::vector<unsigned char> buf(max_size + TST_RNC_PADDING);
+    long unpacked[2] = {0, 0};
+    for (int bitwise = 1; bitwise >= 0; bitwise--)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int n = 0; n < TST_RNC_REPEATS; n++)
+        {
+            for (size_t f = 0; f < files.size(); f++)
+            {
+                long len = bitwise ? rnc_unpack_bitwise(&files[f].packed[0], &buf[0], 0)
+                    : rnc_unpack(&files[f].packed[0], &buf[0], 0);
+                if (len > 0)
+                    unpacked[bitwise] += len;
+            }
+        }
+        auto finish = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(finish - start).count();
+        printf("%d files, %lu bytes, %s: %8.3f ms, %8.1f MB/s\n", (int)files.size(), total_size,
+            bitwise ? "bitwise" : "tables", elapsed * 1000.0, unpacked[bitwise] / (elapsed * 1024.0 * 1024.0));
+    }
+    CU_ASSERT(unpacked[0] == unpacked[1]);
+}
@@ -0,0 +1,152 @@
+#include "tst_main.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <zlib.h>
+#include <keeperfx.hpp>
+#include <bflib_fileio.h>
+#include <bflib_memory.h>
+#include <game_saves.h>
+#include <game_legacy.h>
+#include <game_merge.h>
+#include <thing_data.h>
+#include <creature_control.h>
+
+#define TST_SAVE_FNAME "tst_save_state.sav"
+#define TST_SAVE_PACKED_FNAME "tst_save_state_packed.sav"
+#define TST_SAVE_TURN 1234
+#define TST_SAVE_THINGS 5
+#define TST_SAVE_CCTRLS 3
+
+/**
+ * Makes a small game state with some recognizable values.
+ */
+static void tst_save_prepare_state(void)
+{
+    memset(&game, 0, sizeof(game));
+    memset(&gameadd, 0, sizeof(gameadd));
+    game.thing_slots_count = TST_SAVE_THINGS;
+    game.cctrl_slots_count = TST_SAVE_CCTRLS;
+    init_lookups();
+    game.play_gameturn = TST_SAVE_TURN;
+    gameadd.turn_last_checked_for_gold = TST_SAVE_TURN + 1;
+    for (int i = 0; i < TST_SAVE_THINGS; i++)
+        game.things.lookup[i]->index = i;
+    for (int i = 0; i < TST_SAVE_CCTRLS; i++)
+        game.persons.cctrl_lookup[i]->index = i;
+}
+
+static void tst_save_clear_state(void)
+{
+    memset(&game, 0, sizeof(game));
+    memset(&gameadd, 0, sizeof(gameadd));
+    init_lookups();
+}
+
+static void tst_save_check_state(void)
+{
+    CU_ASSERT(game.play_gameturn == TST_SAVE_TURN);
+    CU_ASSERT(gameadd.turn_last_checked_for_gold == TST_SAVE_TURN + 1);
+    CU_ASSERT_FATAL(game.thing_slots_count == TST_SAVE_THINGS);
+    CU_ASSERT_FATAL(game.cctrl_slots_count == TST_SAVE_CCTRLS);
+    for (int i = 0; i < TST_SAVE_THINGS; i++)
+        CU_ASSERT(game.things.lookup[i]->index == i);
+    for (int i = 0; i < TST_SAVE_CCTRLS; i++)
+        CU_ASSERT(game.persons.cctrl_lookup[i]->index == i);
+}
+
+static int tst_save_load_file(const char *fname)
+{
+    TbFileHandle fh = LbFileOpen(fname, Lb_FILE_MODE_READ_ONLY);
+    if (fh == -1)
+        return GLoad_Failed;
+    int result = load_game_chunks(fh, NULL);
+    LbFileClose(fh);
+    return result;
+}
+
+/**
+ * Rewrites the file with every chunk compressed, the way background save writer stores them.
+ */
+static TbBool tst_save_pack_file(const char *src_fname, const char *dst_fname)
+{
+    std::vector<unsigned char> src;
+    FILE *fh = fopen(src_fname, "rb");
+    if (fh == NULL)
+        return false;
+    unsigned char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), fh)) > 0)
+        src.insert(src.end(), buf, buf + len);
+    fclose(fh);
+    fh = fopen(dst_fname, "wb");
+    if (fh == NULL)
+        return false;
+    TbBool done = true;
+    size_t pos = 0;
+    while (done && (pos + sizeof(struct FileChunkHeader) <= src.size()))
+    {
+        struct FileChunkHeader hdr;
+        memcpy(&hdr, &src[pos], sizeof(hdr));
+        pos += sizeof(hdr);
+        unsigned long raw_len = hdr.len;
+        if (pos + raw_len > src.size())
+        {
+            done = false;
+            break;
+        }
+        uLongf packed_len = compressBound(raw_len);
+        std::vector<unsigned char> packed(packed_len);
+        done = (compress2(&packed[0], &packed_len, &src[pos], raw_len, Z_BEST_SPEED) == Z_OK);
+        pos += raw_len;
+        hdr.ver |= SGC_VER_ZLIB;
+        hdr.len = sizeof(raw_len) + packed_len;
+        done = done && (fwrite(&hdr, sizeof(hdr), 1, fh) == 1) && (fwrite(&raw_len, sizeof(raw_len), 1, fh) == 1)
+            && (fwrite(&packed[0], packed_len, 1, fh) == 1);
+    }
+    fclose(fh);
+    return done;
+}
+
+ADD_TEST(test_save_load_uncompressed)
+{
+    tst_save_prepare_state();
+    TbFileHandle fh = LbFileOpen(TST_SAVE_FNAME, Lb_FILE_MODE_NEW);
+    CU_ASSERT_FATAL(fh != -1);
+    CU_ASSERT(save_game_state_chunks(fh));
+    LbFileClose(fh);
+    tst_save_clear_state();
+    CU_ASSERT(tst_save_load_file(TST_SAVE_FNAME) == GLoad_GameState);
+    tst_save_check_state();
+    LbFileDelete(TST_SAVE_FNAME);
+}
+
+ADD_TEST(test_save_load_compressed)
+{
+    tst_save_prepare_state();
+    TbFileHandle fh = LbFileOpen(TST_SAVE_FNAME, Lb_FILE_MODE_NEW);
+    CU_ASSERT_FATAL(fh != -1);
+    CU_ASSERT(save_game_state_chunks(fh));
+    LbFileClose(fh);
+    CU_ASSERT_FATAL(tst_save_pack_file(TST_SAVE_FNAME, TST_SAVE_PACKED_FNAME));
+    tst_save_clear_state();
+    CU_ASSERT(tst_save_load_file(TST_SAVE_PACKED_FNAME) == GLoad_GameState);
+    tst_save_check_state();
+    LbFileDelete(TST_SAVE_FNAME);
+    LbFileDelete(TST_SAVE_PACKED_FNAME);
+}
+
+ADD_TEST(test_save_load_state_buffer)
+{
+    tst_save_prepare_state();
+    unsigned long len = 0;
+    unsigned char *buf = save_game_state_to_buffer(&len);
+    CU_ASSERT_FATAL(buf != NULL);
+    tst_save_clear_state();
+    CU_ASSERT(load_game_state_from_buffer(buf, len) == GLoad_GameState);
+    tst_save_check_state();
+    // Cut buffer has to be refused
+    CU_ASSERT(load_game_state_from_buffer(buf, len - 1) == GLoad_Failed);
+    LbMemoryFree(buf);
+}